@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_ACTIVITY_GATE_H__
+#define __NVGSTDS_ACTIVITY_GATE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <gst/gst.h>
+#include "gstnvdsmeta.h"
+#include "deepstream_config.h"
+#include "deepstream_audio_clock.h"
+
+typedef struct
+{
+  gboolean enable;
+  /** Band of the detector in Hz; outside it wind and traffic dominate. */
+  gdouble band_low;
+  gdouble band_high;
+  /** Block energy above the tracked noise floor that counts as activity. */
+  gdouble min_snr_db;
+  /** Absolute block level (dBFS) below which no block counts as activity. */
+  gdouble min_level_db;
+  /** Upper bound of the fraction of windows that may be skipped. */
+  gdouble max_skip_fraction;
+  /** Print statistics every report_interval seconds (0: only at EOS). */
+  guint report_interval;
+  /** Result reported for skipped windows. */
+  gchar *background_label;
+  gint background_class_id;
+  /** Filled from the [audio-classifier] group by the application. */
+  guint frame_size;
+} NvDsActivityGateConfig;
+
+typedef struct
+{
+  /** Band-pass biquads (high-pass, low-pass) and their states. */
+  gfloat coeffs[2][5];
+  gfloat state[2][2];
+  guint rate;
+  /** Energy and length of the detector block being filled. */
+  gdouble block_energy;
+  guint block_len;
+  /** Tracked noise floor (mean square), 0 until the first block. */
+  gdouble noise_floor;
+  guint64 num_samples;
+  /** Drops repeated samples like the audio front-end does, so the
+   *  detector sees the samples of its windows. */
+  NvDsAudioClock clock;
+  /** Sample index just after the last active block. */
+  guint64 last_active;
+  gboolean any_active;
+  /** Set by nvds_activity_gate_reset_source(). */
+  gint reset;
+} NvDsActivityGateSource;
+
+typedef struct
+{
+  GstElement *bin;
+  GstElement *queue;
+  /** Carries the synthetic results of skipped windows to the funnel. */
+  GstElement *skip_queue;
+  /** Merges classifier output and synthetic results; owned by the caller. */
+  GstElement *funnel;
+  gulong probe_id;
+  gboolean skip_stream_started;
+  NvDsActivityGateConfig *config;
+  NvDsActivityGateSource sources[MAX_SOURCE_BINS];
+  /** Batches with feature windows, and those whose windows were all
+   *  skipped. */
+  guint64 batches;
+  guint64 batches_skipped;
+  guint64 windows;
+  guint64 windows_skipped;
+  gint64 last_report;
+} NvDsActivityGateBin;
+
+/**
+ * Initialize @ref NvDsActivityGateBin. Placed between the audio front-end
+ * and the classifiers, it tracks band-limited energy against a per-source
+ * noise floor and removes the @ref NvDsAudioFeatureMeta windows of sources
+ * without activity during the last classifier window from the batch. For
+ * every removed window a frame meta with the background label is pushed on
+ * the "skip_src" pad, to be merged with the classifier output by
+ * bin->funnel. The batches themselves go on unchanged.
+ *
+ * CPU backend only: only classifiers of plugin-type 2 classify the feature
+ * windows, so the skipped fraction is inference saved. Dropping whole
+ * batches in front of nvinferaudio would not be sample-continuous: it
+ * windows the audio it receives and would join the samples before and
+ * after the gap.
+ *
+ * @param[in] config pointer to @ref NvDsActivityGateConfig parsed from
+ *            group @ref CONFIG_GROUP_ACTIVITY_GATE.
+ * @param[in] bin pointer to @ref NvDsActivityGateBin to be filled.
+ *
+ * @return true if bin created successfully.
+ */
+gboolean create_activity_gate_bin (NvDsActivityGateConfig *config,
+    NvDsActivityGateBin *bin);
+
+/** Print the number and fraction of skipped windows. */
+void print_activity_gate_stats (NvDsActivityGateBin *bin);
+
+/**
+ * Start @p source_id over with its next buffer: noise floor and filter
+ * states. May be called from any thread.
+ */
+void nvds_activity_gate_reset_source (NvDsActivityGateBin *bin,
+    guint source_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
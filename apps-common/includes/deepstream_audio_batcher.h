@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_AUDIO_BATCHER_H__
+#define __NVGSTDS_AUDIO_BATCHER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <glib.h>
+
+/**
+ * Dynamic batcher of classifier windows. Windows are queued per source and
+ * handed to the workers in batches of up to max_batch_size, taken from the
+ * sources in turn. A batch is formed once it is full or its oldest window
+ * has waited for the deadline, and only while a worker is idle, so batches
+ * grow with the load instead of with the number of sources.
+ */
+typedef struct _NvDsAudioBatcher NvDsAudioBatcher;
+
+typedef struct
+{
+  guint source_id;
+  /** Monotonic time the window was queued. */
+  gint64 queued_time;
+  gpointer data;
+} NvDsAudioBatchItem;
+
+/**
+ * Process one batch on a worker thread. The function owns the data of the
+ * items, the array is freed by the batcher.
+ */
+typedef void (*NvDsAudioBatchFunc) (NvDsAudioBatchItem *items,
+    guint num_items, gpointer user_data);
+
+/**
+ * @param[in] max_batch_size largest batch, e.g. the engine's batch size.
+ * @param[in] deadline_us longest time a window waits for a batch to fill.
+ * @param[in] num_workers number of batches processed at once.
+ * @param[in] func batch function.
+ * @param[in] user_data passed to @p func.
+ *
+ * @return NULL if the threads can't be created.
+ */
+NvDsAudioBatcher *nvds_audio_batcher_new (guint max_batch_size,
+    gint64 deadline_us, guint num_workers, NvDsAudioBatchFunc func,
+    gpointer user_data);
+
+/** Process the queued windows and free @p batcher. */
+void nvds_audio_batcher_free (NvDsAudioBatcher *batcher);
+
+/** Queue a window of @p source_id. */
+void nvds_audio_batcher_push (NvDsAudioBatcher *batcher, guint source_id,
+    gpointer data);
+
+/** Process all queued windows without waiting for deadlines and return
+ *  when they are done. */
+void nvds_audio_batcher_flush (NvDsAudioBatcher *batcher);
+
+/** Print batch occupancy and queueing latency, prefixed by @p name. */
+void nvds_audio_batcher_print_stats (NvDsAudioBatcher *batcher,
+    const gchar *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -29,19 +29,37 @@ extern "C"
 #endif
 
 #include "deepstream_gie.h"
+#include "deepstream_raw_recorder.h"
+
+/** State of a classifier of plugin-type 2, run on the CPU. */
+typedef struct _NvDsCpuClassifier NvDsCpuClassifier;
 
 typedef struct
 {
   GstElement *bin;
   GstElement *queue;
+  /** nvinferaudio; NULL for plugin-type 2. */
   GstElement *classifier;
+  gulong probe_id;
+  NvDsCpuClassifier *cpu;
+  /** nvinferaudio only: handler of its model-updated signal and the time
+   *  the running model swap was requested, 0 if none. */
+  gulong model_updated_id;
+  gint64 swap_start;
+  /** nvinferaudio with top-k only: labels for the top-k meta decoded from
+   *  its output tensor. */
+  GPtrArray *labels;
+  /** infer-raw-output-dir only: recorder of the output tensors. */
+  NvDsRawRecorder *raw_recorder;
 } NvDsAudioClassifierBin;
 
 /**
  * Initialize @ref NvDsAudioClassifierBin. It creates and adds primary infer and
  * other elements needed for processing to the bin.
  * It also sets properties mentioned in the configuration file under
- * group @ref CONFIG_GROUP_AUDIO_CLASSIFIER
+ * group @ref CONFIG_GROUP_AUDIO_CLASSIFIER. With plugin-type 2 the network
+ * of model-engine-file runs on the CPU on the windows of the audio
+ * front-end instead.
  *
  * @param[in] config pointer to infer @ref NvDsGieConfig parsed from
  *            configuration file.
@@ -52,6 +70,61 @@ typedef struct
 gboolean create_audio_classifier_bin (NvDsGieConfig *config,
     NvDsAudioClassifierBin *bin);
 
+/**
+ * Same as @ref create_audio_classifier_bin, for one of several classifiers
+ * in the pipeline. Element names get the suffix "_<index>" unless @p index
+ * is 0, e.g. "audio_classifier_bin_1" for group [audio-classifier-1].
+ *
+ * @param[in] config pointer to infer @ref NvDsGieConfig parsed from
+ *            configuration file.
+ * @param[in] bin pointer to @ref NvDsAudioClassifierBin to be filled.
+ * @param[in] index model ID making the element names unique.
+ *
+ * @return true if bin created successfully.
+ */
+gboolean create_audio_classifier_sub_bin (NvDsGieConfig *config,
+    NvDsAudioClassifierBin *bin, guint index);
+
+/**
+ * Same as @ref create_audio_classifier_bin, for the detector of group
+ * [audio-detector]. Element names get the suffix "_detector".
+ *
+ * @param[in] config pointer to infer @ref NvDsGieConfig parsed from
+ *            configuration file.
+ * @param[in] bin pointer to @ref NvDsAudioClassifierBin to be filled.
+ *
+ * @return true if bin created successfully.
+ */
+gboolean create_audio_detector_bin (NvDsGieConfig *config,
+    NvDsAudioClassifierBin *bin);
+
+/**
+ * Replace the model of a classifier while the pipeline keeps running.
+ *
+ * With plugin-type 2 the new network and labels are loaded on a thread of
+ * their own while the current model goes on classifying. The new model takes
+ * over with the first buffer after loading, once the windows queued for the
+ * current model are done, and the current model is released. Every window
+ * is classified once, by either model. The time to load, to switch and to
+ * release the old model is printed.
+ *
+ * nvinferaudio gets the engine through its model-engine-file property and
+ * swaps it between batches itself, if it supports model updates in PLAYING.
+ * Its labels come from its config-file and can't be changed this way.
+ *
+ * @param[in] bin running classifier.
+ * @param[in] model_engine_file new model-engine-file, NULL to keep it.
+ * @param[in] label_file new labelfile-path, NULL to keep it.
+ *
+ * @return true if the swap was started.
+ */
+gboolean nvds_audio_classifier_swap_model (NvDsAudioClassifierBin *bin,
+    const gchar *model_engine_file, const gchar *label_file);
+
+/** Release the resources of a classifier of plugin-type 2, with top-k or
+ *  infer-raw-output-dir. */
+void destroy_audio_classifier_bin (NvDsAudioClassifierBin *bin);
+
 #ifdef __cplusplus
 }
 #endif
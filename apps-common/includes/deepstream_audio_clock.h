@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_AUDIO_CLOCK_H__
+#define __NVGSTDS_AUDIO_CLOCK_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <gst/gst.h>
+#include "gstnvdsmeta.h"
+
+/** User meta type of @ref NvDsAudioClockMeta attached to an audio frame. */
+#define NVDS_AUDIO_CLOCK_META_STRING "NVIDIA.DSAUDIO.CLOCK"
+
+/** Deviation of a buffer PTS from the sample count that is still jitter. */
+#define NVDS_AUDIO_CLOCK_TOLERANCE (10 * GST_MSECOND)
+/** Longest overlap taken as repeated samples; a PTS further back is a new
+ *  timeline of the source, e.g. after a reconnect. */
+#define NVDS_AUDIO_CLOCK_MAX_OVERLAP GST_SECOND
+/** Segments kept to time windows that started before the last ones. */
+#define NVDS_AUDIO_CLOCK_MAX_SEGMENTS 16
+
+/** Run of samples without loss, at one rate. */
+typedef struct
+{
+  /** Index of the first sample among the samples taken by the clock. */
+  guint64 first_sample;
+  /** Reference time of the first sample, ns. */
+  guint64 time;
+  guint rate;
+  /** The segment follows lost samples or a new timeline. */
+  gboolean gap;
+} NvDsAudioClockSegment;
+
+typedef struct
+{
+  /** Holes in the PTS sequence and their total length, ns. */
+  guint64 gaps;
+  guint64 lost;
+  /** Buffers that repeated samples, and the samples dropped. */
+  guint64 duplicates;
+  guint64 duplicate_samples;
+  /** PTS that went back by more than @ref NVDS_AUDIO_CLOCK_MAX_OVERLAP. */
+  guint64 resyncs;
+  /** Arrival time of the last sample minus its recovered time, ns; grows
+   *  while the pipeline falls behind the source. */
+  gint64 lag;
+  gint64 max_lag;
+} NvDsAudioClockStats;
+
+/**
+ * Clock of one audio source. The time of a sample is the reference time of
+ * the first sample plus the duration of the samples before it, so it does
+ * not depend on when buffers arrive. The reference is the arrival time the
+ * muxer stamped on the first buffer: system time, or the sender's time with
+ * RTCP Sender Reports.
+ *
+ * Buffer PTS are checked against the sample count: a hole starts a new
+ * segment that many ns later, repeated samples are dropped, and a PTS that
+ * jumps back starts a new segment at the arrival time.
+ *
+ * Zero-initialized before the first buffer.
+ */
+typedef struct
+{
+  /** Samples taken, without the dropped ones. */
+  guint64 num_samples;
+  /** PTS the next buffer should have; only valid after a buffer with
+   *  PTS. */
+  guint64 next_pts;
+  gboolean have_pts;
+  /** The last @ref NVDS_AUDIO_CLOCK_MAX_SEGMENTS of num_segments. */
+  NvDsAudioClockSegment segments[NVDS_AUDIO_CLOCK_MAX_SEGMENTS];
+  guint64 num_segments;
+  NvDsAudioClockStats stats;
+} NvDsAudioClock;
+
+/**
+ * One classifier window as seen by the clock, attached to the frame meta of
+ * the window as user meta of type @ref NVDS_AUDIO_CLOCK_META_STRING. The
+ * frame's ntp_timestamp is the recovered time of the window's first sample.
+ */
+typedef struct
+{
+  /** Samples of the window are missing, or come from two timelines. */
+  gboolean gap;
+  /** @ref NvDsAudioClockStats lag of the source when the window was cut. */
+  gint64 lag;
+} NvDsAudioClockMeta;
+
+/**
+ * Take one buffer of @p num_samples samples at @p rate.
+ *
+ * @param[in] pts buffer PTS, GST_CLOCK_TIME_NONE if unknown.
+ * @param[in] arrival reference time the buffer arrived, ns.
+ * @return number of leading samples of the buffer that were received
+ *         before and are to be dropped; @p num_samples for a repeated
+ *         buffer.
+ */
+guint nvds_audio_clock_push (NvDsAudioClock *clock, guint64 pts,
+    guint64 arrival, guint num_samples, guint rate);
+
+/** Recovered reference time of sample @p sample, ns; 0 before the first
+ *  buffer. */
+guint64 nvds_audio_clock_get_time (const NvDsAudioClock *clock,
+    guint64 sample);
+
+/** TRUE if a gap lies within the @p num_samples samples from
+ *  @p first_sample, or directly before them. */
+gboolean nvds_audio_clock_has_gap (const NvDsAudioClock *clock,
+    guint64 first_sample, guint64 num_samples);
+
+/** Attach @ref NvDsAudioClockMeta to @p frame_meta. */
+void nvds_audio_clock_attach (NvDsBatchMeta *batch_meta,
+    NvDsAudioFrameMeta *frame_meta, gboolean gap, gint64 lag);
+
+/** Clock meta of @p frame_meta, NULL if none is attached. */
+NvDsAudioClockMeta *nvds_audio_clock_get_meta (NvDsAudioFrameMeta *frame_meta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
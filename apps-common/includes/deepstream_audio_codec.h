@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_AUDIO_CODEC_H__
+#define __NVGSTDS_AUDIO_CODEC_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <glib.h>
+
+/**
+ * Compressed formats a microphone may stream instead of PCM WAV. Decoders
+ * take the stream in pieces of any size, as they arrive from the network,
+ * and append whole decoded frames to the output.
+ */
+typedef enum
+{
+  /** IMA ADPCM in WAV (format tag 0x11), 4 bits per sample. */
+  NVDS_AUDIO_CODEC_IMA_ADPCM,
+  /** Native FLAC stream, starting with "fLaC" and STREAMINFO. */
+  NVDS_AUDIO_CODEC_FLAC,
+  /** Opus in Ogg, channel mapping family 0. Decoded by libopus, which is
+   *  loaded when the first Opus stream starts. */
+  NVDS_AUDIO_CODEC_OPUS,
+  NVDS_AUDIO_CODEC_COUNT,
+} NvDsAudioCodec;
+
+typedef struct _NvDsAudioDecoder NvDsAudioDecoder;
+
+const gchar *nvds_audio_codec_get_name (NvDsAudioCodec codec);
+
+/** FALSE if the codec needs a library that can't be loaded. */
+gboolean nvds_audio_codec_is_available (NvDsAudioCodec codec);
+
+/**
+ * Decoder of a FLAC or Ogg Opus stream; the format is taken from the
+ * stream headers.
+ */
+NvDsAudioDecoder *nvds_audio_decoder_new (NvDsAudioCodec codec);
+
+/**
+ * Decoder of the data chunk of an IMA ADPCM WAV stream, in blocks of
+ * @p block_align bytes.
+ */
+NvDsAudioDecoder *nvds_audio_decoder_new_ima_adpcm (guint rate,
+    guint channels, guint block_align);
+
+void nvds_audio_decoder_free (NvDsAudioDecoder *dec);
+
+/**
+ * Decode the next @p size bytes of the stream. Incomplete frames are kept
+ * until the rest arrives; decoded samples are appended interleaved to
+ * @p out in the format of nvds_audio_decoder_get_format(). Corrupt FLAC
+ * frames are skipped up to the next frame.
+ *
+ * @return FALSE if the stream can't be decoded, e.g. an unsupported
+ *         variant of the format or libopus missing.
+ */
+gboolean nvds_audio_decoder_decode (NvDsAudioDecoder *dec,
+    const guint8 *data, gsize size, GByteArray *out);
+
+/**
+ * Same as nvds_audio_decoder_decode() on the decode pool shared by all
+ * streams: at most one thread per core decodes, however many microphones
+ * are receiving. Blocks until the data is decoded.
+ */
+gboolean nvds_audio_decoder_decode_pooled (NvDsAudioDecoder *dec,
+    const guint8 *data, gsize size, GByteArray *out);
+
+/**
+ * Output format once the stream headers were decoded: "S16LE" for IMA
+ * ADPCM and FLAC of up to 16 bits, "S32LE" for deeper FLAC, "F32LE" for
+ * Opus, always at 48 kHz.
+ *
+ * @return FALSE while the headers are incomplete.
+ */
+gboolean nvds_audio_decoder_get_format (const NvDsAudioDecoder *dec,
+    const gchar **format, guint *rate, guint *channels);
+
+/** Input bytes and frames skipped as corrupt so far. */
+void nvds_audio_decoder_get_stats (const NvDsAudioDecoder *dec,
+    guint64 *bytes, guint64 *skipped);
+
+/**
+ * Encode interleaved 16 bit samples to a complete stream as a microphone
+ * would send it: a WAV file of IMA ADPCM blocks of 512 bytes per channel,
+ * a FLAC stream of 4096 frame blocks with fixed predictors, or Ogg Opus of
+ * 20 ms packets at @p bitrate bits per second in pages of 200 ms. Used by
+ * the compressed ingest benchmark to stand in for microphones.
+ *
+ * @return NULL if the codec is not available or the format is not
+ *         supported, e.g. Opus at a rate libopus does not take.
+ */
+GByteArray *nvds_audio_encode (NvDsAudioCodec codec, const gint16 *samples,
+    guint num_frames, guint rate, guint channels, guint bitrate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_AUDIO_FEATURES_H__
+#define __NVGSTDS_AUDIO_FEATURES_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <glib.h>
+
+/**
+ * Parameters of the "melsdb" audio transform, as given by the
+ * audio-transform key of group @ref CONFIG_GROUP_AUDIO_CLASSIFIER, e.g.
+ * "melsdb,fft_length=1024,hop_size=482,dsp_window=hann,num_mels=128,..."
+ */
+typedef struct
+{
+  guint fft_length;
+  guint hop_size;
+  guint num_mels;
+  guint sample_rate;
+  gfloat fmin;
+  gfloat fmax;
+  gfloat p2db_ref;
+  gfloat p2db_min_power;
+  gfloat p2db_top_db;
+} NvDsAudioTransformParams;
+
+/** Immutable tables (window, twiddles, mel bands) of one transform. */
+typedef struct _NvDsMelFrontend NvDsMelFrontend;
+
+/** SIMD kernels used by @ref NvDsMelFrontend. */
+typedef enum
+{
+  /** Best kernel supported by the CPU. */
+  NVDS_MEL_KERNEL_AUTO,
+  NVDS_MEL_KERNEL_SCALAR,
+  /** aarch64 only. */
+  NVDS_MEL_KERNEL_NEON,
+  /** x86 only, selected when the CPU supports AVX2 and FMA. */
+  NVDS_MEL_KERNEL_AVX2,
+} NvDsMelKernel;
+
+/** Element type of feature tensors handed to consumers. */
+typedef enum
+{
+  NVDS_AUDIO_TENSOR_FP32,
+  /** IEEE half precision. */
+  NVDS_AUDIO_TENSOR_FP16,
+  /** Asymmetric 8 bit with per-tensor scale and zero point. */
+  NVDS_AUDIO_TENSOR_INT8,
+} NvDsAudioTensorFormat;
+
+/**
+ * Per-source ring of mel columns. Consecutive classifier windows overlap by
+ * (frame_size - hop_size) samples, so only the columns of the newly arrived
+ * samples are computed; a window is assembled from the stored columns.
+ */
+typedef struct
+{
+  const NvDsMelFrontend *fe;
+  guint num_mels;
+  /** Number of columns the ring can hold. */
+  guint capacity;
+  /** capacity x num_mels log-power columns (dB, before top_db clamping). */
+  gfloat *columns;
+  /** Number of columns computed since the ring was created / reset. */
+  guint64 total_columns;
+  /** Unconsumed input samples; pcm[0] is sample index pcm_start. */
+  gfloat *pcm;
+  guint pcm_len;
+  guint pcm_capacity;
+  guint64 pcm_start;
+  /** Scratch memory for @ref nvds_mel_frontend_compute_column(). */
+  gfloat *work;
+} NvDsMelRing;
+
+/**
+ * Parse an audio-transform string. Only "melsdb" transforms are supported.
+ *
+ * @param[in] transform audio-transform string from the configuration file.
+ * @param[out] params parsed parameters; unset fields get librosa defaults.
+ *
+ * @return true if parsed successfully.
+ */
+gboolean nvds_audio_transform_params_parse (const gchar *transform,
+    NvDsAudioTransformParams *params);
+
+/**
+ * Number of spectrogram columns of a window of @p frame_size samples
+ * (no centering / padding), e.g. 456 for 220500 samples at hop 482.
+ */
+guint nvds_audio_transform_num_frames (const NvDsAudioTransformParams *params,
+    guint frame_size);
+
+NvDsMelFrontend *nvds_mel_frontend_new (const NvDsAudioTransformParams *params);
+/** Create a front-end using @p kernel, falling back to the scalar kernel. */
+NvDsMelFrontend *nvds_mel_frontend_new_with_kernel (
+    const NvDsAudioTransformParams *params, NvDsMelKernel kernel);
+/**
+ * Create a front-end using @p kernel. A transform of the deployed size
+ * (fft_length 1024, 128 mels) is computed by a batched kernel specialized for
+ * that size unless @p specialize is FALSE, e.g. for comparison in benchmarks.
+ */
+NvDsMelFrontend *nvds_mel_frontend_new_full (
+    const NvDsAudioTransformParams *params, NvDsMelKernel kernel,
+    gboolean specialize);
+void nvds_mel_frontend_free (NvDsMelFrontend *fe);
+const NvDsAudioTransformParams *nvds_mel_frontend_get_params (
+    const NvDsMelFrontend *fe);
+const gchar *nvds_mel_frontend_get_kernel_name (const NvDsMelFrontend *fe);
+/** Return TRUE if the batched kernel specialized for the deployed size is used. */
+gboolean nvds_mel_frontend_is_specialized (const NvDsMelFrontend *fe);
+
+/**
+ * Non-zero weights of one mel filter, applied to power bins
+ * [first_bin, first_bin + num_bins).
+ */
+const gfloat *nvds_mel_frontend_get_band (const NvDsMelFrontend *fe,
+    guint mel, guint *first_bin, guint *num_bins);
+
+/** Number of floats of scratch memory needed by the compute functions. */
+gsize nvds_mel_frontend_work_size (const NvDsMelFrontend *fe);
+
+/**
+ * Compute one mel column: Hann window, real FFT, mel projection and
+ * conversion to dB relative to p2db_ref.
+ *
+ * @param[in] fe front-end tables.
+ * @param[in] work scratch memory of @ref nvds_mel_frontend_work_size floats.
+ * @param[in] frame fft_length input samples.
+ * @param[out] mel_db num_mels output values.
+ */
+void nvds_mel_frontend_compute_column (const NvDsMelFrontend *fe,
+    gfloat *work, const gfloat *frame, gfloat *mel_db);
+
+/**
+ * Number of columns the batched kernel computes at once: one SIMD lane per
+ * column, 1 for the scalar kernel.
+ */
+guint nvds_mel_frontend_get_batch_size (const NvDsMelFrontend *fe);
+
+/**
+ * Compute @p num_columns mel columns of independent frames, e.g. the same
+ * hop of several sources, in batches of
+ * @ref nvds_mel_frontend_get_batch_size transposed into SIMD lanes.
+ *
+ * @param[in] fe front-end tables.
+ * @param[in] work scratch memory of @ref nvds_mel_frontend_work_size floats.
+ * @param[in] frames @p num_columns pointers to fft_length input samples.
+ * @param[in] num_columns number of columns to compute.
+ * @param[out] mel_db @p num_columns pointers to num_mels output values.
+ */
+void nvds_mel_frontend_compute_columns (const NvDsMelFrontend *fe,
+    gfloat *work, const gfloat *const *frames, guint num_columns,
+    gfloat *const *mel_db);
+
+/**
+ * Clamp a window of columns to (max - p2db_top_db) as done by power_to_db.
+ */
+void nvds_mel_frontend_apply_top_db (const NvDsMelFrontend *fe,
+    gfloat *window, guint num_values);
+
+NvDsMelRing *nvds_mel_ring_new (const NvDsMelFrontend *fe, guint capacity);
+void nvds_mel_ring_free (NvDsMelRing *ring);
+
+/**
+ * Append input samples and compute every column that became complete.
+ *
+ * @return number of newly computed columns.
+ */
+guint nvds_mel_ring_push_samples (NvDsMelRing *ring, const gfloat *samples,
+    guint num_samples);
+
+/** Append input samples without computing columns. */
+void nvds_mel_ring_append_samples (NvDsMelRing *ring, const gfloat *samples,
+    guint num_samples);
+
+/**
+ * Append @p num_columns columns computed elsewhere, e.g. received from a
+ * remote node, in the layout of @ref NvDsMelRing::columns.
+ */
+void nvds_mel_ring_push_columns (NvDsMelRing *ring, const gfloat *columns,
+    guint num_columns);
+
+/** Number of columns that can be computed from the appended samples. */
+guint nvds_mel_ring_pending_columns (NvDsMelRing *ring);
+
+/**
+ * Compute the pending columns of several rings sharing one front-end. The
+ * columns of all rings are batched together across the SIMD lanes.
+ *
+ * @param[in] rings rings created from the same @ref NvDsMelFrontend.
+ * @param[in] num_rings number of rings.
+ * @param[in] work scratch memory of @ref nvds_mel_frontend_work_size floats.
+ *
+ * @return number of newly computed columns.
+ */
+guint nvds_mel_rings_compute (NvDsMelRing **rings, guint num_rings,
+    gfloat *work);
+
+/** Return TRUE if columns [first_column, first_column + num_columns) are held. */
+gboolean nvds_mel_ring_has_columns (NvDsMelRing *ring, guint64 first_column,
+    guint num_columns);
+
+/**
+ * Copy columns [first_column, first_column + num_columns) into @p out
+ * (num_columns x num_mels, time major) and apply top_db clamping.
+ *
+ * @return FALSE if the columns are not (or no longer) held by the ring.
+ */
+gboolean nvds_mel_ring_assemble (NvDsMelRing *ring, guint64 first_column,
+    guint num_columns, gfloat *out);
+
+/** Size in bytes of one tensor element of @p format. */
+gsize nvds_audio_tensor_element_size (NvDsAudioTensorFormat format);
+
+/** Name of @p format as used in configuration files, e.g. "fp16". */
+const gchar *nvds_audio_tensor_format_get_name (NvDsAudioTensorFormat format);
+
+/**
+ * Convert @p num_values floats to @p format. INT8 maps the range of the
+ * values to [-128, 127]; a value is recovered as (q - zero_point) * scale.
+ * FP32 and FP16 return scale 1 and zero point 0.
+ *
+ * @param[in] format element type of @p out.
+ * @param[in] in values to convert.
+ * @param[in] num_values number of values.
+ * @param[out] out @p num_values elements of @p format.
+ * @param[out] scale quantization step.
+ * @param[out] zero_point quantized value of 0.
+ */
+void nvds_audio_tensor_pack (NvDsAudioTensorFormat format, const gfloat *in,
+    guint num_values, gpointer out, gfloat *scale, gint *zero_point);
+
+/** Inverse of @ref nvds_audio_tensor_pack. */
+void nvds_audio_tensor_unpack (NvDsAudioTensorFormat format, gconstpointer in,
+    guint num_values, gfloat scale, gint zero_point, gfloat *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
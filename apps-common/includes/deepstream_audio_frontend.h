@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_AUDIO_FRONTEND_H__
+#define __NVGSTDS_AUDIO_FRONTEND_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <gst/gst.h>
+#include "gstnvdsmeta.h"
+#include "deepstream_config.h"
+#include "deepstream_audio_features.h"
+#include "deepstream_audio_clock.h"
+
+/** User meta type of @ref NvDsAudioFeatureMeta attached to the batch. */
+#define NVDS_AUDIO_FEATURE_META_STRING "NVIDIA.DSAUDIO.MEL_FEATURES"
+
+typedef struct
+{
+  gboolean enable;
+  NvDsMelKernel kernel;
+  /** Element type of the feature windows. */
+  NvDsAudioTensorFormat tensor_format;
+  /** Stretch the hop of sources whose recent results were background. */
+  gboolean adaptive_hop;
+  /** Hop range of adaptive-hop in samples; 0 means hop_size / frame_size. */
+  guint min_hop_size;
+  guint max_hop_size;
+  /** Consecutive background results after which the hop is doubled. */
+  guint stretch_after;
+  /** Label of the background class; any other label is a detection. */
+  gchar *background_label;
+  /** Filled from the [audio-classifier] group by the application. */
+  guint frame_size;
+  guint hop_size;
+  gchar *audio_transform;
+} NvDsAudioFrontendConfig;
+
+/**
+ * One classifier window of log-mel features, attached to the batch as
+ * user meta of type @ref NVDS_AUDIO_FEATURE_META_STRING.
+ */
+typedef struct
+{
+  guint source_id;
+  guint64 window_num;
+  /** Index of the first STFT column in the source's column sequence. */
+  guint64 first_column;
+  /** Recovered time of the first sample, see @ref NvDsAudioClock. */
+  guint64 ntp_timestamp;
+  /** Samples of the window are missing or come from two timelines. */
+  gboolean gap;
+  /** Lag of the source's clock when the window was cut, ns. */
+  gint64 lag;
+  guint num_frames;
+  guint num_mels;
+  /** Element type of data. */
+  NvDsAudioTensorFormat format;
+  /** INT8 only: an element q stands for (q - zero_point) * scale dB. */
+  gfloat scale;
+  gint zero_point;
+  /** num_frames x num_mels values in dB, time major. */
+  gpointer data;
+} NvDsAudioFeatureMeta;
+
+typedef struct
+{
+  NvDsMelRing *ring;
+  /** Number of samples pushed into the ring. */
+  guint64 num_samples;
+  /** Times the samples; repeated samples never reach the ring. */
+  NvDsAudioClock clock;
+  guint64 window_num;
+  /** First sample of the last window. */
+  guint64 last_start;
+  /** Current hop in samples; set from the classifier results. */
+  gint hop_size;
+  /** Consecutive background results. */
+  guint background_run;
+  /** Columns come from a remote node, the samples are placeholders. */
+  gboolean remote;
+  gboolean remote_mismatch;
+  /** Set by nvds_audio_frontend_reset_source(). */
+  gint reset;
+} NvDsAudioFrontendSource;
+
+typedef struct
+{
+  GstElement *bin;
+  GstElement *queue;
+  gulong probe_id;
+  NvDsAudioTransformParams params;
+  NvDsMelFrontend *fe;
+  guint frame_size;
+  guint hop_size;
+  guint num_frames;
+  gboolean adaptive_hop;
+  guint min_hop_size;
+  guint max_hop_size;
+  guint stretch_after;
+  const gchar *background_label;
+  NvDsAudioTensorFormat tensor_format;
+  NvDsAudioFrontendSource sources[MAX_SOURCE_BINS];
+  /** Scratch memory of the batched mel kernel. */
+  gfloat *work;
+  /** FP32 window before conversion to a reduced precision format. */
+  gfloat *window;
+  gfloat *mono;
+  guint mono_len;
+  guint64 columns_computed;
+  /** Columns received from remote mel sources. */
+  guint64 columns_received;
+  guint64 windows_emitted;
+} NvDsAudioFrontendBin;
+
+/**
+ * Initialize @ref NvDsAudioFrontendBin. It computes the mel spectrogram of
+ * every source incrementally: each STFT column is computed once and shared by
+ * all overlapping classifier windows. Windows are attached to the batch as
+ * @ref NvDsAudioFeatureMeta.
+ *
+ * @param[in] config pointer to @ref NvDsAudioFrontendConfig parsed from
+ *            group @ref CONFIG_GROUP_AUDIO_FRONTEND.
+ * @param[in] bin pointer to @ref NvDsAudioFrontendBin to be filled.
+ *
+ * @return true if bin created successfully.
+ */
+gboolean create_audio_frontend_bin (NvDsAudioFrontendConfig *config,
+    NvDsAudioFrontendBin *bin);
+
+/** Print column reuse and clock statistics of @ref NvDsAudioFrontendBin. */
+void print_audio_frontend_stats (NvDsAudioFrontendBin *bin);
+
+/**
+ * Feed back a classification result of @p source_id for adaptive-hop: a
+ * detection resets the hop of the source to min_hop_size, every
+ * stretch_after consecutive background results double it up to
+ * max_hop_size. May be called from any single streaming thread.
+ *
+ * @param[in] bin front-end whose windows were classified.
+ * @param[in] source_id source of the result.
+ * @param[in] label class label; NULL or "" count as background.
+ */
+void nvds_audio_frontend_report_result (NvDsAudioFrontendBin *bin,
+    guint source_id, const gchar *label);
+
+/**
+ * Start @p source_id over at sample 0 with its next buffer, e.g. when a
+ * different source is attached to the slot. May be called from any thread.
+ */
+void nvds_audio_frontend_reset_source (NvDsAudioFrontendBin *bin,
+    guint source_id);
+
+void destroy_audio_frontend_bin (NvDsAudioFrontendBin *bin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_AUDIO_INGEST_H__
+#define __NVGSTDS_AUDIO_INGEST_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <gst/gst.h>
+
+/**
+ * Fused audio ingest element, used instead of the
+ * audioconvert ! audiocheblimit ! audioconvert ! audioresample chain of the
+ * audio source bins. It converts S16LE / S32LE / F32LE input to float, runs
+ * the Chebyshev high-pass of audiocheblimit (mode=high-pass) and resamples to
+ * the "rate" property in one pass over each block of input, producing
+ * interleaved F32LE with the input channel count.
+ *
+ * Properties: "rate" (0 keeps the input rate), "cutoff" (Hz, 0 disables the
+ * high-pass), "poles" and "ripple" (as for audiocheblimit, type 1).
+ */
+#define GST_TYPE_DS_AUDIO_INGEST (gst_ds_audio_ingest_get_type ())
+GType gst_ds_audio_ingest_get_type (void);
+
+/**
+ * Register the element as @ref NVDS_ELEM_AUDIO_INGEST so that it can be
+ * created with gst_element_factory_make. Safe to call more than once.
+ */
+gboolean nvds_audio_ingest_register (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_AUDIO_RESAMPLE_H__
+#define __NVGSTDS_AUDIO_RESAMPLE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <glib.h>
+
+/**
+ * Polyphase windowed-sinc sample rate converter for rational ratios
+ * out_rate / in_rate = L / M. Input is kept planar (one history per channel)
+ * so that the producer can convert and filter straight into it; output is
+ * interleaved. Equal rates are passed through without filtering or delay.
+ */
+typedef struct _NvDsAudioResampler NvDsAudioResampler;
+
+/**
+ * Build the filter banks converting the common microphone rates
+ * (48, 32 and 16 kHz) to @p out_rate. Banks are otherwise built when the
+ * first stream of a ratio starts; either way they are shared by all sources.
+ */
+void nvds_audio_resampler_precompute (guint out_rate);
+
+NvDsAudioResampler *nvds_audio_resampler_new (guint in_rate, guint out_rate,
+    guint channels);
+void nvds_audio_resampler_free (NvDsAudioResampler *rs);
+
+/** Drop the input history, e.g. on a discontinuity or flush. */
+void nvds_audio_resampler_reset (NvDsAudioResampler *rs);
+
+/** TRUE if both rates are equal and samples are only interleaved. */
+gboolean nvds_audio_resampler_is_passthrough (const NvDsAudioResampler *rs);
+
+/** Number of taps of each polyphase filter, 0 in passthrough. */
+guint nvds_audio_resampler_get_num_taps (const NvDsAudioResampler *rs);
+
+/**
+ * Upper bound of the number of output frames produced by
+ * @ref nvds_audio_resampler_process after @p num_frames more input frames.
+ */
+guint nvds_audio_resampler_get_max_output (const NvDsAudioResampler *rs,
+    guint num_frames);
+
+/**
+ * Return room for @p num_frames input samples of @p channel, to be filled
+ * by the caller and committed by @ref nvds_audio_resampler_process.
+ */
+gfloat *nvds_audio_resampler_get_input (NvDsAudioResampler *rs,
+    guint channel, guint num_frames);
+
+/**
+ * Commit @p num_frames input frames written through
+ * @ref nvds_audio_resampler_get_input and compute every output frame that
+ * became available.
+ *
+ * @param[out] out interleaved output, room for
+ *             @ref nvds_audio_resampler_get_max_output frames.
+ *
+ * @return number of output frames written.
+ */
+guint nvds_audio_resampler_process (NvDsAudioResampler *rs, guint num_frames,
+    gfloat *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
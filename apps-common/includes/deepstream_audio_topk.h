@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_AUDIO_TOPK_H__
+#define __NVGSTDS_AUDIO_TOPK_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <gst/gst.h>
+#include "gstnvdsmeta.h"
+
+/** User meta type of @ref NvDsAudioTopKMeta attached to an audio frame. */
+#define NVDS_AUDIO_TOPK_META_STRING "NVIDIA.DSAUDIO.TOPK"
+
+/** Largest top-k. */
+#define NVDS_AUDIO_TOPK_MAX 8
+
+/** Scores are quantized to 1 / NVDS_AUDIO_TOPK_SCORE_SCALE. */
+#define NVDS_AUDIO_TOPK_SCORE_SCALE 65535.0f
+
+typedef struct
+{
+  guint16 class_id;
+  /** Score in [0, 1] times @ref NVDS_AUDIO_TOPK_SCORE_SCALE. */
+  guint16 score;
+} NvDsAudioTopKEntry;
+
+/**
+ * Best classes of one window, highest score first, attached to the frame
+ * meta of the window as user meta of type @ref NVDS_AUDIO_TOPK_META_STRING.
+ */
+typedef struct
+{
+  guint num_entries;
+  NvDsAudioTopKEntry entries[NVDS_AUDIO_TOPK_MAX];
+  /** Labels of the model that produced the scores, one per class; a
+   *  reference is held by the meta. NULL without labels. */
+  GPtrArray *labels;
+} NvDsAudioTopKMeta;
+
+/**
+ * Select the @p k highest of @p num_scores scores that are at least
+ * @p min_score, highest first; of equal scores the lower class comes first.
+ * Blocks of scores below the current k-th best are skipped with SIMD
+ * compares, so after the first blocks almost all classes cost one compare.
+ *
+ * @param[in] scores probabilities of the classes.
+ * @param[in] k at most @ref NVDS_AUDIO_TOPK_MAX.
+ * @param[out] entries @p k entries.
+ * @return number of entries filled.
+ */
+guint nvds_audio_topk_select (const gfloat *scores, guint num_scores,
+    guint k, gfloat min_score, NvDsAudioTopKEntry *entries);
+
+static inline gfloat
+nvds_audio_topk_score (const NvDsAudioTopKEntry *entry)
+{
+  return entry->score / NVDS_AUDIO_TOPK_SCORE_SCALE;
+}
+
+/** Label of @p entry, NULL if the model has no label for it. */
+const gchar *nvds_audio_topk_label (const NvDsAudioTopKMeta *meta,
+    const NvDsAudioTopKEntry *entry);
+
+/**
+ * Attach @p num_entries entries to @p frame_meta.
+ *
+ * @param[in] labels labels of the model, may be NULL.
+ */
+void nvds_audio_topk_attach (NvDsBatchMeta *batch_meta,
+    NvDsAudioFrameMeta *frame_meta, const NvDsAudioTopKEntry *entries,
+    guint num_entries, GPtrArray *labels);
+
+/**
+ * Decode the output tensor nvinferaudio attached to @p frame_meta with
+ * output-tensor-meta=1 and attach its top @p k classes.
+ *
+ * @return FALSE if the frame has no FP32 output tensor meta.
+ */
+gboolean nvds_audio_topk_attach_from_tensor_meta (NvDsBatchMeta *batch_meta,
+    NvDsAudioFrameMeta *frame_meta, guint k, gfloat min_score,
+    GPtrArray *labels);
+
+/** Top-k meta of @p frame_meta, NULL if none is attached. */
+NvDsAudioTopKMeta *nvds_audio_topk_get_meta (NvDsAudioFrameMeta *frame_meta);
+
+/**
+ * Read a label file as written for nvinfer, labels separated by ';' or new
+ * lines.
+ *
+ * @return labels, NULL on error.
+ */
+GPtrArray *nvds_audio_labels_load (const gchar *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
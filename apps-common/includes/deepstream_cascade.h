@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_CASCADE_H__
+#define __NVGSTDS_CASCADE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <gst/gst.h>
+#include "gstnvdsmeta.h"
+#include "deepstream_config.h"
+#include "deepstream_audio_classifier.h"
+
+typedef struct
+{
+  GstElement *bin;
+  /** Stage one, built from group [audio-detector]. */
+  NvDsAudioClassifierBin detector;
+  GstElement *queue;
+  /** Carries the batches without detection to the funnel. */
+  GstElement *skip_queue;
+  gulong probe_id;
+  gboolean skip_stream_started;
+  /** Detector classes that send a window to stage two; any class if none. */
+  gint *class_ids;
+  guint num_class_ids;
+  /** Stage two only gets the windows of the flagged sources of a batch and
+   *  the detector results of the other sources are kept. Only for a
+   *  single stage-two model. */
+  gboolean per_source;
+  gboolean flagged[MAX_SOURCE_BINS];
+  guint64 batches;
+  guint64 batches_passed;
+  guint64 windows;
+  guint64 windows_flagged;
+  guint64 windows_passed;
+} NvDsCascadeBin;
+
+/**
+ * Initialize @ref NvDsCascadeBin, the first stage of a two-stage cascade.
+ * The detector classifies every batch. Batches in which it flags no window
+ * leave on the "skip_src" pad with the detector results, to be merged with
+ * the stage-two output by a funnel of the caller. The other batches leave
+ * on "src" without the detector results, for the stage-two classifiers.
+ *
+ * Stage two does not get every buffer of a source, so it must classify the
+ * @ref NvDsAudioFeatureMeta windows of the buffers it gets (plugin-type 2):
+ * nvinferaudio cuts its windows from the samples of all buffers it received
+ * and would join the audio before and after a skipped batch.
+ *
+ * @param[in] config detector configuration parsed from group
+ *            @ref CONFIG_GROUP_AUDIO_DETECTOR.
+ * @param[in] class_ids detector classes flagging a window, e.g. the
+ *            operate-on-class-ids of the stage-two classifier.
+ * @param[in] num_class_ids number of @p class_ids, 0 for any class.
+ * @param[in] per_source see @ref NvDsCascadeBin.
+ * @param[in] bin pointer to @ref NvDsCascadeBin to be filled.
+ *
+ * @return true if bin created successfully.
+ */
+gboolean create_cascade_bin (NvDsGieConfig *config, gint *class_ids,
+    guint num_class_ids, gboolean per_source, NvDsCascadeBin *bin);
+
+/** Release the resources of the detector. */
+void destroy_cascade_bin (NvDsCascadeBin *bin);
+
+/** Print how many windows the detector flagged and stage two classified. */
+void print_cascade_stats (NvDsCascadeBin *bin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
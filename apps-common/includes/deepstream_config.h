@@ -38,6 +38,8 @@
 #define NVDS_ELEM_SRC_URI "uridecodebin"
 #define NVDS_ELEM_SRC_MULTIFILE "multifilesrc"
 #define NVDS_ELEM_SRC_ALSA "alsasrc"
+#define NVDS_ELEM_SRC_TCP "tcpclientsrc"
+#define NVDS_ELEM_SRC_HTTP_WAV "nvdshttpwavsrc"
 
 #define NVDS_ELEM_DECODEBIN "decodebin"
 #define NVDS_ELEM_WAVPARSE "wavparse"
@@ -45,6 +47,7 @@
 #define NVDS_ELEM_QUEUE "queue"
 #define NVDS_ELEM_CAPS_FILTER "capsfilter"
 #define NVDS_ELEM_TEE "tee"
+#define NVDS_ELEM_FUNNEL "funnel"
 
 #define NVDS_ELEM_PREPROCESS "nvdspreprocess"
 #define NVDS_ELEM_PGIE "nvinfer"
@@ -58,6 +61,8 @@
 #define NVDS_ELEM_AUDIO_CONV "audioconvert"
 #define NVDS_ELEM_AUDIO_LIMIT "audiocheblimit"
 #define NVDS_ELEM_AUDIO_RESAMPLER "audioresample"
+#define NVDS_ELEM_AUDIO_INGEST "nvdsaudioingest"
+#define NVDS_ELEM_MEL_DEPAY "nvdsmeldepay"
 #define NVDS_ELEM_STREAM_MUX "nvstreammux"
 #define NVDS_ELEM_STREAM_DEMUX "nvstreamdemux"
 #define NVDS_ELEM_TILER "nvmultistreamtiler"
@@ -34,6 +34,8 @@ extern "C"
 #include "deepstream_preprocess.h"
 #include "deepstream_primary_gie.h"
 #include "deepstream_audio_classifier.h"
+#include "deepstream_audio_frontend.h"
+#include "deepstream_activity_gate.h"
 #include "deepstream_tiled_display.h"
 #include "deepstream_gie.h"
 #include "deepstream_sinks.h"
@@ -69,6 +71,9 @@ extern "C"
 #define CONFIG_GROUP_IMG_SAVE "img-save"
 #define CONFIG_GROUP_AUDIO_TRANSFORM "audio-transform"
 #define CONFIG_GROUP_AUDIO_CLASSIFIER "audio-classifier"
+#define CONFIG_GROUP_AUDIO_DETECTOR "audio-detector"
+#define CONFIG_GROUP_AUDIO_FRONTEND "audio-frontend"
+#define CONFIG_GROUP_ACTIVITY_GATE "activity-gate"
 
 #define CONFIG_GROUP_SOURCE_GPU_ID "gpu-id"
 #define CONFIG_GROUP_SOURCE_TYPE "type"
@@ -134,6 +139,12 @@ gboolean
 parse_source (NvDsSourceConfig * config, GKeyFile * key_file,
     gchar * group, gchar * cfg_file_path);
 
+/**
+ * Forget the source groups parsed so far, so that the source groups of a
+ * configuration file can be parsed again.
+ */
+void reset_parsed_source_ids (void);
+
 /**
  * Function to read properties of OSD element from configuration file.
  *
@@ -230,6 +241,30 @@ parse_dsanalytics (NvDsDsAnalyticsConfig * config, GKeyFile * key_file, gchar* c
 gboolean
 parse_dsexample (NvDsDsExampleConfig * config, GKeyFile * key_file);
 
+/**
+ * Function to read properties of the incremental mel front-end from
+ * configuration file.
+ *
+ * @param[in] config pointer to @ref NvDsAudioFrontendConfig
+ * @param[in] key_file pointer to file having key value pairs.
+ *
+ * @return true if parsed successfully.
+ */
+gboolean
+parse_audio_frontend (NvDsAudioFrontendConfig * config, GKeyFile * key_file);
+
+/**
+ * Function to read properties of the acoustic activity gate from
+ * configuration file.
+ *
+ * @param[in] config pointer to @ref NvDsActivityGateConfig
+ * @param[in] key_file pointer to file having key value pairs.
+ *
+ * @return true if parsed successfully.
+ */
+gboolean
+parse_activity_gate (NvDsActivityGateConfig * config, GKeyFile * key_file);
+
 /**
  * Function to read properties of streammux element from configuration file.
  *
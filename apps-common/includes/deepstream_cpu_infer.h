@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_CPU_INFER_H__
+#define __NVGSTDS_CPU_INFER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <glib.h>
+
+/**
+ * Built-in network format run by @ref NvDsCpuNet, written by
+ * export_cpu_model.py from an ONNX export of the classifier. All fields are
+ * little endian:
+ *
+ *   header:  "BDNN", u32 version, u32 num_tensors, u32 num_layers,
+ *            u32 input_c, input_h, input_w, u32 output_tensor
+ *   layer:   u32 type, activation, input0, input1, output, out_channels,
+ *            kernel_h, kernel_w, stride_h, stride_w, pad_top, pad_left,
+ *            pad_bottom, pad_right, groups, num_weights, num_bias,
+ *            f32 weights[num_weights], f32 bias[num_bias]
+ *
+ * Tensor 0 is the input; every other tensor is the output of exactly one
+ * layer and is only read by later layers. Unused fields are 0, an unused
+ * input1 is @ref NVDS_CPU_NET_NO_TENSOR.
+ */
+#define NVDS_CPU_NET_MAGIC 0x4e4e4442 /* "BDNN" */
+#define NVDS_CPU_NET_VERSION 1
+#define NVDS_CPU_NET_NO_TENSOR 0xffffffff
+
+typedef enum
+{
+  /** Grouped 2D convolution, weights OC x (C / groups) x KH x KW. Dense
+   *  layers are 1x1 convolutions of a 1x1 input. */
+  NVDS_CPU_LAYER_CONV,
+  /** Max pooling; padding never wins. */
+  NVDS_CPU_LAYER_MAX_POOL,
+  /** Average pooling over the unpadded elements; kernel 0 x 0 is global. */
+  NVDS_CPU_LAYER_AVG_POOL,
+  /** Elementwise sum; input1 may also be C x 1 x 1. */
+  NVDS_CPU_LAYER_ADD,
+  /** Elementwise product; input1 may also be C x 1 x 1. */
+  NVDS_CPU_LAYER_MUL,
+  /** Activation only. */
+  NVDS_CPU_LAYER_ACTIVATION,
+  /** Softmax over all elements of the input. */
+  NVDS_CPU_LAYER_SOFTMAX,
+} NvDsCpuLayerType;
+
+/** Activation applied to the output of a layer. */
+typedef enum
+{
+  NVDS_CPU_ACTIVATION_NONE,
+  NVDS_CPU_ACTIVATION_RELU,
+  NVDS_CPU_ACTIVATION_RELU6,
+  NVDS_CPU_ACTIVATION_SIGMOID,
+  /** x * sigmoid (x) */
+  NVDS_CPU_ACTIVATION_SILU,
+} NvDsCpuActivation;
+
+typedef struct _NvDsCpuNet NvDsCpuNet;
+
+/**
+ * Scratch memory of one thread running @ref NvDsCpuNet on up to
+ * max_batch_size inputs at once.
+ */
+typedef struct _NvDsCpuNetWorkspace NvDsCpuNetWorkspace;
+
+/**
+ * Activations of the last window of one audio source, reused by the next
+ * window where the two overlap. See nvds_cpu_net_enable_streaming().
+ */
+typedef struct _NvDsCpuNetStream NvDsCpuNetStream;
+
+typedef struct
+{
+  guint64 windows;
+  /** Windows that reused activations of the previous window. */
+  guint64 reused;
+  /** Time steps of the streamed tensors, and how many of them were
+   *  computed rather than copied. */
+  guint64 steps;
+  guint64 steps_computed;
+} NvDsCpuNetStreamStats;
+
+/**
+ * Load a network in the built-in format. Shapes are checked and the
+ * intermediate tensors are assigned to as few buffers as their lifetimes
+ * allow.
+ *
+ * @return NULL if the file can't be read or is invalid.
+ */
+NvDsCpuNet *nvds_cpu_net_load (const gchar *path);
+void nvds_cpu_net_free (NvDsCpuNet *net);
+
+/** Input dimensions, channels x height x width. */
+void nvds_cpu_net_get_input_dims (const NvDsCpuNet *net, guint *channels,
+    guint *height, guint *width);
+/** Number of values of the output tensor of one input. */
+guint nvds_cpu_net_get_output_size (const NvDsCpuNet *net);
+
+NvDsCpuNetWorkspace *nvds_cpu_net_workspace_new (const NvDsCpuNet *net,
+    guint max_batch_size);
+void nvds_cpu_net_workspace_free (NvDsCpuNetWorkspace *ws);
+
+/**
+ * Run @p batch_size inputs. The layers are executed one after the other on
+ * all inputs of the batch, so the weights of a layer are read from memory
+ * once per batch.
+ *
+ * @param[in] net network.
+ * @param[in] ws workspace of at least @p batch_size inputs, used by one
+ *            thread at a time.
+ * @param[in] input @p batch_size x channels x height x width values.
+ * @param[in] batch_size number of inputs.
+ * @param[out] output @p batch_size x output size values.
+ */
+void nvds_cpu_net_run (const NvDsCpuNet *net, NvDsCpuNetWorkspace *ws,
+    const gfloat *input, guint batch_size, gfloat *output);
+
+/**
+ * Compute the first layers incrementally for overlapping windows. Up to
+ * @p max_layers leading convolutions, local pools, activations and
+ * elementwise layers on same-shaped inputs are streamed along the time
+ * axis; the prefix ends at the first other layer.
+ *
+ * A streamed tensor keeps the time steps of the previous window of a stream
+ * whose receptive field lies inside both windows, shifted by the hop, and
+ * only computes the steps at the edges. Since the kept steps saw the same
+ * input values through the same arithmetic, the results equal those of
+ * nvds_cpu_net_run() exactly.
+ *
+ * Call before creating the workspaces.
+ *
+ * @param[in] time_on_width TRUE if time is the width of the input, FALSE if
+ *            it is the height.
+ * @return number of streamed layers, 0 if the network starts with a layer
+ *         that can't be streamed.
+ */
+guint nvds_cpu_net_enable_streaming (NvDsCpuNet *net, gboolean time_on_width,
+    guint max_layers);
+/** Bytes cached by each stream. */
+gsize nvds_cpu_net_get_stream_size (const NvDsCpuNet *net);
+
+NvDsCpuNetStream *nvds_cpu_net_stream_new (const NvDsCpuNet *net);
+void nvds_cpu_net_stream_free (NvDsCpuNetStream *stream);
+const NvDsCpuNetStreamStats *nvds_cpu_net_stream_get_stats (
+    const NvDsCpuNetStream *stream);
+
+/**
+ * Same as nvds_cpu_net_run() for windows of streams. Activations are only
+ * reused if the overlapping input steps of a window equal those of the
+ * previous window of its stream bit for bit; otherwise, e.g. after a
+ * gap or a change of the per-window normalization, the window is computed
+ * in full.
+ *
+ * @param[in] streams stream of each input. The windows of a stream must
+ *            come in order and a stream must only be used by one thread at
+ *            a time.
+ * @param[in] positions time step of the first input step of each window
+ *            within its stream.
+ */
+void nvds_cpu_net_run_streams (const NvDsCpuNet *net,
+    NvDsCpuNetWorkspace *ws, NvDsCpuNetStream **streams,
+    const guint64 *positions, const gfloat *input, guint batch_size,
+    gfloat *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
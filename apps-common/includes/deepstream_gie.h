@@ -37,6 +37,8 @@ typedef enum
 {
   NV_DS_GIE_PLUGIN_INFER = 0,
   NV_DS_GIE_PLUGIN_INFER_SERVER,
+  /** Built-in network run on the CPU, fed by the [audio-frontend]. */
+  NV_DS_GIE_PLUGIN_CPU,
 } NvDsGiePluginType;
 
 typedef struct
@@ -93,6 +95,19 @@ typedef struct
   gchar *tag;
 
   NvDsGiePluginType plugin_type;
+  /** NV_DS_GIE_PLUGIN_CPU only: number of inference threads. */
+  guint cpu_threads;
+  /** NV_DS_GIE_PLUGIN_CPU only: batch windows across buffers and sources,
+   *  closing a batch when full or after this many ms. 0 batches per
+   *  buffer. */
+  guint batch_deadline_ms;
+  /** NV_DS_GIE_PLUGIN_CPU only: leading layers whose activations are
+   *  reused across the overlapping windows of a source. 0 disables. */
+  guint streaming_layers;
+  /** Best classes attached to each result as @ref NvDsAudioTopKMeta; 0
+   *  disables. Only classes scoring at least top_k_threshold are kept. */
+  guint top_k;
+  gfloat top_k_threshold;
 } NvDsGieConfig;
 
 #ifdef __cplusplus
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_HTTP_WAV_H__
+#define __NVGSTDS_HTTP_WAV_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <gst/gst.h>
+
+/**
+ * Live source of PCM WAV streamed over HTTP/1.1, such as the
+ * http://<mic>/stream.wav of the BirdEdge microphones, used instead of
+ * uridecodebin for audio URI sources. The WAV header is parsed once per
+ * connection and the samples are received straight into buffers of a fixed
+ * size from a preallocated pool, producing S16LE, S32LE or F32LE with the
+ * rate and channels of the stream. Buffers are timestamped by sample count
+ * from the running time of the connect.
+ *
+ * Microphones on thin links may stream IMA ADPCM WAV, native FLAC or Ogg
+ * Opus instead, told apart by the first bytes of the body. Those are
+ * decoded on the decode pool of deepstream_audio_codec.h into S16LE, S32LE
+ * (FLAC deeper than 16 bits) or F32LE (Opus, 48 kHz); corrupt FLAC frames
+ * are skipped.
+ *
+ * A connection that fails, ends or stays silent for "timeout" ms is
+ * reopened after "retry-delay" ms with the address resolved at start, and
+ * the next buffer is marked DISCONT; the element posts a warning but never
+ * an error for it, so one unreachable microphone does not stop the others.
+ * Chunked transfer encoding and redirects to other http:// URIs are
+ * followed. A body of known length ends the stream with EOS.
+ *
+ * Properties: "location", "timeout", "retry-delay", "block-duration" (ms of
+ * audio per buffer); "connects" (read only) counts the connections made.
+ */
+#define GST_TYPE_DS_HTTP_WAV_SRC (gst_ds_http_wav_src_get_type ())
+GType gst_ds_http_wav_src_get_type (void);
+
+/**
+ * Register the element as @ref NVDS_ELEM_SRC_HTTP_WAV so that it can be
+ * created with gst_element_factory_make. Safe to call more than once.
+ */
+gboolean nvds_http_wav_src_register (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_RAW_RECORDER_H__
+#define __NVGSTDS_RAW_RECORDER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <gst/gst.h>
+#include "gstnvdsinfer.h"
+
+/**
+ * Recorder of the raw output tensors of nvinferaudio for
+ * infer-raw-output-dir. The streaming thread only copies the tensors into a
+ * preallocated ring; a writer thread appends them to large segment files
+ * "<name>_<segment>.bin" and lists every record in "<name>.index", one line
+ * of "<segment> <offset> <size> <batch> <layer>" each. Batches that don't
+ * fit into the ring are dropped and counted rather than blocking the
+ * pipeline.
+ *
+ * A segment holds records back to back, all fields little endian:
+ *
+ *   u32 magic "BDRO", u32 size (header and data, padded to 8 bytes),
+ *   u64 batch, u64 pts, u64 monotonic time in us, u32 layer index,
+ *   u32 data type (NvDsInferDataType), u32 batch size, u32 elements per
+ *   frame, u32 data size, u32 reserved, char layer name[64], data
+ */
+#define NVDS_RAW_RECORDER_MAGIC 0x4f524442 /* "BDRO" */
+
+/** Ring between the streaming thread and the writer. */
+#define NVDS_RAW_RECORDER_RING_SIZE (8 << 20)
+/** A new segment file is started once one reaches this size. */
+#define NVDS_RAW_RECORDER_SEGMENT_SIZE (256 << 20)
+
+typedef struct _NvDsRawRecorder NvDsRawRecorder;
+
+/**
+ * Start a recorder writing to @p directory. Segment numbers continue after
+ * the segments already in the directory.
+ *
+ * @param[in] name prefix of the files, e.g. the element name.
+ * @return NULL if the directory or index can't be written.
+ */
+NvDsRawRecorder *nvds_raw_recorder_new (const gchar *directory,
+    const gchar *name);
+
+/**
+ * Queue the output layers of one batch, e.g. from the
+ * raw-output-generated-callback of nvinferaudio. Safe to call from several
+ * threads.
+ */
+void nvds_raw_recorder_write (NvDsRawRecorder *recorder, GstBuffer *buf,
+    NvDsInferLayerInfo *layers_info, guint num_layers, guint batch_size);
+
+/** Write the queued records, print the statistics and free @p recorder. */
+void nvds_raw_recorder_free (NvDsRawRecorder *recorder);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
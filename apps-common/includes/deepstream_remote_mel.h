@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NVGSTDS_REMOTE_MEL_H__
+#define __NVGSTDS_REMOTE_MEL_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <gst/gst.h>
+#include "deepstream_audio_features.h"
+
+/**
+ * Framing of precomputed mel columns sent by a remote node over TCP. Every
+ * frame is a little endian @ref NvDsRemoteMelHeader of
+ * @ref NVDS_REMOTE_MEL_HEADER_SIZE bytes followed by
+ * num_columns x num_mels elements of the given format, time major. Values
+ * are log-mel powers in dB before top_db clamping, as stored by
+ * @ref NvDsMelRing.
+ */
+#define NVDS_REMOTE_MEL_MAGIC 0x464c454d /* "MELF" */
+#define NVDS_REMOTE_MEL_VERSION 1
+#define NVDS_REMOTE_MEL_HEADER_SIZE 32
+
+typedef struct
+{
+  guint32 magic;
+  guint8 version;
+  /** @ref NvDsAudioTensorFormat of the payload. */
+  guint8 format;
+  guint16 num_mels;
+  guint16 num_columns;
+  /** Samples between columns at sample_rate. */
+  guint16 hop_size;
+  guint32 sample_rate;
+  /** Index of the first column in the sender's column sequence. */
+  guint64 first_column;
+  /** INT8 only, see @ref nvds_audio_tensor_pack. */
+  gfloat scale;
+  gint32 zero_point;
+} NvDsRemoteMelHeader;
+
+/** Serialize @p header into @ref NVDS_REMOTE_MEL_HEADER_SIZE bytes. */
+void nvds_remote_mel_header_write (const NvDsRemoteMelHeader *header,
+    guint8 *out);
+
+/**
+ * Parse @ref NVDS_REMOTE_MEL_HEADER_SIZE bytes.
+ *
+ * @return FALSE if magic, version, format or sizes are invalid.
+ */
+gboolean nvds_remote_mel_header_read (const guint8 *in,
+    NvDsRemoteMelHeader *header);
+
+/** Size in bytes of the payload following @p header. */
+gsize nvds_remote_mel_payload_size (const NvDsRemoteMelHeader *header);
+
+/**
+ * Mark @p source_id as a remote mel source and drop its queued columns. The
+ * audio front-end takes the columns of such sources from
+ * @ref nvds_remote_mel_take_columns instead of computing them.
+ */
+void nvds_remote_mel_source_register (guint source_id);
+
+/** Return TRUE if @p source_id was registered as a remote mel source. */
+gboolean nvds_remote_mel_source_is_registered (guint source_id);
+
+/**
+ * Queue @p num_columns columns of @p num_mels dB values received for
+ * @p source_id. Columns are contiguous with the previously queued ones.
+ */
+void nvds_remote_mel_queue_columns (guint source_id, const gfloat *columns,
+    guint num_columns, guint num_mels, guint hop_size);
+
+/**
+ * Take all queued columns of @p source_id.
+ *
+ * @param[in] source_id registered source.
+ * @param[out] num_columns number of returned columns.
+ * @param[out] num_mels values per column.
+ * @param[out] hop_size hop of the sender's transform.
+ *
+ * @return columns to be freed with g_free, NULL if none are queued.
+ */
+gfloat *nvds_remote_mel_take_columns (guint source_id, guint *num_columns,
+    guint *num_mels, guint *hop_size);
+
+/**
+ * Depayloader element turning a byte stream of frames into silent mono F32LE
+ * placeholder audio at the sender's sample rate, one hop of samples per
+ * column, so that the source is batched and timed by nvstreammux like any
+ * other. The columns themselves are queued for the audio front-end under the
+ * "source-id" property.
+ *
+ * Properties: "source-id", "rate" (expected sample rate, 0 accepts any).
+ */
+#define GST_TYPE_DS_MEL_DEPAY (gst_ds_mel_depay_get_type ())
+GType gst_ds_mel_depay_get_type (void);
+
+/**
+ * Register the element as @ref NVDS_ELEM_MEL_DEPAY so that it can be
+ * created with gst_element_factory_make. Safe to call more than once.
+ */
+gboolean nvds_mel_depay_register (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -42,6 +42,8 @@ typedef enum
   NV_DS_SOURCE_AUDIO_WAV,
   NV_DS_SOURCE_AUDIO_URI,
   NV_DS_SOURCE_ALSA_SRC,
+  /** Precomputed mel columns from a remote node, uri "mel://host:port". */
+  NV_DS_SOURCE_REMOTE_MEL,
 } NvDsSourceType;
 
 typedef struct
@@ -87,8 +89,32 @@ typedef struct
   guint input_audio_rate;
   /** ALSA device, as defined in an asound configuration file */
   gchar* alsa_device;
+  /** Use the audioconvert / (audiocheblimit) / audioresample chains instead
+   * of the fused ingest element for audio sources, and uridecodebin instead
+   * of nvdshttpwavsrc for http:// URIs. */
+  gboolean legacy_ingest;
+  /** Live audio URI and ALSA sources: seconds without data after which the
+   * source counts as down and is reset; 0 to only react to errors. */
+  guint reconnect_timeout_sec;
+  /** Longest wait between two resets of a source that stays down; the wait
+   * starts at 1 s and doubles with every reset. */
+  guint reconnect_backoff_max_sec;
 } NvDsSourceConfig;
 
+/** Outages of a source watched by its reconnect watchdog. */
+typedef struct
+{
+  /** Times the source went down, by an error, EOS or missing data. */
+  guint outages;
+  /** Resets of the source, one or more per outage. */
+  guint reconnects;
+  /** Monotonic time the current outage started, us; 0 while up. */
+  gint64 down_since;
+  /** Length of the last finished outage and of all finished outages, us. */
+  gint64 last_outage;
+  gint64 total_downtime;
+} NvDsSrcReconnectStats;
+
 typedef struct NvDsSrcParentBin NvDsSrcParentBin;
 
 typedef struct
@@ -147,6 +173,21 @@ typedef struct
   NvDsSourceConfig *config;
   NvDsSrcParentBin *parent_bin;
   gpointer recordCtx;
+  /** Monotonic time the source was created, in microseconds. */
+  gint64 attach_time;
+  /** Reconnect watchdog of live audio URI and ALSA sources; 0 if the source
+   * is not watched. */
+  guint watchdog_id;
+  /** The source element reconnects by itself; only errors reset the bin. */
+  gboolean reconnects_itself;
+  /** Under bin_lock: monotonic time of the last buffer, and an error or EOS
+   * not yet handled by the watchdog. */
+  gint64 last_data_time;
+  gboolean source_error;
+  gint64 last_reset_time;
+  gint64 next_reset_time;
+  guint backoff_ms;
+  NvDsSrcReconnectStats reconnect_stats;
 } NvDsSrcBin;
 
 struct NvDsSrcParentBin
@@ -182,6 +223,36 @@ gboolean
 create_multi_source_bin (guint num_sub_bins, NvDsSourceConfig *configs,
                          NvDsSrcParentBin *bin);
 
+/**
+ * Create source @p index of a running @ref NvDsSrcParentBin, link it to
+ * muxer sink pad @p index and bring it to the state of the parent bin.
+ *
+ * @param[in] bin bin created by create_multi_source_bin().
+ * @param[in] config configuration of the source; must outlive the source.
+ * @param[in] index free source slot, used as source ID.
+ *
+ * @return true if the source was added.
+ */
+gboolean add_source_to_multi_source_bin (NvDsSrcParentBin *bin,
+    NvDsSourceConfig *config, guint index);
+
+/**
+ * Stop source @p index of a running @ref NvDsSrcParentBin, release its
+ * muxer sink pad and free the slot. The other sources keep running.
+ */
+gboolean remove_source_from_multi_source_bin (NvDsSrcParentBin *bin,
+    guint index);
+
+/**
+ * Pass an error posted on the bus by @p src to the reconnect watchdog of
+ * the source it belongs to.
+ *
+ * @return true if @p src belongs to a watched source, which is then reset
+ *         with backoff while the other sources keep running; false if the
+ *         error has to stop the pipeline.
+ */
+gboolean handle_source_error (NvDsSrcParentBin *bin, GstObject *src);
+
 gboolean reset_source_pipeline (gpointer data);
 gboolean set_source_to_playing (gpointer data);
 gpointer reset_encodebin (gpointer data);
@@ -0,0 +1,431 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "deepstream_common.h"
+#include "deepstream_activity_gate.h"
+#include "deepstream_audio_frontend.h"
+#include "deepstream_remote_mel.h"
+#include "nvbufaudio.h"
+
+/** Length of one detector block. */
+#define GATE_BLOCK_SEC 0.02
+/** How fast the noise floor follows a rising background level. */
+#define GATE_FLOOR_RISE_DB_PER_SEC 0.5
+#define GATE_MIN_FLOOR 1e-12
+#define GATE_DEFAULT_BACKGROUND_LABEL "00_background"
+
+/**
+ * Second order Butterworth section (RBJ cookbook) as b0, b1, b2, a1, a2
+ * with a0 normalized to 1. A cutoff of 0 or at / above Nyquist yields a
+ * pass-through section.
+ */
+static void
+design_section (gfloat *c, gdouble cutoff, guint rate, gboolean highpass)
+{
+  gdouble w0 = 2.0 * G_PI * cutoff / rate;
+  gdouble alpha = sin (w0) / G_SQRT2;
+  gdouble cw = cos (w0);
+  gdouble a0 = 1.0 + alpha;
+
+  if (cutoff <= 0.0 || w0 >= G_PI) {
+    c[0] = 1.0f;
+    c[1] = c[2] = c[3] = c[4] = 0.0f;
+    return;
+  }
+  if (highpass) {
+    c[0] = (1.0 + cw) / 2.0 / a0;
+    c[1] = -(1.0 + cw) / a0;
+  } else {
+    c[0] = (1.0 - cw) / 2.0 / a0;
+    c[1] = (1.0 - cw) / a0;
+  }
+  c[2] = c[0];
+  c[3] = -2.0 * cw / a0;
+  c[4] = (1.0 - alpha) / a0;
+}
+
+static inline gfloat
+run_section (const gfloat *c, gfloat *z, gfloat x)
+{
+  gfloat y = c[0] * x + z[0];
+
+  z[0] = c[1] * x - c[3] * y + z[1];
+  z[1] = c[2] * x - c[4] * y;
+  return y;
+}
+
+static void
+close_block (NvDsActivityGateBin *bin, NvDsActivityGateSource *src)
+{
+  NvDsActivityGateConfig *config = bin->config;
+  gdouble energy = src->block_energy / src->block_len;
+
+  /* Minimum tracking: follow drops at once, rises slowly. */
+  if (src->noise_floor <= 0.0 || energy < src->noise_floor)
+    src->noise_floor = MAX (energy, GATE_MIN_FLOOR);
+  else
+    src->noise_floor *= pow (10.0,
+        GATE_FLOOR_RISE_DB_PER_SEC * src->block_len / src->rate / 10.0);
+
+  if (energy > src->noise_floor * pow (10.0, config->min_snr_db / 10.0) &&
+      10.0 * log10 (MAX (energy, GATE_MIN_FLOOR)) >= config->min_level_db) {
+    src->last_active = src->num_samples;
+    src->any_active = TRUE;
+  }
+  src->block_energy = 0.0;
+  src->block_len = 0;
+}
+
+/** Run the band-limited energy detector over one source buffer. */
+static void
+update_source (NvDsActivityGateBin *bin, NvDsActivityGateSource *src,
+    NvBufAudioParams *params)
+{
+  guint channels = MAX (params->channels, 1);
+  guint bps = params->bpf / channels;
+  guint block = 0;
+  guint num_samples, drop, i, c;
+
+  if (!params->bpf || !params->dataPtr || !params->rate)
+    return;
+  if (src->rate != params->rate) {
+    src->rate = params->rate;
+    design_section (src->coeffs[0], bin->config->band_low, src->rate, TRUE);
+    design_section (src->coeffs[1], bin->config->band_high, src->rate, FALSE);
+    memset (src->state, 0, sizeof (src->state));
+  }
+  block = MAX ((guint) (GATE_BLOCK_SEC * src->rate), 1);
+  num_samples = params->dataSize / params->bpf;
+  drop = nvds_audio_clock_push (&src->clock, params->bufPts,
+      params->ntpTimestamp, num_samples, params->rate);
+
+  for (i = drop; i < num_samples; i++) {
+    gfloat x = 0.0f, y;
+
+    /* Channel 0 is enough to detect activity. */
+    if (params->format == NVBUF_AUDIO_F32LE && bps == sizeof (gfloat))
+      x = ((const gfloat *) params->dataPtr)[i * channels];
+    else if (params->format == NVBUF_AUDIO_S16LE && bps == sizeof (gint16))
+      x = ((const gint16 *) params->dataPtr)[i * channels] / 32768.0f;
+    else
+      return;
+
+    y = run_section (src->coeffs[1], src->state[1],
+        run_section (src->coeffs[0], src->state[0], x));
+    src->block_energy += y * y;
+    src->num_samples++;
+    if (++src->block_len == block)
+      close_block (bin, src);
+  }
+
+  /* Keep the states out of the denormal range on silent input. */
+  for (c = 0; c < 2; c++) {
+    if (fabsf (src->state[c][0]) < 1e-20f)
+      src->state[c][0] = 0.0f;
+    if (fabsf (src->state[c][1]) < 1e-20f)
+      src->state[c][1] = 0.0f;
+  }
+}
+
+/** Activity within the last classifier window of the source. */
+static gboolean
+source_active (NvDsActivityGateBin *bin, NvDsActivityGateSource *src)
+{
+  return src->any_active &&
+      src->num_samples - src->last_active < bin->config->frame_size;
+}
+
+static gboolean
+copy_sticky_event (GstPad *pad, GstEvent **event, gpointer user_data)
+{
+  if (GST_EVENT_TYPE (*event) != GST_EVENT_EOS)
+    gst_pad_send_event ((GstPad *) user_data, gst_event_ref (*event));
+  return TRUE;
+}
+
+/** Start the synthetic stream with the sticky events of the batch stream. */
+static GstPad *
+get_skip_pad (NvDsActivityGateBin *bin, GstPad *pad)
+{
+  GstPad *skip_pad = gst_element_get_static_pad (bin->skip_queue, "sink");
+
+  if (!bin->skip_stream_started) {
+    gst_pad_sticky_events_foreach (pad, copy_sticky_event, skip_pad);
+    bin->skip_stream_started = TRUE;
+  }
+  return skip_pad;
+}
+
+/** Buffer of the batch carrying the samples of @p source_id. */
+static NvBufAudioParams *
+find_source (NvBufAudio *batch, guint source_id, guint *batch_id)
+{
+  guint i;
+
+  for (i = 0; i < batch->numFilled; i++) {
+    if (batch->audioBuffers[i].sourceId == source_id) {
+      *batch_id = i;
+      return &batch->audioBuffers[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Withhold the feature windows of quiet sources from the classifiers and
+ * report each as background. Returns the buffer of the results, NULL if no
+ * window was skipped.
+ */
+static GstBuffer *
+skip_quiet_windows (NvDsActivityGateBin *bin, GstBuffer *buf,
+    NvDsBatchMeta *batch_meta, NvBufAudio *batch, const gboolean *active,
+    guint *num_windows, guint *num_skipped)
+{
+  NvDsActivityGateConfig *config = bin->config;
+  NvDsMetaType feature_type =
+      nvds_get_user_meta_type ((gchar *) NVDS_AUDIO_FEATURE_META_STRING);
+  GstBuffer *out = NULL;
+  NvDsBatchMeta *out_meta = NULL;
+  NvDsMetaList *l, *next;
+
+  for (l = batch_meta->batch_user_meta_list; l; l = next) {
+    NvDsUserMeta *user_meta = (NvDsUserMeta *) l->data;
+    NvDsAudioFeatureMeta *window = user_meta->user_meta_data;
+    NvDsAudioFrameMeta *frame_meta;
+    NvBufAudioParams *params;
+    guint batch_id = 0;
+
+    next = l->next;
+    if (user_meta->base_meta.meta_type != feature_type)
+      continue;
+    (*num_windows)++;
+    /* Skip only windows of sources that were quiet for a whole window, as
+     * long as the configured share of skipped windows is not exceeded. */
+    if (window->source_id >= MAX_SOURCE_BINS || active[window->source_id] ||
+        bin->windows_skipped + *num_skipped + 1 >
+        config->max_skip_fraction * (bin->windows + *num_windows))
+      continue;
+
+    if (!out) {
+      /* A source may complete several windows per batch. */
+      guint max_windows = g_list_length (batch_meta->batch_user_meta_list);
+      NvDsMeta *meta;
+
+      out = gst_buffer_new ();
+      out_meta = nvds_create_batch_meta (max_windows);
+      meta = gst_buffer_add_nvds_meta (out, out_meta, NULL,
+          nvds_batch_meta_copy_func, nvds_batch_meta_release_func);
+      meta->meta_type = NVDS_BATCH_GST_META;
+      out_meta->base_meta.batch_meta = out_meta;
+      out_meta->base_meta.copy_func = nvds_batch_meta_copy_func;
+      out_meta->base_meta.release_func = nvds_batch_meta_release_func;
+      out_meta->max_frames_in_batch = max_windows;
+      GST_BUFFER_PTS (out) = GST_BUFFER_PTS (buf);
+    }
+
+    params = find_source (batch, window->source_id, &batch_id);
+    frame_meta = nvds_acquire_audio_frame_meta_from_pool (out_meta);
+    frame_meta->pad_index = params ? params->padId : 0;
+    frame_meta->source_id = window->source_id;
+    frame_meta->batch_id = batch_id;
+    frame_meta->frame_num = (gint) window->window_num;
+    frame_meta->buf_pts = params ? params->bufPts : GST_BUFFER_PTS (buf);
+    frame_meta->ntp_timestamp = window->ntp_timestamp;
+    frame_meta->class_id = config->background_class_id;
+    frame_meta->confidence = 0.0f;
+    g_strlcpy (frame_meta->class_label, config->background_label ?
+        config->background_label : GATE_DEFAULT_BACKGROUND_LABEL,
+        MAX_LABEL_SIZE);
+    nvds_add_audio_frame_meta_to_audio_batch (out_meta, frame_meta);
+    nvds_audio_clock_attach (out_meta, frame_meta, window->gap, window->lag);
+
+    nvds_remove_user_meta_from_batch (batch_meta, user_meta);
+    (*num_skipped)++;
+  }
+  return out;
+}
+
+static GstPadProbeReturn
+activity_gate_buf_prob (GstPad *pad, GstPadProbeInfo *info, gpointer u_data)
+{
+  NvDsActivityGateBin *bin = (NvDsActivityGateBin *) u_data;
+  NvDsActivityGateConfig *config = bin->config;
+  NvDsBatchMeta *batch_meta;
+  GstBuffer *buf;
+  GstBuffer *out = NULL;
+  GstMapInfo map;
+  NvBufAudio *batch;
+  gboolean active[MAX_SOURCE_BINS] = { FALSE };
+  guint num_windows = 0, num_skipped = 0;
+  gint64 now;
+  guint i;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    if (GST_EVENT_TYPE ((GstEvent *) info->data) == GST_EVENT_EOS) {
+      GstPad *skip_pad = get_skip_pad (bin, pad);
+
+      print_activity_gate_stats (bin);
+      gst_pad_send_event (skip_pad, gst_event_new_eos ());
+      gst_object_unref (skip_pad);
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  buf = (GstBuffer *) info->data;
+  batch_meta = gst_buffer_get_nvds_batch_meta (buf);
+  if (!batch_meta || !gst_buffer_map (buf, &map, GST_MAP_READ))
+    return GST_PAD_PROBE_OK;
+  batch = (NvBufAudio *) map.data;
+
+  for (i = 0; i < batch->numFilled; i++) {
+    NvBufAudioParams *params = &batch->audioBuffers[i];
+    NvDsActivityGateSource *src;
+
+    if (params->sourceId >= MAX_SOURCE_BINS)
+      continue;
+    /* Remote mel sources carry placeholder samples only. */
+    if (nvds_remote_mel_source_is_registered (params->sourceId)) {
+      active[params->sourceId] = TRUE;
+      continue;
+    }
+    src = &bin->sources[params->sourceId];
+    if (g_atomic_int_compare_and_exchange (&src->reset, TRUE, FALSE))
+      memset (src, 0, sizeof (*src));
+    update_source (bin, src, params);
+    active[params->sourceId] = source_active (bin, src);
+  }
+
+  out = skip_quiet_windows (bin, buf, batch_meta, batch, active,
+      &num_windows, &num_skipped);
+  gst_buffer_unmap (buf, &map);
+
+  if (num_windows) {
+    bin->batches++;
+    bin->windows += num_windows;
+    bin->windows_skipped += num_skipped;
+    if (num_skipped == num_windows)
+      bin->batches_skipped++;
+  }
+  if (out) {
+    GstPad *skip_pad = get_skip_pad (bin, pad);
+
+    gst_pad_chain (skip_pad, out);
+    gst_object_unref (skip_pad);
+  }
+
+  now = g_get_monotonic_time ();
+  if (config->report_interval &&
+      now - bin->last_report >= config->report_interval * G_USEC_PER_SEC) {
+    print_activity_gate_stats (bin);
+    bin->last_report = now;
+  }
+
+  /* The buffer goes on even without windows: the classifiers keep their
+   * samples in order and release pending results. */
+  return GST_PAD_PROBE_OK;
+}
+
+void
+print_activity_gate_stats (NvDsActivityGateBin *bin)
+{
+  if (!bin->batches)
+    return;
+  g_print ("Activity gate: %" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT
+      " windows skipped (%.1f%%), %" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT
+      " batches with windows not inferred\n", bin->windows_skipped, bin->windows,
+      bin->windows ? 100.0 * bin->windows_skipped / bin->windows : 0.0,
+      bin->batches_skipped, bin->batches);
+}
+
+void
+nvds_activity_gate_reset_source (NvDsActivityGateBin *bin, guint source_id)
+{
+  if (source_id < MAX_SOURCE_BINS)
+    g_atomic_int_set (&bin->sources[source_id].reset, TRUE);
+}
+
+gboolean
+create_activity_gate_bin (NvDsActivityGateConfig *config,
+    NvDsActivityGateBin *bin)
+{
+  gboolean ret = FALSE;
+
+  if (!config->frame_size) {
+    NVGSTDS_ERR_MSG_V ("Invalid audio-framesize %u", config->frame_size);
+    goto done;
+  }
+  if (config->band_high > 0.0 && config->band_high <= config->band_low) {
+    NVGSTDS_ERR_MSG_V ("Activity band %.0f-%.0f Hz is empty",
+        config->band_low, config->band_high);
+    goto done;
+  }
+  bin->config = config;
+  bin->last_report = g_get_monotonic_time ();
+
+  bin->bin = gst_bin_new ("activity_gate_bin");
+  if (!bin->bin) {
+    NVGSTDS_ERR_MSG_V ("Failed to create 'activity_gate_bin'");
+    goto done;
+  }
+
+  bin->queue = gst_element_factory_make (NVDS_ELEM_QUEUE, "activity_queue");
+  if (!bin->queue) {
+    NVGSTDS_ERR_MSG_V ("Failed to create 'activity_queue'");
+    goto done;
+  }
+
+  bin->skip_queue = gst_element_factory_make (NVDS_ELEM_QUEUE,
+      "activity_skip_queue");
+  if (!bin->skip_queue) {
+    NVGSTDS_ERR_MSG_V ("Failed to create 'activity_skip_queue'");
+    goto done;
+  }
+
+  bin->funnel = gst_element_factory_make (NVDS_ELEM_FUNNEL,
+      "activity_gate_funnel");
+  if (!bin->funnel) {
+    NVGSTDS_ERR_MSG_V ("Failed to create 'activity_gate_funnel'");
+    goto done;
+  }
+
+  gst_bin_add_many (GST_BIN (bin->bin), bin->queue, bin->skip_queue, NULL);
+
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->queue, "src");
+
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->queue, "sink");
+
+  NVGSTDS_BIN_ADD_GHOST_PAD_NAMED (bin->bin, bin->skip_queue, "src",
+      "skip_src");
+
+  NVGSTDS_ELEM_ADD_PROBE (bin->probe_id, bin->queue, "src",
+      activity_gate_buf_prob,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, bin);
+
+  ret = TRUE;
+done:
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
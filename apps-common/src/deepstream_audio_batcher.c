@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "deepstream_common.h"
+#include "deepstream_config.h"
+#include "deepstream_audio_batcher.h"
+
+typedef struct
+{
+  NvDsAudioBatchItem *items;
+  guint num_items;
+} AudioBatch;
+
+struct _NvDsAudioBatcher
+{
+  guint max_batch_size;
+  gint64 deadline_us;
+  guint num_workers;
+  NvDsAudioBatchFunc func;
+  gpointer user_data;
+
+  GMutex lock;
+  GCond cond;
+  /** Queued NvDsAudioBatchItem of each source. */
+  GQueue queues[MAX_SOURCE_BINS];
+  guint num_queued;
+  /** Source the next batch starts with. */
+  guint next_source;
+  guint in_flight;
+  gboolean flushing;
+  gboolean stop;
+  GThread *thread;
+  GThreadPool *pool;
+
+  guint64 batches;
+  guint64 items;
+  guint64 full_batches;
+  guint64 deadline_batches;
+  gint64 total_wait;
+  gint64 max_wait;
+};
+
+static gint64
+oldest_queued_time (NvDsAudioBatcher *b)
+{
+  gint64 oldest = G_MAXINT64;
+  guint i;
+
+  for (i = 0; i < MAX_SOURCE_BINS; i++) {
+    NvDsAudioBatchItem *item = g_queue_peek_head (&b->queues[i]);
+
+    if (item && item->queued_time < oldest)
+      oldest = item->queued_time;
+  }
+  return oldest;
+}
+
+/** Take up to max_batch_size windows, one per source in turn. */
+static AudioBatch *
+take_batch (NvDsAudioBatcher *b, gint64 now)
+{
+  AudioBatch *batch = g_new (AudioBatch, 1);
+  guint n = MIN (b->num_queued, b->max_batch_size);
+  guint k = 0;
+
+  batch->items = g_new (NvDsAudioBatchItem, n);
+  batch->num_items = n;
+  while (k < n) {
+    NvDsAudioBatchItem *item = g_queue_pop_head (&b->queues[b->next_source]);
+
+    b->next_source = (b->next_source + 1) % MAX_SOURCE_BINS;
+    if (!item)
+      continue;
+    batch->items[k++] = *item;
+    b->total_wait += now - item->queued_time;
+    b->max_wait = MAX (b->max_wait, now - item->queued_time);
+    g_free (item);
+  }
+  b->num_queued -= n;
+  b->batches++;
+  b->items += n;
+  if (n == b->max_batch_size)
+    b->full_batches++;
+  else if (!b->flushing)
+    b->deadline_batches++;
+  return batch;
+}
+
+static gpointer
+batcher_thread_func (gpointer data)
+{
+  NvDsAudioBatcher *b = (NvDsAudioBatcher *) data;
+
+  g_mutex_lock (&b->lock);
+  while (!b->stop) {
+    gint64 now = g_get_monotonic_time ();
+    AudioBatch *batch;
+
+    if (!b->num_queued || b->in_flight >= b->num_workers) {
+      g_cond_wait (&b->cond, &b->lock);
+      continue;
+    }
+    if (b->num_queued < b->max_batch_size && !b->flushing) {
+      gint64 due = oldest_queued_time (b) + b->deadline_us;
+
+      if (now < due) {
+        g_cond_wait_until (&b->cond, &b->lock, due);
+        continue;
+      }
+    }
+
+    batch = take_batch (b, now);
+    b->in_flight++;
+    g_mutex_unlock (&b->lock);
+    g_thread_pool_push (b->pool, batch, NULL);
+    g_mutex_lock (&b->lock);
+  }
+  g_mutex_unlock (&b->lock);
+  return NULL;
+}
+
+static void
+batcher_worker_func (gpointer data, gpointer user_data)
+{
+  NvDsAudioBatcher *b = (NvDsAudioBatcher *) user_data;
+  AudioBatch *batch = (AudioBatch *) data;
+
+  b->func (batch->items, batch->num_items, b->user_data);
+  g_free (batch->items);
+  g_free (batch);
+
+  g_mutex_lock (&b->lock);
+  b->in_flight--;
+  g_cond_broadcast (&b->cond);
+  g_mutex_unlock (&b->lock);
+}
+
+NvDsAudioBatcher *
+nvds_audio_batcher_new (guint max_batch_size, gint64 deadline_us,
+    guint num_workers, NvDsAudioBatchFunc func, gpointer user_data)
+{
+  NvDsAudioBatcher *b = g_new0 (NvDsAudioBatcher, 1);
+  GError *error = NULL;
+  guint i;
+
+  b->max_batch_size = MAX (max_batch_size, 1);
+  b->deadline_us = MAX (deadline_us, 0);
+  b->num_workers = MAX (num_workers, 1);
+  b->func = func;
+  b->user_data = user_data;
+  g_mutex_init (&b->lock);
+  g_cond_init (&b->cond);
+  for (i = 0; i < MAX_SOURCE_BINS; i++)
+    g_queue_init (&b->queues[i]);
+
+  b->pool = g_thread_pool_new (batcher_worker_func, b, b->num_workers, TRUE,
+      &error);
+  if (!b->pool) {
+    NVGSTDS_ERR_MSG_V ("Failed to create batch workers: %s", error->message);
+    g_error_free (error);
+    g_mutex_clear (&b->lock);
+    g_cond_clear (&b->cond);
+    g_free (b);
+    return NULL;
+  }
+  b->thread = g_thread_new ("audio-batcher", batcher_thread_func, b);
+  return b;
+}
+
+void
+nvds_audio_batcher_free (NvDsAudioBatcher *batcher)
+{
+  if (!batcher)
+    return;
+  nvds_audio_batcher_flush (batcher);
+
+  g_mutex_lock (&batcher->lock);
+  batcher->stop = TRUE;
+  g_cond_broadcast (&batcher->cond);
+  g_mutex_unlock (&batcher->lock);
+  g_thread_join (batcher->thread);
+  g_thread_pool_free (batcher->pool, FALSE, TRUE);
+
+  g_mutex_clear (&batcher->lock);
+  g_cond_clear (&batcher->cond);
+  g_free (batcher);
+}
+
+void
+nvds_audio_batcher_push (NvDsAudioBatcher *batcher, guint source_id,
+    gpointer data)
+{
+  NvDsAudioBatchItem *item = g_new (NvDsAudioBatchItem, 1);
+
+  item->source_id = source_id;
+  item->queued_time = g_get_monotonic_time ();
+  item->data = data;
+
+  g_mutex_lock (&batcher->lock);
+  g_queue_push_tail (&batcher->queues[source_id % MAX_SOURCE_BINS], item);
+  batcher->num_queued++;
+  g_cond_broadcast (&batcher->cond);
+  g_mutex_unlock (&batcher->lock);
+}
+
+void
+nvds_audio_batcher_flush (NvDsAudioBatcher *batcher)
+{
+  g_mutex_lock (&batcher->lock);
+  batcher->flushing = TRUE;
+  g_cond_broadcast (&batcher->cond);
+  while (batcher->num_queued || batcher->in_flight)
+    g_cond_wait (&batcher->cond, &batcher->lock);
+  batcher->flushing = FALSE;
+  g_mutex_unlock (&batcher->lock);
+}
+
+void
+nvds_audio_batcher_print_stats (NvDsAudioBatcher *batcher, const gchar *name)
+{
+  g_mutex_lock (&batcher->lock);
+  if (batcher->batches) {
+    g_print ("%s: %" G_GUINT64_FORMAT " batches, %.1f%% occupancy of %u (%"
+        G_GUINT64_FORMAT " full, %" G_GUINT64_FORMAT " on deadline), queueing"
+        " latency mean %.1f ms, max %.1f ms\n", name, batcher->batches,
+        100.0 * batcher->items / (batcher->batches * batcher->max_batch_size),
+        batcher->max_batch_size, batcher->full_batches,
+        batcher->deadline_batches,
+        batcher->total_wait / 1e3 / batcher->items, batcher->max_wait / 1e3);
+  }
+  g_mutex_unlock (&batcher->lock);
+}
@@ -20,127 +20,1271 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
-#include <linux/limits.h> /* For PATH_MAX */
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "deepstream_common.h"
 #include "deepstream_audio_classifier.h"
+#include "deepstream_audio_batcher.h"
+#include "deepstream_audio_clock.h"
+#include "deepstream_audio_frontend.h"
+#include "deepstream_audio_topk.h"
+#include "deepstream_config_file_parser.h"
+#include "deepstream_cpu_infer.h"
+#include "nvbufaudio.h"
+
+/** Key file group and keys of the nvinfer config shared with plugin-type 2. */
+#define CPU_INFER_GROUP "property"
+#define CPU_INFER_LABELS "labelfile-path"
+#define CPU_INFER_THRESHOLD "classifier-threshold"
+#define CPU_INFER_SCALE "net-scale-factor"
+
+#define CHECK_ERROR(error) \
+    if (error) { \
+        NVGSTDS_ERR_MSG_V ("%s", error->message); \
+        goto done; \
+    }
+
+/** Network of a classifier of plugin-type 2 and the state derived from it,
+ *  replaced as a whole by a model swap. */
+typedef struct
+{
+  NvDsCpuNet *net;
+  gchar *path;
+  /** The network reads windows as num_frames x num_mels (time major) or
+   *  num_mels x num_frames. */
+  guint height;
+  guint width;
+  gboolean time_major;
+  guint num_classes;
+  GPtrArray *labels;
+  gfloat threshold;
+  gfloat scale_factor;
+  /** Idle workspaces, one per thread. */
+  GQueue workspaces;
+  gfloat *window;
+  /** streaming-layers only: streamed layers and the cached activations of
+   *  each source. */
+  guint streaming_layers;
+  NvDsCpuNetStream *streams[MAX_SOURCE_BINS];
+  gboolean mismatch;
+} CpuClassifierModel;
+
+typedef enum
+{
+  CPU_SWAP_IDLE,
+  CPU_SWAP_LOADING,
+  CPU_SWAP_READY,
+  CPU_SWAP_FAILED,
+} CpuSwapState;
+
+struct _NvDsCpuClassifier
+{
+  guint index;
+  /** Configuration the models are loaded with; the model and label paths
+   *  are owned copies of the current model's. */
+  NvDsGieConfig config;
+  CpuClassifierModel *model;
+  guint batch_size;
+  guint num_threads;
+  /** NULL for a single thread; batches then run in the streaming thread. */
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  guint pending;
+  /** batch-deadline-ms only: batches windows across buffers. */
+  NvDsAudioBatcher *batcher;
+  /** CpuClassifierResult of the batcher, attached to the next buffer. */
+  GQueue results;
+  /** Model swap: the loader thread loads the next model while the current
+   *  one keeps classifying; CpuSwapState. */
+  GThread *loader;
+  gint swap_state;
+  CpuClassifierModel *next;
+  gchar *next_model_file;
+  gchar *next_label_file;
+  gint64 swap_start;
+  gint64 load_time;
+  /** Stream statistics of the replaced models. */
+  NvDsCpuNetStreamStats stream_stats;
+  guint64 windows;
+  guint64 batches;
+  gint64 busy_time;
+  gint64 start_time;
+  /** Network runs and their time by number of windows, 1 .. batch_size. */
+  guint64 *size_runs;
+  gint64 *size_time;
+};
+
+typedef struct
+{
+  const gfloat *input;
+  gfloat *output;
+  guint num_windows;
+  /** streaming-layers only: stream and first column of each window. */
+  NvDsCpuNetStream **streams;
+  const guint64 *positions;
+} CpuClassifierJob;
+
+/** Window queued in the batcher. */
+typedef struct
+{
+  guint source_id;
+  guint64 window_num;
+  guint64 ntp_timestamp;
+  gboolean gap;
+  gint64 lag;
+  gfloat input[];
+} CpuClassifierWindow;
+
+typedef struct
+{
+  guint source_id;
+  guint64 window_num;
+  guint64 ntp_timestamp;
+  /** Clock of the window, see @ref NvDsAudioClockMeta. */
+  gboolean gap;
+  gint64 lag;
+  gint class_id;
+  gfloat confidence;
+  /** Label of the model that produced the result. */
+  gchar label[MAX_LABEL_SIZE];
+  /** top-k only: best classes and a reference to the labels of the
+   *  model. */
+  NvDsAudioTopKEntry topk[NVDS_AUDIO_TOPK_MAX];
+  guint num_topk;
+  GPtrArray *labels;
+} CpuClassifierResult;
 
 static void
 write_infer_output_to_file (GstBuffer *buf,
     NvDsInferNetworkInfo *network_info,  NvDsInferLayerInfo *layers_info,
     guint num_layers, guint batch_size, gpointer user_data)
 {
-  NvDsGieConfig *config = (NvDsGieConfig *) user_data;
+  nvds_raw_recorder_write ((NvDsRawRecorder *) user_data, buf, layers_info,
+      num_layers, batch_size);
+}
+
+/**
+ * Run @p num_windows inputs on one of the idle workspaces, reusing the
+ * activations of @p streams if not NULL.
+ */
+static void
+run_cpu_network (NvDsCpuClassifier *cpu, const gfloat *input,
+    NvDsCpuNetStream **streams, const guint64 *positions, guint num_windows,
+    gfloat *output)
+{
+  CpuClassifierModel *model = cpu->model;
+  NvDsCpuNetWorkspace *ws;
+  gint64 start = g_get_monotonic_time ();
+  guint size = MIN (num_windows, cpu->batch_size);
+
+  g_mutex_lock (&cpu->lock);
+  ws = g_queue_pop_head (&model->workspaces);
+  g_mutex_unlock (&cpu->lock);
+
+  if (streams) {
+    nvds_cpu_net_run_streams (model->net, ws, streams, positions, input,
+        num_windows, output);
+  } else {
+    nvds_cpu_net_run (model->net, ws, input, num_windows, output);
+  }
+
+  g_mutex_lock (&cpu->lock);
+  g_queue_push_head (&model->workspaces, ws);
+  cpu->size_runs[size]++;
+  cpu->size_time[size] += g_get_monotonic_time () - start;
+  g_mutex_unlock (&cpu->lock);
+}
+
+/** Run a job in batches of batch-size; the windows of a source in order. */
+static void
+run_cpu_classifier_job (NvDsCpuClassifier *cpu, CpuClassifierJob *job)
+{
+  gsize input_size = (gsize) cpu->model->height * cpu->model->width;
+  guint first;
+
+  for (first = 0; first < job->num_windows; first += cpu->batch_size) {
+    run_cpu_network (cpu, job->input + first * input_size,
+        job->streams ? job->streams + first : NULL,
+        job->positions ? job->positions + first : NULL,
+        MIN (cpu->batch_size, job->num_windows - first),
+        job->output + (gsize) first * cpu->model->num_classes);
+  }
+
+  g_mutex_lock (&cpu->lock);
+  if (!--cpu->pending)
+    g_cond_signal (&cpu->cond);
+  g_mutex_unlock (&cpu->lock);
+}
+
+static void
+cpu_classifier_thread_func (gpointer data, gpointer user_data)
+{
+  run_cpu_classifier_job ((NvDsCpuClassifier *) user_data,
+      (CpuClassifierJob *) data);
+}
+
+static void
+count_cpu_batches (NvDsCpuClassifier *cpu, guint num_windows,
+    guint num_batches, gint64 busy_time)
+{
+  g_mutex_lock (&cpu->lock);
+  cpu->windows += num_windows;
+  cpu->batches += num_batches;
+  cpu->busy_time += busy_time;
+  g_mutex_unlock (&cpu->lock);
+}
+
+/**
+ * Copy one feature window into the network input, converting it to FP32
+ * and to the layout of the network.
+ */
+static gboolean
+cpu_classifier_fill_input (NvDsCpuClassifier *cpu, NvDsAudioFeatureMeta *meta,
+    gfloat *input)
+{
+  CpuClassifierModel *model = cpu->model;
+  guint num_values = meta->num_frames * meta->num_mels;
+  guint f, m;
+
+  if (model->height * model->width != num_values ||
+      (model->time_major ? model->height : model->width) !=
+      meta->num_frames) {
+    if (!model->mismatch) {
+      NVGSTDS_WARN_MSG_V ("CPU classifier %u: %u x %u feature windows don't"
+          " match the network input %u x %u; windows skipped", cpu->index,
+          meta->num_frames, meta->num_mels, model->height, model->width);
+      model->mismatch = TRUE;
+    }
+    return FALSE;
+  }
+
+  nvds_audio_tensor_unpack (meta->format, meta->data, num_values, meta->scale,
+      meta->zero_point, model->time_major ? input : model->window);
+  if (!model->time_major) {
+    for (f = 0; f < meta->num_frames; f++) {
+      for (m = 0; m < meta->num_mels; m++)
+        input[m * meta->num_frames + f] =
+            model->window[f * meta->num_mels + m];
+    }
+  }
+  if (model->scale_factor != 1.0f) {
+    for (f = 0; f < num_values; f++)
+      input[f] *= model->scale_factor;
+  }
+  return TRUE;
+}
+
+/** Result like nvinferaudio's: top class above classifier-threshold, else
+ *  class -1 without label. With top-k the best classes are kept as well;
+ *  free with clear_cpu_classifier_result(). */
+static void
+cpu_classifier_get_result (NvDsCpuClassifier *cpu, const gfloat *scores,
+    CpuClassifierResult *result)
+{
+  CpuClassifierModel *model = cpu->model;
+  guint best = 0;
+  guint i;
+
+  for (i = 1; i < model->num_classes; i++) {
+    if (scores[i] > scores[best])
+      best = i;
+  }
+  result->confidence = scores[best];
+  result->class_id = scores[best] >= model->threshold ? (gint) best : -1;
+  if (result->class_id >= 0 && model->labels &&
+      (guint) result->class_id < model->labels->len) {
+    g_strlcpy (result->label, g_ptr_array_index (model->labels,
+            result->class_id), MAX_LABEL_SIZE);
+  } else {
+    result->label[0] = '\0';
+  }
+
+  result->num_topk = 0;
+  result->labels = NULL;
+  if (cpu->config.top_k) {
+    result->num_topk = nvds_audio_topk_select (scores, model->num_classes,
+        cpu->config.top_k, cpu->config.top_k_threshold, result->topk);
+    if (model->labels)
+      result->labels = g_ptr_array_ref (model->labels);
+  }
+}
+
+static void
+clear_cpu_classifier_result (CpuClassifierResult *result)
+{
+  if (result->labels)
+    g_ptr_array_unref (result->labels);
+  result->labels = NULL;
+}
+
+static void
+free_cpu_classifier_result (CpuClassifierResult *result)
+{
+  clear_cpu_classifier_result (result);
+  g_free (result);
+}
+
+/** @p batch may be NULL for buffers without audio. */
+static void
+cpu_classifier_attach_result (NvDsCpuClassifier *cpu,
+    NvDsBatchMeta *batch_meta, NvBufAudio *batch,
+    const CpuClassifierResult *result)
+{
+  NvDsAudioFrameMeta *frame_meta =
+      nvds_acquire_audio_frame_meta_from_pool (batch_meta);
   guint i;
 
-  /* "gst_buffer_get_nvstream_meta()" can be called on the GstBuffer to get more
-   * information about the buffer.*/
-
-  for (i = 0; i < num_layers; i++) {
-    NvDsInferLayerInfo *info = &layers_info[i];
-    guint element_size = 0;
-    guint j;
-    FILE *file;
-    gchar file_name[PATH_MAX];
-    gchar layer_name[128];
-
-    switch (info->dataType) {
-      case FLOAT: element_size = 4; break;
-      case HALF: element_size = 2; break;
-      case INT32: element_size = 4; break;
-      case INT8: element_size = 1; break;
+  for (i = 0; batch && i < batch->numFilled; i++) {
+    if (batch->audioBuffers[i].sourceId == result->source_id) {
+      frame_meta->pad_index = batch->audioBuffers[i].padId;
+      frame_meta->batch_id = i;
+      frame_meta->buf_pts = batch->audioBuffers[i].bufPts;
+      break;
     }
+  }
+  frame_meta->source_id = result->source_id;
+  frame_meta->frame_num = (gint) result->window_num;
+  frame_meta->ntp_timestamp = result->ntp_timestamp;
+  frame_meta->confidence = result->confidence;
+  frame_meta->class_id = result->class_id;
+  g_strlcpy (frame_meta->class_label, result->label, MAX_LABEL_SIZE);
+  nvds_add_audio_frame_meta_to_audio_batch (batch_meta, frame_meta);
+  nvds_audio_clock_attach (batch_meta, frame_meta, result->gap, result->lag);
+  if (cpu->config.top_k) {
+    nvds_audio_topk_attach (batch_meta, frame_meta, result->topk,
+        result->num_topk, result->labels);
+  }
+}
+
+/** Attach the results the batcher finished since the last buffer. */
+static void
+attach_pending_results (NvDsCpuClassifier *cpu, NvDsBatchMeta *batch_meta,
+    NvBufAudio *batch)
+{
+  GQueue results;
+  CpuClassifierResult *result;
+
+  g_mutex_lock (&cpu->lock);
+  results = cpu->results;
+  g_queue_init (&cpu->results);
+  g_mutex_unlock (&cpu->lock);
+
+  while ((result = g_queue_pop_head (&results))) {
+    cpu_classifier_attach_result (cpu, batch_meta, batch, result);
+    free_cpu_classifier_result (result);
+  }
+}
+
+/** Push the results still pending at EOS in a buffer of their own. */
+static void
+push_pending_results (NvDsCpuClassifier *cpu, GstPad *pad)
+{
+  GstBuffer *out;
+  NvDsBatchMeta *batch_meta;
+  NvDsMeta *meta;
+  guint num_results;
+
+  g_mutex_lock (&cpu->lock);
+  num_results = g_queue_get_length (&cpu->results);
+  g_mutex_unlock (&cpu->lock);
+  if (!num_results)
+    return;
+
+  out = gst_buffer_new ();
+  batch_meta = nvds_create_batch_meta (num_results);
+  meta = gst_buffer_add_nvds_meta (out, batch_meta, NULL,
+      nvds_batch_meta_copy_func, nvds_batch_meta_release_func);
+  meta->meta_type = NVDS_BATCH_GST_META;
+  batch_meta->base_meta.batch_meta = batch_meta;
+  batch_meta->base_meta.copy_func = nvds_batch_meta_copy_func;
+  batch_meta->base_meta.release_func = nvds_batch_meta_release_func;
+  batch_meta->max_frames_in_batch = num_results;
+
+  attach_pending_results (cpu, batch_meta, NULL);
+  gst_pad_push (pad, out);
+}
+
+/** Batch function of the batcher, run on the inference threads. */
+static void
+cpu_classifier_run_batch (NvDsAudioBatchItem *items, guint num_items,
+    gpointer user_data)
+{
+  NvDsCpuClassifier *cpu = (NvDsCpuClassifier *) user_data;
+  gsize input_size = (gsize) cpu->model->height * cpu->model->width;
+  gfloat *input = g_new (gfloat, num_items * input_size);
+  gfloat *output = g_new (gfloat, (gsize) num_items * cpu->model->num_classes);
+  gint64 start = g_get_monotonic_time ();
+  GQueue results;
+  guint i;
+
+  for (i = 0; i < num_items; i++) {
+    CpuClassifierWindow *window = items[i].data;
+
+    memcpy (input + i * input_size, window->input,
+        input_size * sizeof (gfloat));
+  }
+  run_cpu_network (cpu, input, NULL, NULL, num_items, output);
+
+  g_queue_init (&results);
+  for (i = 0; i < num_items; i++) {
+    CpuClassifierWindow *window = items[i].data;
+    CpuClassifierResult *result = g_new (CpuClassifierResult, 1);
+
+    result->source_id = window->source_id;
+    result->window_num = window->window_num;
+    result->ntp_timestamp = window->ntp_timestamp;
+    result->gap = window->gap;
+    result->lag = window->lag;
+    cpu_classifier_get_result (cpu,
+        output + (gsize) i * cpu->model->num_classes, result);
+    g_queue_push_tail (&results, result);
+    g_free (window);
+  }
+  count_cpu_batches (cpu, num_items, 1, g_get_monotonic_time () - start);
+
+  g_mutex_lock (&cpu->lock);
+  while (!g_queue_is_empty (&results))
+    g_queue_push_tail (&cpu->results, g_queue_pop_head (&results));
+  g_mutex_unlock (&cpu->lock);
+
+  g_free (output);
+  g_free (input);
+}
+
+/** Add the stream statistics of all sources of @p model to @p total. */
+static void
+add_stream_stats (NvDsCpuNetStreamStats *total, CpuClassifierModel *model)
+{
+  guint i;
+
+  for (i = 0; i < MAX_SOURCE_BINS; i++) {
+    const NvDsCpuNetStreamStats *stats;
+
+    if (!model->streams[i])
+      continue;
+    stats = nvds_cpu_net_stream_get_stats (model->streams[i]);
+    total->windows += stats->windows;
+    total->reused += stats->reused;
+    total->steps += stats->steps;
+    total->steps_computed += stats->steps_computed;
+  }
+}
+
+static void
+print_cpu_classifier_stats (NvDsCpuClassifier *cpu)
+{
+  gdouble elapsed;
+  gchar name[32];
+  guint i;
+
+  if (!cpu->windows)
+    return;
+  elapsed = (g_get_monotonic_time () - cpu->start_time) / 1e6;
+  g_print ("CPU classifier %u: %" G_GUINT64_FORMAT " windows in %"
+      G_GUINT64_FORMAT " batches of up to %u on %u threads, %.1f windows/s"
+      " while busy (%.1f windows/s overall), %.1f ms per window\n",
+      cpu->index, cpu->windows, cpu->batches, cpu->batch_size,
+      cpu->num_threads, cpu->windows * 1e6 / MAX (cpu->busy_time, 1),
+      elapsed > 0 ? cpu->windows / elapsed : 0.0,
+      cpu->busy_time / 1e3 / cpu->windows);
+  /* A run only computes the windows it holds; partly filled batches cost
+   * less than full ones. */
+  for (i = 1; i <= cpu->batch_size; i++) {
+    if (!cpu->size_runs[i])
+      continue;
+    g_print ("  batch of %u: %" G_GUINT64_FORMAT " runs, %.2f ms per run,"
+        " %.2f ms per window\n", i, cpu->size_runs[i],
+        cpu->size_time[i] / 1e3 / cpu->size_runs[i],
+        cpu->size_time[i] / 1e3 / cpu->size_runs[i] / i);
+  }
+  if (cpu->batcher) {
+    g_snprintf (name, sizeof (name), "CPU classifier %u batcher", cpu->index);
+    nvds_audio_batcher_print_stats (cpu->batcher, name);
+  }
+  if (cpu->stream_stats.windows || cpu->model->streaming_layers) {
+    NvDsCpuNetStreamStats total = cpu->stream_stats;
 
-    g_strlcpy (layer_name, info->layerName, 128);
-    for (j = 0; layer_name[j] != '\0'; j++) {
-      layer_name[j] = (layer_name[j] == '/') ? '_' : layer_name[j];
+    add_stream_stats (&total, cpu->model);
+    g_print ("CPU classifier %u: %.1f%% of the windows reused activations of"
+        " the previous window, %.1f%% of the time steps of %u streamed layers"
+        " computed\n", cpu->index,
+        total.reused * 100.0 / MAX (total.windows, 1),
+        total.steps_computed * 100.0 / MAX (total.steps, 1),
+        cpu->model->streaming_layers);
+  }
+}
+
+/** Orders windows by source, then by window number. */
+static gint
+compare_feature_windows (gconstpointer a, gconstpointer b)
+{
+  const NvDsAudioFeatureMeta *wa = *(NvDsAudioFeatureMeta * const *) a;
+  const NvDsAudioFeatureMeta *wb = *(NvDsAudioFeatureMeta * const *) b;
+
+  if (wa->source_id != wb->source_id)
+    return wa->source_id < wb->source_id ? -1 : 1;
+  if (wa->window_num != wb->window_num)
+    return wa->window_num < wb->window_num ? -1 : 1;
+  return 0;
+}
+
+/** Stream of a source, created on its first window. */
+static NvDsCpuNetStream *
+get_source_stream (NvDsCpuClassifier *cpu, guint source_id)
+{
+  CpuClassifierModel *model = cpu->model;
+
+  if (source_id >= MAX_SOURCE_BINS)
+    return NULL;
+  if (!model->streams[source_id])
+    model->streams[source_id] = nvds_cpu_net_stream_new (model->net);
+  return model->streams[source_id];
+}
+
+/** Queue the windows of a buffer in the batcher. */
+static void
+queue_cpu_windows (NvDsCpuClassifier *cpu, NvDsBatchMeta *batch_meta,
+    NvDsMetaType feature_type)
+{
+  gsize input_size = (gsize) cpu->model->height * cpu->model->width;
+  NvDsMetaList *l;
+
+  for (l = batch_meta->batch_user_meta_list; l; l = l->next) {
+    NvDsUserMeta *user_meta = (NvDsUserMeta *) l->data;
+    NvDsAudioFeatureMeta *meta = user_meta->user_meta_data;
+    CpuClassifierWindow *window;
+
+    if (user_meta->base_meta.meta_type != feature_type)
+      continue;
+    window = g_malloc (sizeof (CpuClassifierWindow) +
+        input_size * sizeof (gfloat));
+    if (!cpu_classifier_fill_input (cpu, meta, window->input)) {
+      g_free (window);
+      continue;
     }
+    window->source_id = meta->source_id;
+    window->window_num = meta->window_num;
+    window->ntp_timestamp = meta->ntp_timestamp;
+    window->gap = meta->gap;
+    window->lag = meta->lag;
+    nvds_audio_batcher_push (cpu->batcher, meta->source_id, window);
+  }
+}
 
-    g_snprintf (file_name, PATH_MAX,
-        "%s/%s_batch%010lu_batchsize%02d.bin",
-        config->raw_output_directory, layer_name,
-        config->file_write_frame_num, batch_size);
-    file_name[PATH_MAX -  1] = '\0';
+/**
+ * Load the labels of labelfile-path of the [audio-classifier] group, else of
+ * the nvinfer config file @p key_file. @p labels is left NULL if neither
+ * names one.
+ */
+static gboolean
+load_classifier_labels (NvDsGieConfig *config, GKeyFile *key_file,
+    GPtrArray **labels)
+{
+  gchar *cfg_path = GET_FILE_PATH (config->config_file_path);
+  gchar *labels_path = NULL;
+  GError *error = NULL;
+  gboolean ret = FALSE;
 
-    file = fopen (file_name, "w");
-    if (!file) {
-      g_printerr ("Could not open file '%s' for writing:%s\n",
-          file_name, strerror(errno));
+  *labels = NULL;
+  if (config->label_file_path) {
+    labels_path = g_strdup (GET_FILE_PATH (config->label_file_path));
+  } else if (g_key_file_has_key (key_file, CPU_INFER_GROUP,
+          CPU_INFER_LABELS, NULL)) {
+    labels_path = get_absolute_file_path (cfg_path,
+        g_key_file_get_string (key_file, CPU_INFER_GROUP, CPU_INFER_LABELS,
+            &error));
+    CHECK_ERROR (error);
+  }
+  if (labels_path) {
+    *labels = nvds_audio_labels_load (labels_path);
+    if (!*labels)
+      goto done;
+  }
+
+  ret = TRUE;
+done:
+  if (error) {
+    g_error_free (error);
+  }
+  g_free (labels_path);
+  return ret;
+}
+
+/**
+ * Read classifier-threshold, net-scale-factor and the labels from the
+ * nvinfer config file, so both backends report the same results. A
+ * labelfile-path of the [audio-classifier] group takes precedence.
+ */
+static gboolean
+load_cpu_classifier_config (NvDsGieConfig *config, CpuClassifierModel *model)
+{
+  GKeyFile *key_file = g_key_file_new ();
+  gchar *cfg_path = GET_FILE_PATH (config->config_file_path);
+  GError *error = NULL;
+  gboolean ret = FALSE;
+
+  model->threshold = 0.0f;
+  model->scale_factor = 1.0f;
+
+  if (!g_key_file_load_from_file (key_file, cfg_path, G_KEY_FILE_NONE,
+          &error)) {
+    NVGSTDS_ERR_MSG_V ("Failed to load '%s': %s", cfg_path, error->message);
+    goto done;
+  }
+  if (g_key_file_has_key (key_file, CPU_INFER_GROUP, CPU_INFER_THRESHOLD,
+          NULL)) {
+    model->threshold = g_key_file_get_double (key_file, CPU_INFER_GROUP,
+        CPU_INFER_THRESHOLD, &error);
+    CHECK_ERROR (error);
+  }
+  if (g_key_file_has_key (key_file, CPU_INFER_GROUP, CPU_INFER_SCALE, NULL)) {
+    model->scale_factor = g_key_file_get_double (key_file, CPU_INFER_GROUP,
+        CPU_INFER_SCALE, &error);
+    CHECK_ERROR (error);
+  }
+
+  if (!load_classifier_labels (config, key_file, &model->labels))
+    goto done;
+
+  ret = TRUE;
+done:
+  if (error) {
+    g_error_free (error);
+  }
+  g_key_file_free (key_file);
+  return ret;
+}
+
+static void
+free_cpu_classifier_model (CpuClassifierModel *model)
+{
+  guint i;
+
+  if (!model)
+    return;
+  while (!g_queue_is_empty (&model->workspaces))
+    nvds_cpu_net_workspace_free (g_queue_pop_head (&model->workspaces));
+  for (i = 0; i < MAX_SOURCE_BINS; i++)
+    nvds_cpu_net_stream_free (model->streams[i]);
+  nvds_cpu_net_free (model->net);
+  if (model->labels)
+    g_ptr_array_unref (model->labels);
+  g_free (model->window);
+  g_free (model->path);
+  g_free (model);
+}
+
+/**
+ * Load the network of @p config with its labels and workspaces for the
+ * threads of @p cpu, and check it against the feature windows of the
+ * front-end.
+ */
+static CpuClassifierModel *
+load_cpu_classifier_model (NvDsCpuClassifier *cpu, NvDsGieConfig *config)
+{
+  CpuClassifierModel *model = g_new0 (CpuClassifierModel, 1);
+  NvDsAudioTransformParams params;
+  guint channels, num_frames, i;
+  gboolean ret = FALSE;
+
+  model->path = g_strdup (GET_FILE_PATH (config->model_engine_file_path));
+  model->net = nvds_cpu_net_load (model->path);
+  if (!model->net)
+    goto done;
+  if (!load_cpu_classifier_config (config, model))
+    goto done;
+
+  /** Same window as nvinferaudio: audio-framesize samples of the
+   *  audio-transform, one channel. */
+  if (!nvds_audio_transform_params_parse (config->audio_transform, &params))
+    goto done;
+  num_frames = nvds_audio_transform_num_frames (&params, config->frame_size);
+  nvds_cpu_net_get_input_dims (model->net, &channels, &model->height,
+      &model->width);
+  model->time_major = model->height == num_frames &&
+      model->width == params.num_mels;
+  if (channels != 1 || (!model->time_major &&
+          !(model->height == params.num_mels && model->width == num_frames))) {
+    NVGSTDS_ERR_MSG_V ("Network input %u x %u x %u doesn't match %u mels x %u"
+        " frames", channels, model->height, model->width, params.num_mels,
+        num_frames);
+    goto done;
+  }
+  model->num_classes = nvds_cpu_net_get_output_size (model->net);
+  if (model->labels && model->labels->len != model->num_classes) {
+    NVGSTDS_WARN_MSG_V ("CPU classifier %u: %u labels for %u classes",
+        cpu->index, model->labels->len, model->num_classes);
+  }
+
+  /* The batcher may run consecutive windows of a source on different
+   * threads at once, so their activations can't be passed on. */
+  if (config->streaming_layers && config->batch_deadline_ms) {
+    NVGSTDS_WARN_MSG_V ("CPU classifier %u: streaming-layers is ignored with"
+        " batch-deadline-ms", cpu->index);
+  } else if (config->streaming_layers) {
+    model->streaming_layers = nvds_cpu_net_enable_streaming (model->net,
+        !model->time_major, config->streaming_layers);
+    if (model->streaming_layers) {
+      NVGSTDS_INFO_MSG_V ("CPU classifier %u: streaming %u layers, %.1f MB"
+          " cached per source", cpu->index, model->streaming_layers,
+          nvds_cpu_net_get_stream_size (model->net) / 1048576.0);
+    } else {
+      NVGSTDS_WARN_MSG_V ("CPU classifier %u: the first layer can't be"
+          " streamed; streaming-layers ignored", cpu->index);
+    }
+  }
+
+  for (i = 0; i < cpu->num_threads; i++) {
+    g_queue_push_head (&model->workspaces,
+        nvds_cpu_net_workspace_new (model->net, cpu->batch_size));
+  }
+  model->window = g_new (gfloat, (gsize) model->height * model->width);
+
+  ret = TRUE;
+done:
+  if (!ret) {
+    free_cpu_classifier_model (model);
+    model = NULL;
+  }
+  return model;
+}
+
+static gpointer
+cpu_classifier_loader_func (gpointer data)
+{
+  NvDsCpuClassifier *cpu = (NvDsCpuClassifier *) data;
+  NvDsGieConfig config = cpu->config;
+  gint64 start = g_get_monotonic_time ();
+
+  config.model_engine_file_path = cpu->next_model_file;
+  config.label_file_path = cpu->next_label_file;
+  cpu->next = load_cpu_classifier_model (cpu, &config);
+  cpu->load_time = g_get_monotonic_time () - start;
+  g_atomic_int_set (&cpu->swap_state,
+      cpu->next ? CPU_SWAP_READY : CPU_SWAP_FAILED);
+  return NULL;
+}
+
+/**
+ * Switch to the loaded model between two buffers, when no batch of the
+ * current model runs. Windows queued in the batcher are classified by the
+ * current model first; all later windows by the new one.
+ */
+static void
+finish_cpu_model_swap (NvDsCpuClassifier *cpu)
+{
+  CpuClassifierModel *old = cpu->model;
+  gint64 start = g_get_monotonic_time ();
+  gint64 switched;
+  GThread *loader;
+
+  g_mutex_lock (&cpu->lock);
+  loader = cpu->loader;
+  cpu->loader = NULL;
+  g_mutex_unlock (&cpu->lock);
+  g_thread_join (loader);
+
+  if (g_atomic_int_get (&cpu->swap_state) == CPU_SWAP_FAILED) {
+    NVGSTDS_ERR_MSG_V ("CPU classifier %u: failed to load '%s'; keeping '%s'",
+        cpu->index, cpu->next_model_file, old->path);
+    g_free (cpu->next_model_file);
+    g_free (cpu->next_label_file);
+  } else {
+    if (cpu->batcher)
+      nvds_audio_batcher_flush (cpu->batcher);
+    cpu->model = cpu->next;
+    switched = g_get_monotonic_time ();
+
+    g_free (cpu->config.model_engine_file_path);
+    g_free (cpu->config.label_file_path);
+    cpu->config.model_engine_file_path = cpu->next_model_file;
+    cpu->config.label_file_path = cpu->next_label_file;
+    add_stream_stats (&cpu->stream_stats, old);
+    free_cpu_classifier_model (old);
+
+    NVGSTDS_INFO_MSG_V ("CPU classifier %u: swapped to '%s' %.1f ms after the"
+        " request; loaded in %.1f ms, switched in %.2f ms, old model released"
+        " in %.2f ms", cpu->index, cpu->model->path,
+        (switched - cpu->swap_start) / 1e3, cpu->load_time / 1e3,
+        (switched - start) / 1e3, (g_get_monotonic_time () - switched) / 1e3);
+  }
+  cpu->next = NULL;
+  cpu->next_model_file = NULL;
+  cpu->next_label_file = NULL;
+  g_atomic_int_set (&cpu->swap_state, CPU_SWAP_IDLE);
+}
+
+/** Start loading a new model of a running classifier of plugin-type 2. */
+static gboolean
+swap_cpu_classifier_model (NvDsCpuClassifier *cpu,
+    const gchar *model_engine_file, const gchar *label_file)
+{
+  if (g_atomic_int_get (&cpu->swap_state) != CPU_SWAP_IDLE) {
+    NVGSTDS_WARN_MSG_V ("CPU classifier %u: a model swap is in progress",
+        cpu->index);
+    return FALSE;
+  }
+
+  cpu->next_model_file = g_strdup (model_engine_file ? model_engine_file :
+      cpu->config.model_engine_file_path);
+  cpu->next_label_file = g_strdup (label_file ? label_file :
+      cpu->config.label_file_path);
+  cpu->swap_start = g_get_monotonic_time ();
+  g_atomic_int_set (&cpu->swap_state, CPU_SWAP_LOADING);
+  NVGSTDS_INFO_MSG_V ("CPU classifier %u: loading '%s'", cpu->index,
+      GET_FILE_PATH (cpu->next_model_file));
+
+  /* The probe takes the thread once the model is loaded. */
+  g_mutex_lock (&cpu->lock);
+  cpu->loader = g_thread_new ("cpu-model-loader", cpu_classifier_loader_func,
+      cpu);
+  g_mutex_unlock (&cpu->lock);
+  return TRUE;
+}
+
+/**
+ * Classify the feature windows attached by the audio front-end. With
+ * batch-deadline-ms the windows go to the batcher and every buffer carries
+ * the results finished so far. Otherwise the windows of a buffer are split
+ * into batches of batch-size, which run in parallel on the inference
+ * threads; the buffer is passed on once all are done. With streaming-layers
+ * all windows of a source go to the same thread, in order.
+ */
+static GstPadProbeReturn
+cpu_classifier_buf_prob (GstPad *pad, GstPadProbeInfo *info, gpointer u_data)
+{
+  NvDsCpuClassifier *cpu = (NvDsCpuClassifier *) u_data;
+  NvDsMetaType feature_type =
+      nvds_get_user_meta_type ((gchar *) NVDS_AUDIO_FEATURE_META_STRING);
+  CpuClassifierModel *model;
+  guint input_size, num_classes;
+  NvDsAudioFeatureMeta **metas;
+  CpuClassifierResult result;
+  CpuClassifierJob *jobs;
+  NvDsCpuNetStream **streams = NULL;
+  guint64 *positions = NULL;
+  NvDsBatchMeta *batch_meta;
+  NvDsMetaList *l;
+  GstBuffer *buf;
+  GstMapInfo map;
+  gfloat *input, *output;
+  guint num_metas, num_windows = 0, num_jobs = 0, num_batches = 0, first, i;
+  gint64 start;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    if (GST_EVENT_TYPE ((GstEvent *) info->data) == GST_EVENT_EOS) {
+      if (cpu->batcher) {
+        nvds_audio_batcher_flush (cpu->batcher);
+        push_pending_results (cpu, pad);
+      }
+      print_cpu_classifier_stats (cpu);
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  buf = (GstBuffer *) info->data;
+  batch_meta = gst_buffer_get_nvds_batch_meta (buf);
+  if (!batch_meta)
+    return GST_PAD_PROBE_OK;
+
+  /* No batch runs between two buffers. */
+  if (g_atomic_int_get (&cpu->swap_state) >= CPU_SWAP_READY)
+    finish_cpu_model_swap (cpu);
+  model = cpu->model;
+  input_size = model->height * model->width;
+  num_classes = model->num_classes;
+
+  start = g_get_monotonic_time ();
+  if (!cpu->start_time)
+    cpu->start_time = start;
+
+  if (cpu->batcher) {
+    queue_cpu_windows (cpu, batch_meta, feature_type);
+    if (gst_buffer_map (buf, &map, GST_MAP_READ)) {
+      attach_pending_results (cpu, batch_meta, (NvBufAudio *) map.data);
+      gst_buffer_unmap (buf, &map);
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  for (l = batch_meta->batch_user_meta_list; l; l = l->next) {
+    if (((NvDsUserMeta *) l->data)->base_meta.meta_type == feature_type)
+      num_windows++;
+  }
+  if (!num_windows || !gst_buffer_map (buf, &map, GST_MAP_READ))
+    return GST_PAD_PROBE_OK;
+
+  metas = g_new (NvDsAudioFeatureMeta *, num_windows);
+  input = g_new (gfloat, (gsize) num_windows * input_size);
+  output = g_new (gfloat, (gsize) num_windows * num_classes);
+  num_windows = 0;
+  for (l = batch_meta->batch_user_meta_list; l; l = l->next) {
+    NvDsUserMeta *user_meta = (NvDsUserMeta *) l->data;
+
+    if (user_meta->base_meta.meta_type == feature_type)
+      metas[num_windows++] = user_meta->user_meta_data;
+  }
+  if (model->streaming_layers) {
+    qsort (metas, num_windows, sizeof (NvDsAudioFeatureMeta *),
+        compare_feature_windows);
+    streams = g_new (NvDsCpuNetStream *, num_windows);
+    positions = g_new (guint64, num_windows);
+  }
+  num_metas = num_windows;
+  num_windows = 0;
+  for (i = 0; i < num_metas; i++) {
+    NvDsCpuNetStream *stream = NULL;
+
+    if (streams) {
+      stream = get_source_stream (cpu, metas[i]->source_id);
+      if (!stream)
+        continue;
+    }
+    if (!cpu_classifier_fill_input (cpu, metas[i],
+            input + (gsize) num_windows * input_size))
       continue;
+    if (streams) {
+      streams[num_windows] = stream;
+      positions[num_windows] = metas[i]->first_column;
     }
-    fwrite (info->buffer, element_size, info->inferDims.numElements * batch_size, file);
-    fclose (file);
+    metas[num_windows++] = metas[i];
   }
-  config->file_write_frame_num++;
+
+  jobs = g_new (CpuClassifierJob, MAX (num_windows, 1));
+  for (first = 0; first < num_windows; num_jobs++) {
+    guint end = MIN (first + cpu->batch_size, num_windows);
+
+    /* A source must not be split across threads. */
+    while (streams && end < num_windows &&
+        metas[end]->source_id == metas[end - 1]->source_id)
+      end++;
+    jobs[num_jobs].input = input + (gsize) first * input_size;
+    jobs[num_jobs].output = output + (gsize) first * num_classes;
+    jobs[num_jobs].num_windows = end - first;
+    jobs[num_jobs].streams = streams ? streams + first : NULL;
+    jobs[num_jobs].positions = positions ? positions + first : NULL;
+    num_batches += (end - first + cpu->batch_size - 1) / cpu->batch_size;
+    first = end;
+  }
+  cpu->pending = num_jobs;
+  for (i = 0; i < num_jobs; i++) {
+    if (cpu->pool)
+      g_thread_pool_push (cpu->pool, &jobs[i], NULL);
+    else
+      run_cpu_classifier_job (cpu, &jobs[i]);
+  }
+  g_mutex_lock (&cpu->lock);
+  while (cpu->pending)
+    g_cond_wait (&cpu->cond, &cpu->lock);
+  g_mutex_unlock (&cpu->lock);
+
+  for (i = 0; i < num_windows; i++) {
+    result.source_id = metas[i]->source_id;
+    result.window_num = metas[i]->window_num;
+    result.ntp_timestamp = metas[i]->ntp_timestamp;
+    result.gap = metas[i]->gap;
+    result.lag = metas[i]->lag;
+    cpu_classifier_get_result (cpu, output + (gsize) i * num_classes,
+        &result);
+    cpu_classifier_attach_result (cpu, batch_meta, (NvBufAudio *) map.data,
+        &result);
+    clear_cpu_classifier_result (&result);
+  }
+  gst_buffer_unmap (buf, &map);
+
+  count_cpu_batches (cpu, num_windows, num_batches,
+      g_get_monotonic_time () - start);
+
+  g_free (jobs);
+  g_free (positions);
+  g_free (streams);
+  g_free (output);
+  g_free (input);
+  g_free (metas);
+  return GST_PAD_PROBE_OK;
 }
 
-gboolean
-create_audio_classifier_bin (NvDsGieConfig *config, NvDsAudioClassifierBin *bin)
+static NvDsCpuClassifier *
+create_cpu_classifier (NvDsGieConfig *config, guint index)
 {
+  NvDsCpuClassifier *cpu = g_new0 (NvDsCpuClassifier, 1);
+  GError *error = NULL;
   gboolean ret = FALSE;
-  gst_nvinfer_raw_output_generated_callback out_callback =
-        write_infer_output_to_file;
 
-  bin->bin = gst_bin_new ("audio_classifier_bin");
+  cpu->index = index;
+  cpu->config = *config;
+  cpu->config.model_engine_file_path =
+      g_strdup (config->model_engine_file_path);
+  cpu->config.label_file_path = g_strdup (config->label_file_path);
+  g_mutex_init (&cpu->lock);
+  g_cond_init (&cpu->cond);
+
+  if (!config->model_engine_file_path) {
+    NVGSTDS_ERR_MSG_V ("plugin-type %u needs model-engine-file",
+        NV_DS_GIE_PLUGIN_CPU);
+    goto done;
+  }
+
+  cpu->batch_size = config->is_batch_size_set ? MAX (config->batch_size, 1) : 1;
+  cpu->size_runs = g_new0 (guint64, cpu->batch_size + 1);
+  cpu->size_time = g_new0 (gint64, cpu->batch_size + 1);
+  cpu->num_threads = config->cpu_threads ? config->cpu_threads :
+      g_get_num_processors ();
+  cpu->model = load_cpu_classifier_model (cpu, config);
+  if (!cpu->model)
+    goto done;
+
+  if (config->batch_deadline_ms) {
+    cpu->batcher = nvds_audio_batcher_new (cpu->batch_size,
+        (gint64) config->batch_deadline_ms * 1000, cpu->num_threads,
+        cpu_classifier_run_batch, cpu);
+    if (!cpu->batcher)
+      goto done;
+    NVGSTDS_INFO_MSG_V ("CPU classifier %u: batches close after %u ms",
+        index, config->batch_deadline_ms);
+  } else if (cpu->num_threads > 1) {
+    cpu->pool = g_thread_pool_new (cpu_classifier_thread_func, cpu,
+        cpu->num_threads, TRUE, &error);
+    if (!cpu->pool) {
+      NVGSTDS_ERR_MSG_V ("Failed to create inference threads: %s",
+          error->message);
+      g_error_free (error);
+      goto done;
+    }
+  }
+  NVGSTDS_INFO_MSG_V ("CPU classifier %u: %u classes, batch size %u, %u"
+      " threads", index, cpu->model->num_classes, cpu->batch_size,
+      cpu->num_threads);
+
+  ret = TRUE;
+done:
+  if (!ret) {
+    NvDsAudioClassifierBin bin = { .cpu = cpu };
+
+    destroy_audio_classifier_bin (&bin);
+    cpu = NULL;
+  }
+  return cpu;
+}
+
+void
+destroy_audio_classifier_bin (NvDsAudioClassifierBin *bin)
+{
+  NvDsCpuClassifier *cpu = bin->cpu;
+
+  if (bin->labels) {
+    g_ptr_array_unref (bin->labels);
+    bin->labels = NULL;
+  }
+  nvds_raw_recorder_free (bin->raw_recorder);
+  bin->raw_recorder = NULL;
+  if (!cpu)
+    return;
+  if (cpu->batcher)
+    nvds_audio_batcher_free (cpu->batcher);
+  while (!g_queue_is_empty (&cpu->results))
+    free_cpu_classifier_result (g_queue_pop_head (&cpu->results));
+  if (cpu->pool)
+    g_thread_pool_free (cpu->pool, FALSE, TRUE);
+  if (cpu->loader)
+    g_thread_join (cpu->loader);
+  free_cpu_classifier_model (cpu->next);
+  g_free (cpu->next_model_file);
+  g_free (cpu->next_label_file);
+  free_cpu_classifier_model (cpu->model);
+  g_free (cpu->config.model_engine_file_path);
+  g_free (cpu->config.label_file_path);
+  g_free (cpu->size_runs);
+  g_free (cpu->size_time);
+  g_mutex_clear (&cpu->lock);
+  g_cond_clear (&cpu->cond);
+  g_free (cpu);
+  bin->cpu = NULL;
+}
+
+/**
+ * Bin of a classifier of plugin-type 2: the network runs on the feature
+ * windows of the audio front-end in a probe on the queue.
+ */
+static gboolean
+create_cpu_classifier_bin (NvDsGieConfig *config, NvDsAudioClassifierBin *bin,
+    guint index, const gchar *suffix)
+{
+  gboolean ret = FALSE;
+  gchar elem_name[50];
+
+  bin->cpu = create_cpu_classifier (config, index);
+  if (!bin->cpu)
+    goto done;
+
+  g_snprintf (elem_name, sizeof (elem_name), "audio_classifier_bin%s", suffix);
+  bin->bin = gst_bin_new (elem_name);
   if (!bin->bin) {
-    NVGSTDS_ERR_MSG_V ("Failed to create 'audio_classifier_bin'");
+    NVGSTDS_ERR_MSG_V ("Failed to create '%s'", elem_name);
     goto done;
   }
 
-  bin->queue = gst_element_factory_make (NVDS_ELEM_QUEUE, "classifier_queue");
+  g_snprintf (elem_name, sizeof (elem_name), "classifier_queue%s", suffix);
+  bin->queue = gst_element_factory_make (NVDS_ELEM_QUEUE, elem_name);
   if (!bin->queue) {
-    NVGSTDS_ERR_MSG_V ("Failed to create 'classifier_queue'");
+    NVGSTDS_ERR_MSG_V ("Failed to create '%s'", elem_name);
     goto done;
   }
 
-  bin->classifier =
-      gst_element_factory_make (NVDS_ELEM_INFER_AUDIO, "audio_classifier");
-  if (!bin->classifier) {
-    NVGSTDS_ERR_MSG_V ("Failed to create 'audio_classifier'");
-    goto done;
+  gst_bin_add (GST_BIN (bin->bin), bin->queue);
+
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->queue, "src");
+
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->queue, "sink");
+
+  NVGSTDS_ELEM_ADD_PROBE (bin->probe_id, bin->queue, "src",
+      cpu_classifier_buf_prob,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      bin->cpu);
+
+  ret = TRUE;
+done:
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
   }
+  return ret;
+}
 
-  g_object_set (G_OBJECT (bin->classifier),
-      "config-file-path", GET_FILE_PATH (config->config_file_path), NULL);
+/** nvinferaudio with the properties shared by all engines of @p config;
+ *  the raw output goes to the recorder of @p bin. */
+static GstElement *
+create_nvinferaudio (NvDsGieConfig *config, NvDsAudioClassifierBin *bin,
+    const gchar *name)
+{
+  gst_nvinfer_raw_output_generated_callback out_callback =
+        write_infer_output_to_file;
+  GstElement *classifier;
 
-  if (config->is_batch_size_set)
-    g_object_set (G_OBJECT (bin->classifier),
-        "batch-size", config->batch_size, NULL);
+  classifier = gst_element_factory_make (NVDS_ELEM_INFER_AUDIO, name);
+  if (!classifier) {
+    NVGSTDS_ERR_MSG_V ("Failed to create '%s'", name);
+    return NULL;
+  }
+
+  g_object_set (G_OBJECT (classifier),
+      "config-file-path", GET_FILE_PATH (config->config_file_path), NULL);
 
   if (config->is_unique_id_set)
-    g_object_set (G_OBJECT (bin->classifier),
+    g_object_set (G_OBJECT (classifier),
         "unique-id", config->unique_id, NULL);
 
   if (config->is_gpu_id_set)
-    g_object_set (G_OBJECT (bin->classifier),
+    g_object_set (G_OBJECT (classifier),
         "gpu-id", config->gpu_id, NULL);
 
-  if (config->model_engine_file_path)
-    g_object_set (G_OBJECT (bin->classifier), "model-engine-file",
-        GET_FILE_PATH (config->model_engine_file_path), NULL);
-
   if (config->is_frame_size_set)
-    g_object_set (G_OBJECT (bin->classifier),
+    g_object_set (G_OBJECT (classifier),
         "audio-framesize", config->frame_size, NULL);
 
   if (config->is_hop_size_set)
-    g_object_set (G_OBJECT (bin->classifier),
+    g_object_set (G_OBJECT (classifier),
         "audio-hopsize", config->hop_size, NULL);
 
   if (config->audio_transform) {
     GstStructure *p;
 
     p = gst_structure_from_string (config->audio_transform, NULL);
-    g_object_set (G_OBJECT (bin->classifier), "audio-transform", p, NULL);
+    g_object_set (G_OBJECT (classifier), "audio-transform", p, NULL);
   }
 
-  if (config->raw_output_directory) {
-    g_object_set (G_OBJECT (bin->classifier),
+  if (bin->raw_recorder) {
+    g_object_set (G_OBJECT (classifier),
         "raw-output-generated-callback", out_callback,
-        "raw-output-generated-userdata", config,
+        "raw-output-generated-userdata", bin->raw_recorder,
         NULL);
   }
+  return classifier;
+}
+
+/** top-k only: labels of the nvinfer config file, for the top-k meta. */
+static gboolean
+load_nvinfer_labels (NvDsGieConfig *config, NvDsAudioClassifierBin *bin)
+{
+  GKeyFile *key_file = g_key_file_new ();
+  GError *error = NULL;
+  gboolean ret = FALSE;
+
+  if (!g_key_file_load_from_file (key_file,
+          GET_FILE_PATH (config->config_file_path), G_KEY_FILE_NONE,
+          &error)) {
+    NVGSTDS_ERR_MSG_V ("Failed to load '%s': %s",
+        GET_FILE_PATH (config->config_file_path), error->message);
+    goto done;
+  }
+  ret = load_classifier_labels (config, key_file, &bin->labels);
+done:
+  if (error) {
+    g_error_free (error);
+  }
+  g_key_file_free (key_file);
+  return ret;
+}
+
+static gboolean
+create_classifier_bin (NvDsGieConfig *config, NvDsAudioClassifierBin *bin,
+    guint index, const gchar *suffix)
+{
+  gboolean ret = FALSE;
+  gchar elem_name[50];
+
+  if (config->plugin_type == NV_DS_GIE_PLUGIN_CPU)
+    return create_cpu_classifier_bin (config, bin, index, suffix);
+
+  /* nvinferaudio batches internally; its deadline is the streammux
+   * batched-push-timeout. */
+  if (config->batch_deadline_ms) {
+    NVGSTDS_WARN_MSG_V ("batch-deadline-ms is only used with plugin-type %u;"
+        " ignored", NV_DS_GIE_PLUGIN_CPU);
+  }
+  if (config->streaming_layers) {
+    NVGSTDS_WARN_MSG_V ("streaming-layers is only used with plugin-type %u;"
+        " ignored", NV_DS_GIE_PLUGIN_CPU);
+  }
+
+  g_snprintf (elem_name, sizeof (elem_name), "audio_classifier_bin%s", suffix);
+  bin->bin = gst_bin_new (elem_name);
+  if (!bin->bin) {
+    NVGSTDS_ERR_MSG_V ("Failed to create '%s'", elem_name);
+    goto done;
+  }
+
+  g_snprintf (elem_name, sizeof (elem_name), "classifier_queue%s", suffix);
+  bin->queue = gst_element_factory_make (NVDS_ELEM_QUEUE, elem_name);
+  if (!bin->queue) {
+    NVGSTDS_ERR_MSG_V ("Failed to create '%s'", elem_name);
+    goto done;
+  }
+
+  if (config->top_k && !load_nvinfer_labels (config, bin))
+    goto done;
+
+  if (config->raw_output_directory) {
+    g_snprintf (elem_name, sizeof (elem_name), "audio_classifier%s", suffix);
+    bin->raw_recorder = nvds_raw_recorder_new (config->raw_output_directory,
+        elem_name);
+    if (!bin->raw_recorder)
+      goto done;
+  }
+
+  g_snprintf (elem_name, sizeof (elem_name), "audio_classifier%s", suffix);
+  bin->classifier = create_nvinferaudio (config, bin, elem_name);
+  if (!bin->classifier)
+    goto done;
+
+  if (config->is_batch_size_set)
+    g_object_set (G_OBJECT (bin->classifier),
+        "batch-size", config->batch_size, NULL);
+
+  if (config->model_engine_file_path)
+    g_object_set (G_OBJECT (bin->classifier), "model-engine-file",
+        GET_FILE_PATH (config->model_engine_file_path), NULL);
 
   gst_bin_add_many (GST_BIN (bin->bin), bin->queue,
       bin->classifier, NULL);
@@ -158,3 +1302,81 @@ done:
   }
   return ret;
 }
+
+gboolean
+create_audio_classifier_bin (NvDsGieConfig *config, NvDsAudioClassifierBin *bin)
+{
+  return create_audio_classifier_sub_bin (config, bin, 0);
+}
+
+gboolean
+create_audio_classifier_sub_bin (NvDsGieConfig *config,
+    NvDsAudioClassifierBin *bin, guint index)
+{
+  gchar suffix[16] = "";
+
+  /* Model 0 keeps the element names of the single classifier pipeline. */
+  if (index)
+    g_snprintf (suffix, sizeof (suffix), "_%u", index);
+
+  return create_classifier_bin (config, bin, index, suffix);
+}
+
+gboolean
+create_audio_detector_bin (NvDsGieConfig *config, NvDsAudioClassifierBin *bin)
+{
+  return create_classifier_bin (config, bin, 0, "_detector");
+}
+
+static void
+nvinferaudio_model_updated (GstElement *classifier, gint err,
+    const gchar *config_file, gpointer user_data)
+{
+  NvDsAudioClassifierBin *bin = (NvDsAudioClassifierBin *) user_data;
+
+  if (err) {
+    NVGSTDS_ERR_MSG_V ("%s: model update failed (%d); the previous engine"
+        " keeps running", GST_ELEMENT_NAME (classifier), err);
+  } else {
+    NVGSTDS_INFO_MSG_V ("%s: engine swapped %.1f ms after the request",
+        GST_ELEMENT_NAME (classifier),
+        (g_get_monotonic_time () - bin->swap_start) / 1e3);
+  }
+  bin->swap_start = 0;
+}
+
+gboolean
+nvds_audio_classifier_swap_model (NvDsAudioClassifierBin *bin,
+    const gchar *model_engine_file, const gchar *label_file)
+{
+  if (bin->cpu)
+    return swap_cpu_classifier_model (bin->cpu, model_engine_file,
+        label_file);
+
+  if (label_file) {
+    NVGSTDS_WARN_MSG_V ("%s: labelfile-path can only be swapped with"
+        " plugin-type %u; restart to apply", GST_ELEMENT_NAME (bin->classifier),
+        NV_DS_GIE_PLUGIN_CPU);
+  }
+  if (!model_engine_file)
+    return FALSE;
+  if (!g_signal_lookup ("model-updated", G_OBJECT_TYPE (bin->classifier))) {
+    NVGSTDS_WARN_MSG_V ("%s doesn't update models while playing; restart to"
+        " apply", GST_ELEMENT_NAME (bin->classifier));
+    return FALSE;
+  }
+  if (bin->swap_start) {
+    NVGSTDS_WARN_MSG_V ("%s: a model swap is in progress",
+        GST_ELEMENT_NAME (bin->classifier));
+    return FALSE;
+  }
+
+  if (!bin->model_updated_id) {
+    bin->model_updated_id = g_signal_connect (G_OBJECT (bin->classifier),
+        "model-updated", G_CALLBACK (nvinferaudio_model_updated), bin);
+  }
+  bin->swap_start = g_get_monotonic_time ();
+  g_object_set (G_OBJECT (bin->classifier), "model-engine-file",
+      GET_FILE_PATH (model_engine_file), NULL);
+  return TRUE;
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gst/gst.h>
+
+#include "deepstream_audio_clock.h"
+
+static NvDsAudioClockSegment *
+last_segment (NvDsAudioClock *clock)
+{
+  return &clock->segments[(clock->num_segments - 1) %
+      NVDS_AUDIO_CLOCK_MAX_SEGMENTS];
+}
+
+/** Start a segment at the next sample; replaces a segment without
+ *  samples. */
+static void
+add_segment (NvDsAudioClock *clock, guint64 time, guint rate, gboolean gap)
+{
+  NvDsAudioClockSegment *seg;
+
+  if (clock->num_segments &&
+      last_segment (clock)->first_sample == clock->num_samples) {
+    seg = last_segment (clock);
+    gap |= seg->gap;
+  } else {
+    seg = &clock->segments[clock->num_segments++ %
+        NVDS_AUDIO_CLOCK_MAX_SEGMENTS];
+  }
+  seg->first_sample = clock->num_samples;
+  seg->time = time;
+  seg->rate = rate;
+  seg->gap = gap;
+}
+
+guint
+nvds_audio_clock_push (NvDsAudioClock *clock, guint64 pts, guint64 arrival,
+    guint num_samples, guint rate)
+{
+  guint64 duration;
+  guint drop = 0;
+
+  if (!num_samples || !rate)
+    return 0;
+  duration = gst_util_uint64_scale (num_samples, GST_SECOND, rate);
+
+  if (!clock->num_segments) {
+    /* The buffer arrived with its last sample. */
+    add_segment (clock, arrival > duration ? arrival - duration : 0, rate,
+        FALSE);
+  } else if (GST_CLOCK_TIME_IS_VALID (pts) && clock->have_pts) {
+    gint64 delta = GST_CLOCK_DIFF (clock->next_pts, pts);
+
+    if (delta > (gint64) NVDS_AUDIO_CLOCK_TOLERANCE) {
+      add_segment (clock, nvds_audio_clock_get_time (clock,
+              clock->num_samples) + delta, rate, TRUE);
+      clock->stats.gaps++;
+      clock->stats.lost += delta;
+    } else if (delta < -(gint64) NVDS_AUDIO_CLOCK_MAX_OVERLAP) {
+      add_segment (clock, arrival > duration ? arrival - duration : 0, rate,
+          TRUE);
+      clock->stats.resyncs++;
+    } else if (delta < -(gint64) NVDS_AUDIO_CLOCK_TOLERANCE) {
+      drop = (guint) MIN (gst_util_uint64_scale_round (-delta, rate,
+              GST_SECOND), num_samples);
+      clock->stats.duplicates++;
+      clock->stats.duplicate_samples += drop;
+    }
+  }
+  if (last_segment (clock)->rate != rate) {
+    add_segment (clock, nvds_audio_clock_get_time (clock, clock->num_samples),
+        rate, FALSE);
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (pts)) {
+    /* A partly repeated buffer ends where the last one did or later. */
+    clock->next_pts = drop ? MAX (clock->next_pts, pts + duration) :
+        pts + duration;
+    clock->have_pts = TRUE;
+  } else {
+    clock->have_pts = FALSE;
+  }
+  clock->num_samples += num_samples - drop;
+
+  if (arrival) {
+    clock->stats.lag = GST_CLOCK_DIFF (nvds_audio_clock_get_time (clock,
+            clock->num_samples), arrival);
+    clock->stats.max_lag = MAX (clock->stats.max_lag, clock->stats.lag);
+  }
+  return drop;
+}
+
+guint64
+nvds_audio_clock_get_time (const NvDsAudioClock *clock, guint64 sample)
+{
+  guint64 oldest, i;
+  const NvDsAudioClockSegment *seg;
+  guint64 offset;
+
+  if (!clock->num_segments)
+    return 0;
+  oldest = clock->num_segments -
+      MIN (clock->num_segments, NVDS_AUDIO_CLOCK_MAX_SEGMENTS);
+  for (i = clock->num_segments - 1;; i--) {
+    seg = &clock->segments[i % NVDS_AUDIO_CLOCK_MAX_SEGMENTS];
+    if (seg->first_sample <= sample || i == oldest)
+      break;
+  }
+
+  if (sample >= seg->first_sample) {
+    return seg->time + gst_util_uint64_scale (sample - seg->first_sample,
+        GST_SECOND, seg->rate);
+  }
+  /* Older than the segments kept. */
+  offset = gst_util_uint64_scale (seg->first_sample - sample, GST_SECOND,
+      seg->rate);
+  return seg->time > offset ? seg->time - offset : 0;
+}
+
+gboolean
+nvds_audio_clock_has_gap (const NvDsAudioClock *clock, guint64 first_sample,
+    guint64 num_samples)
+{
+  guint64 i;
+
+  for (i = clock->num_segments -
+      MIN (clock->num_segments, NVDS_AUDIO_CLOCK_MAX_SEGMENTS);
+      i < clock->num_segments; i++) {
+    const NvDsAudioClockSegment *seg =
+        &clock->segments[i % NVDS_AUDIO_CLOCK_MAX_SEGMENTS];
+
+    if (seg->gap && seg->first_sample >= first_sample &&
+        seg->first_sample < first_sample + num_samples)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static gpointer
+copy_audio_clock_meta (gpointer data, gpointer user_data)
+{
+  NvDsUserMeta *user_meta = (NvDsUserMeta *) data;
+
+  return g_slice_dup (NvDsAudioClockMeta, user_meta->user_meta_data);
+}
+
+static void
+release_audio_clock_meta (gpointer data, gpointer user_data)
+{
+  NvDsUserMeta *user_meta = (NvDsUserMeta *) data;
+
+  g_slice_free (NvDsAudioClockMeta, user_meta->user_meta_data);
+  user_meta->user_meta_data = NULL;
+}
+
+void
+nvds_audio_clock_attach (NvDsBatchMeta *batch_meta,
+    NvDsAudioFrameMeta *frame_meta, gboolean gap, gint64 lag)
+{
+  NvDsAudioClockMeta *meta = g_slice_new (NvDsAudioClockMeta);
+  NvDsUserMeta *user_meta = nvds_acquire_user_meta_from_pool (batch_meta);
+
+  meta->gap = gap;
+  meta->lag = lag;
+
+  user_meta->user_meta_data = meta;
+  user_meta->base_meta.meta_type =
+      nvds_get_user_meta_type ((gchar *) NVDS_AUDIO_CLOCK_META_STRING);
+  user_meta->base_meta.copy_func = copy_audio_clock_meta;
+  user_meta->base_meta.release_func = release_audio_clock_meta;
+  nvds_add_user_meta_to_audio_frame (frame_meta, user_meta);
+}
+
+NvDsAudioClockMeta *
+nvds_audio_clock_get_meta (NvDsAudioFrameMeta *frame_meta)
+{
+  NvDsMetaType clock_type =
+      nvds_get_user_meta_type ((gchar *) NVDS_AUDIO_CLOCK_META_STRING);
+  NvDsMetaList *l;
+
+  for (l = frame_meta->frame_user_meta_list; l; l = l->next) {
+    NvDsUserMeta *user_meta = (NvDsUserMeta *) l->data;
+
+    if (user_meta->base_meta.meta_type == clock_type)
+      return (NvDsAudioClockMeta *) user_meta->user_meta_data;
+  }
+  return NULL;
+}
@@ -0,0 +1,1540 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <dlfcn.h>
+#include <math.h>
+#include <string.h>
+#include <gst/gst.h>
+
+#include "deepstream_common.h"
+#include "deepstream_audio_codec.h"
+
+#define IMA_ADPCM_MAX_CHANNELS 8
+/** Block of the encoder per channel, about 21 ms at 48 kHz. */
+#define IMA_ADPCM_BLOCK_ALIGN 512
+
+#define FLAC_MAX_CHANNELS 8
+/** Deeper samples would overflow the 32 bit predictors. */
+#define FLAC_MAX_BITS 24
+#define FLAC_MAX_LPC_ORDER 32
+#define FLAC_ENCODE_BLOCK 4096
+#define FLAC_ENCODE_MAX_PARTITION_ORDER 8
+
+#define OPUS_RATE 48000
+/** Longest Opus packet, 120 ms at 48 kHz. */
+#define OPUS_MAX_FRAME 5760
+#define OPUS_MAX_PACKET 4000
+#define OPUS_ENCODE_PACKETS_PER_PAGE 10
+#define OPUS_APPLICATION_AUDIO 2049
+#define OPUS_SET_BITRATE_REQUEST 4002
+#define OPUS_GET_LOOKAHEAD_REQUEST 4027
+
+#define OGG_HEADER_SIZE 27
+#define OGG_FLAG_CONTINUED 0x01
+#define OGG_FLAG_BOS 0x02
+#define OGG_FLAG_EOS 0x04
+
+typedef enum
+{
+  FLAC_STAGE_MAGIC,
+  FLAC_STAGE_METADATA,
+  FLAC_STAGE_FRAMES,
+} FlacStage;
+
+/** Entry points of libopus, loaded on first use. */
+typedef struct
+{
+  gpointer (*decoder_create) (gint32 rate, gint channels, gint * error);
+  gint (*decode_float) (gpointer dec, const guchar * data, gint32 len,
+      gfloat * pcm, gint frame_size, gint decode_fec);
+  void (*decoder_destroy) (gpointer dec);
+  gpointer (*encoder_create) (gint32 rate, gint channels, gint application,
+      gint * error);
+  gint32 (*encode) (gpointer enc, const gint16 * pcm, gint frame_size,
+      guchar * data, gint32 max_data_bytes);
+  gint (*encoder_ctl) (gpointer enc, gint request, ...);
+  void (*encoder_destroy) (gpointer enc);
+} OpusApi;
+
+struct _NvDsAudioDecoder
+{
+  NvDsAudioCodec codec;
+  /** Received bytes not decoded yet, e.g. the start of a frame. */
+  GByteArray *input;
+  gboolean have_format;
+  const gchar *format;
+  guint rate;
+  guint channels;
+  guint64 bytes;
+  guint64 skipped;
+
+  /* IMA ADPCM. */
+  guint block_align;
+  guint block_frames;
+  gint16 *block;
+
+  /* FLAC. */
+  FlacStage stage;
+  gboolean have_streaminfo;
+  guint bits;
+  /** Channels x block size decoded samples of the current frame. */
+  gint32 *samples;
+  guint samples_size;
+
+  /* Opus. */
+  const OpusApi *opus_api;
+  gpointer opus;
+  guint32 serial;
+  /** Packets of the logical stream so far; 0 and 1 are the headers. */
+  guint64 packets;
+  /** Packet continued on the next page; skip a continuation that started
+   *  before the stream was joined. */
+  GByteArray *packet;
+  gboolean skip_continued;
+  guint pre_skip;
+  gfloat gain;
+  gfloat *pcm;
+};
+
+/** Bit reader of FLAC frames, most significant bit first. */
+typedef struct
+{
+  const guint8 *data;
+  gsize size;
+  guint64 pos;
+  /** Read past the end of the data: the frame is not complete yet. */
+  gboolean overrun;
+} BitReader;
+
+/** Bit writer of the FLAC encoder. */
+typedef struct
+{
+  GByteArray *out;
+  guint64 acc;
+  guint bits;
+} BitWriter;
+
+static const gint16 ima_step_table[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+  45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209,
+  230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876,
+  963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749,
+  3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630,
+  9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385,
+  24623, 27086, 29794, 32767
+};
+
+static const gint8 ima_index_table[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static const guint flac_sample_rates[12] = {
+  0, 88200, 176400, 192000, 8000, 16000, 22050, 24000, 32000, 44100, 48000,
+  96000
+};
+
+static const guint flac_sample_bits[8] = { 0, 8, 12, 0, 16, 20, 24, 32 };
+
+static guint8 crc8_table[256];
+static guint16 crc16_table[256];
+static guint32 ogg_crc_table[256];
+
+static void
+init_crc_tables (void)
+{
+  static gsize initialized = 0;
+  guint i, j;
+
+  if (!g_once_init_enter (&initialized))
+    return;
+  for (i = 0; i < 256; i++) {
+    guint8 c8 = i;
+    guint16 c16 = i << 8;
+    guint32 c32 = i << 24;
+
+    for (j = 0; j < 8; j++) {
+      c8 = (c8 << 1) ^ (c8 & 0x80 ? 0x07 : 0);
+      c16 = (c16 << 1) ^ (c16 & 0x8000 ? 0x8005 : 0);
+      c32 = (c32 << 1) ^ (c32 & 0x80000000 ? 0x04c11db7 : 0);
+    }
+    crc8_table[i] = c8;
+    crc16_table[i] = c16;
+    ogg_crc_table[i] = c32;
+  }
+  g_once_init_leave (&initialized, 1);
+}
+
+static guint8
+crc8 (const guint8 * data, gsize size)
+{
+  guint8 crc = 0;
+
+  while (size--)
+    crc = crc8_table[crc ^ *data++];
+  return crc;
+}
+
+static guint16
+crc16 (const guint8 * data, gsize size)
+{
+  guint16 crc = 0;
+
+  while (size--)
+    crc = (crc << 8) ^ crc16_table[(crc >> 8) ^ *data++];
+  return crc;
+}
+
+static guint32
+ogg_crc (const guint8 * data, gsize size)
+{
+  guint32 crc = 0;
+
+  while (size--)
+    crc = (crc << 8) ^ ogg_crc_table[(crc >> 24) ^ *data++];
+  return crc;
+}
+
+static const OpusApi *
+get_opus_api (void)
+{
+  static gsize loaded = 0;
+  static OpusApi api;
+
+  if (g_once_init_enter (&loaded)) {
+    gpointer lib = dlopen ("libopus.so.0", RTLD_NOW | RTLD_LOCAL);
+    gboolean ok = FALSE;
+
+    if (lib) {
+      api.decoder_create = dlsym (lib, "opus_decoder_create");
+      api.decode_float = dlsym (lib, "opus_decode_float");
+      api.decoder_destroy = dlsym (lib, "opus_decoder_destroy");
+      api.encoder_create = dlsym (lib, "opus_encoder_create");
+      api.encode = dlsym (lib, "opus_encode");
+      api.encoder_ctl = dlsym (lib, "opus_encoder_ctl");
+      api.encoder_destroy = dlsym (lib, "opus_encoder_destroy");
+      ok = api.decoder_create && api.decode_float && api.decoder_destroy &&
+          api.encoder_create && api.encode && api.encoder_ctl &&
+          api.encoder_destroy;
+    }
+    if (!ok)
+      NVGSTDS_WARN_MSG_V ("libopus.so.0 not found, Opus streams can't be"
+          " decoded");
+    g_once_init_leave (&loaded, ok ? 1 : 2);
+  }
+  return loaded == 1 ? &api : NULL;
+}
+
+const gchar *
+nvds_audio_codec_get_name (NvDsAudioCodec codec)
+{
+  switch (codec) {
+    case NVDS_AUDIO_CODEC_IMA_ADPCM:
+      return "IMA ADPCM";
+    case NVDS_AUDIO_CODEC_FLAC:
+      return "FLAC";
+    case NVDS_AUDIO_CODEC_OPUS:
+      return "Opus";
+    default:
+      return "unknown";
+  }
+}
+
+gboolean
+nvds_audio_codec_is_available (NvDsAudioCodec codec)
+{
+  if (codec == NVDS_AUDIO_CODEC_OPUS)
+    return get_opus_api () != NULL;
+  return codec < NVDS_AUDIO_CODEC_COUNT;
+}
+
+NvDsAudioDecoder *
+nvds_audio_decoder_new (NvDsAudioCodec codec)
+{
+  NvDsAudioDecoder *dec;
+
+  if (codec != NVDS_AUDIO_CODEC_FLAC && codec != NVDS_AUDIO_CODEC_OPUS)
+    return NULL;
+  init_crc_tables ();
+  dec = g_new0 (NvDsAudioDecoder, 1);
+  dec->codec = codec;
+  dec->input = g_byte_array_new ();
+  dec->packet = g_byte_array_new ();
+  dec->stage = FLAC_STAGE_MAGIC;
+  return dec;
+}
+
+NvDsAudioDecoder *
+nvds_audio_decoder_new_ima_adpcm (guint rate, guint channels,
+    guint block_align)
+{
+  NvDsAudioDecoder *dec;
+
+  /* A 4 byte header and whole groups of 8 samples per channel. */
+  if (!rate || !channels || channels > IMA_ADPCM_MAX_CHANNELS ||
+      block_align <= 4 * channels || (block_align - 4 * channels) %
+      (4 * channels))
+    return NULL;
+  dec = g_new0 (NvDsAudioDecoder, 1);
+  dec->codec = NVDS_AUDIO_CODEC_IMA_ADPCM;
+  dec->input = g_byte_array_new ();
+  dec->rate = rate;
+  dec->channels = channels;
+  dec->block_align = block_align;
+  dec->block_frames = (block_align - 4 * channels) * 2 / channels + 1;
+  dec->block = g_new (gint16, (gsize) dec->block_frames * channels);
+  dec->format = "S16LE";
+  dec->have_format = TRUE;
+  return dec;
+}
+
+void
+nvds_audio_decoder_free (NvDsAudioDecoder * dec)
+{
+  if (!dec)
+    return;
+  if (dec->opus)
+    dec->opus_api->decoder_destroy (dec->opus);
+  g_byte_array_free (dec->input, TRUE);
+  if (dec->packet)
+    g_byte_array_free (dec->packet, TRUE);
+  g_free (dec->block);
+  g_free (dec->samples);
+  g_free (dec->pcm);
+  g_free (dec);
+}
+
+gboolean
+nvds_audio_decoder_get_format (const NvDsAudioDecoder * dec,
+    const gchar ** format, guint * rate, guint * channels)
+{
+  if (!dec->have_format)
+    return FALSE;
+  *format = dec->format;
+  *rate = dec->rate;
+  *channels = dec->channels;
+  return TRUE;
+}
+
+void
+nvds_audio_decoder_get_stats (const NvDsAudioDecoder * dec, guint64 * bytes,
+    guint64 * skipped)
+{
+  *bytes = dec->bytes;
+  *skipped = dec->skipped;
+}
+
+/* IMA ADPCM. */
+
+typedef struct
+{
+  gint pred;
+  gint index;
+} ImaState;
+
+static inline gint16
+ima_decode_nibble (ImaState * state, guint nibble)
+{
+  gint step = ima_step_table[state->index];
+  gint diff = step >> 3;
+
+  if (nibble & 1)
+    diff += step >> 2;
+  if (nibble & 2)
+    diff += step >> 1;
+  if (nibble & 4)
+    diff += step;
+  state->pred += nibble & 8 ? -diff : diff;
+  state->pred = CLAMP (state->pred, -32768, 32767);
+  state->index = CLAMP (state->index + ima_index_table[nibble & 7], 0, 88);
+  return state->pred;
+}
+
+/**
+ * One block: per channel a header with the first sample and the step
+ * index, then per channel groups of 4 bytes of 8 samples, low nibble
+ * first.
+ */
+static void
+decode_ima_block (const guint8 * in, guint channels, guint frames,
+    gint16 * out)
+{
+  ImaState state[IMA_ADPCM_MAX_CHANNELS];
+  const guint8 *data = in + 4 * channels;
+  guint ch, g, j;
+
+  for (ch = 0; ch < channels; ch++) {
+    state[ch].pred = (gint16) GST_READ_UINT16_LE (in + 4 * ch);
+    state[ch].index = MIN (in[4 * ch + 2], 88);
+    out[ch] = state[ch].pred;
+  }
+  for (g = 0; g < (frames - 1) / 8; g++) {
+    for (ch = 0; ch < channels; ch++) {
+      const guint8 *b = data + (g * channels + ch) * 4;
+      gint16 *o = out + (1 + g * 8) * channels + ch;
+
+      for (j = 0; j < 8; j++)
+        o[j * channels] = ima_decode_nibble (&state[ch],
+            (b[j / 2] >> ((j & 1) * 4)) & 0xf);
+    }
+  }
+}
+
+static gsize
+decode_ima_adpcm (NvDsAudioDecoder * dec, const guint8 * data, gsize size,
+    GByteArray * out)
+{
+  gsize used = 0;
+
+  while (size - used >= dec->block_align) {
+    gsize samples = (gsize) dec->block_frames * dec->channels;
+    guint old = out->len;
+    guint i;
+
+    g_byte_array_set_size (out, old + samples * 2);
+    decode_ima_block (data + used, dec->channels, dec->block_frames,
+        dec->block);
+    for (i = 0; i < samples; i++)
+      GST_WRITE_UINT16_LE (out->data + old + 2 * i, dec->block[i]);
+    used += dec->block_align;
+  }
+  return used;
+}
+
+/* FLAC. */
+
+/** 64 bits from the current position; bits past the end are 0. */
+static inline guint64
+peek_bits (const BitReader * br)
+{
+  gsize byte = br->pos >> 3;
+  guint64 w = 0;
+  guint i;
+
+  if (byte + 8 <= br->size) {
+    memcpy (&w, br->data + byte, 8);
+    w = GUINT64_FROM_BE (w);
+  } else {
+    for (i = 0; i < 8; i++)
+      w = (w << 8) | (byte + i < br->size ? br->data[byte + i] : 0);
+  }
+  return w << (br->pos & 7);
+}
+
+static inline guint32
+read_bits (BitReader * br, guint n)
+{
+  guint64 w;
+
+  if (!n)
+    return 0;
+  if (br->pos + n > (guint64) br->size * 8) {
+    br->overrun = TRUE;
+    br->pos = (guint64) br->size * 8;
+    return 0;
+  }
+  w = peek_bits (br);
+  br->pos += n;
+  return (guint32) (w >> (64 - n));
+}
+
+static inline gint32
+read_signed (BitReader * br, guint n)
+{
+  if (!n)
+    return 0;
+  return (gint32) (read_bits (br, n) << (32 - n)) >> (32 - n);
+}
+
+/** Number of 0 bits before the next 1 bit, which is skipped. */
+static inline guint32
+read_unary (BitReader * br)
+{
+  guint32 zeros = 0;
+
+  while (TRUE) {
+    guint64 left = (guint64) br->size * 8 - br->pos;
+    /* The window holds at least 57 bits of data. */
+    guint avail = MIN (left, 57);
+    guint64 w;
+
+    if (!avail) {
+      br->overrun = TRUE;
+      return 0;
+    }
+    w = peek_bits (br);
+    if (w >> (64 - avail)) {
+      guint n = __builtin_clzll (w);
+
+      br->pos += n + 1;
+      return zeros + n;
+    }
+    zeros += avail;
+    br->pos += avail;
+  }
+}
+
+static gboolean
+decode_flac_residual (BitReader * br, guint block, guint order, gint32 * res)
+{
+  guint method = read_bits (br, 2);
+  guint param_bits = method ? 5 : 4;
+  guint escape = (1 << param_bits) - 1;
+  guint porder = read_bits (br, 4);
+  guint part_size = block >> porder;
+  guint p, j;
+
+  if (method > 1 || part_size << porder != block || part_size < order)
+    return FALSE;
+
+  for (p = 0; p < 1u << porder && !br->overrun; p++) {
+    guint n = part_size - (p ? 0 : order);
+    guint k = read_bits (br, param_bits);
+
+    if (k == escape) {
+      guint bits = read_bits (br, 5);
+
+      for (j = 0; j < n; j++)
+        *res++ = read_signed (br, bits);
+    } else {
+      for (j = 0; j < n; j++) {
+        guint32 v = (read_unary (br) << k) | read_bits (br, k);
+
+        *res++ = (gint32) (v >> 1) ^ -(gint32) (v & 1);
+      }
+    }
+  }
+  return TRUE;
+}
+
+static gboolean
+decode_flac_subframe (BitReader * br, guint bits, guint block, gint32 * s)
+{
+  guint32 *u = (guint32 *) s;
+  guint type, wasted = 0, order, i, j;
+
+  if (read_bits (br, 1))
+    return FALSE;
+  type = read_bits (br, 6);
+  if (read_bits (br, 1))
+    wasted = read_unary (br) + 1;
+  if (wasted >= bits)
+    return FALSE;
+  bits -= wasted;
+
+  if (type == 0) {
+    gint32 v = read_signed (br, bits);
+
+    for (i = 0; i < block; i++)
+      s[i] = v;
+  } else if (type == 1) {
+    for (i = 0; i < block; i++)
+      s[i] = read_signed (br, bits);
+  } else if (type >= 8 && type <= 12) {
+    order = type - 8;
+    if (order > block)
+      return FALSE;
+    for (i = 0; i < order; i++)
+      s[i] = read_signed (br, bits);
+    if (!decode_flac_residual (br, block, order, s + order))
+      return FALSE;
+    /* Unsigned, so that corrupt frames wrap until their CRC fails. */
+    switch (order) {
+      case 1:
+        for (i = 1; i < block; i++)
+          u[i] += u[i - 1];
+        break;
+      case 2:
+        for (i = 2; i < block; i++)
+          u[i] += 2 * u[i - 1] - u[i - 2];
+        break;
+      case 3:
+        for (i = 3; i < block; i++)
+          u[i] += 3 * (u[i - 1] - u[i - 2]) + u[i - 3];
+        break;
+      case 4:
+        for (i = 4; i < block; i++)
+          u[i] += 4 * (u[i - 1] + u[i - 3]) - 6 * u[i - 2] - u[i - 4];
+        break;
+      default:
+        break;
+    }
+  } else if (type >= 32) {
+    gint32 coefs[FLAC_MAX_LPC_ORDER];
+    guint precision;
+    gint shift;
+
+    order = type - 31;
+    if (order > block)
+      return FALSE;
+    for (i = 0; i < order; i++)
+      s[i] = read_signed (br, bits);
+    precision = read_bits (br, 4) + 1;
+    shift = read_signed (br, 5);
+    if (precision == 16 || shift < 0)
+      return FALSE;
+    for (i = 0; i < order; i++)
+      coefs[i] = read_signed (br, precision);
+    if (!decode_flac_residual (br, block, order, s + order))
+      return FALSE;
+    for (i = order; i < block; i++) {
+      gint64 sum = 0;
+
+      for (j = 0; j < order; j++)
+        sum += (gint64) coefs[j] * s[i - 1 - j];
+      u[i] += (guint32) (sum >> shift);
+    }
+  } else {
+    return FALSE;
+  }
+
+  if (wasted) {
+    for (i = 0; i < block; i++)
+      u[i] <<= wasted;
+  }
+  return TRUE;
+}
+
+/** Frame number or sample number, UTF-8 like coded. */
+static gboolean
+read_flac_utf8 (BitReader * br)
+{
+  guint32 first = read_bits (br, 8);
+  guint extra = 0;
+
+  while (extra < 8 && first & (0x80 >> extra))
+    extra++;
+  if (extra == 1 || extra == 8)
+    return FALSE;
+  if (extra)
+    extra--;
+  while (extra--) {
+    if ((read_bits (br, 8) & 0xc0) != 0x80)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * Decode the frame at @p data.
+ *
+ * @return bytes of the frame, 0 if it is not complete yet, -1 if it is
+ *         corrupt.
+ */
+static gssize
+decode_flac_frame (NvDsAudioDecoder * dec, const guint8 * data, gsize size,
+    GByteArray * out)
+{
+  BitReader br = { data, size, 0, FALSE };
+  guint bs_code, sr_code, ch_code, ss_code, block, bits, channels, ch, i;
+  gsize max_size;
+  guint old;
+
+  if (size < 2)
+    return 0;
+  if (data[0] != 0xff || (data[1] & 0xfe) != 0xf8)
+    return -1;
+  read_bits (&br, 16);
+  bs_code = read_bits (&br, 4);
+  sr_code = read_bits (&br, 4);
+  ch_code = read_bits (&br, 4);
+  ss_code = read_bits (&br, 3);
+  if (read_bits (&br, 1) || !bs_code || sr_code == 15 || ch_code > 10 ||
+      !read_flac_utf8 (&br))
+    return br.overrun ? 0 : -1;
+
+  if (bs_code == 1)
+    block = 192;
+  else if (bs_code <= 5)
+    block = 576 << (bs_code - 2);
+  else if (bs_code == 6)
+    block = read_bits (&br, 8) + 1;
+  else if (bs_code == 7)
+    block = read_bits (&br, 16) + 1;
+  else
+    block = 256 << (bs_code - 8);
+  if (sr_code == 12)
+    read_bits (&br, 8);
+  else if (sr_code >= 13)
+    read_bits (&br, 16);
+  if (br.overrun || br.pos / 8 >= size)
+    return 0;
+  if (crc8 (data, br.pos / 8) != read_bits (&br, 8))
+    return -1;
+
+  channels = ch_code < 8 ? ch_code + 1 : 2;
+  bits = ss_code ? flac_sample_bits[ss_code] : dec->bits;
+  /* The format is fixed by STREAMINFO for the whole connection. */
+  if (channels != dec->channels || bits != dec->bits)
+    return -1;
+
+  if (dec->samples_size < block * channels) {
+    dec->samples_size = block * channels;
+    g_free (dec->samples);
+    dec->samples = g_new (gint32, dec->samples_size);
+  }
+  for (ch = 0; ch < channels; ch++) {
+    gboolean side = (ch_code == 8 && ch == 1) || (ch_code == 9 && ch == 0) ||
+        (ch_code == 10 && ch == 1);
+
+    if (!decode_flac_subframe (&br, bits + side, block,
+            dec->samples + ch * block) && !br.overrun)
+      return -1;
+    if (br.overrun)
+      break;
+  }
+  br.pos = (br.pos + 7) & ~(guint64) 7;
+  if (br.overrun || br.pos / 8 + 2 > size) {
+    /* Verbatim subframes are the largest a frame can be; waiting for more
+     * than that means the header was garbage. */
+    max_size = 32 + (gsize) channels * ((gsize) block * (bits + 1) / 8 + 16);
+    return size > max_size ? -1 : 0;
+  }
+  if (crc16 (data, br.pos / 8) != read_bits (&br, 16))
+    return -1;
+
+  if (ch_code >= 8) {
+    guint32 *a = (guint32 *) dec->samples, *b = a + block;
+
+    for (i = 0; i < block; i++) {
+      if (ch_code == 8) {
+        b[i] = a[i] - b[i];
+      } else if (ch_code == 9) {
+        a[i] += b[i];
+      } else {
+        guint32 mid = (a[i] << 1) | (b[i] & 1);
+
+        a[i] = (guint32) ((gint32) (mid + b[i]) >> 1);
+        b[i] = (guint32) ((gint32) (mid - b[i]) >> 1);
+      }
+    }
+  }
+
+  old = out->len;
+  if (bits <= 16) {
+    g_byte_array_set_size (out, old + block * channels * 2);
+    for (i = 0; i < block; i++) {
+      for (ch = 0; ch < channels; ch++)
+        GST_WRITE_UINT16_LE (out->data + old + (i * channels + ch) * 2,
+            (guint32) dec->samples[ch * block + i] << (16 - bits));
+    }
+  } else {
+    g_byte_array_set_size (out, old + block * channels * 4);
+    for (i = 0; i < block; i++) {
+      for (ch = 0; ch < channels; ch++)
+        GST_WRITE_UINT32_LE (out->data + old + (i * channels + ch) * 4,
+            (guint32) dec->samples[ch * block + i] << (32 - bits));
+    }
+  }
+  return br.pos / 8;
+}
+
+/** "fLaC" and the metadata blocks; returns bytes used, -1 if invalid. */
+static gssize
+parse_flac_header (NvDsAudioDecoder * dec, const guint8 * data, gsize size)
+{
+  gsize used = 0;
+
+  if (dec->stage == FLAC_STAGE_MAGIC) {
+    if (size < 4)
+      return 0;
+    if (memcmp (data, "fLaC", 4))
+      return -1;
+    dec->stage = FLAC_STAGE_METADATA;
+    used = 4;
+  }
+
+  while (dec->stage == FLAC_STAGE_METADATA && size - used >= 4) {
+    const guint8 *block = data + used;
+    guint type = block[0] & 0x7f;
+    gsize len = GST_READ_UINT24_BE (block + 1);
+
+    if (size - used < 4 + len)
+      break;
+    if (type == 0) {
+      guint64 info;
+
+      if (len < 34)
+        return -1;
+      info = GST_READ_UINT64_BE (block + 4 + 10);
+      dec->rate = info >> 44;
+      dec->channels = ((info >> 41) & 7) + 1;
+      dec->bits = ((info >> 36) & 31) + 1;
+      dec->have_streaminfo = TRUE;
+    }
+    used += 4 + len;
+    if (block[0] & 0x80) {
+      if (!dec->have_streaminfo || !dec->rate || dec->bits < 4 ||
+          dec->bits > FLAC_MAX_BITS)
+        return -1;
+      dec->stage = FLAC_STAGE_FRAMES;
+      dec->format = dec->bits <= 16 ? "S16LE" : "S32LE";
+      dec->have_format = TRUE;
+    }
+  }
+  return used;
+}
+
+static gssize
+decode_flac (NvDsAudioDecoder * dec, const guint8 * data, gsize size,
+    GByteArray * out)
+{
+  gsize used = 0;
+
+  if (dec->stage != FLAC_STAGE_FRAMES) {
+    gssize n = parse_flac_header (dec, data, size);
+
+    if (n < 0)
+      return -1;
+    used = n;
+  }
+
+  while (dec->stage == FLAC_STAGE_FRAMES && used < size) {
+    gssize n = decode_flac_frame (dec, data + used, size - used, out);
+
+    if (!n)
+      break;
+    if (n > 0) {
+      used += n;
+      continue;
+    }
+    /* Skip to the next sync code. */
+    dec->skipped++;
+    for (used++; used + 1 < size; used++) {
+      if (data[used] == 0xff && (data[used + 1] & 0xfe) == 0xf8)
+        break;
+    }
+  }
+  return used;
+}
+
+/* Ogg Opus. */
+
+static gboolean
+decode_opus_packet (NvDsAudioDecoder * dec, const guint8 * data, gsize size,
+    GByteArray * out)
+{
+  gint frames;
+  guint skip, old;
+
+  if (dec->packets == 0) {
+    if (size < 19 || memcmp (data, "OpusHead", 8) || (data[8] & 0xf0))
+      return FALSE;
+    dec->channels = data[9];
+    dec->pre_skip = GST_READ_UINT16_LE (data + 10);
+    dec->gain = pow (10.0, (gint16) GST_READ_UINT16_LE (data + 16) /
+        (20.0 * 256.0));
+    if (data[18] != 0 || !dec->channels || dec->channels > 2) {
+      NVGSTDS_ERR_MSG_V ("Opus channel mapping %u of %u channels not"
+          " supported", data[18], dec->channels);
+      return FALSE;
+    }
+    if (!(dec->opus_api = get_opus_api ()))
+      return FALSE;
+    if (dec->opus)
+      dec->opus_api->decoder_destroy (dec->opus);
+    dec->opus = dec->opus_api->decoder_create (OPUS_RATE, dec->channels,
+        &frames);
+    if (!dec->opus)
+      return FALSE;
+    if (!dec->pcm)
+      dec->pcm = g_new (gfloat, OPUS_MAX_FRAME * 2);
+    dec->rate = OPUS_RATE;
+    dec->format = "F32LE";
+    dec->have_format = TRUE;
+    dec->packets++;
+    return TRUE;
+  }
+  if (dec->packets++ == 1)
+    return TRUE;
+
+  frames = dec->opus_api->decode_float (dec->opus, data, size, dec->pcm,
+      OPUS_MAX_FRAME, 0);
+  if (frames < 0) {
+    dec->skipped++;
+    return TRUE;
+  }
+  /* The encoder delay at the start of the stream. */
+  skip = MIN ((guint) frames, dec->pre_skip);
+  dec->pre_skip -= skip;
+  frames -= skip;
+  old = out->len;
+  g_byte_array_set_size (out, old + frames * dec->channels * 4);
+  if (dec->gain != 1.0f) {
+    gfloat *pcm = dec->pcm + skip * dec->channels;
+    guint i;
+
+    for (i = 0; i < frames * dec->channels; i++)
+      pcm[i] *= dec->gain;
+  }
+  memcpy (out->data + old, dec->pcm + skip * dec->channels,
+      frames * dec->channels * 4);
+  return TRUE;
+}
+
+static gssize
+decode_ogg_opus (NvDsAudioDecoder * dec, const guint8 * data, gsize size,
+    GByteArray * out)
+{
+  gsize used = 0;
+
+  while (size - used >= OGG_HEADER_SIZE) {
+    const guint8 *page = data + used;
+    guint nsegs = page[26], i;
+    const guint8 *body = page + OGG_HEADER_SIZE + nsegs;
+    gsize body_size = 0, page_size;
+    guint32 serial;
+
+    if (memcmp (page, "OggS", 4) || page[4]) {
+      /* Lost sync: skip to the next capture pattern. */
+      dec->skipped++;
+      for (used++; used + 4 <= size; used++) {
+        if (!memcmp (data + used, "OggS", 4))
+          break;
+      }
+      continue;
+    }
+    if (size - used < OGG_HEADER_SIZE + nsegs)
+      break;
+    for (i = 0; i < nsegs; i++)
+      body_size += page[OGG_HEADER_SIZE + i];
+    page_size = OGG_HEADER_SIZE + nsegs + body_size;
+    if (size - used < page_size)
+      break;
+    used += page_size;
+
+    serial = GST_READ_UINT32_LE (page + 14);
+    if (page[5] & OGG_FLAG_BOS) {
+      /* A chained stream, e.g. after the microphone restarted its
+       * encoder; it must keep the format of the connection. */
+      guint channels = dec->channels;
+
+      dec->serial = serial;
+      dec->packets = 0;
+      g_byte_array_set_size (dec->packet, 0);
+      dec->skip_continued = FALSE;
+      if (dec->have_format) {
+        dec->have_format = FALSE;
+        if (!decode_opus_packet (dec, body, body_size, out) ||
+            dec->channels != channels)
+          return -1;
+        continue;
+      }
+    } else if (serial != dec->serial || !dec->packets) {
+      continue;
+    }
+
+    if (!(page[5] & OGG_FLAG_CONTINUED)) {
+      g_byte_array_set_size (dec->packet, 0);
+      dec->skip_continued = FALSE;
+    } else if (!dec->packet->len) {
+      dec->skip_continued = TRUE;
+    }
+    for (i = 0; i < nsegs; i++) {
+      guint lacing = page[OGG_HEADER_SIZE + i];
+
+      if (!dec->skip_continued)
+        g_byte_array_append (dec->packet, body, lacing);
+      body += lacing;
+      if (lacing < 255) {
+        if (!dec->skip_continued &&
+            !decode_opus_packet (dec, dec->packet->data, dec->packet->len,
+                out))
+          return -1;
+        g_byte_array_set_size (dec->packet, 0);
+        dec->skip_continued = FALSE;
+      }
+    }
+  }
+  return used;
+}
+
+gboolean
+nvds_audio_decoder_decode (NvDsAudioDecoder * dec, const guint8 * data,
+    gsize size, GByteArray * out)
+{
+  const guint8 *in = data;
+  gsize avail = size;
+  gssize used;
+
+  dec->bytes += size;
+  /* Decode straight from @p data unless a frame was left incomplete. */
+  if (dec->input->len) {
+    g_byte_array_append (dec->input, data, size);
+    in = dec->input->data;
+    avail = dec->input->len;
+  }
+
+  switch (dec->codec) {
+    case NVDS_AUDIO_CODEC_IMA_ADPCM:
+      used = decode_ima_adpcm (dec, in, avail, out);
+      break;
+    case NVDS_AUDIO_CODEC_FLAC:
+      used = decode_flac (dec, in, avail, out);
+      break;
+    case NVDS_AUDIO_CODEC_OPUS:
+      used = decode_ogg_opus (dec, in, avail, out);
+      break;
+    default:
+      used = -1;
+      break;
+  }
+  if (used < 0)
+    return FALSE;
+
+  if (dec->input->len)
+    g_byte_array_remove_range (dec->input, 0, used);
+  else
+    g_byte_array_append (dec->input, data + used, size - used);
+  return TRUE;
+}
+
+/* Decode pool. */
+
+typedef struct
+{
+  NvDsAudioDecoder *dec;
+  const guint8 *data;
+  gsize size;
+  GByteArray *out;
+  gboolean result;
+  gboolean done;
+  GMutex lock;
+  GCond cond;
+} DecodeJob;
+
+static void
+decode_pool_func (gpointer data, gpointer user_data)
+{
+  DecodeJob *job = (DecodeJob *) data;
+  gboolean result =
+      nvds_audio_decoder_decode (job->dec, job->data, job->size, job->out);
+
+  g_mutex_lock (&job->lock);
+  job->result = result;
+  job->done = TRUE;
+  g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->lock);
+}
+
+gboolean
+nvds_audio_decoder_decode_pooled (NvDsAudioDecoder * dec,
+    const guint8 * data, gsize size, GByteArray * out)
+{
+  static gsize initialized = 0;
+  static GThreadPool *pool = NULL;
+  DecodeJob job;
+
+  if (g_once_init_enter (&initialized)) {
+    pool = g_thread_pool_new (decode_pool_func, NULL,
+        MAX (g_get_num_processors (), 1), TRUE, NULL);
+    g_once_init_leave (&initialized, 1);
+  }
+  if (!pool)
+    return nvds_audio_decoder_decode (dec, data, size, out);
+
+  memset (&job, 0, sizeof (job));
+  job.dec = dec;
+  job.data = data;
+  job.size = size;
+  job.out = out;
+  g_mutex_init (&job.lock);
+  g_cond_init (&job.cond);
+  g_thread_pool_push (pool, &job, NULL);
+  g_mutex_lock (&job.lock);
+  while (!job.done)
+    g_cond_wait (&job.cond, &job.lock);
+  g_mutex_unlock (&job.lock);
+  g_mutex_clear (&job.lock);
+  g_cond_clear (&job.cond);
+  return job.result;
+}
+
+/* Encoders. */
+
+static void
+put_bits (BitWriter * bw, guint32 value, guint n)
+{
+  if (!n)
+    return;
+  bw->acc = (bw->acc << n) | (value & (n == 32 ? 0xffffffff :
+          (1u << n) - 1));
+  bw->bits += n;
+  while (bw->bits >= 8) {
+    guint8 byte = bw->acc >> (bw->bits - 8);
+
+    g_byte_array_append (bw->out, &byte, 1);
+    bw->bits -= 8;
+  }
+}
+
+static void
+put_signed (BitWriter * bw, gint32 value, guint n)
+{
+  put_bits (bw, (guint32) value, n);
+}
+
+static void
+align_bits (BitWriter * bw)
+{
+  if (bw->bits)
+    put_bits (bw, 0, 8 - bw->bits);
+}
+
+static GByteArray *
+encode_ima_adpcm (const gint16 * samples, guint num_frames, guint rate,
+    guint channels)
+{
+  guint block_align = IMA_ADPCM_BLOCK_ALIGN * channels;
+  guint block_frames = (block_align - 4 * channels) * 2 / channels + 1;
+  guint num_blocks = (num_frames + block_frames - 1) / block_frames;
+  GByteArray *out;
+  ImaState state[IMA_ADPCM_MAX_CHANNELS];
+  guint8 header[60];
+  guint b, ch, g, j;
+
+  if (!channels || channels > IMA_ADPCM_MAX_CHANNELS)
+    return NULL;
+  out = g_byte_array_sized_new (60 + num_blocks * block_align);
+  memset (state, 0, sizeof (state));
+
+  memcpy (header, "RIFF", 4);
+  GST_WRITE_UINT32_LE (header + 4, 52 + num_blocks * block_align);
+  memcpy (header + 8, "WAVEfmt ", 8);
+  GST_WRITE_UINT32_LE (header + 16, 20);
+  GST_WRITE_UINT16_LE (header + 20, 0x11);
+  GST_WRITE_UINT16_LE (header + 22, channels);
+  GST_WRITE_UINT32_LE (header + 24, rate);
+  GST_WRITE_UINT32_LE (header + 28,
+      (guint64) rate * block_align / block_frames);
+  GST_WRITE_UINT16_LE (header + 32, block_align);
+  GST_WRITE_UINT16_LE (header + 34, 4);
+  GST_WRITE_UINT16_LE (header + 36, 2);
+  GST_WRITE_UINT16_LE (header + 38, block_frames);
+  memcpy (header + 40, "fact", 4);
+  GST_WRITE_UINT32_LE (header + 44, 4);
+  GST_WRITE_UINT32_LE (header + 48, num_frames);
+  memcpy (header + 52, "data", 4);
+  GST_WRITE_UINT32_LE (header + 56, num_blocks * block_align);
+  g_byte_array_append (out, header, sizeof (header));
+
+  for (b = 0; b < num_blocks; b++) {
+    guint first = b * block_frames;
+    guint old = out->len;
+    guint8 *block;
+
+    g_byte_array_set_size (out, old + block_align);
+    block = out->data + old;
+    memset (block, 0, block_align);
+    /* The last block is padded with its last sample. */
+#define SAMPLE(f, c) samples[MIN (first + (f), num_frames - 1) * channels + (c)]
+    for (ch = 0; ch < channels; ch++) {
+      state[ch].pred = SAMPLE (0, ch);
+      GST_WRITE_UINT16_LE (block + 4 * ch, (gint16) state[ch].pred);
+      block[4 * ch + 2] = state[ch].index;
+    }
+    for (g = 0; g < (block_frames - 1) / 8; g++) {
+      for (ch = 0; ch < channels; ch++) {
+        guint8 *d = block + 4 * channels + (g * channels + ch) * 4;
+
+        for (j = 0; j < 8; j++) {
+          gint diff = SAMPLE (1 + g * 8 + j, ch) - state[ch].pred;
+          gint step = ima_step_table[state[ch].index];
+          guint nibble = 0;
+
+          if (diff < 0) {
+            nibble = 8;
+            diff = -diff;
+          }
+          if (diff >= step) {
+            nibble |= 4;
+            diff -= step;
+          }
+          step >>= 1;
+          if (diff >= step) {
+            nibble |= 2;
+            diff -= step;
+          }
+          step >>= 1;
+          if (diff >= step)
+            nibble |= 1;
+          ima_decode_nibble (&state[ch], nibble);
+          d[j / 2] |= nibble << ((j & 1) * 4);
+        }
+      }
+    }
+#undef SAMPLE
+  }
+  return out;
+}
+
+/** Bits of a partition of residuals coded with Rice parameter @p k. */
+static guint64
+rice_bits (const guint32 * u, guint n, guint k)
+{
+  guint64 bits = (guint64) n * (k + 1);
+  guint i;
+
+  for (i = 0; i < n; i++)
+    bits += u[i] >> k;
+  return bits;
+}
+
+/** Cheapest Rice parameter of a partition and its bits. */
+static guint
+best_rice_param (const guint32 * u, guint n, guint64 * bits)
+{
+  guint64 sum = 0;
+  guint i, k = 0, best_k = 0;
+  gint d;
+
+  for (i = 0; i < n; i++)
+    sum += u[i];
+  while (k < 14 && ((guint64) n << (k + 1)) < sum)
+    k++;
+  *bits = G_MAXUINT64;
+  for (d = -1; d <= 1; d++) {
+    guint64 b;
+
+    if ((gint) k + d < 0 || k + d > 14)
+      continue;
+    b = rice_bits (u, n, k + d);
+    if (b < *bits) {
+      *bits = b;
+      best_k = k + d;
+    }
+  }
+  return best_k;
+}
+
+static void
+encode_flac_subframe (BitWriter * bw, const gint32 * s, guint block,
+    guint32 * u)
+{
+  guint64 best_sum = G_MAXUINT64, best_bits = G_MAXUINT64;
+  guint order, best_order = 0, porder, best_porder = 0, i, p;
+  guint params[1 << FLAC_ENCODE_MAX_PARTITION_ORDER];
+
+  for (i = 1; i < block && s[i] == s[0]; i++);
+  if (i == block) {
+    put_bits (bw, 0, 8);
+    put_signed (bw, s[0], 16);
+    return;
+  }
+
+  /* The fixed predictor with the smallest residual. */
+  for (order = 0; order <= MIN (4, block - 1); order++) {
+    guint64 sum = 0;
+
+    for (i = order; i < block; i++) {
+      gint32 r = s[i];
+
+      if (order == 1)
+        r -= s[i - 1];
+      else if (order == 2)
+        r -= 2 * s[i - 1] - s[i - 2];
+      else if (order == 3)
+        r -= 3 * (s[i - 1] - s[i - 2]) + s[i - 3];
+      else if (order == 4)
+        r -= 4 * (s[i - 1] + s[i - 3]) - 6 * s[i - 2] - s[i - 4];
+      sum += ABS (r);
+    }
+    if (sum < best_sum) {
+      best_sum = sum;
+      best_order = order;
+    }
+  }
+  order = best_order;
+  for (i = order; i < block; i++) {
+    gint32 r = s[i];
+
+    if (order == 1)
+      r -= s[i - 1];
+    else if (order == 2)
+      r -= 2 * s[i - 1] - s[i - 2];
+    else if (order == 3)
+      r -= 3 * (s[i - 1] - s[i - 2]) + s[i - 3];
+    else if (order == 4)
+      r -= 4 * (s[i - 1] + s[i - 3]) - 6 * s[i - 2] - s[i - 4];
+    u[i - order] = ((guint32) r << 1) ^ (guint32) (r >> 31);
+  }
+
+  for (porder = 0; porder <= FLAC_ENCODE_MAX_PARTITION_ORDER; porder++) {
+    guint part_size = block >> porder;
+    guint64 bits = 0;
+
+    if (part_size << porder != block || part_size <= order)
+      break;
+    for (p = 0; p < 1u << porder; p++) {
+      guint64 b;
+      guint first = p ? p * part_size - order : 0;
+
+      best_rice_param (u + first, part_size - (p ? 0 : order), &b);
+      bits += b + 4;
+    }
+    if (bits < best_bits) {
+      best_bits = bits;
+      best_porder = porder;
+    }
+  }
+
+  if (best_bits + 4 * 16 >= (guint64) block * 16) {
+    put_bits (bw, 1 << 1, 8);
+    for (i = 0; i < block; i++)
+      put_signed (bw, s[i], 16);
+    return;
+  }
+
+  put_bits (bw, (8 + order) << 1, 8);
+  for (i = 0; i < order; i++)
+    put_signed (bw, s[i], 16);
+  put_bits (bw, 0, 2);
+  put_bits (bw, best_porder, 4);
+  for (p = 0; p < 1u << best_porder; p++) {
+    guint part_size = block >> best_porder;
+    guint first = p ? p * part_size - order : 0;
+    guint n = part_size - (p ? 0 : order);
+    guint64 b;
+
+    params[p] = best_rice_param (u + first, n, &b);
+    put_bits (bw, params[p], 4);
+    for (i = 0; i < n; i++) {
+      guint32 q = u[first + i] >> params[p];
+
+      while (q >= 32) {
+        put_bits (bw, 0, 32);
+        q -= 32;
+      }
+      put_bits (bw, 1, q + 1);
+      put_bits (bw, u[first + i], params[p]);
+    }
+  }
+}
+
+static GByteArray *
+encode_flac (const gint16 * samples, guint num_frames, guint rate,
+    guint channels)
+{
+  BitWriter bw = { NULL, 0, 0 };
+  gint32 *s;
+  guint32 *u;
+  guint sr_code = 0, first, frame_num = 0, ch, i;
+
+  if (!channels || channels > FLAC_MAX_CHANNELS || !rate || rate >= 1 << 20)
+    return NULL;
+  init_crc_tables ();
+  for (i = 1; i < G_N_ELEMENTS (flac_sample_rates); i++) {
+    if (flac_sample_rates[i] == rate)
+      sr_code = i;
+  }
+
+  bw.out = g_byte_array_new ();
+  g_byte_array_append (bw.out, (const guint8 *) "fLaC", 4);
+  put_bits (&bw, 0x80, 8);
+  put_bits (&bw, 34, 24);
+  put_bits (&bw, FLAC_ENCODE_BLOCK, 16);
+  put_bits (&bw, FLAC_ENCODE_BLOCK, 16);
+  put_bits (&bw, 0, 24);
+  put_bits (&bw, 0, 24);
+  put_bits (&bw, rate, 20);
+  put_bits (&bw, channels - 1, 3);
+  put_bits (&bw, 15, 5);
+  /* Length and MD5 unknown, as of a live stream. */
+  put_bits (&bw, 0, 4);
+  for (i = 0; i < 5; i++)
+    put_bits (&bw, 0, 32);
+
+  s = g_new (gint32, FLAC_ENCODE_BLOCK);
+  u = g_new (guint32, FLAC_ENCODE_BLOCK);
+  for (first = 0; first < num_frames; first += FLAC_ENCODE_BLOCK) {
+    guint block = MIN (FLAC_ENCODE_BLOCK, num_frames - first);
+    guint start = bw.out->len;
+    guint32 n = frame_num++;
+
+    put_bits (&bw, 0xfff8, 16);
+    put_bits (&bw, block == FLAC_ENCODE_BLOCK ? 12 : 7, 4);
+    put_bits (&bw, sr_code, 4);
+    put_bits (&bw, channels - 1, 4);
+    put_bits (&bw, 4, 3);
+    put_bits (&bw, 0, 1);
+    if (n < 0x80) {
+      put_bits (&bw, n, 8);
+    } else {
+      guint extra = n < 0x800 ? 1 : n < 0x10000 ? 2 : n < 0x200000 ? 3 :
+          n < 0x4000000 ? 4 : 5;
+
+      put_bits (&bw, ((0xff00 >> (extra + 1)) & 0xff) |
+          (n >> (6 * extra)), 8);
+      while (extra--)
+        put_bits (&bw, 0x80 | ((n >> (6 * extra)) & 0x3f), 8);
+    }
+    if (block != FLAC_ENCODE_BLOCK)
+      put_bits (&bw, block - 1, 16);
+    put_bits (&bw, crc8 (bw.out->data + start, bw.out->len - start), 8);
+
+    for (ch = 0; ch < channels; ch++) {
+      for (i = 0; i < block; i++)
+        s[i] = samples[(gsize) (first + i) * channels + ch];
+      encode_flac_subframe (&bw, s, block, u);
+    }
+    align_bits (&bw);
+    put_bits (&bw, crc16 (bw.out->data + start, bw.out->len - start), 16);
+  }
+  g_free (s);
+  g_free (u);
+  return bw.out;
+}
+
+static void
+write_ogg_page (GByteArray * out, guint8 flags, guint64 granule,
+    guint32 serial, guint32 seq, const guint8 * lacing, guint nsegs,
+    const guint8 * body, gsize body_size)
+{
+  guint8 header[OGG_HEADER_SIZE];
+  guint start = out->len;
+
+  memcpy (header, "OggS", 4);
+  header[4] = 0;
+  header[5] = flags;
+  GST_WRITE_UINT64_LE (header + 6, granule);
+  GST_WRITE_UINT32_LE (header + 14, serial);
+  GST_WRITE_UINT32_LE (header + 18, seq);
+  GST_WRITE_UINT32_LE (header + 22, 0);
+  header[26] = nsegs;
+  g_byte_array_append (out, header, sizeof (header));
+  g_byte_array_append (out, lacing, nsegs);
+  g_byte_array_append (out, body, body_size);
+  GST_WRITE_UINT32_LE (out->data + start + 22,
+      ogg_crc (out->data + start, out->len - start));
+}
+
+/** Lacing values of a packet of @p size bytes. */
+static guint
+lace_packet (guint8 * lacing, gsize size)
+{
+  guint n = 0;
+
+  while (size >= 255) {
+    lacing[n++] = 255;
+    size -= 255;
+  }
+  lacing[n++] = size;
+  return n;
+}
+
+static GByteArray *
+encode_ogg_opus (const gint16 * samples, guint num_frames, guint rate,
+    guint channels, guint bitrate)
+{
+  const OpusApi *api = get_opus_api ();
+  guint frame = rate / 50;
+  guint32 serial = 0x42697264, seq = 0;
+  guint8 head[19], tags[24], lacing[255];
+  guint8 *packet;
+  gint16 *pcm;
+  GByteArray *out, *body;
+  gpointer enc;
+  gint err = 0, lookahead = 0;
+  guint nsegs = 0, packets = 0, pre_skip, first;
+  guint64 granule;
+
+  if (!api || !channels || channels > 2 || (rate != 8000 && rate != 12000 &&
+          rate != 16000 && rate != 24000 && rate != 48000))
+    return NULL;
+  enc = api->encoder_create (rate, channels, OPUS_APPLICATION_AUDIO, &err);
+  if (!enc)
+    return NULL;
+  api->encoder_ctl (enc, OPUS_SET_BITRATE_REQUEST, (gint32) bitrate);
+  api->encoder_ctl (enc, OPUS_GET_LOOKAHEAD_REQUEST, &lookahead);
+  pre_skip = (guint64) lookahead * OPUS_RATE / rate;
+  init_crc_tables ();
+
+  out = g_byte_array_new ();
+  memcpy (head, "OpusHead", 8);
+  head[8] = 1;
+  head[9] = channels;
+  GST_WRITE_UINT16_LE (head + 10, pre_skip);
+  GST_WRITE_UINT32_LE (head + 12, rate);
+  GST_WRITE_UINT16_LE (head + 16, 0);
+  head[18] = 0;
+  nsegs = lace_packet (lacing, sizeof (head));
+  write_ogg_page (out, OGG_FLAG_BOS, 0, serial, seq++, lacing, nsegs, head,
+      sizeof (head));
+  memcpy (tags, "OpusTags", 8);
+  GST_WRITE_UINT32_LE (tags + 8, 8);
+  memcpy (tags + 12, "BirdEdge", 8);
+  GST_WRITE_UINT32_LE (tags + 20, 0);
+  nsegs = lace_packet (lacing, sizeof (tags));
+  write_ogg_page (out, 0, 0, serial, seq++, lacing, nsegs, tags,
+      sizeof (tags));
+
+  body = g_byte_array_new ();
+  packet = g_malloc (OPUS_MAX_PACKET);
+  pcm = g_new0 (gint16, (gsize) frame * channels);
+  nsegs = 0;
+  for (first = 0; first < num_frames; first += frame) {
+    guint n = MIN (frame, num_frames - first);
+    gint32 size;
+    gboolean last = first + frame >= num_frames;
+
+    memset (pcm, 0, (gsize) frame * channels * sizeof (gint16));
+    memcpy (pcm, samples + (gsize) first * channels,
+        (gsize) n * channels * sizeof (gint16));
+    size = api->encode (enc, pcm, frame, packet, OPUS_MAX_PACKET);
+    if (size < 0) {
+      g_byte_array_free (out, TRUE);
+      out = NULL;
+      break;
+    }
+    nsegs += lace_packet (lacing + nsegs, size);
+    g_byte_array_append (body, packet, size);
+    packets++;
+
+    if (last || packets == OPUS_ENCODE_PACKETS_PER_PAGE || nsegs > 255 - 17) {
+      granule = (guint64) (first + n) * OPUS_RATE / rate + pre_skip;
+      write_ogg_page (out, last ? OGG_FLAG_EOS : 0, granule, serial, seq++,
+          lacing, nsegs, body->data, body->len);
+      g_byte_array_set_size (body, 0);
+      nsegs = packets = 0;
+    }
+  }
+  api->encoder_destroy (enc);
+  g_byte_array_free (body, TRUE);
+  g_free (packet);
+  g_free (pcm);
+  return out;
+}
+
+GByteArray *
+nvds_audio_encode (NvDsAudioCodec codec, const gint16 * samples,
+    guint num_frames, guint rate, guint channels, guint bitrate)
+{
+  if (!num_frames)
+    return NULL;
+  switch (codec) {
+    case NVDS_AUDIO_CODEC_IMA_ADPCM:
+      return encode_ima_adpcm (samples, num_frames, rate, channels);
+    case NVDS_AUDIO_CODEC_FLAC:
+      return encode_flac (samples, num_frames, rate, channels);
+    case NVDS_AUDIO_CODEC_OPUS:
+      return encode_ogg_opus (samples, num_frames, rate, channels, bitrate);
+    default:
+      return NULL;
+  }
+}
@@ -0,0 +1,1182 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <gst/gst.h>
+
+#include "deepstream_common.h"
+#include "deepstream_audio_features.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define MEL_HAVE_NEON 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MEL_HAVE_AVX2 1
+#endif
+
+/** Smallest power considered by power_to_db when p2db_min_power is 0. */
+#define MEL_MIN_POWER 1e-10f
+
+/*
+ * Structure-of-arrays kernel: lane l of every vector belongs to column l of
+ * a batch, so all FFT stages (including the first, short ones) and the mel
+ * projection run at full SIMD width regardless of the fft_length.
+ */
+#if defined(__aarch64__)
+#define MEL_SOA_LANES 4
+#define MEL_SOA_CLONES
+#elif defined(__x86_64__)
+#define MEL_SOA_LANES 8
+#define MEL_SOA_CLONES __attribute__ ((target_clones ("avx2", "default")))
+#else
+#define MEL_SOA_LANES 4
+#define MEL_SOA_CLONES
+#endif
+
+typedef gfloat mel_vec
+    __attribute__ ((vector_size (MEL_SOA_LANES * sizeof (gfloat))));
+typedef gint32 mel_ivec
+    __attribute__ ((vector_size (MEL_SOA_LANES * sizeof (gint32))));
+
+/*
+ * Transform size of the deployed model. A melsdb transform with this FFT
+ * length and number of mels runs a copy of the batched kernel compiled for
+ * these constants; hop_size, sample_rate, fmin and fmax only enter the
+ * tables.
+ */
+#define MEL_FIXED_FFT_LENGTH 1024
+#define MEL_FIXED_NUM_MELS 128
+
+typedef struct
+{
+  const gchar *name;
+  /** Number of floats processed per instruction. */
+  guint lanes;
+  /** One radix-2 stage of an m point complex FFT; half >= lanes. */
+  void (*butterflies) (gfloat *re, gfloat *im, guint m, guint half,
+      const gfloat *wr, const gfloat *wi);
+  /** Power spectrum of the real input from its half size complex FFT. */
+  void (*rfft_power) (const NvDsMelFrontend *fe, const gfloat *re,
+      const gfloat *im, gfloat *power);
+  gfloat (*dot) (const gfloat *a, const gfloat *b, guint n);
+} NvDsMelKernels;
+
+struct _NvDsMelFrontend
+{
+  NvDsAudioTransformParams params;
+  const NvDsMelKernels *kernels;
+  guint num_bins;
+  gfloat *window;
+  /**
+   * The fft_length real FFT is computed as a complex FFT of half the size.
+   * Stage twiddles are stored contiguously (half - 1 is the stage offset),
+   * post twiddles split the result into the real spectrum.
+   */
+  guint *bitrev;
+  gfloat *stage_re;
+  gfloat *stage_im;
+  gfloat *post_re;
+  gfloat *post_im;
+  /** Mel filter bank stored as one band of non-zero weights per mel. */
+  guint *band_start;
+  guint *band_len;
+  guint *band_offset;
+  gfloat *band_weights;
+  gfloat db_offset;
+  gfloat min_power;
+  /** Power bins [power_first, power_end) touched by any mel band. */
+  guint power_first;
+  guint power_end;
+  /** Use the kernel compiled for the MEL_FIXED_* transform size. */
+  gboolean fixed;
+};
+
+static void
+butterflies_scalar (gfloat *re, gfloat *im, guint m, guint half,
+    const gfloat *wr, const gfloat *wi)
+{
+  guint i, j;
+
+  for (i = 0; i < m; i += 2 * half) {
+    for (j = 0; j < half; j++) {
+      guint a = i + j, b = i + j + half;
+      gfloat tr = re[b] * wr[j] - im[b] * wi[j];
+      gfloat ti = re[b] * wi[j] + im[b] * wr[j];
+      re[b] = re[a] - tr;
+      im[b] = im[a] - ti;
+      re[a] += tr;
+      im[a] += ti;
+    }
+  }
+}
+
+/* Bin k of the real spectrum from bins k and m - k of the complex FFT. */
+static inline gfloat
+rfft_power_bin (const NvDsMelFrontend *fe, const gfloat *re,
+    const gfloat *im, guint k)
+{
+  guint m = fe->params.fft_length / 2;
+  guint a = k % m, b = (m - k) % m;
+  gfloat er = 0.5f * (re[a] + re[b]);
+  gfloat ei = 0.5f * (im[a] - im[b]);
+  gfloat odr = 0.5f * (im[a] + im[b]);
+  gfloat odi = -0.5f * (re[a] - re[b]);
+  gfloat xr = er + fe->post_re[k] * odr - fe->post_im[k] * odi;
+  gfloat xi = ei + fe->post_re[k] * odi + fe->post_im[k] * odr;
+  return xr * xr + xi * xi;
+}
+
+static void
+rfft_power_scalar (const NvDsMelFrontend *fe, const gfloat *re,
+    const gfloat *im, gfloat *power)
+{
+  guint k;
+
+  for (k = 0; k < fe->num_bins; k++)
+    power[k] = rfft_power_bin (fe, re, im, k);
+}
+
+static gfloat
+dot_scalar (const gfloat *a, const gfloat *b, guint n)
+{
+  gfloat acc = 0.0f;
+  guint i;
+
+  for (i = 0; i < n; i++)
+    acc += a[i] * b[i];
+  return acc;
+}
+
+static const NvDsMelKernels mel_kernels_scalar = {
+  "scalar", 1, butterflies_scalar, rfft_power_scalar, dot_scalar
+};
+
+#ifdef MEL_HAVE_NEON
+static void
+butterflies_neon (gfloat *re, gfloat *im, guint m, guint half,
+    const gfloat *wr, const gfloat *wi)
+{
+  guint i, j;
+
+  for (i = 0; i < m; i += 2 * half) {
+    for (j = 0; j < half; j += 4) {
+      float32x4_t w_r = vld1q_f32 (wr + j), w_i = vld1q_f32 (wi + j);
+      float32x4_t ar = vld1q_f32 (re + i + j), ai = vld1q_f32 (im + i + j);
+      float32x4_t br = vld1q_f32 (re + i + j + half);
+      float32x4_t bi = vld1q_f32 (im + i + j + half);
+      float32x4_t tr = vfmsq_f32 (vmulq_f32 (br, w_r), bi, w_i);
+      float32x4_t ti = vfmaq_f32 (vmulq_f32 (br, w_i), bi, w_r);
+      vst1q_f32 (re + i + j + half, vsubq_f32 (ar, tr));
+      vst1q_f32 (im + i + j + half, vsubq_f32 (ai, ti));
+      vst1q_f32 (re + i + j, vaddq_f32 (ar, tr));
+      vst1q_f32 (im + i + j, vaddq_f32 (ai, ti));
+    }
+  }
+}
+
+static inline float32x4_t
+reverse_neon (float32x4_t v)
+{
+  v = vrev64q_f32 (v);
+  return vcombine_f32 (vget_high_f32 (v), vget_low_f32 (v));
+}
+
+static void
+rfft_power_neon (const NvDsMelFrontend *fe, const gfloat *re,
+    const gfloat *im, gfloat *power)
+{
+  guint m = fe->params.fft_length / 2;
+  const float32x4_t half = vdupq_n_f32 (0.5f);
+  guint k = 1;
+
+  power[0] = rfft_power_bin (fe, re, im, 0);
+  for (; k + 4 <= m; k += 4) {
+    float32x4_t zr = vld1q_f32 (re + k), zi = vld1q_f32 (im + k);
+    float32x4_t cr = reverse_neon (vld1q_f32 (re + m - k - 3));
+    float32x4_t ci = reverse_neon (vld1q_f32 (im + m - k - 3));
+    float32x4_t wr = vld1q_f32 (fe->post_re + k);
+    float32x4_t wi = vld1q_f32 (fe->post_im + k);
+    float32x4_t er = vmulq_f32 (half, vaddq_f32 (zr, cr));
+    float32x4_t ei = vmulq_f32 (half, vsubq_f32 (zi, ci));
+    float32x4_t odr = vmulq_f32 (half, vaddq_f32 (zi, ci));
+    float32x4_t odi = vmulq_f32 (half, vsubq_f32 (cr, zr));
+    float32x4_t xr = vfmsq_f32 (vfmaq_f32 (er, wr, odr), wi, odi);
+    float32x4_t xi = vfmaq_f32 (vfmaq_f32 (ei, wr, odi), wi, odr);
+    vst1q_f32 (power + k, vfmaq_f32 (vmulq_f32 (xr, xr), xi, xi));
+  }
+  for (; k <= m; k++)
+    power[k] = rfft_power_bin (fe, re, im, k);
+}
+
+static gfloat
+dot_neon (const gfloat *a, const gfloat *b, guint n)
+{
+  float32x4_t acc = vdupq_n_f32 (0.0f);
+  gfloat sum;
+  guint i = 0;
+
+  for (; i + 4 <= n; i += 4)
+    acc = vfmaq_f32 (acc, vld1q_f32 (a + i), vld1q_f32 (b + i));
+  sum = vaddvq_f32 (acc);
+  for (; i < n; i++)
+    sum += a[i] * b[i];
+  return sum;
+}
+
+static const NvDsMelKernels mel_kernels_neon = {
+  "neon", 4, butterflies_neon, rfft_power_neon, dot_neon
+};
+#endif
+
+#ifdef MEL_HAVE_AVX2
+#define MEL_AVX2 __attribute__ ((target ("avx2,fma")))
+
+static MEL_AVX2 void
+butterflies_avx2 (gfloat *re, gfloat *im, guint m, guint half,
+    const gfloat *wr, const gfloat *wi)
+{
+  guint i, j;
+
+  for (i = 0; i < m; i += 2 * half) {
+    for (j = 0; j < half; j += 8) {
+      __m256 w_r = _mm256_loadu_ps (wr + j), w_i = _mm256_loadu_ps (wi + j);
+      __m256 ar = _mm256_loadu_ps (re + i + j);
+      __m256 ai = _mm256_loadu_ps (im + i + j);
+      __m256 br = _mm256_loadu_ps (re + i + j + half);
+      __m256 bi = _mm256_loadu_ps (im + i + j + half);
+      __m256 tr = _mm256_fmsub_ps (br, w_r, _mm256_mul_ps (bi, w_i));
+      __m256 ti = _mm256_fmadd_ps (br, w_i, _mm256_mul_ps (bi, w_r));
+      _mm256_storeu_ps (re + i + j + half, _mm256_sub_ps (ar, tr));
+      _mm256_storeu_ps (im + i + j + half, _mm256_sub_ps (ai, ti));
+      _mm256_storeu_ps (re + i + j, _mm256_add_ps (ar, tr));
+      _mm256_storeu_ps (im + i + j, _mm256_add_ps (ai, ti));
+    }
+  }
+}
+
+static MEL_AVX2 void
+rfft_power_avx2 (const NvDsMelFrontend *fe, const gfloat *re,
+    const gfloat *im, gfloat *power)
+{
+  guint m = fe->params.fft_length / 2;
+  const __m256 half = _mm256_set1_ps (0.5f);
+  const __m256i rev = _mm256_set_epi32 (0, 1, 2, 3, 4, 5, 6, 7);
+  guint k = 1;
+
+  power[0] = rfft_power_bin (fe, re, im, 0);
+  for (; k + 8 <= m; k += 8) {
+    __m256 zr = _mm256_loadu_ps (re + k), zi = _mm256_loadu_ps (im + k);
+    __m256 cr = _mm256_permutevar8x32_ps (_mm256_loadu_ps (re + m - k - 7),
+        rev);
+    __m256 ci = _mm256_permutevar8x32_ps (_mm256_loadu_ps (im + m - k - 7),
+        rev);
+    __m256 wr = _mm256_loadu_ps (fe->post_re + k);
+    __m256 wi = _mm256_loadu_ps (fe->post_im + k);
+    __m256 er = _mm256_mul_ps (half, _mm256_add_ps (zr, cr));
+    __m256 ei = _mm256_mul_ps (half, _mm256_sub_ps (zi, ci));
+    __m256 odr = _mm256_mul_ps (half, _mm256_add_ps (zi, ci));
+    __m256 odi = _mm256_mul_ps (half, _mm256_sub_ps (cr, zr));
+    __m256 xr = _mm256_fnmadd_ps (wi, odi, _mm256_fmadd_ps (wr, odr, er));
+    __m256 xi = _mm256_fmadd_ps (wi, odr, _mm256_fmadd_ps (wr, odi, ei));
+    _mm256_storeu_ps (power + k,
+        _mm256_fmadd_ps (xi, xi, _mm256_mul_ps (xr, xr)));
+  }
+  for (; k <= m; k++)
+    power[k] = rfft_power_bin (fe, re, im, k);
+}
+
+static MEL_AVX2 gfloat
+dot_avx2 (const gfloat *a, const gfloat *b, guint n)
+{
+  __m256 acc = _mm256_setzero_ps ();
+  __m128 s;
+  gfloat sum;
+  guint i = 0;
+
+  for (; i + 8 <= n; i += 8)
+    acc = _mm256_fmadd_ps (_mm256_loadu_ps (a + i), _mm256_loadu_ps (b + i),
+        acc);
+  s = _mm_add_ps (_mm256_castps256_ps128 (acc),
+      _mm256_extractf128_ps (acc, 1));
+  s = _mm_add_ps (s, _mm_movehl_ps (s, s));
+  s = _mm_add_ss (s, _mm_shuffle_ps (s, s, 1));
+  sum = _mm_cvtss_f32 (s);
+  for (; i < n; i++)
+    sum += a[i] * b[i];
+  return sum;
+}
+
+static const NvDsMelKernels mel_kernels_avx2 = {
+  "avx2", 8, butterflies_avx2, rfft_power_avx2, dot_avx2
+};
+#endif
+
+static const NvDsMelKernels *
+select_mel_kernels (NvDsMelKernel kernel)
+{
+#ifdef MEL_HAVE_NEON
+  if (kernel == NVDS_MEL_KERNEL_AUTO || kernel == NVDS_MEL_KERNEL_NEON)
+    return &mel_kernels_neon;
+#endif
+#ifdef MEL_HAVE_AVX2
+  if ((kernel == NVDS_MEL_KERNEL_AUTO || kernel == NVDS_MEL_KERNEL_AVX2) &&
+      __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+    return &mel_kernels_avx2;
+#endif
+  if (kernel != NVDS_MEL_KERNEL_AUTO && kernel != NVDS_MEL_KERNEL_SCALAR)
+    NVGSTDS_WARN_MSG_V ("Requested mel kernel not supported on this CPU;"
+        " using scalar kernel");
+  return &mel_kernels_scalar;
+}
+
+static gboolean
+get_uint_field (const GstStructure *s, const gchar *name, guint *value)
+{
+  gint v;
+  if (!gst_structure_has_field (s, name))
+    return TRUE;
+  if (!gst_structure_get_int (s, name, &v) || v <= 0) {
+    NVGSTDS_ERR_MSG_V ("audio-transform field '%s' must be a positive integer",
+        name);
+    return FALSE;
+  }
+  *value = v;
+  return TRUE;
+}
+
+static gboolean
+get_float_field (const GstStructure *s, const gchar *name, gfloat *value)
+{
+  const GValue *v = gst_structure_get_value (s, name);
+  if (!v)
+    return TRUE;
+  if (G_VALUE_HOLDS_FLOAT (v))
+    *value = g_value_get_float (v);
+  else if (G_VALUE_HOLDS_DOUBLE (v))
+    *value = g_value_get_double (v);
+  else if (G_VALUE_HOLDS_INT (v))
+    *value = g_value_get_int (v);
+  else {
+    NVGSTDS_ERR_MSG_V ("audio-transform field '%s' must be a number", name);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+gboolean
+nvds_audio_transform_params_parse (const gchar *transform,
+    NvDsAudioTransformParams *params)
+{
+  gboolean ret = FALSE;
+  GstStructure *s = NULL;
+  const gchar *window;
+
+  memset (params, 0, sizeof (*params));
+  params->fft_length = 1024;
+  params->hop_size = 512;
+  params->num_mels = 128;
+  params->sample_rate = 44100;
+  params->p2db_ref = 1.0f;
+  params->p2db_top_db = 80.0f;
+
+  if (!transform) {
+    NVGSTDS_ERR_MSG_V ("audio-transform not configured");
+    goto done;
+  }
+
+  s = gst_structure_from_string (transform, NULL);
+  if (!s) {
+    NVGSTDS_ERR_MSG_V ("Could not parse audio-transform '%s'", transform);
+    goto done;
+  }
+
+  if (!gst_structure_has_name (s, "melsdb")) {
+    NVGSTDS_ERR_MSG_V ("Unsupported audio-transform '%s'; only melsdb is"
+        " implemented", gst_structure_get_name (s));
+    goto done;
+  }
+
+  window = gst_structure_get_string (s, "dsp_window");
+  if (window && g_strcmp0 (window, "hann")) {
+    NVGSTDS_ERR_MSG_V ("Unsupported dsp_window '%s'", window);
+    goto done;
+  }
+
+  if (!get_uint_field (s, "fft_length", &params->fft_length) ||
+      !get_uint_field (s, "hop_size", &params->hop_size) ||
+      !get_uint_field (s, "num_mels", &params->num_mels) ||
+      !get_uint_field (s, "sample_rate", &params->sample_rate) ||
+      !get_float_field (s, "fmin", &params->fmin) ||
+      !get_float_field (s, "fmax", &params->fmax) ||
+      !get_float_field (s, "p2db_ref", &params->p2db_ref) ||
+      !get_float_field (s, "p2db_min_power", &params->p2db_min_power) ||
+      !get_float_field (s, "p2db_top_db", &params->p2db_top_db))
+    goto done;
+
+  if (params->fft_length < 4 || params->fft_length & (params->fft_length - 1)) {
+    NVGSTDS_ERR_MSG_V ("fft_length %u is not a power of two >= 4",
+        params->fft_length);
+    goto done;
+  }
+  if (params->fmax <= 0.0f)
+    params->fmax = params->sample_rate / 2.0f;
+
+  ret = TRUE;
+done:
+  if (s)
+    gst_structure_free (s);
+  return ret;
+}
+
+guint
+nvds_audio_transform_num_frames (const NvDsAudioTransformParams *params,
+    guint frame_size)
+{
+  if (frame_size < params->fft_length)
+    return 0;
+  return 1 + (frame_size - params->fft_length) / params->hop_size;
+}
+
+/* Slaney mel scale, as used by librosa by default. */
+static gdouble
+hz_to_mel (gdouble hz)
+{
+  const gdouble f_sp = 200.0 / 3.0;
+  const gdouble min_log_hz = 1000.0;
+  const gdouble min_log_mel = min_log_hz / f_sp;
+  const gdouble logstep = log (6.4) / 27.0;
+
+  if (hz < min_log_hz)
+    return hz / f_sp;
+  return min_log_mel + log (hz / min_log_hz) / logstep;
+}
+
+static gdouble
+mel_to_hz (gdouble mel)
+{
+  const gdouble f_sp = 200.0 / 3.0;
+  const gdouble min_log_hz = 1000.0;
+  const gdouble min_log_mel = min_log_hz / f_sp;
+  const gdouble logstep = log (6.4) / 27.0;
+
+  if (mel < min_log_mel)
+    return mel * f_sp;
+  return min_log_hz * exp (logstep * (mel - min_log_mel));
+}
+
+/* Slaney-normalized triangular filters (librosa.filters.mel defaults). */
+static void
+build_mel_bands (NvDsMelFrontend *fe)
+{
+  const NvDsAudioTransformParams *p = &fe->params;
+  guint n_mels = p->num_mels;
+  gdouble *mel_f = g_new0 (gdouble, n_mels + 2);
+  gdouble *weights = g_new0 (gdouble, fe->num_bins);
+  gdouble mel_min = hz_to_mel (p->fmin);
+  gdouble mel_max = hz_to_mel (p->fmax);
+  guint total = 0;
+  guint m, k;
+
+  for (m = 0; m < n_mels + 2; m++)
+    mel_f[m] = mel_to_hz (mel_min + (mel_max - mel_min) * m / (n_mels + 1));
+
+  fe->band_start = g_new0 (guint, n_mels);
+  fe->band_len = g_new0 (guint, n_mels);
+  fe->band_offset = g_new0 (guint, n_mels);
+  fe->band_weights = g_new0 (gfloat, n_mels * fe->num_bins);
+  fe->power_first = fe->num_bins;
+  fe->power_end = 0;
+
+  for (m = 0; m < n_mels; m++) {
+    gdouble enorm = 2.0 / (mel_f[m + 2] - mel_f[m]);
+    gint first = -1, last = -1;
+
+    for (k = 0; k < fe->num_bins; k++) {
+      gdouble freq = (gdouble) k * p->sample_rate / p->fft_length;
+      gdouble lower = (freq - mel_f[m]) / (mel_f[m + 1] - mel_f[m]);
+      gdouble upper = (mel_f[m + 2] - freq) / (mel_f[m + 2] - mel_f[m + 1]);
+      weights[k] = MAX (0.0, MIN (lower, upper)) * enorm;
+      if (weights[k] > 0.0) {
+        if (first < 0)
+          first = k;
+        last = k;
+      }
+    }
+
+    fe->band_offset[m] = total;
+    if (first < 0)
+      continue;
+    fe->band_start[m] = first;
+    fe->band_len[m] = last - first + 1;
+    fe->power_first = MIN (fe->power_first, (guint) first);
+    fe->power_end = MAX (fe->power_end, (guint) last + 1);
+    for (k = 0; k < fe->band_len[m]; k++)
+      fe->band_weights[total + k] = weights[first + k];
+    total += fe->band_len[m];
+  }
+
+  g_free (weights);
+  g_free (mel_f);
+
+  if (fe->power_first > fe->power_end)
+    fe->power_first = fe->power_end = 0;
+}
+
+NvDsMelFrontend *
+nvds_mel_frontend_new_full (const NvDsAudioTransformParams *params,
+    NvDsMelKernel kernel, gboolean specialize)
+{
+  NvDsMelFrontend *fe = g_new0 (NvDsMelFrontend, 1);
+  guint n = params->fft_length;
+  guint m = n / 2;
+  guint bits = 0;
+  guint i, half;
+
+  fe->params = *params;
+  fe->kernels = select_mel_kernels (kernel);
+  fe->num_bins = m + 1;
+
+  /* Periodic Hann window, as scipy.signal.get_window ("hann", n). */
+  fe->window = g_new (gfloat, n);
+  for (i = 0; i < n; i++)
+    fe->window[i] = 0.5 - 0.5 * cos (2.0 * G_PI * i / n);
+
+  while ((1u << bits) < m)
+    bits++;
+  fe->bitrev = g_new (guint, m);
+  for (i = 0; i < m; i++) {
+    guint r = 0, b;
+    for (b = 0; b < bits; b++)
+      r |= ((i >> b) & 1) << (bits - 1 - b);
+    fe->bitrev[i] = r;
+  }
+
+  fe->stage_re = g_new (gfloat, MAX (m, 1));
+  fe->stage_im = g_new (gfloat, MAX (m, 1));
+  for (half = 1; half < m; half <<= 1) {
+    for (i = 0; i < half; i++) {
+      fe->stage_re[half - 1 + i] = cos (G_PI * i / half);
+      fe->stage_im[half - 1 + i] = -sin (G_PI * i / half);
+    }
+  }
+
+  fe->post_re = g_new (gfloat, m + 1);
+  fe->post_im = g_new (gfloat, m + 1);
+  for (i = 0; i <= m; i++) {
+    fe->post_re[i] = cos (2.0 * G_PI * i / n);
+    fe->post_im[i] = -sin (2.0 * G_PI * i / n);
+  }
+
+  build_mel_bands (fe);
+
+  fe->min_power = MAX (params->p2db_min_power, MEL_MIN_POWER);
+  fe->db_offset = 10.0f * log10f (MAX (params->p2db_ref, fe->min_power));
+
+  fe->fixed = specialize && fe->kernels != &mel_kernels_scalar &&
+      params->fft_length == MEL_FIXED_FFT_LENGTH &&
+      params->num_mels == MEL_FIXED_NUM_MELS;
+
+  return fe;
+}
+
+NvDsMelFrontend *
+nvds_mel_frontend_new_with_kernel (const NvDsAudioTransformParams *params,
+    NvDsMelKernel kernel)
+{
+  return nvds_mel_frontend_new_full (params, kernel, TRUE);
+}
+
+NvDsMelFrontend *
+nvds_mel_frontend_new (const NvDsAudioTransformParams *params)
+{
+  return nvds_mel_frontend_new_with_kernel (params, NVDS_MEL_KERNEL_AUTO);
+}
+
+void
+nvds_mel_frontend_free (NvDsMelFrontend *fe)
+{
+  if (!fe)
+    return;
+  g_free (fe->window);
+  g_free (fe->bitrev);
+  g_free (fe->stage_re);
+  g_free (fe->stage_im);
+  g_free (fe->post_re);
+  g_free (fe->post_im);
+  g_free (fe->band_start);
+  g_free (fe->band_len);
+  g_free (fe->band_offset);
+  g_free (fe->band_weights);
+  g_free (fe);
+}
+
+const NvDsAudioTransformParams *
+nvds_mel_frontend_get_params (const NvDsMelFrontend *fe)
+{
+  return &fe->params;
+}
+
+const gchar *
+nvds_mel_frontend_get_kernel_name (const NvDsMelFrontend *fe)
+{
+  return fe->kernels->name;
+}
+
+gboolean
+nvds_mel_frontend_is_specialized (const NvDsMelFrontend *fe)
+{
+  return fe->fixed;
+}
+
+const gfloat *
+nvds_mel_frontend_get_band (const NvDsMelFrontend *fe, guint mel,
+    guint *first_bin, guint *num_bins)
+{
+  *first_bin = fe->band_start[mel];
+  *num_bins = fe->band_len[mel];
+  return fe->band_weights + fe->band_offset[mel];
+}
+
+gsize
+nvds_mel_frontend_work_size (const NvDsMelFrontend *fe)
+{
+  /*
+   * Half size complex FFT buffers plus the power spectrum, for every lane of
+   * the batched kernel, plus alignment slack and one spare output column.
+   */
+  return (fe->params.fft_length + fe->num_bins + 1) * MEL_SOA_LANES +
+      MEL_SOA_LANES + fe->params.num_mels;
+}
+
+/* In-place iterative radix-2 complex FFT of bit-reversed input. */
+static void
+fft_radix2 (const NvDsMelFrontend *fe, gfloat *re, gfloat *im)
+{
+  guint m = fe->params.fft_length / 2;
+  guint half;
+
+  for (half = 1; half < m; half <<= 1) {
+    const NvDsMelKernels *k =
+        half >= fe->kernels->lanes ? fe->kernels : &mel_kernels_scalar;
+    k->butterflies (re, im, m, half, fe->stage_re + half - 1,
+        fe->stage_im + half - 1);
+  }
+}
+
+void
+nvds_mel_frontend_compute_column (const NvDsMelFrontend *fe,
+    gfloat *work, const gfloat *frame, gfloat *mel_db)
+{
+  guint m = fe->params.fft_length / 2;
+  gfloat *re = work;
+  gfloat *im = work + m;
+  gfloat *power = work + 2 * m;
+  guint i;
+
+  /* Even samples form the real part, odd samples the imaginary part. */
+  for (i = 0; i < m; i++) {
+    re[fe->bitrev[i]] = frame[2 * i] * fe->window[2 * i];
+    im[fe->bitrev[i]] = frame[2 * i + 1] * fe->window[2 * i + 1];
+  }
+
+  fft_radix2 (fe, re, im);
+  fe->kernels->rfft_power (fe, re, im, power);
+
+  for (i = 0; i < fe->params.num_mels; i++) {
+    gfloat acc = fe->kernels->dot (fe->band_weights + fe->band_offset[i],
+        power + fe->band_start[i], fe->band_len[i]);
+    mel_db[i] = 10.0f * log10f (MAX (acc, fe->min_power)) - fe->db_offset;
+  }
+}
+
+/*
+ * 10 * log10 (x) of positive normal floats: exponent plus the atanh series
+ * of the mantissa in [1, 2); the error is below 1e-4 dB.
+ */
+static inline __attribute__ ((always_inline)) void
+power_to_db_vec (mel_vec *x)
+{
+  mel_ivec bits = (mel_ivec) *x;
+  mel_vec e = __builtin_convertvector ((bits >> 23) - 127, mel_vec);
+  mel_vec m = (mel_vec) ((bits & 0x007fffff) | 0x3f800000);
+  mel_vec t = (m - 1.0f) / (m + 1.0f);
+  mel_vec t2 = t * t;
+  mel_vec ln_m = 2.0f * t * (1.0f + t2 * (1.0f / 3.0f + t2 * (1.0f / 5.0f +
+              t2 * (1.0f / 7.0f + t2 * (1.0f / 9.0f)))));
+
+  /* 10 log10 (2) and 10 / ln (10). */
+  *x = 3.01029996f * e + 4.34294482f * ln_m;
+}
+
+/*
+ * Batched kernel body. Inlined once with the runtime transform size and once
+ * with the MEL_FIXED_* constants, which lets the compiler resolve the loop
+ * bounds and index arithmetic; @p fixed also merges the first two FFT stages,
+ * skips the power bins outside the mel bands and converts to dB in vectors.
+ */
+static inline __attribute__ ((always_inline)) void
+compute_columns_soa_impl (const NvDsMelFrontend *fe, mel_vec *work,
+    const gfloat *const *frames, gfloat *const *mel_db, guint m,
+    guint num_mels, gboolean fixed)
+{
+  mel_vec *re = work;
+  mel_vec *im = work + m;
+  mel_vec *power = work + 2 * m;
+  guint first_bin = fixed ? fe->power_first : 0;
+  guint end_bin = fixed ? fe->power_end : m + 1;
+  guint i, j, l, half = 1;
+
+  for (i = 0; i < m; i++) {
+    gfloat w0 = fe->window[2 * i], w1 = fe->window[2 * i + 1];
+    for (l = 0; l < MEL_SOA_LANES; l++) {
+      re[fe->bitrev[i]][l] = frames[l][2 * i] * w0;
+      im[fe->bitrev[i]][l] = frames[l][2 * i + 1] * w1;
+    }
+  }
+
+  if (fixed) {
+    /* Stages half = 1 and 2 as radix-4 butterflies; twiddles are 1 and -i. */
+    for (i = 0; i < m; i += 4) {
+      mel_vec r0 = re[i] + re[i + 1], i0 = im[i] + im[i + 1];
+      mel_vec r1 = re[i] - re[i + 1], i1 = im[i] - im[i + 1];
+      mel_vec r2 = re[i + 2] + re[i + 3], i2 = im[i + 2] + im[i + 3];
+      mel_vec r3 = re[i + 2] - re[i + 3], i3 = im[i + 2] - im[i + 3];
+      re[i] = r0 + r2;
+      im[i] = i0 + i2;
+      re[i + 2] = r0 - r2;
+      im[i + 2] = i0 - i2;
+      re[i + 1] = r1 + i3;
+      im[i + 1] = i1 - r3;
+      re[i + 3] = r1 - i3;
+      im[i + 3] = i1 + r3;
+    }
+    half = 4;
+  }
+
+  for (; half < m; half <<= 1) {
+    const gfloat *wr = fe->stage_re + half - 1;
+    const gfloat *wi = fe->stage_im + half - 1;
+    for (i = 0; i < m; i += 2 * half) {
+      for (j = 0; j < half; j++) {
+        guint a = i + j, b = i + j + half;
+        mel_vec tr = re[b] * wr[j] - im[b] * wi[j];
+        mel_vec ti = re[b] * wi[j] + im[b] * wr[j];
+        re[b] = re[a] - tr;
+        im[b] = im[a] - ti;
+        re[a] += tr;
+        im[a] += ti;
+      }
+    }
+  }
+
+  for (i = first_bin; i < end_bin; i++) {
+    guint a = i % m, b = (m - i) % m;
+    mel_vec er = 0.5f * (re[a] + re[b]);
+    mel_vec ei = 0.5f * (im[a] - im[b]);
+    mel_vec odr = 0.5f * (im[a] + im[b]);
+    mel_vec odi = 0.5f * (re[b] - re[a]);
+    mel_vec xr = er + fe->post_re[i] * odr - fe->post_im[i] * odi;
+    mel_vec xi = ei + fe->post_re[i] * odi + fe->post_im[i] * odr;
+    power[i] = xr * xr + xi * xi;
+  }
+
+  for (i = 0; i < num_mels; i++) {
+    const gfloat *w = fe->band_weights + fe->band_offset[i];
+    const mel_vec *p = power + fe->band_start[i];
+    mel_vec acc = { 0 };
+    for (j = 0; j < fe->band_len[i]; j++)
+      acc += w[j] * p[j];
+    if (fixed) {
+      for (l = 0; l < MEL_SOA_LANES; l++)
+        acc[l] = MAX (acc[l], fe->min_power);
+      power_to_db_vec (&acc);
+      for (l = 0; l < MEL_SOA_LANES; l++)
+        mel_db[l][i] = acc[l] - fe->db_offset;
+    } else {
+      for (l = 0; l < MEL_SOA_LANES; l++)
+        mel_db[l][i] =
+            10.0f * log10f (MAX (acc[l], fe->min_power)) - fe->db_offset;
+    }
+  }
+}
+
+static MEL_SOA_CLONES void
+compute_columns_soa (const NvDsMelFrontend *fe, mel_vec *work,
+    const gfloat *const *frames, gfloat *const *mel_db)
+{
+  compute_columns_soa_impl (fe, work, frames, mel_db,
+      fe->params.fft_length / 2, fe->params.num_mels, FALSE);
+}
+
+static MEL_SOA_CLONES void
+compute_columns_soa_fixed (const NvDsMelFrontend *fe, mel_vec *work,
+    const gfloat *const *frames, gfloat *const *mel_db)
+{
+  compute_columns_soa_impl (fe, work, frames, mel_db,
+      MEL_FIXED_FFT_LENGTH / 2, MEL_FIXED_NUM_MELS, TRUE);
+}
+
+guint
+nvds_mel_frontend_get_batch_size (const NvDsMelFrontend *fe)
+{
+  return fe->kernels == &mel_kernels_scalar ? 1 : MEL_SOA_LANES;
+}
+
+void
+nvds_mel_frontend_compute_columns (const NvDsMelFrontend *fe,
+    gfloat *work, const gfloat *const *frames, guint num_columns,
+    gfloat *const *mel_db)
+{
+  const gfloat *lane_frames[MEL_SOA_LANES];
+  gfloat *lane_out[MEL_SOA_LANES];
+  gfloat *spare;
+  mel_vec *vwork;
+  guint i, l;
+
+  if (nvds_mel_frontend_get_batch_size (fe) == 1) {
+    for (i = 0; i < num_columns; i++)
+      nvds_mel_frontend_compute_column (fe, work, frames[i], mel_db[i]);
+    return;
+  }
+
+  /* The work area is over-allocated so the vectors can be aligned. */
+  vwork = (mel_vec *) (((guintptr) work + sizeof (mel_vec) - 1) &
+      ~(guintptr) (sizeof (mel_vec) - 1));
+  spare = (gfloat *) (vwork + 3 * (fe->params.fft_length / 2) + 1);
+
+  for (i = 0; i < num_columns; i += MEL_SOA_LANES) {
+    /* Unused lanes of the last batch repeat a frame into spare output. */
+    for (l = 0; l < MEL_SOA_LANES; l++) {
+      gboolean used = i + l < num_columns;
+      lane_frames[l] = frames[used ? i + l : i];
+      lane_out[l] = used ? mel_db[i + l] : spare;
+    }
+    if (fe->fixed)
+      compute_columns_soa_fixed (fe, vwork, lane_frames, lane_out);
+    else
+      compute_columns_soa (fe, vwork, lane_frames, lane_out);
+  }
+}
+
+void
+nvds_mel_frontend_apply_top_db (const NvDsMelFrontend *fe,
+    gfloat *window, guint num_values)
+{
+  gfloat max_db = -G_MAXFLOAT;
+  gfloat floor_db;
+  guint i;
+
+  if (fe->params.p2db_top_db <= 0.0f)
+    return;
+
+  for (i = 0; i < num_values; i++)
+    max_db = MAX (max_db, window[i]);
+  floor_db = max_db - fe->params.p2db_top_db;
+  for (i = 0; i < num_values; i++)
+    window[i] = MAX (window[i], floor_db);
+}
+
+NvDsMelRing *
+nvds_mel_ring_new (const NvDsMelFrontend *fe, guint capacity)
+{
+  NvDsMelRing *ring = g_new0 (NvDsMelRing, 1);
+
+  ring->fe = fe;
+  ring->num_mels = fe->params.num_mels;
+  ring->capacity = capacity;
+  ring->columns = g_new0 (gfloat, (gsize) capacity * ring->num_mels);
+  ring->pcm_capacity = 2 * fe->params.fft_length;
+  ring->pcm = g_new0 (gfloat, ring->pcm_capacity);
+  ring->work = g_new0 (gfloat, nvds_mel_frontend_work_size (fe));
+  return ring;
+}
+
+void
+nvds_mel_ring_free (NvDsMelRing *ring)
+{
+  if (!ring)
+    return;
+  g_free (ring->columns);
+  g_free (ring->pcm);
+  g_free (ring->work);
+  g_free (ring);
+}
+
+void
+nvds_mel_ring_append_samples (NvDsMelRing *ring, const gfloat *samples,
+    guint num_samples)
+{
+  if (ring->pcm_len + num_samples > ring->pcm_capacity) {
+    ring->pcm_capacity = ring->pcm_len + num_samples;
+    ring->pcm = g_realloc (ring->pcm, ring->pcm_capacity * sizeof (gfloat));
+  }
+  memcpy (ring->pcm + ring->pcm_len, samples, num_samples * sizeof (gfloat));
+  ring->pcm_len += num_samples;
+}
+
+void
+nvds_mel_ring_push_columns (NvDsMelRing *ring, const gfloat *columns,
+    guint num_columns)
+{
+  guint i;
+
+  for (i = 0; i < num_columns; i++) {
+    memcpy (ring->columns +
+        (ring->total_columns % ring->capacity) * ring->num_mels,
+        columns + (gsize) i * ring->num_mels, ring->num_mels * sizeof (gfloat));
+    ring->total_columns++;
+  }
+}
+
+guint
+nvds_mel_ring_pending_columns (NvDsMelRing *ring)
+{
+  const NvDsAudioTransformParams *p = &ring->fe->params;
+  guint64 end = ring->pcm_start + ring->pcm_len;
+
+  /* Column c covers samples [c * hop_size, c * hop_size + fft_length). */
+  if (end < p->fft_length)
+    return 0;
+  return (end - p->fft_length) / p->hop_size + 1 - ring->total_columns;
+}
+
+/* Drop the samples no future column needs. */
+static void
+mel_ring_drop_samples (NvDsMelRing *ring)
+{
+  guint64 start = ring->total_columns * ring->fe->params.hop_size;
+  guint consumed = MIN (start - ring->pcm_start, (guint64) ring->pcm_len);
+
+  if (consumed) {
+    memmove (ring->pcm, ring->pcm + consumed,
+        (ring->pcm_len - consumed) * sizeof (gfloat));
+    ring->pcm_len -= consumed;
+    ring->pcm_start += consumed;
+  }
+}
+
+guint
+nvds_mel_rings_compute (NvDsMelRing **rings, guint num_rings, gfloat *work)
+{
+  const NvDsMelFrontend *fe;
+  const gfloat **frames;
+  gfloat **columns;
+  guint batch, queued = 0, computed = 0;
+  guint r, c;
+
+  if (!num_rings)
+    return 0;
+  fe = rings[0]->fe;
+  batch = nvds_mel_frontend_get_batch_size (fe);
+  frames = g_newa (const gfloat *, batch);
+  columns = g_newa (gfloat *, batch);
+
+  /* Pending columns of all rings share the lanes of the batched kernel. */
+  for (r = 0; r < num_rings; r++) {
+    NvDsMelRing *ring = rings[r];
+    guint pending = nvds_mel_ring_pending_columns (ring);
+
+    for (c = 0; c < pending; c++) {
+      guint64 start = ring->total_columns * fe->params.hop_size;
+      frames[queued] = ring->pcm + (start - ring->pcm_start);
+      columns[queued] = ring->columns +
+          (ring->total_columns % ring->capacity) * ring->num_mels;
+      ring->total_columns++;
+      if (++queued == batch) {
+        nvds_mel_frontend_compute_columns (fe, work, frames, queued, columns);
+        computed += queued;
+        queued = 0;
+      }
+    }
+  }
+  if (queued) {
+    nvds_mel_frontend_compute_columns (fe, work, frames, queued, columns);
+    computed += queued;
+  }
+
+  for (r = 0; r < num_rings; r++)
+    mel_ring_drop_samples (rings[r]);
+  return computed;
+}
+
+guint
+nvds_mel_ring_push_samples (NvDsMelRing *ring, const gfloat *samples,
+    guint num_samples)
+{
+  nvds_mel_ring_append_samples (ring, samples, num_samples);
+  return nvds_mel_rings_compute (&ring, 1, ring->work);
+}
+
+gboolean
+nvds_mel_ring_has_columns (NvDsMelRing *ring, guint64 first_column,
+    guint num_columns)
+{
+  if (num_columns > ring->capacity)
+    return FALSE;
+  if (first_column + num_columns > ring->total_columns)
+    return FALSE;
+  return ring->total_columns - first_column <= ring->capacity;
+}
+
+gboolean
+nvds_mel_ring_assemble (NvDsMelRing *ring, guint64 first_column,
+    guint num_columns, gfloat *out)
+{
+  guint i;
+
+  if (!nvds_mel_ring_has_columns (ring, first_column, num_columns))
+    return FALSE;
+
+  for (i = 0; i < num_columns; i++) {
+    const gfloat *column = ring->columns +
+        ((first_column + i) % ring->capacity) * ring->num_mels;
+    memcpy (out + (gsize) i * ring->num_mels, column,
+        ring->num_mels * sizeof (gfloat));
+  }
+  nvds_mel_frontend_apply_top_db (ring->fe, out,
+      num_columns * ring->num_mels);
+  return TRUE;
+}
+
+/* Round to nearest even; overflow saturates to infinity. */
+static guint16
+float_to_half (gfloat value)
+{
+  union { gfloat f; guint32 u; } v = { value };
+  guint32 sign = (v.u >> 16) & 0x8000;
+  guint32 mant_odd;
+
+  v.u &= 0x7fffffff;
+  if (v.u >= 0x47800000)
+    return sign | (v.u > 0x7f800000 ? 0x7e00 : 0x7c00);
+  if (v.u < 0x38800000) {
+    /* Subnormal or zero: let the FPU round into the low mantissa bits. */
+    v.f += 0.5f;
+    return sign | (v.u - 0x3f000000);
+  }
+  mant_odd = (v.u >> 13) & 1;
+  v.u += 0xc8000fff + mant_odd;
+  return sign | (v.u >> 13);
+}
+
+static gfloat
+half_to_float (guint16 h)
+{
+  union { guint32 u; gfloat f; } v;
+  guint32 exp;
+
+  v.u = (guint32) (h & 0x7fff) << 13;
+  exp = v.u & 0x0f800000;
+  v.u += (127 - 15) << 23;
+  if (exp == 0x0f800000) {
+    v.u += (128 - 16) << 23;
+  } else if (exp == 0) {
+    union { guint32 u; gfloat f; } magic = { 113 << 23 };
+    v.u += 1 << 23;
+    v.f -= magic.f;
+  }
+  v.u |= (guint32) (h & 0x8000) << 16;
+  return v.f;
+}
+
+gsize
+nvds_audio_tensor_element_size (NvDsAudioTensorFormat format)
+{
+  switch (format) {
+    case NVDS_AUDIO_TENSOR_FP16:
+      return sizeof (guint16);
+    case NVDS_AUDIO_TENSOR_INT8:
+      return sizeof (gint8);
+    default:
+      return sizeof (gfloat);
+  }
+}
+
+const gchar *
+nvds_audio_tensor_format_get_name (NvDsAudioTensorFormat format)
+{
+  switch (format) {
+    case NVDS_AUDIO_TENSOR_FP16:
+      return "fp16";
+    case NVDS_AUDIO_TENSOR_INT8:
+      return "int8";
+    default:
+      return "fp32";
+  }
+}
+
+void
+nvds_audio_tensor_pack (NvDsAudioTensorFormat format, const gfloat *in,
+    guint num_values, gpointer out, gfloat *scale, gint *zero_point)
+{
+  gfloat min_value = G_MAXFLOAT, max_value = -G_MAXFLOAT;
+  gfloat inv_scale;
+  guint i;
+
+  *scale = 1.0f;
+  *zero_point = 0;
+
+  if (format == NVDS_AUDIO_TENSOR_FP32) {
+    memcpy (out, in, num_values * sizeof (gfloat));
+    return;
+  }
+
+  if (format == NVDS_AUDIO_TENSOR_FP16) {
+    guint16 *half = (guint16 *) out;
+    for (i = 0; i < num_values; i++)
+      half[i] = float_to_half (in[i]);
+    return;
+  }
+
+  /* INT8: [min, max] of the window onto the 256 levels. */
+  for (i = 0; i < num_values; i++) {
+    min_value = MIN (min_value, in[i]);
+    max_value = MAX (max_value, in[i]);
+  }
+  if (num_values && max_value > min_value)
+    *scale = (max_value - min_value) / 255.0f;
+  *zero_point = num_values ? -128 - (gint) lrintf (min_value / *scale) : 0;
+  inv_scale = 1.0f / *scale;
+  for (i = 0; i < num_values; i++) {
+    gint q = (gint) lrintf (in[i] * inv_scale) + *zero_point;
+    ((gint8 *) out)[i] = CLAMP (q, -128, 127);
+  }
+}
+
+void
+nvds_audio_tensor_unpack (NvDsAudioTensorFormat format, gconstpointer in,
+    guint num_values, gfloat scale, gint zero_point, gfloat *out)
+{
+  guint i;
+
+  if (format == NVDS_AUDIO_TENSOR_FP32) {
+    memcpy (out, in, num_values * sizeof (gfloat));
+  } else if (format == NVDS_AUDIO_TENSOR_FP16) {
+    for (i = 0; i < num_values; i++)
+      out[i] = half_to_float (((const guint16 *) in)[i]);
+  } else {
+    for (i = 0; i < num_values; i++)
+      out[i] = (((const gint8 *) in)[i] - zero_point) * scale;
+  }
+}
@@ -0,0 +1,539 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "deepstream_common.h"
+#include "deepstream_audio_frontend.h"
+#include "deepstream_remote_mel.h"
+#include "nvbufaudio.h"
+
+#define FRONTEND_DEFAULT_BACKGROUND_LABEL "00_background"
+
+static gpointer
+copy_audio_feature_meta (gpointer data, gpointer user_data)
+{
+  NvDsUserMeta *user_meta = (NvDsUserMeta *) data;
+  NvDsAudioFeatureMeta *src = (NvDsAudioFeatureMeta *) user_meta->user_meta_data;
+  NvDsAudioFeatureMeta *dst = g_memdup (src, sizeof (NvDsAudioFeatureMeta));
+
+  dst->data = g_memdup (src->data, (gsize) src->num_frames * src->num_mels *
+      nvds_audio_tensor_element_size (src->format));
+  return dst;
+}
+
+static void
+release_audio_feature_meta (gpointer data, gpointer user_data)
+{
+  NvDsUserMeta *user_meta = (NvDsUserMeta *) data;
+  NvDsAudioFeatureMeta *meta = (NvDsAudioFeatureMeta *) user_meta->user_meta_data;
+
+  g_free (meta->data);
+  g_free (meta);
+  user_meta->user_meta_data = NULL;
+}
+
+static void
+attach_audio_feature_meta (NvDsBatchMeta *batch_meta,
+    NvDsAudioFeatureMeta *meta)
+{
+  NvDsUserMeta *user_meta = nvds_acquire_user_meta_from_pool (batch_meta);
+
+  user_meta->user_meta_data = meta;
+  user_meta->base_meta.meta_type =
+      nvds_get_user_meta_type ((gchar *) NVDS_AUDIO_FEATURE_META_STRING);
+  user_meta->base_meta.copy_func = copy_audio_feature_meta;
+  user_meta->base_meta.release_func = release_audio_feature_meta;
+  nvds_add_user_meta_to_batch (batch_meta, user_meta);
+}
+
+/**
+ * Convert one interleaved buffer to mono float samples in bin->mono.
+ * Returns the number of samples, 0 for unsupported formats.
+ */
+static guint
+audio_params_to_mono (NvDsAudioFrontendBin *bin, NvBufAudioParams *params)
+{
+  guint channels = MAX (params->channels, 1);
+  guint bps = params->bpf / channels;
+  guint num_samples;
+  guint i, c;
+
+  if (!params->bpf || !params->dataPtr)
+    return 0;
+  num_samples = params->dataSize / params->bpf;
+
+  if (num_samples > bin->mono_len) {
+    bin->mono = g_realloc (bin->mono, num_samples * sizeof (gfloat));
+    bin->mono_len = num_samples;
+  }
+
+  if (params->format == NVBUF_AUDIO_F32LE && bps == sizeof (gfloat)) {
+    const gfloat *in = (const gfloat *) params->dataPtr;
+    for (i = 0; i < num_samples; i++) {
+      gfloat acc = 0.0f;
+      for (c = 0; c < channels; c++)
+        acc += in[i * channels + c];
+      bin->mono[i] = acc / channels;
+    }
+  } else if (params->format == NVBUF_AUDIO_S16LE && bps == sizeof (gint16)) {
+    const gint16 *in = (const gint16 *) params->dataPtr;
+    const gfloat scale = 1.0f / (32768.0f * channels);
+    for (i = 0; i < num_samples; i++) {
+      gint acc = 0;
+      for (c = 0; c < channels; c++)
+        acc += in[i * channels + c];
+      bin->mono[i] = acc * scale;
+    }
+  } else {
+    return 0;
+  }
+  return num_samples;
+}
+
+/**
+ * Move the columns received for a remote mel source into its ring. They must
+ * come from the same transform; the samples of the source are placeholders.
+ */
+static void
+append_remote_columns (NvDsAudioFrontendBin *bin, guint source_id,
+    NvDsAudioFrontendSource *src)
+{
+  guint num_columns, num_mels = 0, hop_size = 0;
+  gfloat *columns = nvds_remote_mel_take_columns (source_id, &num_columns,
+      &num_mels, &hop_size);
+
+  if (!columns)
+    return;
+  if (num_mels != bin->params.num_mels || hop_size != bin->params.hop_size) {
+    if (!src->remote_mismatch) {
+      NVGSTDS_WARN_MSG_V ("Source %u sends %u mels every %u samples, the"
+          " audio-transform needs %u every %u; dropping its columns",
+          source_id, num_mels, hop_size, bin->params.num_mels,
+          bin->params.hop_size);
+      src->remote_mismatch = TRUE;
+    }
+  } else {
+    nvds_mel_ring_push_columns (src->ring, columns, num_columns);
+    bin->columns_received += num_columns;
+  }
+  g_free (columns);
+}
+
+/** Log what the clock of a source found in its last buffer. */
+static void
+report_clock_events (guint source_id, const NvDsAudioClockStats *before,
+    const NvDsAudioClockStats *after)
+{
+  if (after->gaps != before->gaps) {
+    NVGSTDS_WARN_MSG_V ("Source %u: %.3f s of audio lost", source_id,
+        (gdouble) (after->lost - before->lost) / GST_SECOND);
+  }
+  if (after->duplicates != before->duplicates) {
+    NVGSTDS_WARN_MSG_V ("Source %u: dropped %" G_GUINT64_FORMAT
+        " repeated samples", source_id,
+        after->duplicate_samples - before->duplicate_samples);
+  }
+  if (after->resyncs != before->resyncs) {
+    NVGSTDS_WARN_MSG_V ("Source %u: timestamps went back, clock restarted"
+        " at the arrival time", source_id);
+  }
+}
+
+/**
+ * Append the newly arrived samples of one source to its ring. Returns the
+ * ring if it has columns to compute, NULL otherwise.
+ */
+static NvDsMelRing *
+append_audio_source (NvDsAudioFrontendBin *bin, NvBufAudioParams *params)
+{
+  NvDsAudioFrontendSource *src;
+  NvDsAudioClockStats before;
+  guint num_samples, drop;
+
+  if (params->sourceId >= MAX_SOURCE_BINS)
+    return NULL;
+  src = &bin->sources[params->sourceId];
+
+  if (g_atomic_int_compare_and_exchange (&src->reset, TRUE, FALSE)) {
+    nvds_mel_ring_free (src->ring);
+    memset (src, 0, sizeof (*src));
+  }
+
+  num_samples = audio_params_to_mono (bin, params);
+  if (!num_samples)
+    return NULL;
+
+  if (!src->ring) {
+    /* One window plus the columns of two of the longest hops of
+     * look-ahead. */
+    guint hop_columns = MAX (bin->hop_size, bin->max_hop_size) /
+        bin->params.hop_size + 1;
+    src->ring = nvds_mel_ring_new (bin->fe, bin->num_frames + 2 * hop_columns);
+    src->remote = nvds_remote_mel_source_is_registered (params->sourceId);
+    g_atomic_int_set (&src->hop_size, CLAMP (bin->hop_size,
+            bin->min_hop_size, bin->max_hop_size));
+  }
+
+  before = src->clock.stats;
+  drop = nvds_audio_clock_push (&src->clock, params->bufPts,
+      params->ntpTimestamp, num_samples, params->rate ? params->rate :
+      bin->params.sample_rate);
+  report_clock_events (params->sourceId, &before, &src->clock.stats);
+  num_samples -= drop;
+  src->num_samples += num_samples;
+
+  if (src->remote) {
+    append_remote_columns (bin, params->sourceId, src);
+    return NULL;
+  }
+  if (!num_samples)
+    return NULL;
+  nvds_mel_ring_append_samples (src->ring, bin->mono + drop, num_samples);
+  return src->ring;
+}
+
+static guint
+source_hop_size (NvDsAudioFrontendBin *bin, NvDsAudioFrontendSource *src)
+{
+  if (!bin->adaptive_hop)
+    return bin->hop_size;
+  return (guint) g_atomic_int_get (&src->hop_size);
+}
+
+/**
+ * Emit every classifier window of one source that became complete. Each
+ * window starts one hop after the previous one, the first at sample 0; its
+ * first column is the STFT column closest to the start. The hop is read
+ * when the window is due, so a shortened hop applies at once. Windows are
+ * timed by the clock of the source, not by the buffer that completed them.
+ */
+static void
+emit_audio_windows (NvDsAudioFrontendBin *bin, NvDsBatchMeta *batch_meta,
+    NvBufAudioParams *params)
+{
+  NvDsAudioFrontendSource *src = &bin->sources[params->sourceId];
+
+  while (TRUE) {
+    guint64 start = src->window_num ?
+        src->last_start + source_hop_size (bin, src) : 0;
+    guint64 first_column =
+        (start + bin->params.hop_size / 2) / bin->params.hop_size;
+    NvDsAudioFeatureMeta *meta;
+
+    if (src->num_samples < start + bin->frame_size)
+      break;
+    if (!nvds_mel_ring_has_columns (src->ring, first_column, bin->num_frames)) {
+      if (first_column + bin->num_frames > src->ring->total_columns)
+        break;
+      /* Fell out of the ring; skip to the next window. */
+      src->last_start = start;
+      src->window_num++;
+      continue;
+    }
+
+    if (batch_meta) {
+      meta = g_new0 (NvDsAudioFeatureMeta, 1);
+      meta->source_id = params->sourceId;
+      meta->window_num = src->window_num;
+      meta->first_column = first_column;
+      meta->ntp_timestamp = nvds_audio_clock_get_time (&src->clock, start);
+      meta->gap = nvds_audio_clock_has_gap (&src->clock, start,
+          bin->frame_size);
+      meta->lag = src->clock.stats.lag;
+      meta->num_frames = bin->num_frames;
+      meta->num_mels = bin->params.num_mels;
+      meta->format = bin->tensor_format;
+      meta->scale = 1.0f;
+      meta->data = g_malloc ((gsize) meta->num_frames * meta->num_mels *
+          nvds_audio_tensor_element_size (meta->format));
+      if (meta->format == NVDS_AUDIO_TENSOR_FP32) {
+        nvds_mel_ring_assemble (src->ring, first_column, meta->num_frames,
+            meta->data);
+      } else {
+        nvds_mel_ring_assemble (src->ring, first_column, meta->num_frames,
+            bin->window);
+        nvds_audio_tensor_pack (meta->format, bin->window,
+            meta->num_frames * meta->num_mels, meta->data, &meta->scale,
+            &meta->zero_point);
+      }
+      attach_audio_feature_meta (batch_meta, meta);
+    }
+    bin->windows_emitted++;
+    src->last_start = start;
+    src->window_num++;
+  }
+}
+
+static GstPadProbeReturn
+audio_frontend_buf_prob (GstPad *pad, GstPadProbeInfo *info, gpointer u_data)
+{
+  NvDsAudioFrontendBin *bin = (NvDsAudioFrontendBin *) u_data;
+  GstBuffer *buf;
+  GstMapInfo map;
+  NvBufAudio *batch;
+  NvDsBatchMeta *batch_meta;
+  NvDsMelRing **rings;
+  guint num_rings = 0;
+  guint i;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    if (GST_EVENT_TYPE ((GstEvent *) info->data) == GST_EVENT_EOS)
+      print_audio_frontend_stats (bin);
+    return GST_PAD_PROBE_OK;
+  }
+
+  buf = (GstBuffer *) info->data;
+  if (!gst_buffer_map (buf, &map, GST_MAP_READ))
+    return GST_PAD_PROBE_OK;
+
+  batch = (NvBufAudio *) map.data;
+  batch_meta = gst_buffer_get_nvds_batch_meta (buf);
+
+  /* The new columns of all sources in the batch are computed together. */
+  rings = g_newa (NvDsMelRing *, batch->numFilled);
+  for (i = 0; i < batch->numFilled; i++) {
+    NvDsMelRing *ring = append_audio_source (bin, &batch->audioBuffers[i]);
+    if (ring)
+      rings[num_rings++] = ring;
+  }
+  bin->columns_computed += nvds_mel_rings_compute (rings, num_rings, bin->work);
+
+  for (i = 0; i < batch->numFilled; i++) {
+    if (batch->audioBuffers[i].sourceId < MAX_SOURCE_BINS &&
+        bin->sources[batch->audioBuffers[i].sourceId].ring)
+      emit_audio_windows (bin, batch_meta, &batch->audioBuffers[i]);
+  }
+
+  gst_buffer_unmap (buf, &map);
+  return GST_PAD_PROBE_OK;
+}
+
+void
+nvds_audio_frontend_report_result (NvDsAudioFrontendBin *bin,
+    guint source_id, const gchar *label)
+{
+  NvDsAudioFrontendSource *src;
+  guint hop, new_hop;
+
+  if (!bin->adaptive_hop || source_id >= MAX_SOURCE_BINS)
+    return;
+  src = &bin->sources[source_id];
+  hop = (guint) g_atomic_int_get (&src->hop_size);
+
+  if (label && *label && g_strcmp0 (label, bin->background_label)) {
+    src->background_run = 0;
+    new_hop = bin->min_hop_size;
+  } else if (++src->background_run >= bin->stretch_after) {
+    src->background_run = 0;
+    new_hop = MIN (hop * 2, bin->max_hop_size);
+  } else {
+    return;
+  }
+
+  if (new_hop != hop) {
+    g_atomic_int_set (&src->hop_size, (gint) new_hop);
+    NVGSTDS_INFO_MSG_V ("Source %u: hop %.2f s", source_id,
+        (gdouble) new_hop / bin->params.sample_rate);
+  }
+}
+
+/** Effective hop of every source and the windows a fixed hop would need. */
+static void
+print_adaptive_hop_stats (NvDsAudioFrontendBin *bin)
+{
+  guint64 fixed_windows = 0, windows = 0;
+  guint i;
+
+  for (i = 0; i < MAX_SOURCE_BINS; i++) {
+    NvDsAudioFrontendSource *src = &bin->sources[i];
+
+    if (!src->window_num)
+      continue;
+    g_print ("Audio front-end: source %u hop %.2f s, mean %.2f s over %"
+        G_GUINT64_FORMAT " windows\n", i,
+        (gdouble) g_atomic_int_get (&src->hop_size) / bin->params.sample_rate,
+        src->window_num > 1 ? (gdouble) src->last_start /
+        (src->window_num - 1) / bin->params.sample_rate : 0.0,
+        src->window_num);
+    windows += src->window_num;
+    fixed_windows += src->last_start / bin->hop_size + 1;
+  }
+  if (windows)
+    g_print ("Audio front-end: %" G_GUINT64_FORMAT " windows instead of %"
+        G_GUINT64_FORMAT " at the fixed hop (%.1fx fewer)\n", windows,
+        fixed_windows, (gdouble) fixed_windows / windows);
+}
+
+/** Gaps, repeated samples and lag found by the clock of every source. */
+static void
+print_clock_stats (NvDsAudioFrontendBin *bin)
+{
+  guint i;
+
+  for (i = 0; i < MAX_SOURCE_BINS; i++) {
+    const NvDsAudioClockStats *stats = &bin->sources[i].clock.stats;
+
+    if (!bin->sources[i].clock.num_segments)
+      continue;
+    g_print ("Audio front-end: source %u clock %" G_GUINT64_FORMAT
+        " gaps (%.3f s lost), %" G_GUINT64_FORMAT " repeated samples, %"
+        G_GUINT64_FORMAT " restarts, lag %.1f ms (max %.1f ms)\n", i,
+        stats->gaps, (gdouble) stats->lost / GST_SECOND,
+        stats->duplicate_samples, stats->resyncs,
+        (gdouble) stats->lag / GST_MSECOND,
+        (gdouble) stats->max_lag / GST_MSECOND);
+  }
+}
+
+void
+print_audio_frontend_stats (NvDsAudioFrontendBin *bin)
+{
+  guint64 delivered = bin->windows_emitted * bin->num_frames;
+
+  if (bin->adaptive_hop)
+    print_adaptive_hop_stats (bin);
+  print_clock_stats (bin);
+
+  if (!delivered)
+    return;
+  g_print ("Audio front-end: %" G_GUINT64_FORMAT " windows, %" G_GUINT64_FORMAT
+      " computed and %" G_GUINT64_FORMAT " received of %" G_GUINT64_FORMAT
+      " mel columns (%.1f%% reused), %s tensors of %" G_GSIZE_FORMAT
+      " bytes\n", bin->windows_emitted, bin->columns_computed,
+      bin->columns_received, delivered, 100.0 * (1.0 -
+          (gdouble) (bin->columns_computed + bin->columns_received) /
+          delivered),
+      nvds_audio_tensor_format_get_name (bin->tensor_format),
+      (gsize) bin->num_frames * bin->params.num_mels *
+      nvds_audio_tensor_element_size (bin->tensor_format));
+}
+
+gboolean
+create_audio_frontend_bin (NvDsAudioFrontendConfig *config,
+    NvDsAudioFrontendBin *bin)
+{
+  gboolean ret = FALSE;
+
+  if (!nvds_audio_transform_params_parse (config->audio_transform,
+          &bin->params))
+    goto done;
+
+  bin->frame_size = config->frame_size;
+  bin->hop_size = config->hop_size;
+  bin->adaptive_hop = config->adaptive_hop;
+  bin->min_hop_size = config->min_hop_size ? config->min_hop_size :
+      config->hop_size;
+  bin->max_hop_size = config->max_hop_size ? config->max_hop_size :
+      config->frame_size;
+  bin->stretch_after = MAX (config->stretch_after, 1);
+  bin->background_label = config->background_label ?
+      config->background_label : FRONTEND_DEFAULT_BACKGROUND_LABEL;
+  bin->num_frames =
+      nvds_audio_transform_num_frames (&bin->params, bin->frame_size);
+  if (!bin->num_frames || !bin->hop_size) {
+    NVGSTDS_ERR_MSG_V ("Invalid audio-framesize %u / audio-hopsize %u",
+        bin->frame_size, bin->hop_size);
+    goto done;
+  }
+  if (bin->adaptive_hop && (!bin->min_hop_size ||
+          bin->min_hop_size > bin->max_hop_size ||
+          bin->max_hop_size > G_MAXINT)) {
+    NVGSTDS_ERR_MSG_V ("Invalid adaptive hop range %u - %u",
+        bin->min_hop_size, bin->max_hop_size);
+    goto done;
+  }
+  if (!bin->adaptive_hop)
+    bin->min_hop_size = bin->max_hop_size = bin->hop_size;
+  if (bin->hop_size % bin->params.hop_size) {
+    NVGSTDS_WARN_MSG_V ("audio-hopsize %u is not a multiple of the transform"
+        " hop_size %u; windows are aligned to the nearest STFT column",
+        bin->hop_size, bin->params.hop_size);
+  }
+
+  bin->fe = nvds_mel_frontend_new_with_kernel (&bin->params, config->kernel);
+  bin->work = g_new (gfloat, nvds_mel_frontend_work_size (bin->fe));
+  bin->tensor_format = config->tensor_format;
+  if (bin->tensor_format != NVDS_AUDIO_TENSOR_FP32)
+    bin->window = g_new (gfloat, (gsize) bin->num_frames * bin->params.num_mels);
+  NVGSTDS_INFO_MSG_V ("Audio front-end using %s mel kernel, %u columns"
+      " per batch, %s tensors", nvds_mel_frontend_get_kernel_name (bin->fe),
+      nvds_mel_frontend_get_batch_size (bin->fe),
+      nvds_audio_tensor_format_get_name (bin->tensor_format));
+
+  bin->bin = gst_bin_new ("audio_frontend_bin");
+  if (!bin->bin) {
+    NVGSTDS_ERR_MSG_V ("Failed to create 'audio_frontend_bin'");
+    goto done;
+  }
+
+  bin->queue = gst_element_factory_make (NVDS_ELEM_QUEUE, "frontend_queue");
+  if (!bin->queue) {
+    NVGSTDS_ERR_MSG_V ("Failed to create 'frontend_queue'");
+    goto done;
+  }
+
+  gst_bin_add (GST_BIN (bin->bin), bin->queue);
+
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->queue, "src");
+
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->queue, "sink");
+
+  NVGSTDS_ELEM_ADD_PROBE (bin->probe_id, bin->queue, "src",
+      audio_frontend_buf_prob,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, bin);
+
+  ret = TRUE;
+done:
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+void
+nvds_audio_frontend_reset_source (NvDsAudioFrontendBin *bin,
+    guint source_id)
+{
+  if (source_id < MAX_SOURCE_BINS)
+    g_atomic_int_set (&bin->sources[source_id].reset, TRUE);
+}
+
+void
+destroy_audio_frontend_bin (NvDsAudioFrontendBin *bin)
+{
+  guint i;
+
+  for (i = 0; i < MAX_SOURCE_BINS; i++) {
+    nvds_mel_ring_free (bin->sources[i].ring);
+    bin->sources[i].ring = NULL;
+  }
+  nvds_mel_frontend_free (bin->fe);
+  bin->fe = NULL;
+  g_free (bin->work);
+  bin->work = NULL;
+  g_free (bin->window);
+  bin->window = NULL;
+  g_free (bin->mono);
+  bin->mono = NULL;
+  bin->mono_len = 0;
+}
@@ -0,0 +1,669 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "deepstream_common.h"
+#include "deepstream_config.h"
+#include "deepstream_audio_ingest.h"
+#include "deepstream_audio_resample.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_ds_audio_ingest_debug);
+#define GST_CAT_DEFAULT gst_ds_audio_ingest_debug
+
+/** Frames converted and filtered at once; small enough to stay in L1. */
+#define INGEST_BLOCK_FRAMES 1024
+#define INGEST_MAX_POLES 32
+
+#define DEFAULT_RATE 0
+#define DEFAULT_CUTOFF 120.0
+#define DEFAULT_POLES 4
+#define DEFAULT_RIPPLE 0.25
+
+#define INGEST_SINK_CAPS \
+  "audio/x-raw, format = (string) { S16LE, S32LE, F32LE }, " \
+  "layout = (string) interleaved, rate = (int) [ 1, MAX ], " \
+  "channels = (int) [ 1, MAX ]"
+#define INGEST_SRC_CAPS \
+  "audio/x-raw, format = (string) F32LE, layout = (string) interleaved, " \
+  "rate = (int) [ 1, MAX ], channels = (int) [ 1, MAX ]"
+
+enum
+{
+  PROP_0,
+  PROP_RATE,
+  PROP_CUTOFF,
+  PROP_POLES,
+  PROP_RIPPLE,
+};
+
+typedef enum
+{
+  INGEST_FORMAT_S16LE,
+  INGEST_FORMAT_S32LE,
+  INGEST_FORMAT_F32LE,
+} IngestFormat;
+
+/** y = b0 x + b1 x[-1] + b2 x[-2] + a1 y[-1] + a2 y[-2], as audiocheblimit. */
+typedef struct
+{
+  gfloat b0, b1, b2;
+  gfloat a1, a2;
+} IngestBiquad;
+
+typedef struct
+{
+  GstElement element;
+  GstPad *sinkpad;
+  GstPad *srcpad;
+
+  /* Properties. */
+  guint rate;
+  gdouble cutoff;
+  gint poles;
+  gdouble ripple;
+
+  /* Negotiated stream. */
+  IngestFormat format;
+  guint in_rate;
+  guint out_rate;
+  guint channels;
+  guint bpf;
+  GstCaps *src_caps;
+  IngestBiquad sections[INGEST_MAX_POLES / 2];
+  guint num_sections;
+  /** channels x num_sections transposed direct form II states (2 each). */
+  gfloat *state;
+  NvDsAudioResampler *resampler;
+
+  /* Timestamps are derived from the first buffer after a reset. */
+  gboolean started;
+  gboolean discont;
+  GstClockTime base_ts;
+  guint64 in_frames;
+  guint64 out_frames;
+} GstDsAudioIngest;
+
+typedef struct
+{
+  GstElementClass parent_class;
+} GstDsAudioIngestClass;
+
+#define GST_DS_AUDIO_INGEST(obj) ((GstDsAudioIngest *) (obj))
+
+G_DEFINE_TYPE (GstDsAudioIngest, gst_ds_audio_ingest, GST_TYPE_ELEMENT);
+
+static GstStaticPadTemplate sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (INGEST_SINK_CAPS));
+
+static GstStaticPadTemplate src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (INGEST_SRC_CAPS));
+
+/**
+ * Chebyshev type 1 high-pass as designed by audiocheblimit: analog low-pass
+ * prototype poles, bilinear transform to a low-pass at frequency 1 and
+ * low-pass to high-pass transform to the cutoff, one biquad per pole pair.
+ * The cascade is normalized to unity gain at the Nyquist frequency.
+ */
+static void
+design_highpass (GstDsAudioIngest * self)
+{
+  gdouble omega = 2.0 * G_PI * self->cutoff / self->in_rate;
+  gdouble gain = 1.0;
+  gint np = self->poles & ~1;
+  gint p;
+
+  self->num_sections = 0;
+  if (self->cutoff <= 0.0 || np < 2)
+    return;
+  if (omega >= G_PI) {
+    GST_WARNING_OBJECT (self, "Cutoff %.1f Hz above Nyquist; high-pass"
+        " disabled", self->cutoff);
+    return;
+  }
+
+  for (p = 1; p <= np / 2; p++) {
+    IngestBiquad *s = &self->sections[self->num_sections++];
+    gdouble angle = (G_PI / 2.0) * (2.0 * p - 1) / np;
+    gdouble rp = -sin (angle);
+    gdouble ip = cos (angle);
+    gdouble t, m, d, k, x0, x1, x2, y1, y2, b0, b1, b2, a1, a2;
+
+    if (self->ripple > 0.0) {
+      gdouble es = sqrt (pow (10.0, self->ripple / 10.0) - 1.0);
+      gdouble vx = (1.0 / np) * asinh (1.0 / es);
+
+      rp = rp * sinh (vx);
+      ip = ip * cosh (vx);
+    }
+
+    t = 2.0 * tan (0.5);
+    m = rp * rp + ip * ip;
+    d = 4.0 - 4.0 * rp * t + m * t * t;
+    x0 = (t * t) / d;
+    x1 = 2.0 * x0;
+    x2 = x0;
+    y1 = (8.0 - 2.0 * m * t * t) / d;
+    y2 = (-4.0 - 4.0 * rp * t - m * t * t) / d;
+
+    k = -cos ((omega + 1.0) / 2.0) / cos ((omega - 1.0) / 2.0);
+    d = 1.0 + y1 * k - y2 * k * k;
+    b0 = (x0 + k * (-x1 + k * x2)) / d;
+    b1 = -(x1 + k * k * x1 - 2.0 * k * (x0 + x2)) / d;
+    b2 = (x0 * k * k - x1 * k + x2) / d;
+    a1 = -(2.0 * k + y1 + y1 * k * k - 2.0 * y2 * k) / d;
+    a2 = (-k * k - y1 * k + y2) / d;
+
+    gain *= (b0 - b1 + b2) / (1.0 + a1 - a2);
+    s->b0 = b0;
+    s->b1 = b1;
+    s->b2 = b2;
+    s->a1 = a1;
+    s->a2 = a2;
+  }
+
+  gain = fabs (gain);
+  self->sections[0].b0 /= gain;
+  self->sections[0].b1 /= gain;
+  self->sections[0].b2 /= gain;
+}
+
+static void
+highpass (const IngestBiquad * sections, guint num_sections, gfloat * state,
+    gfloat * x, guint n)
+{
+  guint k, i;
+
+  for (k = 0; k < num_sections; k++) {
+    const IngestBiquad s = sections[k];
+    gfloat z1 = state[2 * k];
+    gfloat z2 = state[2 * k + 1];
+
+    for (i = 0; i < n; i++) {
+      gfloat in = x[i];
+      gfloat y = s.b0 * in + z1;
+
+      z1 = s.b1 * in + s.a1 * y + z2;
+      z2 = s.b2 * in + s.a2 * y;
+      x[i] = y;
+    }
+    /* Keep the states out of the denormal range on silent input. */
+    state[2 * k] = fabsf (z1) < 1e-20f ? 0.0f : z1;
+    state[2 * k + 1] = fabsf (z2) < 1e-20f ? 0.0f : z2;
+  }
+}
+
+static void
+convert_channel (const GstDsAudioIngest * self, const guint8 * frames,
+    guint channel, guint n, gfloat * out)
+{
+  guint stride = self->channels;
+  guint i;
+
+  switch (self->format) {
+    case INGEST_FORMAT_S16LE:{
+      const gint16 *in = (const gint16 *) frames + channel;
+
+      for (i = 0; i < n; i++)
+        out[i] = in[i * stride] * (1.0f / 32768.0f);
+      break;
+    }
+    case INGEST_FORMAT_S32LE:{
+      const gint32 *in = (const gint32 *) frames + channel;
+
+      for (i = 0; i < n; i++)
+        out[i] = in[i * stride] * (1.0f / 2147483648.0f);
+      break;
+    }
+    case INGEST_FORMAT_F32LE:{
+      const gfloat *in = (const gfloat *) frames + channel;
+
+      for (i = 0; i < n; i++)
+        out[i] = in[i * stride];
+      break;
+    }
+  }
+}
+
+static void
+gst_ds_audio_ingest_reset (GstDsAudioIngest * self)
+{
+  if (self->resampler)
+    nvds_audio_resampler_reset (self->resampler);
+  if (self->state)
+    memset (self->state, 0,
+        (gsize) self->channels * INGEST_MAX_POLES * sizeof (gfloat));
+  self->started = FALSE;
+  self->in_frames = 0;
+  self->out_frames = 0;
+}
+
+static gboolean
+gst_ds_audio_ingest_setcaps (GstDsAudioIngest * self, GstCaps * caps)
+{
+  GstStructure *s = gst_caps_get_structure (caps, 0);
+  const gchar *format = gst_structure_get_string (s, "format");
+  GstCaps *src_caps;
+  guint64 channel_mask;
+  gint rate = 0, channels = 0;
+  gboolean ret;
+
+  if (!format || !gst_structure_get_int (s, "rate", &rate) ||
+      !gst_structure_get_int (s, "channels", &channels) ||
+      rate <= 0 || channels <= 0) {
+    GST_ERROR_OBJECT (self, "Invalid caps %" GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+
+  if (!g_strcmp0 (format, "S16LE")) {
+    self->format = INGEST_FORMAT_S16LE;
+    self->bpf = channels * sizeof (gint16);
+  } else if (!g_strcmp0 (format, "S32LE")) {
+    self->format = INGEST_FORMAT_S32LE;
+    self->bpf = channels * sizeof (gint32);
+  } else {
+    self->format = INGEST_FORMAT_F32LE;
+    self->bpf = channels * sizeof (gfloat);
+  }
+
+  /* Keep filter and resampler history if only the format changed. */
+  if (!self->resampler || self->in_rate != (guint) rate ||
+      self->channels != (guint) channels) {
+    self->in_rate = rate;
+    self->channels = channels;
+    self->out_rate = self->rate ? self->rate : self->in_rate;
+
+    design_highpass (self);
+    g_free (self->state);
+    self->state = g_new0 (gfloat, (gsize) channels * INGEST_MAX_POLES);
+    nvds_audio_resampler_free (self->resampler);
+    self->resampler = nvds_audio_resampler_new (self->in_rate,
+        self->out_rate, self->channels);
+    if (!self->resampler)
+      return FALSE;
+    gst_ds_audio_ingest_reset (self);
+
+    GST_INFO_OBJECT (self, "%s %u Hz x %u -> F32LE %u Hz, %u high-pass"
+        " sections, %u taps", format, self->in_rate, self->channels,
+        self->out_rate, self->num_sections,
+        nvds_audio_resampler_get_num_taps (self->resampler));
+  }
+
+  src_caps = gst_caps_new_simple ("audio/x-raw",
+      "format", G_TYPE_STRING, "F32LE",
+      "layout", G_TYPE_STRING, "interleaved",
+      "rate", G_TYPE_INT, (gint) self->out_rate,
+      "channels", G_TYPE_INT, (gint) self->channels, NULL);
+  if (gst_structure_get (s, "channel-mask", GST_TYPE_BITMASK, &channel_mask,
+          NULL))
+    gst_caps_set_simple (src_caps, "channel-mask", GST_TYPE_BITMASK,
+        channel_mask, NULL);
+  gst_caps_replace (&self->src_caps, src_caps);
+
+  ret = gst_pad_set_caps (self->srcpad, src_caps);
+  gst_caps_unref (src_caps);
+  return ret;
+}
+
+static GstFlowReturn
+gst_ds_audio_ingest_push (GstDsAudioIngest * self, GstBuffer * outbuf,
+    guint num_frames)
+{
+  if (GST_CLOCK_TIME_IS_VALID (self->base_ts)) {
+    GstClockTime start = gst_util_uint64_scale (self->out_frames,
+        GST_SECOND, self->out_rate);
+    GstClockTime end = gst_util_uint64_scale (self->out_frames + num_frames,
+        GST_SECOND, self->out_rate);
+
+    GST_BUFFER_PTS (outbuf) = self->base_ts + start;
+    GST_BUFFER_DURATION (outbuf) = end - start;
+  }
+  GST_BUFFER_OFFSET (outbuf) = self->out_frames;
+  GST_BUFFER_OFFSET_END (outbuf) = self->out_frames + num_frames;
+  if (self->discont) {
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+    self->discont = FALSE;
+  }
+  self->out_frames += num_frames;
+
+  return gst_pad_push (self->srcpad, outbuf);
+}
+
+/** Flush the resampler look-ahead with silence at the end of the stream. */
+static GstFlowReturn
+gst_ds_audio_ingest_drain (GstDsAudioIngest * self)
+{
+  GstBuffer *outbuf;
+  GstMapInfo map;
+  guint64 expected;
+  guint half, num_frames, c;
+
+  if (!self->resampler || !self->in_frames)
+    return GST_FLOW_OK;
+  expected = gst_util_uint64_scale_ceil (self->in_frames, self->out_rate,
+      self->in_rate);
+  if (expected <= self->out_frames)
+    return GST_FLOW_OK;
+
+  half = nvds_audio_resampler_get_num_taps (self->resampler) / 2;
+  for (c = 0; c < self->channels; c++)
+    memset (nvds_audio_resampler_get_input (self->resampler, c, half), 0,
+        half * sizeof (gfloat));
+
+  outbuf = gst_buffer_new_allocate (NULL,
+      (gsize) nvds_audio_resampler_get_max_output (self->resampler, half) *
+      self->channels * sizeof (gfloat), NULL);
+  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+  num_frames = nvds_audio_resampler_process (self->resampler, half,
+      (gfloat *) map.data);
+  gst_buffer_unmap (outbuf, &map);
+
+  num_frames = MIN (num_frames, expected - self->out_frames);
+  if (!num_frames) {
+    gst_buffer_unref (outbuf);
+    return GST_FLOW_OK;
+  }
+  gst_buffer_set_size (outbuf,
+      (gsize) num_frames * self->channels * sizeof (gfloat));
+  return gst_ds_audio_ingest_push (self, outbuf, num_frames);
+}
+
+static GstFlowReturn
+gst_ds_audio_ingest_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * inbuf)
+{
+  GstDsAudioIngest *self = GST_DS_AUDIO_INGEST (parent);
+  GstMapInfo in_map, out_map;
+  GstBuffer *outbuf;
+  gfloat *out;
+  guint num_frames, out_len = 0, done, n, c;
+
+  if (!self->resampler) {
+    GST_ELEMENT_ERROR (self, CORE, NEGOTIATION, (NULL),
+        ("Received buffer before caps"));
+    gst_buffer_unref (inbuf);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  if (GST_BUFFER_IS_DISCONT (inbuf) && self->in_frames)
+    gst_ds_audio_ingest_reset (self);
+  if (!self->started) {
+    self->started = TRUE;
+    self->discont = TRUE;
+    self->base_ts = GST_BUFFER_PTS (inbuf);
+  }
+
+  if (!gst_buffer_map (inbuf, &in_map, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+        ("Could not map input buffer"));
+    gst_buffer_unref (inbuf);
+    return GST_FLOW_ERROR;
+  }
+  num_frames = in_map.size / self->bpf;
+
+  outbuf = gst_buffer_new_allocate (NULL,
+      (gsize) nvds_audio_resampler_get_max_output (self->resampler,
+          num_frames) * self->channels * sizeof (gfloat), NULL);
+  gst_buffer_map (outbuf, &out_map, GST_MAP_WRITE);
+  out = (gfloat *) out_map.data;
+
+  /* Convert, filter and resample block by block so that every stage works
+   * on samples still in cache. */
+  for (done = 0; done < num_frames; done += n) {
+    const guint8 *frames = in_map.data + (gsize) done * self->bpf;
+
+    n = MIN (INGEST_BLOCK_FRAMES, num_frames - done);
+    for (c = 0; c < self->channels; c++) {
+      gfloat *x = nvds_audio_resampler_get_input (self->resampler, c, n);
+
+      convert_channel (self, frames, c, n, x);
+      highpass (self->sections, self->num_sections,
+          self->state + (gsize) c * INGEST_MAX_POLES, x, n);
+    }
+    out_len += nvds_audio_resampler_process (self->resampler, n,
+        out + (gsize) out_len * self->channels);
+  }
+  self->in_frames += num_frames;
+
+  gst_buffer_unmap (outbuf, &out_map);
+  gst_buffer_unmap (inbuf, &in_map);
+  gst_buffer_unref (inbuf);
+
+  if (!out_len) {
+    gst_buffer_unref (outbuf);
+    return GST_FLOW_OK;
+  }
+  gst_buffer_set_size (outbuf,
+      (gsize) out_len * self->channels * sizeof (gfloat));
+  return gst_ds_audio_ingest_push (self, outbuf, out_len);
+}
+
+static gboolean
+gst_ds_audio_ingest_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstDsAudioIngest *self = GST_DS_AUDIO_INGEST (parent);
+  gboolean ret;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:{
+      GstCaps *caps;
+
+      gst_event_parse_caps (event, &caps);
+      ret = gst_ds_audio_ingest_setcaps (self, caps);
+      gst_event_unref (event);
+      break;
+    }
+    case GST_EVENT_SEGMENT:
+    case GST_EVENT_FLUSH_STOP:
+      gst_ds_audio_ingest_reset (self);
+      ret = gst_pad_event_default (pad, parent, event);
+      break;
+    case GST_EVENT_EOS:
+      gst_ds_audio_ingest_drain (self);
+      ret = gst_pad_event_default (pad, parent, event);
+      break;
+    default:
+      ret = gst_pad_event_default (pad, parent, event);
+      break;
+  }
+  return ret;
+}
+
+static gboolean
+gst_ds_audio_ingest_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstDsAudioIngest *self = GST_DS_AUDIO_INGEST (parent);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *caps;
+
+      gst_query_parse_caps (query, &filter);
+      if (pad == self->srcpad && self->src_caps) {
+        caps = gst_caps_ref (self->src_caps);
+      } else {
+        caps = gst_pad_get_pad_template_caps (pad);
+        if (pad == self->srcpad && self->rate) {
+          caps = gst_caps_make_writable (caps);
+          gst_caps_set_simple (caps, "rate", G_TYPE_INT, (gint) self->rate,
+              NULL);
+        }
+      }
+      if (filter) {
+        GstCaps *tmp = gst_caps_intersect_full (filter, caps,
+            GST_CAPS_INTERSECT_FIRST);
+
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    }
+    case GST_QUERY_ALLOCATION:
+      /* Output buffers differ in size and format from the input. */
+      return FALSE;
+    default:
+      return gst_pad_query_default (pad, parent, query);
+  }
+}
+
+static void
+gst_ds_audio_ingest_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstDsAudioIngest *self = GST_DS_AUDIO_INGEST (object);
+
+  switch (prop_id) {
+    case PROP_RATE:
+      self->rate = g_value_get_uint (value);
+      break;
+    case PROP_CUTOFF:
+      self->cutoff = g_value_get_double (value);
+      break;
+    case PROP_POLES:
+      self->poles = g_value_get_int (value);
+      break;
+    case PROP_RIPPLE:
+      self->ripple = g_value_get_double (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ds_audio_ingest_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstDsAudioIngest *self = GST_DS_AUDIO_INGEST (object);
+
+  switch (prop_id) {
+    case PROP_RATE:
+      g_value_set_uint (value, self->rate);
+      break;
+    case PROP_CUTOFF:
+      g_value_set_double (value, self->cutoff);
+      break;
+    case PROP_POLES:
+      g_value_set_int (value, self->poles);
+      break;
+    case PROP_RIPPLE:
+      g_value_set_double (value, self->ripple);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ds_audio_ingest_finalize (GObject * object)
+{
+  GstDsAudioIngest *self = GST_DS_AUDIO_INGEST (object);
+
+  nvds_audio_resampler_free (self->resampler);
+  g_free (self->state);
+  gst_caps_replace (&self->src_caps, NULL);
+
+  G_OBJECT_CLASS (gst_ds_audio_ingest_parent_class)->finalize (object);
+}
+
+static void
+gst_ds_audio_ingest_class_init (GstDsAudioIngestClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_ds_audio_ingest_set_property;
+  gobject_class->get_property = gst_ds_audio_ingest_get_property;
+  gobject_class->finalize = gst_ds_audio_ingest_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_RATE,
+      g_param_spec_uint ("rate", "Rate",
+          "Output sample rate in Hz (0 = input rate)", 0, G_MAXINT,
+          DEFAULT_RATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CUTOFF,
+      g_param_spec_double ("cutoff", "Cutoff",
+          "High-pass cutoff frequency in Hz (0 = disabled)", 0.0, 100000.0,
+          DEFAULT_CUTOFF, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_POLES,
+      g_param_spec_int ("poles", "Poles",
+          "Number of poles of the high-pass (multiple of 2)", 2,
+          INGEST_MAX_POLES, DEFAULT_POLES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_RIPPLE,
+      g_param_spec_double ("ripple", "Ripple",
+          "Pass band ripple of the high-pass in dB", 0.0, 200.0,
+          DEFAULT_RIPPLE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "DeepStream audio ingest", "Filter/Converter/Audio",
+      "Converts to float, high-pass filters and resamples audio in one pass",
+      "NVIDIA Corporation");
+}
+
+static void
+gst_ds_audio_ingest_init (GstDsAudioIngest * self)
+{
+  self->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_ds_audio_ingest_chain));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_ds_audio_ingest_sink_event));
+  gst_pad_set_query_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_ds_audio_ingest_query));
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_set_query_function (self->srcpad,
+      GST_DEBUG_FUNCPTR (gst_ds_audio_ingest_query));
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  self->rate = DEFAULT_RATE;
+  self->cutoff = DEFAULT_CUTOFF;
+  self->poles = DEFAULT_POLES;
+  self->ripple = DEFAULT_RIPPLE;
+  self->base_ts = GST_CLOCK_TIME_NONE;
+}
+
+gboolean
+nvds_audio_ingest_register (void)
+{
+  static gsize registered = 0;
+
+  if (g_once_init_enter (&registered)) {
+    GST_DEBUG_CATEGORY_INIT (gst_ds_audio_ingest_debug,
+        NVDS_ELEM_AUDIO_INGEST, 0, "DeepStream audio ingest");
+    g_once_init_leave (&registered,
+        gst_element_register (NULL, NVDS_ELEM_AUDIO_INGEST, GST_RANK_NONE,
+            GST_TYPE_DS_AUDIO_INGEST) ? 1 : 2);
+  }
+  return registered == 1;
+}
@@ -0,0 +1,432 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <gst/gst.h>
+
+#include "deepstream_common.h"
+#include "deepstream_audio_resample.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define RESAMPLE_HAVE_NEON 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RESAMPLE_HAVE_AVX2 1
+#endif
+
+/** Zero crossings of the sinc on each side, at the lower of both rates. */
+#define RESAMPLE_ZERO_CROSSINGS 16
+/** Cutoff relative to the lower Nyquist frequency. */
+#define RESAMPLE_ROLLOFF 0.95
+#define RESAMPLE_KAISER_BETA 8.6
+/** Ratios with more phases use the nearest of this many phases. */
+#define RESAMPLE_MAX_PHASES 1024
+
+/** Input rates whose filter banks are built ahead of the first stream. */
+static const guint resample_common_rates[] = { 48000, 32000, 16000 };
+
+typedef gfloat (*NvDsResampleDot) (const gfloat *a, const gfloat *b, guint n);
+
+/**
+ * Immutable polyphase filter bank of one rate pair. Banks are built once
+ * and shared by every resampler (i.e. every source) with the same ratio.
+ */
+typedef struct
+{
+  guint in_rate;
+  guint out_rate;
+  /** out_rate / in_rate = up / down. */
+  guint up;
+  guint down;
+  guint num_phases;
+  guint num_taps;
+  /** num_phases x num_taps filter coefficients. */
+  gfloat *filters;
+} NvDsResampleBank;
+
+struct _NvDsAudioResampler
+{
+  guint channels;
+  /** NULL when both rates match and input is passed through. */
+  const NvDsResampleBank *bank;
+  NvDsResampleDot dot;
+  /** Per-channel input history; history[c][0] is the oldest sample kept. */
+  gfloat **history;
+  guint history_len;
+  guint history_capacity;
+  /** Output position: history index pos plus phase / up samples. */
+  guint pos;
+  guint phase;
+};
+
+static GMutex banks_lock;
+static GSList *banks;
+
+static gfloat
+dot_scalar (const gfloat *a, const gfloat *b, guint n)
+{
+  gfloat acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+  guint i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    acc0 += a[i] * b[i];
+    acc1 += a[i + 1] * b[i + 1];
+    acc2 += a[i + 2] * b[i + 2];
+    acc3 += a[i + 3] * b[i + 3];
+  }
+  for (; i < n; i++)
+    acc0 += a[i] * b[i];
+  return (acc0 + acc1) + (acc2 + acc3);
+}
+
+#ifdef RESAMPLE_HAVE_NEON
+static gfloat
+dot_neon (const gfloat *a, const gfloat *b, guint n)
+{
+  float32x4_t acc0 = vdupq_n_f32 (0.0f);
+  float32x4_t acc1 = vdupq_n_f32 (0.0f);
+  gfloat sum;
+  guint i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    acc0 = vfmaq_f32 (acc0, vld1q_f32 (a + i), vld1q_f32 (b + i));
+    acc1 = vfmaq_f32 (acc1, vld1q_f32 (a + i + 4), vld1q_f32 (b + i + 4));
+  }
+  for (; i + 4 <= n; i += 4)
+    acc0 = vfmaq_f32 (acc0, vld1q_f32 (a + i), vld1q_f32 (b + i));
+  sum = vaddvq_f32 (vaddq_f32 (acc0, acc1));
+  for (; i < n; i++)
+    sum += a[i] * b[i];
+  return sum;
+}
+#endif
+
+#ifdef RESAMPLE_HAVE_AVX2
+static __attribute__ ((target ("avx2,fma"))) gfloat
+dot_avx2 (const gfloat *a, const gfloat *b, guint n)
+{
+  __m256 acc = _mm256_setzero_ps ();
+  __m128 s;
+  gfloat sum;
+  guint i = 0;
+
+  for (; i + 8 <= n; i += 8)
+    acc = _mm256_fmadd_ps (_mm256_loadu_ps (a + i), _mm256_loadu_ps (b + i),
+        acc);
+  s = _mm_add_ps (_mm256_castps256_ps128 (acc),
+      _mm256_extractf128_ps (acc, 1));
+  s = _mm_add_ps (s, _mm_movehl_ps (s, s));
+  s = _mm_add_ss (s, _mm_shuffle_ps (s, s, 1));
+  sum = _mm_cvtss_f32 (s);
+  for (; i < n; i++)
+    sum += a[i] * b[i];
+  return sum;
+}
+#endif
+
+static NvDsResampleDot
+select_dot (void)
+{
+#ifdef RESAMPLE_HAVE_NEON
+  return dot_neon;
+#endif
+#ifdef RESAMPLE_HAVE_AVX2
+  if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+    return dot_avx2;
+#endif
+  return dot_scalar;
+}
+
+/** Zeroth order modified Bessel function of the first kind. */
+static gdouble
+bessel_i0 (gdouble x)
+{
+  gdouble sum = 1.0, term = 1.0;
+  guint k;
+
+  for (k = 1; k < 64 && term > sum * 1e-12; k++) {
+    term *= (x * x) / (4.0 * k * k);
+    sum += term;
+  }
+  return sum;
+}
+
+/**
+ * Fill one polyphase filter: tap j weights the input sample at distance
+ * (num_taps / 2 - 1 - j + frac) before the output position. Each phase is
+ * normalized to unity DC gain.
+ */
+static void
+design_phase (gfloat *taps, guint num_taps, gdouble frac, gdouble cutoff)
+{
+  gdouble half = num_taps / 2;
+  gdouble norm = bessel_i0 (RESAMPLE_KAISER_BETA);
+  gdouble sum = 0.0;
+  gdouble *h = g_new (gdouble, num_taps);
+  guint j;
+
+  for (j = 0; j < num_taps; j++) {
+    gdouble d = half - 1 - j + frac;
+    gdouble x = d / half;
+    gdouble w, s;
+
+    if (fabs (x) >= 1.0) {
+      h[j] = 0.0;
+      continue;
+    }
+    w = bessel_i0 (RESAMPLE_KAISER_BETA * sqrt (1.0 - x * x)) / norm;
+    s = d == 0.0 ? 1.0 : sin (G_PI * cutoff * d) / (G_PI * cutoff * d);
+    h[j] = cutoff * s * w;
+    sum += h[j];
+  }
+  for (j = 0; j < num_taps; j++)
+    taps[j] = (gfloat) (h[j] / sum);
+  g_free (h);
+}
+
+static guint
+gcd (guint a, guint b)
+{
+  while (b) {
+    guint t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+static NvDsResampleBank *
+create_bank (guint in_rate, guint out_rate)
+{
+  NvDsResampleBank *bank = g_new0 (NvDsResampleBank, 1);
+  gdouble cutoff;
+  guint g, p, half_width;
+
+  bank->in_rate = in_rate;
+  bank->out_rate = out_rate;
+  g = gcd (in_rate, out_rate);
+  bank->up = out_rate / g;
+  bank->down = in_rate / g;
+  bank->num_phases = MIN (bank->up, RESAMPLE_MAX_PHASES);
+
+  /* The sinc is stretched when downsampling so that it cuts at the output
+   * Nyquist frequency; taps are rounded up to a multiple of 8 so that the
+   * dot products have no scalar tail. */
+  cutoff = RESAMPLE_ROLLOFF * MIN (1.0, (gdouble) bank->up / bank->down);
+  half_width = (guint) ceil (RESAMPLE_ZERO_CROSSINGS / cutoff);
+  bank->num_taps = (2 * half_width + 7) & ~7u;
+
+  bank->filters = g_new (gfloat, (gsize) bank->num_phases * bank->num_taps);
+  for (p = 0; p < bank->num_phases; p++)
+    design_phase (bank->filters + (gsize) p * bank->num_taps, bank->num_taps,
+        (gdouble) p / bank->num_phases, cutoff);
+  return bank;
+}
+
+/** Return the shared filter bank of a rate pair, building it on first use. */
+static const NvDsResampleBank *
+get_bank (guint in_rate, guint out_rate)
+{
+  NvDsResampleBank *bank = NULL;
+  GSList *l;
+
+  g_mutex_lock (&banks_lock);
+  for (l = banks; l; l = l->next) {
+    NvDsResampleBank *b = (NvDsResampleBank *) l->data;
+    if (b->in_rate == in_rate && b->out_rate == out_rate) {
+      bank = b;
+      break;
+    }
+  }
+  if (!bank) {
+    bank = create_bank (in_rate, out_rate);
+    banks = g_slist_prepend (banks, bank);
+  }
+  g_mutex_unlock (&banks_lock);
+  return bank;
+}
+
+void
+nvds_audio_resampler_precompute (guint out_rate)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (resample_common_rates); i++)
+    if (out_rate && resample_common_rates[i] != out_rate)
+      get_bank (resample_common_rates[i], out_rate);
+}
+
+NvDsAudioResampler *
+nvds_audio_resampler_new (guint in_rate, guint out_rate, guint channels)
+{
+  NvDsAudioResampler *rs;
+  guint c;
+
+  if (!in_rate || !out_rate || !channels) {
+    NVGSTDS_ERR_MSG_V ("Invalid resampler rates %u -> %u, %u channels",
+        in_rate, out_rate, channels);
+    return NULL;
+  }
+
+  rs = g_new0 (NvDsAudioResampler, 1);
+  rs->channels = channels;
+  if (in_rate != out_rate)
+    rs->bank = get_bank (in_rate, out_rate);
+  rs->dot = select_dot ();
+
+  rs->history = g_new0 (gfloat *, channels);
+  rs->history_capacity = rs->bank ? 4 * rs->bank->num_taps : 1024;
+  for (c = 0; c < channels; c++)
+    rs->history[c] = g_new (gfloat, rs->history_capacity);
+  nvds_audio_resampler_reset (rs);
+
+  return rs;
+}
+
+void
+nvds_audio_resampler_free (NvDsAudioResampler *rs)
+{
+  guint c;
+
+  if (!rs)
+    return;
+  for (c = 0; c < rs->channels; c++)
+    g_free (rs->history[c]);
+  g_free (rs->history);
+  g_free (rs);
+}
+
+void
+nvds_audio_resampler_reset (NvDsAudioResampler *rs)
+{
+  guint c;
+
+  /* Zero history so that the first output frame is aligned with the first
+   * input frame. */
+  rs->history_len = rs->bank ? rs->bank->num_taps / 2 - 1 : 0;
+  for (c = 0; c < rs->channels; c++)
+    memset (rs->history[c], 0, rs->history_len * sizeof (gfloat));
+  rs->pos = rs->history_len;
+  rs->phase = 0;
+}
+
+gboolean
+nvds_audio_resampler_is_passthrough (const NvDsAudioResampler *rs)
+{
+  return rs->bank == NULL;
+}
+
+guint
+nvds_audio_resampler_get_num_taps (const NvDsAudioResampler *rs)
+{
+  return rs->bank ? rs->bank->num_taps : 0;
+}
+
+guint
+nvds_audio_resampler_get_max_output (const NvDsAudioResampler *rs,
+    guint num_frames)
+{
+  guint64 avail = (guint64) rs->history_len + num_frames;
+
+  if (!rs->bank)
+    return (guint) avail;
+  if (avail <= rs->pos)
+    return 0;
+  return (guint) (((avail - rs->pos) * rs->bank->up) / rs->bank->down + 1);
+}
+
+gfloat *
+nvds_audio_resampler_get_input (NvDsAudioResampler *rs, guint channel,
+    guint num_frames)
+{
+  if (rs->history_len + num_frames > rs->history_capacity) {
+    guint c;
+
+    rs->history_capacity = rs->history_len + num_frames +
+        nvds_audio_resampler_get_num_taps (rs);
+    for (c = 0; c < rs->channels; c++)
+      rs->history[c] = g_renew (gfloat, rs->history[c],
+          rs->history_capacity);
+  }
+  return rs->history[channel] + rs->history_len;
+}
+
+/** Equal rates: interleave the committed input, no filtering or delay. */
+static guint
+process_passthrough (NvDsAudioResampler *rs, gfloat *out)
+{
+  guint num_frames = rs->history_len;
+  guint i, c;
+
+  if (rs->channels == 1) {
+    memcpy (out, rs->history[0], num_frames * sizeof (gfloat));
+  } else {
+    for (c = 0; c < rs->channels; c++)
+      for (i = 0; i < num_frames; i++)
+        out[i * rs->channels + c] = rs->history[c][i];
+  }
+  rs->history_len = 0;
+  return num_frames;
+}
+
+guint
+nvds_audio_resampler_process (NvDsAudioResampler *rs, guint num_frames,
+    gfloat *out)
+{
+  const NvDsResampleBank *bank = rs->bank;
+  guint lookbehind, lookahead, consumed, c;
+  guint produced = 0;
+
+  rs->history_len += num_frames;
+  if (!bank)
+    return process_passthrough (rs, out);
+
+  lookbehind = bank->num_taps / 2 - 1;
+  lookahead = bank->num_taps / 2;
+  while (rs->pos + lookahead < rs->history_len) {
+    guint base = rs->pos - lookbehind;
+    guint phase = bank->num_phases == bank->up ? rs->phase :
+        (guint) (((guint64) rs->phase * bank->num_phases) / bank->up);
+    const gfloat *taps = bank->filters + (gsize) phase * bank->num_taps;
+
+    for (c = 0; c < rs->channels; c++)
+      *out++ = rs->dot (rs->history[c] + base, taps, bank->num_taps);
+    produced++;
+
+    rs->phase += bank->down;
+    rs->pos += rs->phase / bank->up;
+    rs->phase %= bank->up;
+  }
+
+  /* Keep the look-behind of the next output position. */
+  consumed = MIN (rs->pos - lookbehind, rs->history_len);
+  if (consumed) {
+    for (c = 0; c < rs->channels; c++)
+      memmove (rs->history[c], rs->history[c] + consumed,
+          (rs->history_len - consumed) * sizeof (gfloat));
+    rs->history_len -= consumed;
+    rs->pos -= consumed;
+  }
+  return produced;
+}
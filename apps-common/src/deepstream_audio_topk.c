@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <gst/gst.h>
+
+#include "deepstream_common.h"
+#include "deepstream_audio_topk.h"
+#include "gstnvdsinfer.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define TOPK_HAVE_NEON 1
+#elif defined(__x86_64__)
+#include <immintrin.h>
+#define TOPK_HAVE_SSE 1
+#endif
+
+/** Scores compared per block. */
+#define TOPK_BLOCK 8
+
+/** TRUE if any of the TOPK_BLOCK scores at @p scores is >= @p bar. */
+static inline gboolean
+topk_block_has_candidate (const gfloat *scores, gfloat bar)
+{
+#if defined(TOPK_HAVE_NEON)
+  float32x4_t b = vdupq_n_f32 (bar);
+  uint32x4_t ge = vorrq_u32 (vcgeq_f32 (vld1q_f32 (scores), b),
+      vcgeq_f32 (vld1q_f32 (scores + 4), b));
+
+  return vmaxvq_u32 (ge) != 0;
+#elif defined(TOPK_HAVE_SSE)
+  __m128 b = _mm_set1_ps (bar);
+  __m128 ge = _mm_or_ps (_mm_cmpge_ps (_mm_loadu_ps (scores), b),
+      _mm_cmpge_ps (_mm_loadu_ps (scores + 4), b));
+
+  return _mm_movemask_ps (ge) != 0;
+#else
+  guint i;
+
+  for (i = 0; i < TOPK_BLOCK; i++) {
+    if (scores[i] >= bar)
+      return TRUE;
+  }
+  return FALSE;
+#endif
+}
+
+/** Insert score @p i into the descending list of @p *num of at most @p k. */
+static inline void
+topk_insert (gfloat *top, guint16 *ids, guint *num, guint k, gfloat score,
+    guint i)
+{
+  guint j;
+
+  if (*num == k) {
+    /* Strictly greater, so the lower class wins a tie. */
+    if (!(score > top[k - 1]))
+      return;
+    j = k - 1;
+  } else {
+    j = (*num)++;
+  }
+  for (; j > 0 && top[j - 1] < score; j--) {
+    top[j] = top[j - 1];
+    ids[j] = ids[j - 1];
+  }
+  top[j] = score;
+  ids[j] = (guint16) i;
+}
+
+guint
+nvds_audio_topk_select (const gfloat *scores, guint num_scores, guint k,
+    gfloat min_score, NvDsAudioTopKEntry *entries)
+{
+  gfloat top[NVDS_AUDIO_TOPK_MAX];
+  guint16 ids[NVDS_AUDIO_TOPK_MAX];
+  guint num = 0;
+  guint i = 0, j;
+
+  k = MIN (k, NVDS_AUDIO_TOPK_MAX);
+  if (!k)
+    return 0;
+
+  for (; i + TOPK_BLOCK <= num_scores; i += TOPK_BLOCK) {
+    gfloat bar = num == k ? top[k - 1] : min_score;
+
+    if (!topk_block_has_candidate (scores + i, bar))
+      continue;
+    for (j = i; j < i + TOPK_BLOCK; j++) {
+      if (scores[j] >= min_score)
+        topk_insert (top, ids, &num, k, scores[j], j);
+    }
+  }
+  for (; i < num_scores; i++) {
+    if (scores[i] >= min_score)
+      topk_insert (top, ids, &num, k, scores[i], i);
+  }
+
+  for (j = 0; j < num; j++) {
+    entries[j].class_id = ids[j];
+    entries[j].score = (guint16) lrintf (CLAMP (top[j], 0.0f, 1.0f) *
+        NVDS_AUDIO_TOPK_SCORE_SCALE);
+  }
+  return num;
+}
+
+const gchar *
+nvds_audio_topk_label (const NvDsAudioTopKMeta *meta,
+    const NvDsAudioTopKEntry *entry)
+{
+  if (!meta->labels || entry->class_id >= meta->labels->len)
+    return NULL;
+  return g_ptr_array_index (meta->labels, entry->class_id);
+}
+
+static gpointer
+copy_audio_topk_meta (gpointer data, gpointer user_data)
+{
+  NvDsUserMeta *user_meta = (NvDsUserMeta *) data;
+  NvDsAudioTopKMeta *meta = g_slice_dup (NvDsAudioTopKMeta,
+      user_meta->user_meta_data);
+
+  if (meta->labels)
+    g_ptr_array_ref (meta->labels);
+  return meta;
+}
+
+static void
+release_audio_topk_meta (gpointer data, gpointer user_data)
+{
+  NvDsUserMeta *user_meta = (NvDsUserMeta *) data;
+  NvDsAudioTopKMeta *meta = (NvDsAudioTopKMeta *) user_meta->user_meta_data;
+
+  if (meta->labels)
+    g_ptr_array_unref (meta->labels);
+  g_slice_free (NvDsAudioTopKMeta, meta);
+  user_meta->user_meta_data = NULL;
+}
+
+void
+nvds_audio_topk_attach (NvDsBatchMeta *batch_meta,
+    NvDsAudioFrameMeta *frame_meta, const NvDsAudioTopKEntry *entries,
+    guint num_entries, GPtrArray *labels)
+{
+  NvDsAudioTopKMeta *meta = g_slice_new (NvDsAudioTopKMeta);
+  NvDsUserMeta *user_meta = nvds_acquire_user_meta_from_pool (batch_meta);
+
+  meta->num_entries = MIN (num_entries, NVDS_AUDIO_TOPK_MAX);
+  memcpy (meta->entries, entries,
+      meta->num_entries * sizeof (NvDsAudioTopKEntry));
+  meta->labels = labels ? g_ptr_array_ref (labels) : NULL;
+
+  user_meta->user_meta_data = meta;
+  user_meta->base_meta.meta_type =
+      nvds_get_user_meta_type ((gchar *) NVDS_AUDIO_TOPK_META_STRING);
+  user_meta->base_meta.copy_func = copy_audio_topk_meta;
+  user_meta->base_meta.release_func = release_audio_topk_meta;
+  nvds_add_user_meta_to_audio_frame (frame_meta, user_meta);
+}
+
+gboolean
+nvds_audio_topk_attach_from_tensor_meta (NvDsBatchMeta *batch_meta,
+    NvDsAudioFrameMeta *frame_meta, guint k, gfloat min_score,
+    GPtrArray *labels)
+{
+  NvDsAudioTopKEntry entries[NVDS_AUDIO_TOPK_MAX];
+  NvDsMetaList *l;
+
+  for (l = frame_meta->frame_user_meta_list; l; l = l->next) {
+    NvDsUserMeta *user_meta = (NvDsUserMeta *) l->data;
+    NvDsInferTensorMeta *tensor_meta;
+    NvDsInferLayerInfo *layer;
+
+    if (user_meta->base_meta.meta_type != NVDSINFER_TENSOR_OUTPUT_META)
+      continue;
+    tensor_meta = (NvDsInferTensorMeta *) user_meta->user_meta_data;
+    if (!tensor_meta->num_output_layers)
+      continue;
+    /* The classifiers have a single output, the class scores. */
+    layer = &tensor_meta->output_layers_info[0];
+    if (layer->dataType != FLOAT || !tensor_meta->out_buf_ptrs_host[0])
+      return FALSE;
+
+    nvds_audio_topk_attach (batch_meta, frame_meta, entries,
+        nvds_audio_topk_select (
+            (const gfloat *) tensor_meta->out_buf_ptrs_host[0],
+            layer->inferDims.numElements, k, min_score, entries), labels);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+NvDsAudioTopKMeta *
+nvds_audio_topk_get_meta (NvDsAudioFrameMeta *frame_meta)
+{
+  NvDsMetaType topk_type =
+      nvds_get_user_meta_type ((gchar *) NVDS_AUDIO_TOPK_META_STRING);
+  NvDsMetaList *l;
+
+  for (l = frame_meta->frame_user_meta_list; l; l = l->next) {
+    NvDsUserMeta *user_meta = (NvDsUserMeta *) l->data;
+
+    if (user_meta->base_meta.meta_type == topk_type)
+      return (NvDsAudioTopKMeta *) user_meta->user_meta_data;
+  }
+  return NULL;
+}
+
+GPtrArray *
+nvds_audio_labels_load (const gchar *path)
+{
+  GPtrArray *labels = NULL;
+  gchar *contents = NULL;
+  GError *error = NULL;
+  gchar **split;
+  guint i;
+
+  if (!g_file_get_contents (path, &contents, NULL, &error)) {
+    NVGSTDS_ERR_MSG_V ("Failed to read labels '%s': %s", path,
+        error->message);
+    g_error_free (error);
+    return NULL;
+  }
+  split = g_strsplit_set (g_strstrip (contents), ";\n", -1);
+  labels = g_ptr_array_new_full (g_strv_length (split), g_free);
+  for (i = 0; split[i]; i++)
+    g_ptr_array_add (labels, split[i]);
+  /* The strings now belong to the array. */
+  g_free (split);
+  g_free (contents);
+  return labels;
+}
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "deepstream_common.h"
+#include "deepstream_audio_frontend.h"
+#include "deepstream_cascade.h"
+
+static gboolean
+copy_sticky_event (GstPad *pad, GstEvent **event, gpointer user_data)
+{
+  if (GST_EVENT_TYPE (*event) != GST_EVENT_EOS)
+    gst_pad_send_event ((GstPad *) user_data, gst_event_ref (*event));
+  return TRUE;
+}
+
+static GstPad *
+get_skip_pad (NvDsCascadeBin *bin, GstPad *pad)
+{
+  GstPad *skip_pad = gst_element_get_static_pad (bin->skip_queue, "sink");
+
+  if (!bin->skip_stream_started) {
+    gst_pad_sticky_events_foreach (pad, copy_sticky_event, skip_pad);
+    bin->skip_stream_started = TRUE;
+  }
+  return skip_pad;
+}
+
+static gboolean
+window_flagged (NvDsCascadeBin *bin, NvDsAudioFrameMeta *frame_meta)
+{
+  guint i;
+
+  if (frame_meta->class_id < 0)
+    return FALSE;
+  if (!bin->num_class_ids)
+    return TRUE;
+  for (i = 0; i < bin->num_class_ids; i++) {
+    if (bin->class_ids[i] == frame_meta->class_id)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/**
+ * Per source mode: withhold the feature windows of the sources without
+ * detection from stage two and keep only their detector results.
+ */
+static guint
+pass_flagged_sources (NvDsCascadeBin *bin, NvDsBatchMeta *batch_meta)
+{
+  NvDsMetaType feature_type =
+      nvds_get_user_meta_type ((gchar *) NVDS_AUDIO_FEATURE_META_STRING);
+  NvDsAudioFrameMeta *kept;
+  /** Clock meta of the kept frames, if they had one. */
+  NvDsAudioClockMeta *clocks;
+  gboolean *timed;
+  NvDsMetaList *l, *next;
+  guint num_kept = 0, num_passed = 0;
+  guint i;
+
+  for (l = batch_meta->batch_user_meta_list; l; l = next) {
+    NvDsUserMeta *user_meta = (NvDsUserMeta *) l->data;
+    NvDsAudioFeatureMeta *meta = user_meta->user_meta_data;
+
+    next = l->next;
+    if (user_meta->base_meta.meta_type == feature_type &&
+        meta->source_id < MAX_SOURCE_BINS && !bin->flagged[meta->source_id])
+      nvds_remove_user_meta_from_batch (batch_meta, user_meta);
+  }
+
+  kept = g_new (NvDsAudioFrameMeta, MAX (batch_meta->num_frames_in_batch, 1));
+  clocks = g_new (NvDsAudioClockMeta, MAX (batch_meta->num_frames_in_batch, 1));
+  timed = g_new (gboolean, MAX (batch_meta->num_frames_in_batch, 1));
+  for (l = batch_meta->frame_meta_list; l; l = l->next) {
+    NvDsAudioFrameMeta *frame_meta = (NvDsAudioFrameMeta *) l->data;
+
+    if (frame_meta->source_id < MAX_SOURCE_BINS &&
+        bin->flagged[frame_meta->source_id]) {
+      num_passed++;
+    } else if (num_kept < batch_meta->num_frames_in_batch) {
+      NvDsAudioClockMeta *clock = nvds_audio_clock_get_meta (frame_meta);
+
+      timed[num_kept] = clock != NULL;
+      if (clock)
+        clocks[num_kept] = *clock;
+      kept[num_kept++] = *frame_meta;
+    }
+  }
+
+  nvds_clear_frame_meta_list (batch_meta, batch_meta->frame_meta_list);
+  batch_meta->frame_meta_list = NULL;
+  batch_meta->num_frames_in_batch = 0;
+  for (i = 0; i < num_kept; i++) {
+    NvDsAudioFrameMeta *frame_meta =
+        nvds_acquire_audio_frame_meta_from_pool (batch_meta);
+
+    frame_meta->pad_index = kept[i].pad_index;
+    frame_meta->batch_id = kept[i].batch_id;
+    frame_meta->frame_num = kept[i].frame_num;
+    frame_meta->buf_pts = kept[i].buf_pts;
+    frame_meta->ntp_timestamp = kept[i].ntp_timestamp;
+    frame_meta->source_id = kept[i].source_id;
+    frame_meta->class_id = kept[i].class_id;
+    frame_meta->confidence = kept[i].confidence;
+    g_strlcpy (frame_meta->class_label, kept[i].class_label, MAX_LABEL_SIZE);
+    nvds_add_audio_frame_meta_to_audio_batch (batch_meta, frame_meta);
+    if (timed[i]) {
+      nvds_audio_clock_attach (batch_meta, frame_meta, clocks[i].gap,
+          clocks[i].lag);
+    }
+  }
+  g_free (timed);
+  g_free (clocks);
+  g_free (kept);
+  return num_passed;
+}
+
+static GstPadProbeReturn
+cascade_buf_prob (GstPad *pad, GstPadProbeInfo *info, gpointer u_data)
+{
+  NvDsCascadeBin *bin = (NvDsCascadeBin *) u_data;
+  NvDsBatchMeta *batch_meta;
+  NvDsMetaList *l;
+  GstPad *skip_pad;
+  guint num_windows = 0, num_flagged = 0;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    if (GST_EVENT_TYPE ((GstEvent *) info->data) == GST_EVENT_EOS) {
+      skip_pad = get_skip_pad (bin, pad);
+      print_cascade_stats (bin);
+      gst_pad_send_event (skip_pad, gst_event_new_eos ());
+      gst_object_unref (skip_pad);
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  batch_meta = gst_buffer_get_nvds_batch_meta ((GstBuffer *) info->data);
+  if (!batch_meta)
+    return GST_PAD_PROBE_OK;
+
+  memset (bin->flagged, 0, sizeof (bin->flagged));
+  for (l = batch_meta->frame_meta_list; l; l = l->next) {
+    NvDsAudioFrameMeta *frame_meta = (NvDsAudioFrameMeta *) l->data;
+
+    num_windows++;
+    if (window_flagged (bin, frame_meta)) {
+      num_flagged++;
+      if (frame_meta->source_id < MAX_SOURCE_BINS)
+        bin->flagged[frame_meta->source_id] = TRUE;
+    }
+  }
+  bin->batches++;
+  bin->windows += num_windows;
+  bin->windows_flagged += num_flagged;
+
+  /* Nothing detected: the detector results are final. */
+  if (!num_flagged) {
+    skip_pad = get_skip_pad (bin, pad);
+    gst_pad_chain (skip_pad, gst_buffer_ref ((GstBuffer *) info->data));
+    gst_object_unref (skip_pad);
+    return GST_PAD_PROBE_DROP;
+  }
+
+  bin->batches_passed++;
+  if (bin->per_source) {
+    bin->windows_passed += pass_flagged_sources (bin, batch_meta);
+  } else {
+    /* Stage two classifies the whole batch and replaces all results. */
+    bin->windows_passed += num_windows;
+    nvds_clear_frame_meta_list (batch_meta, batch_meta->frame_meta_list);
+    batch_meta->frame_meta_list = NULL;
+    batch_meta->num_frames_in_batch = 0;
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+void
+print_cascade_stats (NvDsCascadeBin *bin)
+{
+  if (!bin->batches)
+    return;
+  g_print ("Cascade: detector flagged %" G_GUINT64_FORMAT " of %"
+      G_GUINT64_FORMAT " windows (%.1f%%), %" G_GUINT64_FORMAT " windows"
+      " (%.1f%%) in %" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT " batches"
+      " reached stage two\n", bin->windows_flagged, bin->windows,
+      bin->windows ? 100.0 * bin->windows_flagged / bin->windows : 0.0,
+      bin->windows_passed,
+      bin->windows ? 100.0 * bin->windows_passed / bin->windows : 0.0,
+      bin->batches_passed, bin->batches);
+}
+
+void
+destroy_cascade_bin (NvDsCascadeBin *bin)
+{
+  destroy_audio_classifier_bin (&bin->detector);
+}
+
+gboolean
+create_cascade_bin (NvDsGieConfig *config, gint *class_ids,
+    guint num_class_ids, gboolean per_source, NvDsCascadeBin *bin)
+{
+  gboolean ret = FALSE;
+
+  bin->class_ids = class_ids;
+  bin->num_class_ids = num_class_ids;
+  bin->per_source = per_source;
+
+  bin->bin = gst_bin_new ("cascade_bin");
+  if (!bin->bin) {
+    NVGSTDS_ERR_MSG_V ("Failed to create 'cascade_bin'");
+    goto done;
+  }
+
+  if (!create_audio_detector_bin (config, &bin->detector))
+    goto done;
+
+  bin->queue = gst_element_factory_make (NVDS_ELEM_QUEUE, "cascade_queue");
+  if (!bin->queue) {
+    NVGSTDS_ERR_MSG_V ("Failed to create 'cascade_queue'");
+    goto done;
+  }
+
+  bin->skip_queue = gst_element_factory_make (NVDS_ELEM_QUEUE,
+      "cascade_skip_queue");
+  if (!bin->skip_queue) {
+    NVGSTDS_ERR_MSG_V ("Failed to create 'cascade_skip_queue'");
+    goto done;
+  }
+
+  gst_bin_add_many (GST_BIN (bin->bin), bin->detector.bin, bin->queue,
+      bin->skip_queue, NULL);
+
+  NVGSTDS_LINK_ELEMENT (bin->detector.bin, bin->queue);
+
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->queue, "src");
+
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->detector.bin, "sink");
+
+  NVGSTDS_BIN_ADD_GHOST_PAD_NAMED (bin->bin, bin->skip_queue, "src",
+      "skip_src");
+
+  NVGSTDS_ELEM_ADD_PROBE (bin->probe_id, bin->queue, "src",
+      cascade_buf_prob,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, bin);
+
+  ret = TRUE;
+done:
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
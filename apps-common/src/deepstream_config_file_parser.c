@@ -22,6 +22,7 @@
 
 #include "deepstream_common.h"
 #include "deepstream_config_file_parser.h"
+#include "deepstream_audio_topk.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -63,6 +64,9 @@ GST_DEBUG_CATEGORY (APP_CFG_PARSER_CAT);
 #define CONFIG_GROUP_SOURCE_SMART_RECORD_DURATION "smart-rec-duration"
 #define CONFIG_GROUP_SOURCE_SMART_RECORD_INTERVAL "smart-rec-interval"
 #define CONFIG_GROUP_SOURCE_ALSA_DEVICE "alsa-device"
+#define CONFIG_GROUP_SOURCE_LEGACY_INGEST "legacy-ingest"
+#define CONFIG_GROUP_SOURCE_RECONNECT_TIMEOUT_SEC "reconnect-timeout-sec"
+#define CONFIG_GROUP_SOURCE_RECONNECT_BACKOFF_MAX_SEC "reconnect-backoff-max-sec"
 
 #define CONFIG_GROUP_STREAMMUX_ENABLE_PADDING "enable-padding"
 #define CONFIG_GROUP_STREAMMUX_WIDTH "width"
@@ -107,6 +111,11 @@ GST_DEBUG_CATEGORY (APP_CFG_PARSER_CAT);
 #define CONFIG_GROUP_GIE_CONFIG_FILE "config-file"
 #define CONFIG_GROUP_GIE_LABEL "labelfile-path"
 #define CONFIG_GROUP_GIE_PLUGIN_TYPE "plugin-type"
+#define CONFIG_GROUP_GIE_CPU_THREADS "cpu-threads"
+#define CONFIG_GROUP_GIE_BATCH_DEADLINE "batch-deadline-ms"
+#define CONFIG_GROUP_GIE_STREAMING_LAYERS "streaming-layers"
+#define CONFIG_GROUP_GIE_TOP_K "top-k"
+#define CONFIG_GROUP_GIE_TOP_K_THRESHOLD "top-k-threshold"
 #define CONFIG_GROUP_GIE_UNIQUE_ID "gie-unique-id"
 #define CONFIG_GROUP_GIE_ID_FOR_OPERATION "operate-on-gie-id"
 #define CONFIG_GROUP_GIE_BBOX_BORDER_COLOR "bbox-border-color"
@@ -210,6 +219,23 @@ GST_DEBUG_CATEGORY (APP_CFG_PARSER_CAT);
 #define CONFIG_GROUP_DSEXAMPLE_UNIQUE_ID "unique-id"
 #define CONFIG_GROUP_DSEXAMPLE_GPU_ID "gpu-id"
 
+#define CONFIG_GROUP_AUDIO_FRONTEND_KERNEL "kernel"
+#define CONFIG_GROUP_AUDIO_FRONTEND_TENSOR_FORMAT "tensor-format"
+#define CONFIG_GROUP_AUDIO_FRONTEND_ADAPTIVE_HOP "adaptive-hop"
+#define CONFIG_GROUP_AUDIO_FRONTEND_MIN_HOP_SIZE "min-hopsize"
+#define CONFIG_GROUP_AUDIO_FRONTEND_MAX_HOP_SIZE "max-hopsize"
+#define CONFIG_GROUP_AUDIO_FRONTEND_STRETCH_AFTER "stretch-after"
+#define CONFIG_GROUP_AUDIO_FRONTEND_BACKGROUND_LABEL "background-label"
+
+#define CONFIG_GROUP_ACTIVITY_GATE_BAND_LOW "band-low"
+#define CONFIG_GROUP_ACTIVITY_GATE_BAND_HIGH "band-high"
+#define CONFIG_GROUP_ACTIVITY_GATE_MIN_SNR_DB "min-snr-db"
+#define CONFIG_GROUP_ACTIVITY_GATE_MIN_LEVEL_DB "min-level-db"
+#define CONFIG_GROUP_ACTIVITY_GATE_MAX_SKIP_FRACTION "max-skip-fraction"
+#define CONFIG_GROUP_ACTIVITY_GATE_REPORT_INTERVAL "report-interval-sec"
+#define CONFIG_GROUP_ACTIVITY_GATE_BACKGROUND_LABEL "background-label"
+#define CONFIG_GROUP_ACTIVITY_GATE_BACKGROUND_CLASS_ID "background-class-id"
+
 #define CHECK_ERROR(error) \
     if (error) { \
         GST_CAT_ERROR (APP_CFG_PARSER_CAT, "%s", error->message); \
@@ -372,6 +398,16 @@ done:
   return ret;
 }
 
+/** IDs of the source groups parsed so far, to catch duplicates. */
+static GList *camera_id_list = NULL;
+
+void
+reset_parsed_source_ids (void)
+{
+  g_list_free (camera_id_list);
+  camera_id_list = NULL;
+}
+
 gboolean
 parse_source (NvDsSourceConfig *config, GKeyFile *key_file, gchar *group, gchar *cfg_file_path)
 {
@@ -379,7 +415,6 @@ parse_source (NvDsSourceConfig *config, GKeyFile *key_file, gchar *group, gchar
   gchar **keys = NULL;
   gchar **key = NULL;
   GError *error = NULL;
-  static GList *camera_id_list = NULL;
 
   if (g_strcmp0 (group, CONFIG_GROUP_SOURCE_ALL)) {
     if (g_key_file_get_integer (key_file, group,
@@ -392,6 +427,8 @@ parse_source (NvDsSourceConfig *config, GKeyFile *key_file, gchar *group, gchar
     config->camera_id = g_ascii_strtoull (source_id_start_ptr, &source_id_end_ptr, 10);
 
     config->rtsp_reconnect_attempts = -1;
+    config->reconnect_timeout_sec = 10;
+    config->reconnect_backoff_max_sec = 60;
 
     // Source group name should be of the form [source<%u>]. If
     // *source_id_end_ptr is not the string terminating character '\0' or if
@@ -463,6 +500,22 @@ parse_source (NvDsSourceConfig *config, GKeyFile *key_file, gchar *group, gchar
           g_key_file_get_string (key_file, group,
           CONFIG_GROUP_SOURCE_ALSA_DEVICE, &error);
       CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_SOURCE_LEGACY_INGEST)) {
+      config->legacy_ingest =
+          g_key_file_get_integer (key_file, group,
+          CONFIG_GROUP_SOURCE_LEGACY_INGEST, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_SOURCE_RECONNECT_TIMEOUT_SEC)) {
+      config->reconnect_timeout_sec =
+          g_key_file_get_integer (key_file, group,
+          CONFIG_GROUP_SOURCE_RECONNECT_TIMEOUT_SEC, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key,
+            CONFIG_GROUP_SOURCE_RECONNECT_BACKOFF_MAX_SEC)) {
+      config->reconnect_backoff_max_sec =
+          g_key_file_get_integer (key_file, group,
+          CONFIG_GROUP_SOURCE_RECONNECT_BACKOFF_MAX_SEC, &error);
+      CHECK_ERROR (error);
     } else if (!g_strcmp0 (*key, CONFIG_GROUP_SOURCE_URI)) {
       gchar *uri =
           g_key_file_get_string (key_file, group,
@@ -850,6 +903,201 @@ done:
   return ret;
 }
 
+gboolean
+parse_audio_frontend (NvDsAudioFrontendConfig *config, GKeyFile *key_file)
+{
+  gboolean ret = FALSE;
+  gchar **keys = NULL;
+  gchar **key = NULL;
+  GError *error = NULL;
+
+  keys = g_key_file_get_keys (key_file, CONFIG_GROUP_AUDIO_FRONTEND, NULL,
+      &error);
+  CHECK_ERROR (error);
+  for (key = keys; *key; key++) {
+    if (!g_strcmp0 (*key, CONFIG_GROUP_ENABLE)) {
+      config->enable =
+        g_key_file_get_integer (key_file, CONFIG_GROUP_AUDIO_FRONTEND,
+            CONFIG_GROUP_ENABLE, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_AUDIO_FRONTEND_KERNEL)) {
+      gchar *kernel =
+        g_key_file_get_string (key_file, CONFIG_GROUP_AUDIO_FRONTEND,
+            CONFIG_GROUP_AUDIO_FRONTEND_KERNEL, &error);
+      CHECK_ERROR (error);
+      if (!g_strcmp0 (kernel, "auto")) {
+        config->kernel = NVDS_MEL_KERNEL_AUTO;
+      } else if (!g_strcmp0 (kernel, "scalar")) {
+        config->kernel = NVDS_MEL_KERNEL_SCALAR;
+      } else if (!g_strcmp0 (kernel, "neon")) {
+        config->kernel = NVDS_MEL_KERNEL_NEON;
+      } else if (!g_strcmp0 (kernel, "avx2")) {
+        config->kernel = NVDS_MEL_KERNEL_AVX2;
+      } else {
+        NVGSTDS_ERR_MSG_V ("Invalid %s '%s'; expected auto, scalar, neon"
+            " or avx2", CONFIG_GROUP_AUDIO_FRONTEND_KERNEL, kernel);
+        g_free (kernel);
+        goto done;
+      }
+      g_free (kernel);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_AUDIO_FRONTEND_TENSOR_FORMAT)) {
+      gchar *format =
+        g_key_file_get_string (key_file, CONFIG_GROUP_AUDIO_FRONTEND,
+            CONFIG_GROUP_AUDIO_FRONTEND_TENSOR_FORMAT, &error);
+      CHECK_ERROR (error);
+      if (!g_strcmp0 (format, "fp32")) {
+        config->tensor_format = NVDS_AUDIO_TENSOR_FP32;
+      } else if (!g_strcmp0 (format, "fp16")) {
+        config->tensor_format = NVDS_AUDIO_TENSOR_FP16;
+      } else if (!g_strcmp0 (format, "int8")) {
+        config->tensor_format = NVDS_AUDIO_TENSOR_INT8;
+      } else {
+        NVGSTDS_ERR_MSG_V ("Invalid %s '%s'; expected fp32, fp16 or int8",
+            CONFIG_GROUP_AUDIO_FRONTEND_TENSOR_FORMAT, format);
+        g_free (format);
+        goto done;
+      }
+      g_free (format);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_AUDIO_FRONTEND_ADAPTIVE_HOP)) {
+      config->adaptive_hop =
+        g_key_file_get_boolean (key_file, CONFIG_GROUP_AUDIO_FRONTEND,
+            CONFIG_GROUP_AUDIO_FRONTEND_ADAPTIVE_HOP, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_AUDIO_FRONTEND_MIN_HOP_SIZE)) {
+      config->min_hop_size =
+        g_key_file_get_integer (key_file, CONFIG_GROUP_AUDIO_FRONTEND,
+            CONFIG_GROUP_AUDIO_FRONTEND_MIN_HOP_SIZE, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_AUDIO_FRONTEND_MAX_HOP_SIZE)) {
+      config->max_hop_size =
+        g_key_file_get_integer (key_file, CONFIG_GROUP_AUDIO_FRONTEND,
+            CONFIG_GROUP_AUDIO_FRONTEND_MAX_HOP_SIZE, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_AUDIO_FRONTEND_STRETCH_AFTER)) {
+      config->stretch_after =
+        g_key_file_get_integer (key_file, CONFIG_GROUP_AUDIO_FRONTEND,
+            CONFIG_GROUP_AUDIO_FRONTEND_STRETCH_AFTER, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key,
+            CONFIG_GROUP_AUDIO_FRONTEND_BACKGROUND_LABEL)) {
+      g_free (config->background_label);
+      config->background_label =
+        g_key_file_get_string (key_file, CONFIG_GROUP_AUDIO_FRONTEND,
+            CONFIG_GROUP_AUDIO_FRONTEND_BACKGROUND_LABEL, &error);
+      CHECK_ERROR (error);
+    } else {
+      NVGSTDS_WARN_MSG_V ("Unknown key '%s' for group [%s]", *key,
+          CONFIG_GROUP_AUDIO_FRONTEND);
+    }
+  }
+
+  ret = TRUE;
+done:
+  if (error) {
+    g_error_free (error);
+  }
+  if (keys) {
+    g_strfreev (keys);
+  }
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+gboolean
+parse_activity_gate (NvDsActivityGateConfig *config, GKeyFile *key_file)
+{
+  gboolean ret = FALSE;
+  gchar **keys = NULL;
+  gchar **key = NULL;
+  GError *error = NULL;
+
+  config->band_low = 800.0;
+  config->band_high = 10000.0;
+  config->min_snr_db = 9.0;
+  config->min_level_db = -70.0;
+  config->max_skip_fraction = 1.0;
+
+  keys = g_key_file_get_keys (key_file, CONFIG_GROUP_ACTIVITY_GATE, NULL,
+      &error);
+  CHECK_ERROR (error);
+  for (key = keys; *key; key++) {
+    if (!g_strcmp0 (*key, CONFIG_GROUP_ENABLE)) {
+      config->enable =
+        g_key_file_get_integer (key_file, CONFIG_GROUP_ACTIVITY_GATE,
+            CONFIG_GROUP_ENABLE, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_ACTIVITY_GATE_BAND_LOW)) {
+      config->band_low =
+        g_key_file_get_double (key_file, CONFIG_GROUP_ACTIVITY_GATE,
+            CONFIG_GROUP_ACTIVITY_GATE_BAND_LOW, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_ACTIVITY_GATE_BAND_HIGH)) {
+      config->band_high =
+        g_key_file_get_double (key_file, CONFIG_GROUP_ACTIVITY_GATE,
+            CONFIG_GROUP_ACTIVITY_GATE_BAND_HIGH, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_ACTIVITY_GATE_MIN_SNR_DB)) {
+      config->min_snr_db =
+        g_key_file_get_double (key_file, CONFIG_GROUP_ACTIVITY_GATE,
+            CONFIG_GROUP_ACTIVITY_GATE_MIN_SNR_DB, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_ACTIVITY_GATE_MIN_LEVEL_DB)) {
+      config->min_level_db =
+        g_key_file_get_double (key_file, CONFIG_GROUP_ACTIVITY_GATE,
+            CONFIG_GROUP_ACTIVITY_GATE_MIN_LEVEL_DB, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key,
+            CONFIG_GROUP_ACTIVITY_GATE_MAX_SKIP_FRACTION)) {
+      config->max_skip_fraction =
+        g_key_file_get_double (key_file, CONFIG_GROUP_ACTIVITY_GATE,
+            CONFIG_GROUP_ACTIVITY_GATE_MAX_SKIP_FRACTION, &error);
+      CHECK_ERROR (error);
+      if (config->max_skip_fraction < 0.0 || config->max_skip_fraction > 1.0) {
+        NVGSTDS_ERR_MSG_V ("Invalid %s %f; expected 0 to 1",
+            CONFIG_GROUP_ACTIVITY_GATE_MAX_SKIP_FRACTION,
+            config->max_skip_fraction);
+        goto done;
+      }
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_ACTIVITY_GATE_REPORT_INTERVAL)) {
+      config->report_interval =
+        g_key_file_get_integer (key_file, CONFIG_GROUP_ACTIVITY_GATE,
+            CONFIG_GROUP_ACTIVITY_GATE_REPORT_INTERVAL, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key,
+            CONFIG_GROUP_ACTIVITY_GATE_BACKGROUND_LABEL)) {
+      g_free (config->background_label);
+      config->background_label =
+        g_key_file_get_string (key_file, CONFIG_GROUP_ACTIVITY_GATE,
+            CONFIG_GROUP_ACTIVITY_GATE_BACKGROUND_LABEL, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key,
+            CONFIG_GROUP_ACTIVITY_GATE_BACKGROUND_CLASS_ID)) {
+      config->background_class_id =
+        g_key_file_get_integer (key_file, CONFIG_GROUP_ACTIVITY_GATE,
+            CONFIG_GROUP_ACTIVITY_GATE_BACKGROUND_CLASS_ID, &error);
+      CHECK_ERROR (error);
+    } else {
+      NVGSTDS_WARN_MSG_V ("Unknown key '%s' for group [%s]", *key,
+          CONFIG_GROUP_ACTIVITY_GATE);
+    }
+  }
+
+  ret = TRUE;
+done:
+  if (error) {
+    g_error_free (error);
+  }
+  if (keys) {
+    g_strfreev (keys);
+  }
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
 gboolean
 parse_osd (NvDsOSDConfig *config, GKeyFile *key_file)
 {
@@ -1156,6 +1404,36 @@ parse_gie (NvDsGieConfig *config, GKeyFile *key_file, gchar *group, gchar *cfg_f
       config->plugin_type =
           (NvDsGiePluginType)g_key_file_get_integer (key_file, group,
             CONFIG_GROUP_GIE_PLUGIN_TYPE, &error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_GIE_CPU_THREADS)) {
+      config->cpu_threads =
+          g_key_file_get_integer (key_file, group,
+          CONFIG_GROUP_GIE_CPU_THREADS, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_GIE_BATCH_DEADLINE)) {
+      config->batch_deadline_ms =
+          g_key_file_get_integer (key_file, group,
+          CONFIG_GROUP_GIE_BATCH_DEADLINE, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_GIE_STREAMING_LAYERS)) {
+      config->streaming_layers =
+          g_key_file_get_integer (key_file, group,
+          CONFIG_GROUP_GIE_STREAMING_LAYERS, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_GIE_TOP_K)) {
+      config->top_k =
+          g_key_file_get_integer (key_file, group,
+          CONFIG_GROUP_GIE_TOP_K, &error);
+      CHECK_ERROR (error);
+      if (config->top_k > NVDS_AUDIO_TOPK_MAX) {
+        NVGSTDS_ERR_MSG_V ("Invalid %s %u; expected 0 to %u",
+            CONFIG_GROUP_GIE_TOP_K, config->top_k, NVDS_AUDIO_TOPK_MAX);
+        goto done;
+      }
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_GIE_TOP_K_THRESHOLD)) {
+      config->top_k_threshold =
+          g_key_file_get_double (key_file, group,
+          CONFIG_GROUP_GIE_TOP_K_THRESHOLD, &error);
+      CHECK_ERROR (error);
     } else if (!g_strcmp0 (*key, CONFIG_GROUP_GIE_AUDIO_TRANSFORM)) {
       config->audio_transform =
           g_key_file_get_string (key_file, group,
@@ -0,0 +1,1172 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "deepstream_common.h"
+#include "deepstream_cpu_infer.h"
+
+/** Output columns processed at once by the GEMM, keeping one output row
+ *  and one input row in L1. */
+#define CPU_NET_GEMM_BLOCK 256
+
+typedef struct
+{
+  guint c;
+  guint h;
+  guint w;
+  /** Workspace buffer holding the tensor. */
+  guint buffer;
+} CpuTensor;
+
+typedef struct
+{
+  NvDsCpuLayerType type;
+  NvDsCpuActivation activation;
+  guint input[2];
+  guint output;
+  guint out_channels;
+  guint kernel_h;
+  guint kernel_w;
+  guint stride_h;
+  guint stride_w;
+  guint pad_top;
+  guint pad_left;
+  guint pad_bottom;
+  guint pad_right;
+  guint groups;
+  gfloat *weights;
+  gfloat *bias;
+} CpuLayer;
+
+struct _NvDsCpuNet
+{
+  guint num_tensors;
+  CpuTensor *tensors;
+  guint num_layers;
+  CpuLayer *layers;
+  guint output_tensor;
+  guint num_buffers;
+  /** Floats of each buffer per input. */
+  gsize *buffer_sizes;
+  /** Floats of the im2col matrix of the largest convolution. */
+  gsize col_size;
+  /** Layers computed incrementally by nvds_cpu_net_run_streams(). */
+  guint stream_layers;
+  gboolean stream_time_on_width;
+  /** Per streamed tensor: time steps [lo, hi) whose receptive field lies
+   *  inside the input, and input steps per time step. */
+  guint *stream_lo;
+  guint *stream_hi;
+  guint *stream_step;
+  /** Floats of the largest tensor read or written by a streamed layer. */
+  gsize stream_scratch;
+};
+
+struct _NvDsCpuNetWorkspace
+{
+  guint max_batch_size;
+  guint num_buffers;
+  gfloat **buffers;
+  gfloat *col;
+  /** Streaming only: time slices of the inputs and output of a layer. */
+  gfloat *slices[3];
+};
+
+struct _NvDsCpuNetStream
+{
+  guint num_tensors;
+  /** Input and streamed tensors of the cached window, NULL for the other
+   *  tensors. */
+  gfloat **tensors;
+  gboolean cached;
+  guint64 position;
+  NvDsCpuNetStreamStats stats;
+};
+
+typedef struct
+{
+  const guint8 *data;
+  gsize len;
+  gsize pos;
+} NetReader;
+
+static gboolean
+read_u32 (NetReader *r, guint32 *value)
+{
+  if (r->len - r->pos < sizeof (guint32))
+    return FALSE;
+  memcpy (value, r->data + r->pos, sizeof (guint32));
+  *value = GUINT32_FROM_LE (*value);
+  r->pos += sizeof (guint32);
+  return TRUE;
+}
+
+static gboolean
+read_floats (NetReader *r, guint32 count, gfloat **values)
+{
+  guint32 *bits;
+  guint32 i;
+
+  *values = NULL;
+  if (!count)
+    return TRUE;
+  if ((r->len - r->pos) / sizeof (gfloat) < count)
+    return FALSE;
+  *values = g_new (gfloat, count);
+  memcpy (*values, r->data + r->pos, count * sizeof (gfloat));
+  bits = (guint32 *) *values;
+  for (i = 0; i < count; i++)
+    bits[i] = GUINT32_FROM_LE (bits[i]);
+  r->pos += count * sizeof (gfloat);
+  return TRUE;
+}
+
+static gsize
+tensor_size (const CpuTensor *t)
+{
+  return (gsize) t->c * t->h * t->w;
+}
+
+static gboolean
+is_pointwise (const CpuLayer *l)
+{
+  return l->kernel_h == 1 && l->kernel_w == 1 && l->stride_h == 1 &&
+      l->stride_w == 1 && !l->pad_top && !l->pad_left && !l->pad_bottom &&
+      !l->pad_right;
+}
+
+static gboolean
+is_depthwise (const CpuLayer *l, const CpuTensor *in)
+{
+  return l->groups > 1 && l->groups == in->c && l->out_channels == in->c;
+}
+
+/** Output size of a sliding window, 0 if the kernel doesn't fit. */
+static guint
+window_output_size (guint size, guint kernel, guint stride, guint pad0,
+    guint pad1)
+{
+  if (!kernel || !stride || size + pad0 + pad1 < kernel)
+    return 0;
+  return (size + pad0 + pad1 - kernel) / stride + 1;
+}
+
+/** Check the parameters of layer @p index and set its output shape. */
+static gboolean
+infer_layer_shape (NvDsCpuNet *net, CpuLayer *l, guint index,
+    guint32 num_weights, guint32 num_bias, const gboolean *defined)
+{
+  const CpuTensor *in = &net->tensors[l->input[0]];
+  const CpuTensor *in1 = NULL;
+  CpuTensor *out = &net->tensors[l->output];
+  guint32 expected_weights = 0;
+  guint32 expected_bias = 0;
+
+  if (l->type == NVDS_CPU_LAYER_ADD || l->type == NVDS_CPU_LAYER_MUL) {
+    if (l->input[1] >= net->num_tensors || !defined[l->input[1]])
+      goto invalid;
+    in1 = &net->tensors[l->input[1]];
+  } else if (l->input[1] != NVDS_CPU_NET_NO_TENSOR) {
+    goto invalid;
+  }
+  if (l->activation > NVDS_CPU_ACTIVATION_SILU)
+    goto invalid;
+
+  out->c = in->c;
+  out->h = in->h;
+  out->w = in->w;
+
+  switch (l->type) {
+    case NVDS_CPU_LAYER_CONV:
+      if (!l->groups || !l->out_channels || in->c % l->groups ||
+          l->out_channels % l->groups)
+        goto invalid;
+      out->c = l->out_channels;
+      out->h = window_output_size (in->h, l->kernel_h, l->stride_h,
+          l->pad_top, l->pad_bottom);
+      out->w = window_output_size (in->w, l->kernel_w, l->stride_w,
+          l->pad_left, l->pad_right);
+      expected_weights = l->out_channels * (in->c / l->groups) *
+          l->kernel_h * l->kernel_w;
+      expected_bias = num_bias ? l->out_channels : 0;
+      if (!is_pointwise (l) && !is_depthwise (l, in)) {
+        net->col_size = MAX (net->col_size, (gsize) (in->c / l->groups) *
+            l->kernel_h * l->kernel_w * out->h * out->w);
+      }
+      break;
+    case NVDS_CPU_LAYER_AVG_POOL:
+      if (!l->kernel_h && !l->kernel_w) {
+        out->h = out->w = 1;
+        break;
+      }
+      /* fall through */
+    case NVDS_CPU_LAYER_MAX_POOL:
+      out->h = window_output_size (in->h, l->kernel_h, l->stride_h,
+          l->pad_top, l->pad_bottom);
+      out->w = window_output_size (in->w, l->kernel_w, l->stride_w,
+          l->pad_left, l->pad_right);
+      break;
+    case NVDS_CPU_LAYER_ADD:
+    case NVDS_CPU_LAYER_MUL:
+      if (in1->c != in->c || !((in1->h == in->h && in1->w == in->w) ||
+              (in1->h == 1 && in1->w == 1)))
+        goto invalid;
+      break;
+    case NVDS_CPU_LAYER_ACTIVATION:
+    case NVDS_CPU_LAYER_SOFTMAX:
+      break;
+    default:
+      goto invalid;
+  }
+
+  if (!out->c || !out->h || !out->w || num_weights != expected_weights ||
+      num_bias != expected_bias)
+    goto invalid;
+  return TRUE;
+
+invalid:
+  NVGSTDS_ERR_MSG_V ("Invalid layer %u (type %u)", index, l->type);
+  return FALSE;
+}
+
+/**
+ * Assign every tensor a buffer. A buffer is reused once the last layer
+ * reading its tensor has run; the output of a layer never shares a buffer
+ * with its inputs.
+ */
+static void
+plan_buffers (NvDsCpuNet *net)
+{
+  guint *last_use = g_new0 (guint, net->num_tensors);
+  gboolean *busy = g_new0 (gboolean, net->num_tensors);
+  guint i, j;
+
+  net->buffer_sizes = g_new0 (gsize, net->num_tensors);
+  for (i = 0; i < net->num_layers; i++) {
+    CpuLayer *l = &net->layers[i];
+
+    last_use[l->output] = i;
+    for (j = 0; j < 2; j++) {
+      if (l->input[j] != NVDS_CPU_NET_NO_TENSOR)
+        last_use[l->input[j]] = i;
+    }
+  }
+  last_use[net->output_tensor] = G_MAXUINT;
+
+  net->tensors[0].buffer = 0;
+  net->buffer_sizes[0] = tensor_size (&net->tensors[0]);
+  busy[0] = TRUE;
+  net->num_buffers = 1;
+
+  for (i = 0; i < net->num_layers; i++) {
+    CpuLayer *l = &net->layers[i];
+    CpuTensor *out = &net->tensors[l->output];
+    gsize need = tensor_size (out);
+    gint best = -1;
+
+    /* Smallest free buffer that fits, else the largest one, grown. */
+    for (j = 0; j < net->num_buffers; j++) {
+      gboolean fits, best_fits;
+
+      if (busy[j])
+        continue;
+      if (best < 0) {
+        best = j;
+        continue;
+      }
+      fits = net->buffer_sizes[j] >= need;
+      best_fits = net->buffer_sizes[best] >= need;
+      if ((fits && (!best_fits ||
+                  net->buffer_sizes[j] < net->buffer_sizes[best])) ||
+          (!fits && !best_fits &&
+              net->buffer_sizes[j] > net->buffer_sizes[best]))
+        best = j;
+    }
+    if (best < 0)
+      best = net->num_buffers++;
+    net->buffer_sizes[best] = MAX (net->buffer_sizes[best], need);
+    busy[best] = TRUE;
+    out->buffer = best;
+
+    for (j = 0; j < 2; j++) {
+      if (l->input[j] != NVDS_CPU_NET_NO_TENSOR && last_use[l->input[j]] == i)
+        busy[net->tensors[l->input[j]].buffer] = FALSE;
+    }
+    if (last_use[l->output] == i)
+      busy[best] = FALSE;
+  }
+
+  g_free (last_use);
+  g_free (busy);
+}
+
+NvDsCpuNet *
+nvds_cpu_net_load (const gchar *path)
+{
+  NvDsCpuNet *net = g_new0 (NvDsCpuNet, 1);
+  gboolean *defined = NULL;
+  gchar *contents = NULL;
+  gsize length = 0;
+  NetReader reader;
+  guint32 header[8];
+  GError *error = NULL;
+  gboolean ret = FALSE;
+  guint i;
+
+  if (!g_file_get_contents (path, &contents, &length, &error)) {
+    NVGSTDS_ERR_MSG_V ("Failed to read '%s': %s", path, error->message);
+    g_error_free (error);
+    goto done;
+  }
+  reader.data = (const guint8 *) contents;
+  reader.len = length;
+  reader.pos = 0;
+
+  for (i = 0; i < G_N_ELEMENTS (header); i++) {
+    if (!read_u32 (&reader, &header[i]))
+      goto truncated;
+  }
+  if (header[0] != NVDS_CPU_NET_MAGIC || header[1] != NVDS_CPU_NET_VERSION) {
+    NVGSTDS_ERR_MSG_V ("'%s' is not a version %u network", path,
+        NVDS_CPU_NET_VERSION);
+    goto done;
+  }
+  net->num_tensors = header[2];
+  net->num_layers = header[3];
+  net->output_tensor = header[7];
+  if (!net->num_layers || net->num_tensors != net->num_layers + 1 ||
+      !net->output_tensor || net->output_tensor >= net->num_tensors ||
+      !header[4] || !header[5] || !header[6]) {
+    NVGSTDS_ERR_MSG_V ("Invalid network header in '%s'", path);
+    goto done;
+  }
+
+  net->tensors = g_new0 (CpuTensor, net->num_tensors);
+  net->layers = g_new0 (CpuLayer, net->num_layers);
+  defined = g_new0 (gboolean, net->num_tensors);
+  net->tensors[0].c = header[4];
+  net->tensors[0].h = header[5];
+  net->tensors[0].w = header[6];
+  defined[0] = TRUE;
+
+  for (i = 0; i < net->num_layers; i++) {
+    CpuLayer *l = &net->layers[i];
+    guint32 fields[17];
+    guint j;
+
+    for (j = 0; j < G_N_ELEMENTS (fields); j++) {
+      if (!read_u32 (&reader, &fields[j]))
+        goto truncated;
+    }
+    l->type = fields[0];
+    l->activation = fields[1];
+    l->input[0] = fields[2];
+    l->input[1] = fields[3];
+    l->output = fields[4];
+    l->out_channels = fields[5];
+    l->kernel_h = fields[6];
+    l->kernel_w = fields[7];
+    l->stride_h = fields[8];
+    l->stride_w = fields[9];
+    l->pad_top = fields[10];
+    l->pad_left = fields[11];
+    l->pad_bottom = fields[12];
+    l->pad_right = fields[13];
+    l->groups = fields[14];
+    if (!read_floats (&reader, fields[15], &l->weights) ||
+        !read_floats (&reader, fields[16], &l->bias))
+      goto truncated;
+
+    if (l->input[0] >= net->num_tensors || !defined[l->input[0]] ||
+        l->output >= net->num_tensors || defined[l->output]) {
+      NVGSTDS_ERR_MSG_V ("Invalid tensors of layer %u", i);
+      goto done;
+    }
+    if (!infer_layer_shape (net, l, i, fields[15], fields[16], defined))
+      goto done;
+    defined[l->output] = TRUE;
+  }
+
+  plan_buffers (net);
+  ret = TRUE;
+  goto done;
+
+truncated:
+  NVGSTDS_ERR_MSG_V ("Network file '%s' is truncated", path);
+done:
+  g_free (defined);
+  g_free (contents);
+  if (!ret) {
+    nvds_cpu_net_free (net);
+    net = NULL;
+  }
+  return net;
+}
+
+void
+nvds_cpu_net_free (NvDsCpuNet *net)
+{
+  guint i;
+
+  if (!net)
+    return;
+  for (i = 0; net->layers && i < net->num_layers; i++) {
+    g_free (net->layers[i].weights);
+    g_free (net->layers[i].bias);
+  }
+  g_free (net->layers);
+  g_free (net->tensors);
+  g_free (net->buffer_sizes);
+  g_free (net->stream_lo);
+  g_free (net->stream_hi);
+  g_free (net->stream_step);
+  g_free (net);
+}
+
+void
+nvds_cpu_net_get_input_dims (const NvDsCpuNet *net, guint *channels,
+    guint *height, guint *width)
+{
+  *channels = net->tensors[0].c;
+  *height = net->tensors[0].h;
+  *width = net->tensors[0].w;
+}
+
+guint
+nvds_cpu_net_get_output_size (const NvDsCpuNet *net)
+{
+  return tensor_size (&net->tensors[net->output_tensor]);
+}
+
+NvDsCpuNetWorkspace *
+nvds_cpu_net_workspace_new (const NvDsCpuNet *net, guint max_batch_size)
+{
+  NvDsCpuNetWorkspace *ws = g_new0 (NvDsCpuNetWorkspace, 1);
+  guint i;
+
+  ws->max_batch_size = MAX (max_batch_size, 1);
+  ws->num_buffers = net->num_buffers;
+  ws->buffers = g_new0 (gfloat *, net->num_buffers);
+  for (i = 0; i < net->num_buffers; i++)
+    ws->buffers[i] = g_new (gfloat, net->buffer_sizes[i] * ws->max_batch_size);
+  if (net->col_size)
+    ws->col = g_new (gfloat, net->col_size);
+  for (i = 0; net->stream_scratch && i < G_N_ELEMENTS (ws->slices); i++)
+    ws->slices[i] = g_new (gfloat, net->stream_scratch);
+  return ws;
+}
+
+void
+nvds_cpu_net_workspace_free (NvDsCpuNetWorkspace *ws)
+{
+  guint i;
+
+  if (!ws)
+    return;
+  for (i = 0; i < ws->num_buffers; i++)
+    g_free (ws->buffers[i]);
+  g_free (ws->buffers);
+  g_free (ws->col);
+  for (i = 0; i < G_N_ELEMENTS (ws->slices); i++)
+    g_free (ws->slices[i]);
+  g_free (ws);
+}
+
+static gfloat *
+tensor_data (const NvDsCpuNet *net, NvDsCpuNetWorkspace *ws, guint tensor,
+    guint item)
+{
+  guint buffer = net->tensors[tensor].buffer;
+
+  return ws->buffers[buffer] + item * net->buffer_sizes[buffer];
+}
+
+static void
+apply_activation (NvDsCpuActivation activation, gfloat *x, gsize n)
+{
+  gsize i;
+
+  switch (activation) {
+    case NVDS_CPU_ACTIVATION_RELU:
+      for (i = 0; i < n; i++)
+        x[i] = x[i] > 0.0f ? x[i] : 0.0f;
+      break;
+    case NVDS_CPU_ACTIVATION_RELU6:
+      for (i = 0; i < n; i++)
+        x[i] = CLAMP (x[i], 0.0f, 6.0f);
+      break;
+    case NVDS_CPU_ACTIVATION_SIGMOID:
+      for (i = 0; i < n; i++)
+        x[i] = 1.0f / (1.0f + expf (-x[i]));
+      break;
+    case NVDS_CPU_ACTIVATION_SILU:
+      for (i = 0; i < n; i++)
+        x[i] = x[i] / (1.0f + expf (-x[i]));
+      break;
+    default:
+      break;
+  }
+}
+
+/** c (m x n) = a (m x k) * b (k x n) + bias (m). */
+static void
+gemm (const gfloat *a, const gfloat *b, const gfloat *bias, guint m, guint k,
+    guint n, gfloat *c)
+{
+  guint j0, i, p, j;
+
+  for (j0 = 0; j0 < n; j0 += CPU_NET_GEMM_BLOCK) {
+    guint nb = MIN (CPU_NET_GEMM_BLOCK, n - j0);
+
+    for (i = 0; i < m; i++) {
+      gfloat *row = c + (gsize) i * n + j0;
+      gfloat init = bias ? bias[i] : 0.0f;
+
+      for (j = 0; j < nb; j++)
+        row[j] = init;
+      for (p = 0; p < k; p++) {
+        const gfloat *brow = b + (gsize) p * n + j0;
+        gfloat w = a[(gsize) i * k + p];
+
+        if (w == 0.0f)
+          continue;
+        for (j = 0; j < nb; j++)
+          row[j] += w * brow[j];
+      }
+    }
+  }
+}
+
+/** Unfold the receptive fields of @p channels input channels into rows. */
+static void
+im2col (const CpuLayer *l, const CpuTensor *in, const gfloat *src,
+    guint channels, const CpuTensor *out, gfloat *col)
+{
+  gsize n = (gsize) out->h * out->w;
+  guint c, ky, kx, oy, ox;
+
+  for (c = 0; c < channels; c++) {
+    const gfloat *plane = src + (gsize) c * in->h * in->w;
+
+    for (ky = 0; ky < l->kernel_h; ky++) {
+      for (kx = 0; kx < l->kernel_w; kx++) {
+        gfloat *dst = col +
+            (((gsize) c * l->kernel_h + ky) * l->kernel_w + kx) * n;
+
+        for (oy = 0; oy < out->h; oy++) {
+          gint iy = (gint) (oy * l->stride_h + ky) - (gint) l->pad_top;
+          gfloat *drow = dst + (gsize) oy * out->w;
+
+          if (iy < 0 || iy >= (gint) in->h) {
+            memset (drow, 0, out->w * sizeof (gfloat));
+            continue;
+          }
+          for (ox = 0; ox < out->w; ox++) {
+            gint ix = (gint) (ox * l->stride_w + kx) - (gint) l->pad_left;
+
+            drow[ox] = (ix >= 0 && ix < (gint) in->w) ?
+                plane[iy * in->w + ix] : 0.0f;
+          }
+        }
+      }
+    }
+  }
+}
+
+static void
+run_depthwise (const CpuLayer *l, const CpuTensor *in, const gfloat *src,
+    const CpuTensor *out, gfloat *dst)
+{
+  guint c, oy, ox, ky, kx;
+
+  for (c = 0; c < in->c; c++) {
+    const gfloat *plane = src + (gsize) c * in->h * in->w;
+    const gfloat *w = l->weights + (gsize) c * l->kernel_h * l->kernel_w;
+    gfloat *oplane = dst + (gsize) c * out->h * out->w;
+
+    for (oy = 0; oy < out->h; oy++) {
+      for (ox = 0; ox < out->w; ox++) {
+        gfloat acc = l->bias ? l->bias[c] : 0.0f;
+
+        for (ky = 0; ky < l->kernel_h; ky++) {
+          gint iy = (gint) (oy * l->stride_h + ky) - (gint) l->pad_top;
+
+          if (iy < 0 || iy >= (gint) in->h)
+            continue;
+          for (kx = 0; kx < l->kernel_w; kx++) {
+            gint ix = (gint) (ox * l->stride_w + kx) - (gint) l->pad_left;
+
+            if (ix >= 0 && ix < (gint) in->w)
+              acc += w[ky * l->kernel_w + kx] * plane[iy * in->w + ix];
+          }
+        }
+        oplane[oy * out->w + ox] = acc;
+      }
+    }
+  }
+}
+
+static void
+run_conv (const CpuLayer *l, const CpuTensor *in, const gfloat *src,
+    const CpuTensor *out, gfloat *dst, gfloat *col)
+{
+  guint in_group = in->c / l->groups;
+  guint out_group = l->out_channels / l->groups;
+  guint k = in_group * l->kernel_h * l->kernel_w;
+  gsize n = (gsize) out->h * out->w;
+  guint g;
+
+  if (is_depthwise (l, in)) {
+    run_depthwise (l, in, src, out, dst);
+    return;
+  }
+
+  for (g = 0; g < l->groups; g++) {
+    const gfloat *group_src = src + (gsize) g * in_group * in->h * in->w;
+
+    if (!is_pointwise (l)) {
+      im2col (l, in, group_src, in_group, out, col);
+      group_src = col;
+    }
+    gemm (l->weights + (gsize) g * out_group * k, group_src,
+        l->bias ? l->bias + g * out_group : NULL, out_group, k, n,
+        dst + g * out_group * n);
+  }
+}
+
+static void
+run_pool (const CpuLayer *l, const CpuTensor *in, const gfloat *src,
+    const CpuTensor *out, gfloat *dst)
+{
+  gsize plane_size = (gsize) in->h * in->w;
+  guint c, oy, ox, ky, kx;
+
+  for (c = 0; c < in->c; c++) {
+    const gfloat *plane = src + c * plane_size;
+    gfloat *oplane = dst + (gsize) c * out->h * out->w;
+
+    if (l->type == NVDS_CPU_LAYER_AVG_POOL && !l->kernel_h && !l->kernel_w) {
+      gfloat acc = 0.0f;
+      gsize i;
+
+      for (i = 0; i < plane_size; i++)
+        acc += plane[i];
+      oplane[0] = acc / plane_size;
+      continue;
+    }
+
+    for (oy = 0; oy < out->h; oy++) {
+      for (ox = 0; ox < out->w; ox++) {
+        gfloat acc = l->type == NVDS_CPU_LAYER_MAX_POOL ? -G_MAXFLOAT : 0.0f;
+        guint count = 0;
+
+        for (ky = 0; ky < l->kernel_h; ky++) {
+          gint iy = (gint) (oy * l->stride_h + ky) - (gint) l->pad_top;
+
+          if (iy < 0 || iy >= (gint) in->h)
+            continue;
+          for (kx = 0; kx < l->kernel_w; kx++) {
+            gint ix = (gint) (ox * l->stride_w + kx) - (gint) l->pad_left;
+            gfloat v;
+
+            if (ix < 0 || ix >= (gint) in->w)
+              continue;
+            v = plane[iy * in->w + ix];
+            if (l->type == NVDS_CPU_LAYER_MAX_POOL)
+              acc = MAX (acc, v);
+            else
+              acc += v;
+            count++;
+          }
+        }
+        if (l->type == NVDS_CPU_LAYER_AVG_POOL)
+          acc = count ? acc / count : 0.0f;
+        oplane[oy * out->w + ox] = acc;
+      }
+    }
+  }
+}
+
+static void
+run_elementwise (const CpuLayer *l, const CpuTensor *in, const gfloat *a,
+    const CpuTensor *in1, const gfloat *b, gfloat *dst)
+{
+  gsize plane_size = (gsize) in->h * in->w;
+  gboolean broadcast = in1->h * in1->w != plane_size;
+  guint c;
+  gsize i;
+
+  for (c = 0; c < in->c; c++) {
+    const gfloat *pa = a + c * plane_size;
+    const gfloat *pb = broadcast ? b + c : b + c * plane_size;
+    gfloat *pd = dst + c * plane_size;
+
+    if (l->type == NVDS_CPU_LAYER_ADD) {
+      for (i = 0; i < plane_size; i++)
+        pd[i] = pa[i] + pb[broadcast ? 0 : i];
+    } else {
+      for (i = 0; i < plane_size; i++)
+        pd[i] = pa[i] * pb[broadcast ? 0 : i];
+    }
+  }
+}
+
+static void
+run_softmax (const gfloat *src, gsize n, gfloat *dst)
+{
+  gfloat max = -G_MAXFLOAT;
+  gfloat sum = 0.0f;
+  gsize i;
+
+  for (i = 0; i < n; i++)
+    max = MAX (max, src[i]);
+  for (i = 0; i < n; i++) {
+    dst[i] = expf (src[i] - max);
+    sum += dst[i];
+  }
+  for (i = 0; i < n; i++)
+    dst[i] /= sum;
+}
+
+static void
+compute_layer (const CpuLayer *l, const CpuTensor *in, const gfloat *src,
+    const CpuTensor *in1, const gfloat *src1, const CpuTensor *out,
+    gfloat *dst, gfloat *col)
+{
+  switch (l->type) {
+    case NVDS_CPU_LAYER_CONV:
+      run_conv (l, in, src, out, dst, col);
+      break;
+    case NVDS_CPU_LAYER_MAX_POOL:
+    case NVDS_CPU_LAYER_AVG_POOL:
+      run_pool (l, in, src, out, dst);
+      break;
+    case NVDS_CPU_LAYER_ADD:
+    case NVDS_CPU_LAYER_MUL:
+      run_elementwise (l, in, src, in1, src1, dst);
+      break;
+    case NVDS_CPU_LAYER_ACTIVATION:
+      memcpy (dst, src, tensor_size (out) * sizeof (gfloat));
+      break;
+    case NVDS_CPU_LAYER_SOFTMAX:
+      run_softmax (src, tensor_size (out), dst);
+      break;
+  }
+  apply_activation (l->activation, dst, tensor_size (out));
+}
+
+static void
+run_layer (const NvDsCpuNet *net, NvDsCpuNetWorkspace *ws,
+    const CpuLayer *l, guint item)
+{
+  gboolean binary = l->input[1] != NVDS_CPU_NET_NO_TENSOR;
+
+  compute_layer (l, &net->tensors[l->input[0]],
+      tensor_data (net, ws, l->input[0], item),
+      binary ? &net->tensors[l->input[1]] : NULL,
+      binary ? tensor_data (net, ws, l->input[1], item) : NULL,
+      &net->tensors[l->output], tensor_data (net, ws, l->output, item),
+      ws->col);
+}
+
+void
+nvds_cpu_net_run (const NvDsCpuNet *net, NvDsCpuNetWorkspace *ws,
+    const gfloat *input, guint batch_size, gfloat *output)
+{
+  gsize input_size = tensor_size (&net->tensors[0]);
+  gsize output_size = tensor_size (&net->tensors[net->output_tensor]);
+  guint i, b;
+
+  g_return_if_fail (batch_size <= ws->max_batch_size);
+
+  for (b = 0; b < batch_size; b++) {
+    memcpy (tensor_data (net, ws, 0, b), input + b * input_size,
+        input_size * sizeof (gfloat));
+  }
+  for (i = 0; i < net->num_layers; i++) {
+    for (b = 0; b < batch_size; b++)
+      run_layer (net, ws, &net->layers[i], b);
+  }
+  for (b = 0; b < batch_size; b++) {
+    memcpy (output + b * output_size,
+        tensor_data (net, ws, net->output_tensor, b),
+        output_size * sizeof (gfloat));
+  }
+}
+
+static guint
+time_length (const NvDsCpuNet *net, const CpuTensor *t)
+{
+  return net->stream_time_on_width ? t->w : t->h;
+}
+
+static void
+set_time_length (const NvDsCpuNet *net, CpuTensor *t, guint length)
+{
+  if (net->stream_time_on_width)
+    t->w = length;
+  else
+    t->h = length;
+}
+
+/** Kernel, stride and padding of @p l along the time axis. */
+static void
+get_time_window (const NvDsCpuNet *net, const CpuLayer *l, guint *kernel,
+    guint *stride, guint *pad0, guint *pad1)
+{
+  if (l->type != NVDS_CPU_LAYER_CONV && l->type != NVDS_CPU_LAYER_MAX_POOL &&
+      l->type != NVDS_CPU_LAYER_AVG_POOL) {
+    *kernel = *stride = 1;
+    *pad0 = *pad1 = 0;
+  } else if (net->stream_time_on_width) {
+    *kernel = l->kernel_w;
+    *stride = l->stride_w;
+    *pad0 = l->pad_left;
+    *pad1 = l->pad_right;
+  } else {
+    *kernel = l->kernel_h;
+    *stride = l->stride_h;
+    *pad0 = l->pad_top;
+    *pad1 = l->pad_bottom;
+  }
+}
+
+static void
+set_time_padding (const NvDsCpuNet *net, CpuLayer *l, guint pad0, guint pad1)
+{
+  if (net->stream_time_on_width) {
+    l->pad_left = pad0;
+    l->pad_right = pad1;
+  } else {
+    l->pad_top = pad0;
+    l->pad_bottom = pad1;
+  }
+}
+
+/**
+ * Copy @p n time steps of every channel from step @p from of @p src to step
+ * @p to of @p dst. Both have the channels and the other dimension of @p t
+ * and a time axis of @p src_len and @p dst_len steps.
+ */
+static void
+copy_time_steps (const NvDsCpuNet *net, const CpuTensor *t, const gfloat *src,
+    guint src_len, guint from, gfloat *dst, guint dst_len, guint to, guint n)
+{
+  /* Time on the width: one run per row. On the height: one per channel. */
+  guint blocks = net->stream_time_on_width ? t->c * t->h : t->c;
+  guint unit = net->stream_time_on_width ? 1 : t->w;
+  guint i;
+
+  for (i = 0; i < blocks; i++) {
+    memcpy (dst + ((gsize) i * dst_len + to) * unit,
+        src + ((gsize) i * src_len + from) * unit,
+        (gsize) n * unit * sizeof (gfloat));
+  }
+}
+
+static gboolean
+time_steps_equal (const NvDsCpuNet *net, const CpuTensor *t, const gfloat *a,
+    guint from_a, const gfloat *b, guint from_b, guint n)
+{
+  guint blocks = net->stream_time_on_width ? t->c * t->h : t->c;
+  guint unit = net->stream_time_on_width ? 1 : t->w;
+  guint len = time_length (net, t);
+  guint i;
+
+  for (i = 0; i < blocks; i++) {
+    if (memcmp (a + ((gsize) i * len + from_a) * unit,
+            b + ((gsize) i * len + from_b) * unit,
+            (gsize) n * unit * sizeof (gfloat)))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean
+is_streamable (const NvDsCpuNet *net, const CpuLayer *l,
+    const gboolean *streamed)
+{
+  const CpuTensor *in = &net->tensors[l->input[0]];
+  const CpuTensor *in1;
+
+  if (!streamed[l->input[0]])
+    return FALSE;
+  switch (l->type) {
+    case NVDS_CPU_LAYER_CONV:
+    case NVDS_CPU_LAYER_MAX_POOL:
+    case NVDS_CPU_LAYER_ACTIVATION:
+      return TRUE;
+    case NVDS_CPU_LAYER_AVG_POOL:
+      return l->kernel_h || l->kernel_w;
+    case NVDS_CPU_LAYER_ADD:
+    case NVDS_CPU_LAYER_MUL:
+      in1 = &net->tensors[l->input[1]];
+      return streamed[l->input[1]] && in1->h == in->h && in1->w == in->w &&
+          net->stream_step[l->input[1]] == net->stream_step[l->input[0]];
+    default:
+      return FALSE;
+  }
+}
+
+guint
+nvds_cpu_net_enable_streaming (NvDsCpuNet *net, gboolean time_on_width,
+    guint max_layers)
+{
+  gboolean *streamed = g_new0 (gboolean, net->num_tensors);
+  guint i;
+
+  net->stream_time_on_width = time_on_width;
+  net->stream_layers = 0;
+  net->stream_scratch = 0;
+  g_free (net->stream_lo);
+  g_free (net->stream_hi);
+  g_free (net->stream_step);
+  net->stream_lo = g_new0 (guint, net->num_tensors);
+  net->stream_hi = g_new0 (guint, net->num_tensors);
+  net->stream_step = g_new0 (guint, net->num_tensors);
+
+  streamed[0] = TRUE;
+  net->stream_hi[0] = time_length (net, &net->tensors[0]);
+  net->stream_step[0] = 1;
+
+  for (i = 0; i < net->num_layers && i < max_layers; i++) {
+    const CpuLayer *l = &net->layers[i];
+    const CpuTensor *out = &net->tensors[l->output];
+    guint lo, hi, kernel, stride, pad0, pad1;
+
+    if (!is_streamable (net, l, streamed))
+      break;
+    lo = net->stream_lo[l->input[0]];
+    hi = net->stream_hi[l->input[0]];
+    if (l->input[1] != NVDS_CPU_NET_NO_TENSOR) {
+      lo = MAX (lo, net->stream_lo[l->input[1]]);
+      hi = MIN (hi, net->stream_hi[l->input[1]]);
+    }
+    /* Outputs whose window lies in [lo, hi) of the input. */
+    get_time_window (net, l, &kernel, &stride, &pad0, &pad1);
+    lo = (lo + pad0 + stride - 1) / stride;
+    hi = hi + pad0 >= kernel ? (hi + pad0 - kernel) / stride + 1 : 0;
+    hi = MIN (hi, time_length (net, out));
+    /* Nothing to reuse here or in any later layer. */
+    if (lo >= hi)
+      break;
+
+    net->stream_lo[l->output] = lo;
+    net->stream_hi[l->output] = hi;
+    net->stream_step[l->output] = net->stream_step[l->input[0]] * stride;
+    streamed[l->output] = TRUE;
+    net->stream_scratch = MAX (net->stream_scratch,
+        MAX (tensor_size (&net->tensors[l->input[0]]), tensor_size (out)));
+    net->stream_layers = i + 1;
+  }
+
+  g_free (streamed);
+  return net->stream_layers;
+}
+
+gsize
+nvds_cpu_net_get_stream_size (const NvDsCpuNet *net)
+{
+  gsize size = tensor_size (&net->tensors[0]);
+  guint i;
+
+  for (i = 0; i < net->stream_layers; i++)
+    size += tensor_size (&net->tensors[net->layers[i].output]);
+  return size * sizeof (gfloat);
+}
+
+NvDsCpuNetStream *
+nvds_cpu_net_stream_new (const NvDsCpuNet *net)
+{
+  NvDsCpuNetStream *stream = g_new0 (NvDsCpuNetStream, 1);
+  guint i;
+
+  stream->num_tensors = net->num_tensors;
+  stream->tensors = g_new0 (gfloat *, net->num_tensors);
+  stream->tensors[0] = g_new (gfloat, tensor_size (&net->tensors[0]));
+  for (i = 0; i < net->stream_layers; i++) {
+    guint t = net->layers[i].output;
+
+    stream->tensors[t] = g_new (gfloat, tensor_size (&net->tensors[t]));
+  }
+  return stream;
+}
+
+void
+nvds_cpu_net_stream_free (NvDsCpuNetStream *stream)
+{
+  guint i;
+
+  if (!stream)
+    return;
+  for (i = 0; i < stream->num_tensors; i++)
+    g_free (stream->tensors[i]);
+  g_free (stream->tensors);
+  g_free (stream);
+}
+
+const NvDsCpuNetStreamStats *
+nvds_cpu_net_stream_get_stats (const NvDsCpuNetStream *stream)
+{
+  return &stream->stats;
+}
+
+/**
+ * Input steps the window at @p position starts after the cached window of
+ * @p stream, 0 if nothing can be reused. The window then becomes the cached
+ * one.
+ */
+static guint
+stream_shift (const NvDsCpuNet *net, NvDsCpuNetStream *stream,
+    guint64 position, const gfloat *input)
+{
+  const CpuTensor *t = &net->tensors[0];
+  guint len = time_length (net, t);
+  guint shift = 0;
+
+  if (stream->cached && position > stream->position &&
+      position - stream->position < len) {
+    shift = position - stream->position;
+    if (!time_steps_equal (net, t, input, 0, stream->tensors[0], shift,
+            len - shift))
+      shift = 0;
+  }
+  memcpy (stream->tensors[0], input, tensor_size (t) * sizeof (gfloat));
+  stream->cached = TRUE;
+  stream->position = position;
+  stream->stats.windows++;
+  if (shift)
+    stream->stats.reused++;
+  return shift;
+}
+
+/**
+ * Compute time steps [t0, t1) of the output of @p l: the input steps they
+ * read are copied to a slice, which runs through the layer with the padding
+ * of its position.
+ */
+static void
+run_layer_steps (const NvDsCpuNet *net, NvDsCpuNetWorkspace *ws,
+    const CpuLayer *l, guint item, guint t0, guint t1)
+{
+  const CpuTensor *in = &net->tensors[l->input[0]];
+  const CpuTensor *out = &net->tensors[l->output];
+  CpuTensor in_slice = *in, out_slice = *out;
+  CpuLayer slice_layer = *l;
+  guint in_len = time_length (net, in);
+  guint kernel, stride, pad0, pad1, from, to;
+  gint first, last;
+
+  if (t0 >= t1)
+    return;
+
+  get_time_window (net, l, &kernel, &stride, &pad0, &pad1);
+  first = (gint) (t0 * stride) - (gint) pad0;
+  last = (gint) ((t1 - 1) * stride + kernel) - (gint) pad0;
+  from = MAX (first, 0);
+  to = MIN (last, (gint) in_len);
+  set_time_length (net, &in_slice, to - from);
+  set_time_length (net, &out_slice, t1 - t0);
+  set_time_padding (net, &slice_layer, from - first, last - to);
+
+  copy_time_steps (net, in, tensor_data (net, ws, l->input[0], item), in_len,
+      from, ws->slices[0], to - from, 0, to - from);
+  if (l->input[1] != NVDS_CPU_NET_NO_TENSOR) {
+    copy_time_steps (net, in, tensor_data (net, ws, l->input[1], item),
+        in_len, from, ws->slices[1], to - from, 0, to - from);
+  }
+  compute_layer (&slice_layer, &in_slice, ws->slices[0], &in_slice,
+      ws->slices[1], &out_slice, ws->slices[2], ws->col);
+  copy_time_steps (net, out, ws->slices[2], t1 - t0, 0,
+      tensor_data (net, ws, l->output, item), time_length (net, out), t0,
+      t1 - t0);
+}
+
+/**
+ * Run streamed layer @p l: the steps kept from the cached window are copied
+ * @p shift input steps earlier, the others are computed.
+ */
+static void
+run_stream_layer (const NvDsCpuNet *net, NvDsCpuNetWorkspace *ws,
+    NvDsCpuNetStream *stream, guint shift, const CpuLayer *l, guint item)
+{
+  const CpuTensor *out = &net->tensors[l->output];
+  gfloat *dst = tensor_data (net, ws, l->output, item);
+  gfloat *cache = stream->tensors[l->output];
+  guint len = time_length (net, out);
+  guint step = net->stream_step[l->output];
+  guint lo = net->stream_lo[l->output];
+  guint hi = net->stream_hi[l->output];
+  guint kept = shift / step;
+
+  if (!shift || shift % step || hi <= lo + kept) {
+    run_layer (net, ws, l, item);
+    stream->stats.steps_computed += len;
+  } else {
+    copy_time_steps (net, out, cache, len, lo + kept, dst, len, lo,
+        hi - kept - lo);
+    run_layer_steps (net, ws, l, item, 0, lo);
+    run_layer_steps (net, ws, l, item, hi - kept, len);
+    stream->stats.steps_computed += len - (hi - kept - lo);
+  }
+  stream->stats.steps += len;
+  memcpy (cache, dst, tensor_size (out) * sizeof (gfloat));
+}
+
+void
+nvds_cpu_net_run_streams (const NvDsCpuNet *net, NvDsCpuNetWorkspace *ws,
+    NvDsCpuNetStream **streams, const guint64 *positions, const gfloat *input,
+    guint batch_size, gfloat *output)
+{
+  gsize input_size = tensor_size (&net->tensors[0]);
+  gsize output_size = tensor_size (&net->tensors[net->output_tensor]);
+  guint *shifts;
+  guint i, b;
+
+  g_return_if_fail (batch_size <= ws->max_batch_size);
+
+  shifts = g_new (guint, MAX (batch_size, 1));
+  for (b = 0; b < batch_size; b++) {
+    gfloat *data = tensor_data (net, ws, 0, b);
+
+    memcpy (data, input + b * input_size, input_size * sizeof (gfloat));
+    shifts[b] = stream_shift (net, streams[b], positions[b], data);
+  }
+  /* A later window of the same stream in the batch sees the activations of
+   * the earlier one, cached when the layer ran on it. */
+  for (i = 0; i < net->num_layers; i++) {
+    for (b = 0; b < batch_size; b++) {
+      if (i < net->stream_layers)
+        run_stream_layer (net, ws, streams[b], shifts[b], &net->layers[i], b);
+      else
+        run_layer (net, ws, &net->layers[i], b);
+    }
+  }
+  for (b = 0; b < batch_size; b++) {
+    memcpy (output + b * output_size,
+        tensor_data (net, ws, net->output_tensor, b),
+        output_size * sizeof (gfloat));
+  }
+  g_free (shifts);
+}
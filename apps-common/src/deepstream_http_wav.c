@@ -0,0 +1,1197 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <gst/base/gstpushsrc.h>
+
+#include "deepstream_audio_codec.h"
+#include "deepstream_common.h"
+#include "deepstream_config.h"
+#include "deepstream_http_wav.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_ds_http_wav_src_debug);
+#define GST_CAT_DEFAULT gst_ds_http_wav_src_debug
+
+/** Longest status, header or chunk size line. */
+#define HTTP_WAV_MAX_LINE 8192
+/** Receive buffer of headers, chunk framing and partial reads. */
+#define HTTP_WAV_READ_SIZE 65536
+/** Compressed bytes read from the body per decode. */
+#define HTTP_WAV_DECODE_READ_SIZE 16384
+#define HTTP_WAV_MAX_REDIRECTS 4
+/** Probe a silent connection after 2 s, every second, 3 times, so that a
+ *  microphone that lost power is noticed without waiting for the timeout. */
+#define HTTP_WAV_KEEPALIVE_IDLE 2
+#define HTTP_WAV_KEEPALIVE_INTERVAL 1
+#define HTTP_WAV_KEEPALIVE_COUNT 3
+
+#define DEFAULT_LOCATION NULL
+#define DEFAULT_TIMEOUT 5000
+#define DEFAULT_RETRY_DELAY 500
+#define DEFAULT_BLOCK_DURATION 20
+
+#define HTTP_WAV_SRC_CAPS \
+  "audio/x-raw, format = (string) { S16LE, S32LE, F32LE }, " \
+  "layout = (string) interleaved, rate = (int) [ 1, MAX ], " \
+  "channels = (int) [ 1, MAX ]"
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_TIMEOUT,
+  PROP_RETRY_DELAY,
+  PROP_BLOCK_DURATION,
+  PROP_CONNECTS,
+};
+
+typedef enum
+{
+  HTTP_WAV_OK,
+  /** Connection failed or lost; try again after the retry delay. */
+  HTTP_WAV_RETRY,
+  /** The stream can't be handled; retrying won't help. */
+  HTTP_WAV_FATAL,
+  HTTP_WAV_FLUSHING,
+} HttpWavResult;
+
+typedef struct
+{
+  GstPushSrc parent;
+
+  /* Properties. */
+  gchar *location;
+  guint timeout;
+  guint retry_delay;
+  guint block_duration;
+
+  /** Target of the last redirect, resolved once and kept for reconnects. */
+  gchar *host;
+  gchar *port;
+  gchar *path;
+  struct addrinfo *addrs;
+
+  gint fd;
+  GstPoll *poll;
+  GstPollFD pollfd;
+  gint flushing;
+  guint8 *rbuf;
+  gsize rpos;
+  gsize rlen;
+
+  /* Body of the current response. */
+  gboolean chunked;
+  guint64 chunk_left;
+  gboolean chunk_crlf;
+  /** Bytes left of a body of known length, G_MAXUINT64 if unknown. */
+  guint64 body_left;
+  /** Bytes left of the WAV data chunk, or of the body of a FLAC or Ogg
+   *  stream, G_MAXUINT64 if unbounded. */
+  guint64 data_left;
+
+  /** Decoder of a compressed stream, NULL for PCM; new per connection. */
+  NvDsAudioDecoder *decoder;
+  NvDsAudioCodec codec;
+  /** Decoded samples not handed out yet start at decoded_pos. */
+  GByteArray *decoded;
+  gsize decoded_pos;
+  guint8 *cbuf;
+
+  /* Stream format of the current connection. */
+  const gchar *format;
+  guint rate;
+  guint channels;
+  guint bpf;
+  GstCaps *caps;
+
+  /* Buffers are timestamped by sample count from the connect. */
+  GstClockTime base_pts;
+  guint64 samples;
+  gboolean discont;
+  /** Set once a failure was posted, cleared by the next connect. */
+  gboolean failing;
+  gint64 failed_since;
+  guint connects;
+} GstDsHttpWavSrc;
+
+typedef struct
+{
+  GstPushSrcClass parent_class;
+} GstDsHttpWavSrcClass;
+
+#define GST_DS_HTTP_WAV_SRC(obj) ((GstDsHttpWavSrc *) (obj))
+
+G_DEFINE_TYPE (GstDsHttpWavSrc, gst_ds_http_wav_src, GST_TYPE_PUSH_SRC);
+
+static GstStaticPadTemplate src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (HTTP_WAV_SRC_CAPS));
+
+/** Split "http://host[:port][/path]"; FALSE if it is not such a URI. */
+static gboolean
+parse_http_uri (const gchar * uri, gchar ** host, gchar ** port,
+    gchar ** path)
+{
+  const gchar *start, *end, *colon;
+
+  if (!uri || g_ascii_strncasecmp (uri, "http://", 7))
+    return FALSE;
+  start = uri + 7;
+  end = start + strcspn (start, "/?#");
+  if (end == start)
+    return FALSE;
+  colon = memchr (start, ':', end - start);
+  *host = g_strndup (start, (colon ? colon : end) - start);
+  *port = colon && colon + 1 < end ? g_strndup (colon + 1, end - colon - 1) :
+      g_strdup ("80");
+  *path = *end == '/' ? g_strdup (end) : g_strdup_printf ("/%s", end);
+  return TRUE;
+}
+
+/** Connect to "location" again, e.g. after a redirect target failed. */
+static gboolean
+reset_target (GstDsHttpWavSrc * self)
+{
+  g_clear_pointer (&self->host, g_free);
+  g_clear_pointer (&self->port, g_free);
+  g_clear_pointer (&self->path, g_free);
+  if (self->addrs)
+    freeaddrinfo (self->addrs);
+  self->addrs = NULL;
+  return parse_http_uri (self->location, &self->host, &self->port,
+      &self->path);
+}
+
+static void
+close_connection (GstDsHttpWavSrc * self)
+{
+  if (self->fd < 0)
+    return;
+  gst_poll_remove_fd (self->poll, &self->pollfd);
+  close (self->fd);
+  self->fd = -1;
+  self->rpos = self->rlen = 0;
+}
+
+/**
+ * Wait until the socket is readable or writable or, without a socket, for
+ * @p timeout_ms. Returns HTTP_WAV_OK when ready, HTTP_WAV_RETRY on timeout.
+ */
+static HttpWavResult
+wait_socket (GstDsHttpWavSrc * self, gboolean write, guint timeout_ms)
+{
+  gint n;
+
+  if (self->fd >= 0) {
+    gst_poll_fd_ctl_read (self->poll, &self->pollfd, !write);
+    gst_poll_fd_ctl_write (self->poll, &self->pollfd, write);
+  }
+  do {
+    n = gst_poll_wait (self->poll, timeout_ms * GST_MSECOND);
+  } while (n < 0 && (errno == EINTR || errno == EAGAIN));
+
+  if (g_atomic_int_get (&self->flushing) || (n < 0 && errno == EBUSY))
+    return HTTP_WAV_FLUSHING;
+  return n > 0 ? HTTP_WAV_OK : HTTP_WAV_RETRY;
+}
+
+/** Receive up to @p size bytes; 0 if the peer closed, -1 on error. */
+static gssize
+recv_some (GstDsHttpWavSrc * self, guint8 * dst, gsize size,
+    HttpWavResult * result)
+{
+  while (TRUE) {
+    gssize n = recv (self->fd, dst, size, MSG_DONTWAIT);
+
+    if (n >= 0) {
+      *result = n ? HTTP_WAV_OK : HTTP_WAV_RETRY;
+      if (!n)
+        GST_DEBUG_OBJECT (self, "connection closed by %s", self->host);
+      return n;
+    }
+    if (errno == EINTR)
+      continue;
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      GST_DEBUG_OBJECT (self, "recv: %s", strerror (errno));
+      *result = HTTP_WAV_RETRY;
+      return -1;
+    }
+    *result = wait_socket (self, FALSE, self->timeout);
+    if (*result != HTTP_WAV_OK) {
+      if (*result == HTTP_WAV_RETRY)
+        GST_DEBUG_OBJECT (self, "no data for %u ms", self->timeout);
+      return -1;
+    }
+  }
+}
+
+/** Receive more bytes into the receive buffer. */
+static HttpWavResult
+fill_rbuf (GstDsHttpWavSrc * self)
+{
+  HttpWavResult result;
+  gssize n;
+
+  if (self->rpos == self->rlen) {
+    self->rpos = self->rlen = 0;
+  } else if (self->rpos) {
+    memmove (self->rbuf, self->rbuf + self->rpos, self->rlen - self->rpos);
+    self->rlen -= self->rpos;
+    self->rpos = 0;
+  }
+  n = recv_some (self, self->rbuf + self->rlen,
+      HTTP_WAV_READ_SIZE - self->rlen, &result);
+  if (n > 0)
+    self->rlen += n;
+  return result;
+}
+
+/** Next line of the response without its CRLF. */
+static HttpWavResult
+read_line (GstDsHttpWavSrc * self, gchar ** line)
+{
+  HttpWavResult result;
+  guint8 *newline;
+
+  while (!(newline = memchr (self->rbuf + self->rpos, '\n',
+              self->rlen - self->rpos))) {
+    if (self->rlen - self->rpos >= HTTP_WAV_MAX_LINE) {
+      GST_DEBUG_OBJECT (self, "response line too long");
+      return HTTP_WAV_RETRY;
+    }
+    if ((result = fill_rbuf (self)) != HTTP_WAV_OK)
+      return result;
+  }
+  *line = g_strndup ((gchar *) self->rbuf + self->rpos,
+      newline - (self->rbuf + self->rpos));
+  g_strchomp (*line);
+  self->rpos = newline - self->rbuf + 1;
+  return HTTP_WAV_OK;
+}
+
+/**
+ * Read up to @p size bytes of the response body, straight from the socket
+ * once the receive buffer is drained. Sets @p size to 0 at the end of the
+ * body.
+ */
+static HttpWavResult
+read_body (GstDsHttpWavSrc * self, guint8 * dst, gsize * size)
+{
+  HttpWavResult result;
+  guint64 limit = MIN (*size, self->body_left);
+  gssize n;
+
+  if (self->chunked) {
+    while (!self->chunk_left) {
+      gchar *line = NULL;
+
+      if (self->chunk_crlf) {
+        if ((result = read_line (self, &line)) != HTTP_WAV_OK)
+          return result;
+        g_free (line);
+        self->chunk_crlf = FALSE;
+      }
+      if ((result = read_line (self, &line)) != HTTP_WAV_OK)
+        return result;
+      self->chunk_left = g_ascii_strtoull (line, NULL, 16);
+      g_free (line);
+      if (!self->chunk_left) {
+        *size = 0;
+        return HTTP_WAV_OK;
+      }
+      self->chunk_crlf = TRUE;
+    }
+    limit = MIN (limit, self->chunk_left);
+  }
+  if (!limit) {
+    *size = 0;
+    return HTTP_WAV_OK;
+  }
+
+  if (self->rpos < self->rlen) {
+    n = MIN (limit, self->rlen - self->rpos);
+    memcpy (dst, self->rbuf + self->rpos, n);
+    self->rpos += n;
+  } else if ((n = recv_some (self, dst, limit, &result)) <= 0) {
+    return result;
+  }
+
+  if (self->chunked)
+    self->chunk_left -= n;
+  if (self->body_left != G_MAXUINT64)
+    self->body_left -= n;
+  *size = n;
+  return HTTP_WAV_OK;
+}
+
+/** Read exactly @p size bytes of the body; @p dst NULL skips them. */
+static HttpWavResult
+read_body_full (GstDsHttpWavSrc * self, guint8 * dst, gsize size)
+{
+  guint8 scratch[256];
+
+  while (size) {
+    gsize n = dst ? size : MIN (size, sizeof (scratch));
+    HttpWavResult result = read_body (self, dst ? dst : scratch, &n);
+
+    if (result != HTTP_WAV_OK)
+      return result;
+    if (!n) {
+      GST_DEBUG_OBJECT (self, "body ended inside the WAV header");
+      return HTTP_WAV_RETRY;
+    }
+    if (dst)
+      dst += n;
+    size -= n;
+  }
+  return HTTP_WAV_OK;
+}
+
+static void
+set_keepalive (gint fd)
+{
+  gint on = 1;
+
+  setsockopt (fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof (on));
+#ifdef TCP_KEEPIDLE
+  {
+    gint idle = HTTP_WAV_KEEPALIVE_IDLE;
+    gint interval = HTTP_WAV_KEEPALIVE_INTERVAL;
+    gint count = HTTP_WAV_KEEPALIVE_COUNT;
+
+    setsockopt (fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof (idle));
+    setsockopt (fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof (interval));
+    setsockopt (fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof (count));
+  }
+#endif
+}
+
+/** Connect to the first reachable address of the current host. */
+static HttpWavResult
+open_socket (GstDsHttpWavSrc * self)
+{
+  struct addrinfo hints, *ai;
+  HttpWavResult result = HTTP_WAV_RETRY;
+  gint err;
+
+  if (!self->addrs) {
+    memset (&hints, 0, sizeof (hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    err = getaddrinfo (self->host, self->port, &hints, &self->addrs);
+    if (err) {
+      GST_DEBUG_OBJECT (self, "Error resolving '%s': %s", self->host,
+          gai_strerror (err));
+      self->addrs = NULL;
+      return HTTP_WAV_RETRY;
+    }
+  }
+
+  for (ai = self->addrs; ai; ai = ai->ai_next) {
+    socklen_t len = sizeof (err);
+
+    self->fd = socket (ai->ai_family,
+        ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+    if (self->fd < 0)
+      continue;
+    gst_poll_fd_init (&self->pollfd);
+    self->pollfd.fd = self->fd;
+    gst_poll_add_fd (self->poll, &self->pollfd);
+
+    if (connect (self->fd, ai->ai_addr, ai->ai_addrlen) < 0 &&
+        errno != EINPROGRESS) {
+      err = errno;
+    } else if ((result = wait_socket (self, TRUE, self->timeout)) ==
+        HTTP_WAV_FLUSHING) {
+      close_connection (self);
+      return result;
+    } else if (result != HTTP_WAV_OK) {
+      err = ETIMEDOUT;
+    } else if (getsockopt (self->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+      err = errno;
+    }
+    if (!err) {
+      set_keepalive (self->fd);
+      return HTTP_WAV_OK;
+    }
+    GST_DEBUG_OBJECT (self, "connect to %s:%s: %s", self->host, self->port,
+        strerror (err));
+    close_connection (self);
+    result = HTTP_WAV_RETRY;
+  }
+  return result;
+}
+
+static HttpWavResult
+send_request (GstDsHttpWavSrc * self)
+{
+  gchar *request = g_strdup_printf ("GET %s HTTP/1.1\r\n"
+      "Host: %s:%s\r\n"
+      "User-Agent: BirdEdge\r\n"
+      "Accept: audio/wav, audio/x-wav, audio/flac, audio/ogg, */*\r\n"
+      "Connection: keep-alive\r\n\r\n", self->path, self->host, self->port);
+  gsize len = strlen (request), sent = 0;
+  HttpWavResult result = HTTP_WAV_OK;
+
+  while (sent < len && result == HTTP_WAV_OK) {
+    gssize n = send (self->fd, request + sent, len - sent,
+        MSG_DONTWAIT | MSG_NOSIGNAL);
+
+    if (n > 0)
+      sent += n;
+    else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      result = wait_socket (self, TRUE, self->timeout);
+    else if (n < 0 && errno != EINTR)
+      result = HTTP_WAV_RETRY;
+  }
+  g_free (request);
+  return result;
+}
+
+/**
+ * Read the status line and headers. A redirect replaces host, port and
+ * path and returns HTTP_WAV_RETRY with @p redirected set.
+ */
+static HttpWavResult
+read_response_headers (GstDsHttpWavSrc * self, gboolean * redirected)
+{
+  HttpWavResult result;
+  gchar *line = NULL;
+  gchar *location = NULL;
+  guint status = 0;
+
+  *redirected = FALSE;
+  if ((result = read_line (self, &line)) != HTTP_WAV_OK)
+    return result;
+  if (g_ascii_strncasecmp (line, "HTTP/1.", 7) || strlen (line) < 12) {
+    GST_DEBUG_OBJECT (self, "invalid status line '%s'", line);
+    g_free (line);
+    return HTTP_WAV_RETRY;
+  }
+  status = g_ascii_strtoull (line + 9, NULL, 10);
+  g_free (line);
+
+  self->chunked = FALSE;
+  self->chunk_left = 0;
+  self->chunk_crlf = FALSE;
+  self->body_left = G_MAXUINT64;
+  while ((result = read_line (self, &line)) == HTTP_WAV_OK && *line) {
+    gchar *value = strchr (line, ':');
+
+    if (value) {
+      *value++ = '\0';
+      value = g_strstrip (value);
+      if (!g_ascii_strcasecmp (line, "Transfer-Encoding"))
+        self->chunked = !g_ascii_strcasecmp (value, "chunked");
+      else if (!g_ascii_strcasecmp (line, "Content-Length"))
+        self->body_left = g_ascii_strtoull (value, NULL, 10);
+      else if (!g_ascii_strcasecmp (line, "Location")) {
+        g_free (location);
+        location = g_strdup (value);
+      }
+    }
+    g_free (line);
+  }
+  g_free (line);
+  if (result != HTTP_WAV_OK)
+    goto done;
+  if (self->chunked)
+    self->body_left = G_MAXUINT64;
+
+  if (status >= 300 && status < 400 && location) {
+    gchar *host, *port, *path;
+
+    if (!parse_http_uri (location, &host, &port, &path)) {
+      GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND, (NULL),
+          ("Redirect of %s to unsupported location %s", self->location,
+              location));
+      result = HTTP_WAV_FATAL;
+      goto done;
+    }
+    GST_INFO_OBJECT (self, "redirected to %s", location);
+    g_free (self->host);
+    g_free (self->port);
+    g_free (self->path);
+    self->host = host;
+    self->port = port;
+    self->path = path;
+    if (self->addrs)
+      freeaddrinfo (self->addrs);
+    self->addrs = NULL;
+    *redirected = TRUE;
+    result = HTTP_WAV_RETRY;
+  } else if (status != 200) {
+    GST_DEBUG_OBJECT (self, "HTTP status %u", status);
+    result = HTTP_WAV_RETRY;
+  }
+
+done:
+  g_free (location);
+  return result;
+}
+
+static void
+set_caps (GstDsHttpWavSrc * self, const gchar * format, guint bits)
+{
+  self->format = format;
+  self->bpf = bits / 8 * self->channels;
+  if (self->caps)
+    gst_caps_unref (self->caps);
+  self->caps = gst_caps_new_simple ("audio/x-raw",
+      "format", G_TYPE_STRING, format,
+      "layout", G_TYPE_STRING, "interleaved",
+      "rate", G_TYPE_INT, (gint) self->rate,
+      "channels", G_TYPE_INT, (gint) self->channels, NULL);
+}
+
+/**
+ * Format and caps of a "fmt " chunk; only what nvdsaudioingest takes, and
+ * IMA ADPCM, which is decoded to S16LE.
+ */
+static HttpWavResult
+set_format (GstDsHttpWavSrc * self, guint16 tag, guint16 bits,
+    guint16 block_align)
+{
+  const gchar *format = NULL;
+
+  if (tag == 1 && bits == 16)
+    format = "S16LE";
+  else if (tag == 1 && bits == 32)
+    format = "S32LE";
+  else if (tag == 3 && bits == 32)
+    format = "F32LE";
+  else if (tag == 0x11 && bits == 4 &&
+      (self->decoder = nvds_audio_decoder_new_ima_adpcm (self->rate,
+              self->channels, block_align))) {
+    self->codec = NVDS_AUDIO_CODEC_IMA_ADPCM;
+    format = "S16LE";
+    bits = 16;
+  }
+  if (!format || !self->rate || !self->channels) {
+    GST_ELEMENT_ERROR (self, STREAM, FORMAT, (NULL),
+        ("Unsupported WAV format %u, %u bits, %u Hz, %u channels of %s",
+            tag, bits, self->rate, self->channels, self->location));
+    return HTTP_WAV_FATAL;
+  }
+
+  set_caps (self, format, bits);
+  return HTTP_WAV_OK;
+}
+
+/** Decode received bytes of a compressed stream. */
+static HttpWavResult
+decode_body (GstDsHttpWavSrc * self, const guint8 * data, gsize size)
+{
+  if (!nvds_audio_decoder_decode_pooled (self->decoder, data, size,
+          self->decoded)) {
+    GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+        ("Could not decode the %s stream of %s",
+            nvds_audio_codec_get_name (self->codec), self->location));
+    return HTTP_WAV_FATAL;
+  }
+  return HTTP_WAV_OK;
+}
+
+/**
+ * Decode the start of a FLAC or Ogg Opus stream until its headers gave the
+ * format. The body is decoded up to its end, if its length is known.
+ */
+static HttpWavResult
+read_compressed_header (GstDsHttpWavSrc * self, NvDsAudioCodec codec,
+    const guint8 * magic)
+{
+  HttpWavResult result;
+  const gchar *format;
+
+  self->codec = codec;
+  self->decoder = nvds_audio_decoder_new (codec);
+  self->data_left = self->body_left;
+  if ((result = decode_body (self, magic, 4)) != HTTP_WAV_OK)
+    return result;
+
+  while (!nvds_audio_decoder_get_format (self->decoder, &format, &self->rate,
+          &self->channels)) {
+    gsize n = MIN (HTTP_WAV_DECODE_READ_SIZE, self->data_left);
+
+    if ((result = read_body (self, self->cbuf, &n)) != HTTP_WAV_OK)
+      return result;
+    if (!n) {
+      GST_DEBUG_OBJECT (self, "body ended inside the %s headers",
+          nvds_audio_codec_get_name (codec));
+      return HTTP_WAV_RETRY;
+    }
+    if (self->data_left != G_MAXUINT64)
+      self->data_left -= n;
+    if ((result = decode_body (self, self->cbuf, n)) != HTTP_WAV_OK)
+      return result;
+  }
+  set_caps (self, format, strcmp (format, "S16LE") ? 32 : 16);
+  return HTTP_WAV_OK;
+}
+
+/**
+ * Parse the start of the body: a RIFF header up to the start of the data
+ * chunk, or the headers of a FLAC or Ogg Opus stream, told apart by their
+ * first bytes.
+ */
+static HttpWavResult
+read_stream_header (GstDsHttpWavSrc * self)
+{
+  HttpWavResult result;
+  guint8 header[40];
+  guint32 size;
+  guint16 tag = 0, bits = 0, block_align = 0;
+  gboolean have_fmt = FALSE;
+
+  g_clear_pointer (&self->decoder, nvds_audio_decoder_free);
+  g_byte_array_set_size (self->decoded, 0);
+  self->decoded_pos = 0;
+
+  if ((result = read_body_full (self, header, 4)) != HTTP_WAV_OK)
+    return result;
+  if (!memcmp (header, "fLaC", 4))
+    return read_compressed_header (self, NVDS_AUDIO_CODEC_FLAC, header);
+  if (!memcmp (header, "OggS", 4))
+    return read_compressed_header (self, NVDS_AUDIO_CODEC_OPUS, header);
+
+  if ((result = read_body_full (self, header + 4, 8)) != HTTP_WAV_OK)
+    return result;
+  if (memcmp (header, "RIFF", 4) || memcmp (header + 8, "WAVE", 4)) {
+    GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+        ("%s is not a WAV, FLAC or Ogg Opus stream", self->location));
+    return HTTP_WAV_FATAL;
+  }
+
+  while (TRUE) {
+    if ((result = read_body_full (self, header, 8)) != HTTP_WAV_OK)
+      return result;
+    size = GST_READ_UINT32_LE (header + 4);
+
+    if (!memcmp (header, "data", 4)) {
+      if (!have_fmt) {
+        GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+            ("No format chunk before the data of %s", self->location));
+        return HTTP_WAV_FATAL;
+      }
+      /* Streams of unknown length give 0 or the maximum. */
+      self->data_left = size && size != G_MAXUINT32 ? size : G_MAXUINT64;
+      return set_format (self, tag, bits, block_align);
+    }
+
+    if (!memcmp (header, "fmt ", 4) && size >= 16) {
+      guint n = MIN (size, sizeof (header));
+
+      if ((result = read_body_full (self, header, n)) != HTTP_WAV_OK)
+        return result;
+      tag = GST_READ_UINT16_LE (header);
+      self->channels = GST_READ_UINT16_LE (header + 2);
+      self->rate = GST_READ_UINT32_LE (header + 4);
+      block_align = GST_READ_UINT16_LE (header + 12);
+      bits = GST_READ_UINT16_LE (header + 14);
+      /* WAVE_FORMAT_EXTENSIBLE: the subformat GUID starts with the tag. */
+      if (tag == 0xfffe && n >= 26)
+        tag = GST_READ_UINT16_LE (header + 24);
+      size -= n;
+      have_fmt = TRUE;
+    }
+    /* Padded in 64 bits, a size of 0xffffffff must not wrap to 0. */
+    if ((result = read_body_full (self, NULL,
+                (guint64) size + (size & 1))) != HTTP_WAV_OK)
+      return result;
+  }
+}
+
+
+static GstClockTime
+get_running_time (GstDsHttpWavSrc * self)
+{
+  GstClock *clock = gst_element_get_clock (GST_ELEMENT (self));
+  GstClockTime now, base;
+
+  if (!clock)
+    return 0;
+  now = gst_clock_get_time (clock);
+  base = gst_element_get_base_time (GST_ELEMENT (self));
+  gst_object_unref (clock);
+  return now > base ? now - base : 0;
+}
+
+/**
+ * Open the stream: connect, request it and parse its header, following
+ * redirects. Failed attempts are repeated every retry-delay ms with the
+ * host resolved again, until connected, flushing or a fatal error.
+ */
+static HttpWavResult
+connect_stream (GstDsHttpWavSrc * self)
+{
+  HttpWavResult result;
+  guint redirects = 0;
+
+  while (TRUE) {
+    gboolean redirected = FALSE;
+
+    close_connection (self);
+    result = open_socket (self);
+    if (result == HTTP_WAV_OK)
+      result = send_request (self);
+    if (result == HTTP_WAV_OK)
+      result = read_response_headers (self, &redirected);
+    if (result == HTTP_WAV_OK)
+      result = read_stream_header (self);
+    if (result == HTTP_WAV_OK)
+      break;
+    close_connection (self);
+    if (redirected && ++redirects <= HTTP_WAV_MAX_REDIRECTS)
+      continue;
+    if (result != HTTP_WAV_RETRY)
+      return result;
+
+    if (!self->failing) {
+      GST_ELEMENT_WARNING (self, RESOURCE, OPEN_READ,
+          ("Could not connect to %s, retrying every %u ms", self->location,
+              self->retry_delay), (NULL));
+      self->failing = TRUE;
+      self->failed_since = g_get_monotonic_time ();
+    }
+    /* The address may have changed, e.g. a microphone got a new lease. */
+    if (!reset_target (self))
+      return HTTP_WAV_FATAL;
+    redirects = 0;
+    if (wait_socket (self, FALSE, self->retry_delay) == HTTP_WAV_FLUSHING)
+      return HTTP_WAV_FLUSHING;
+  }
+
+  if (self->failing)
+    GST_INFO_OBJECT (self, "reconnected to %s after %.1f s", self->location,
+        (g_get_monotonic_time () - self->failed_since) / 1e6);
+  else
+    GST_INFO_OBJECT (self, "connected to %s: %s, %s, %u Hz, %u channels",
+        self->location, self->decoder ?
+        nvds_audio_codec_get_name (self->codec) : "PCM", self->format,
+        self->rate, self->channels);
+  self->failing = FALSE;
+  self->connects++;
+  self->base_pts = get_running_time (self);
+  self->samples = 0;
+  self->discont = TRUE;
+  return HTTP_WAV_OK;
+}
+
+static void
+update_blocksize (GstDsHttpWavSrc * self)
+{
+  guint frames = MAX ((guint64) self->rate * self->block_duration / 1000, 1);
+
+  gst_base_src_set_blocksize (GST_BASE_SRC (self), frames * self->bpf);
+}
+
+/** Connect before the first buffer to learn the caps of the stream. */
+static gboolean
+gst_ds_http_wav_src_negotiate (GstBaseSrc * bsrc)
+{
+  GstDsHttpWavSrc *self = GST_DS_HTTP_WAV_SRC (bsrc);
+
+  if (self->fd < 0 && connect_stream (self) != HTTP_WAV_OK)
+    return FALSE;
+  update_blocksize (self);
+  return gst_base_src_set_caps (bsrc, self->caps);
+}
+
+/** Buffers of blocksize bytes, allocated once. */
+static gboolean
+gst_ds_http_wav_src_decide_allocation (GstBaseSrc * bsrc, GstQuery * query)
+{
+  GstBufferPool *pool = NULL;
+  guint size = gst_base_src_get_blocksize (bsrc);
+  guint min = 0, max = 0;
+
+  if (gst_query_get_n_allocation_pools (query) > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, NULL, &min, &max);
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, MAX (min, 4),
+        max);
+  } else {
+    pool = gst_buffer_pool_new ();
+    gst_query_add_allocation_pool (query, pool, size, 4, 0);
+  }
+  if (pool)
+    gst_object_unref (pool);
+
+  return GST_BASE_SRC_CLASS (gst_ds_http_wav_src_parent_class)->
+      decide_allocation (bsrc, query);
+}
+
+/** Decode until @p size bytes of samples are ready or the body ends. */
+static HttpWavResult
+fill_decoded (GstDsHttpWavSrc * self, guint8 * dst, gsize size,
+    gsize * filled)
+{
+  HttpWavResult result = HTTP_WAV_OK;
+
+  g_byte_array_remove_range (self->decoded, 0, self->decoded_pos);
+  self->decoded_pos = 0;
+  while (self->decoded->len < size && self->data_left) {
+    gsize n = MIN (HTTP_WAV_DECODE_READ_SIZE, self->data_left);
+
+    result = read_body (self, self->cbuf, &n);
+    if (result != HTTP_WAV_OK)
+      break;
+    if (!n) {
+      result = HTTP_WAV_RETRY;
+      break;
+    }
+    if (self->data_left != G_MAXUINT64)
+      self->data_left -= n;
+    if ((result = decode_body (self, self->cbuf, n)) != HTTP_WAV_OK)
+      break;
+  }
+  *filled = MIN (size, self->decoded->len);
+  memcpy (dst, self->decoded->data, *filled);
+  self->decoded_pos = *filled;
+  return result;
+}
+
+static GstFlowReturn
+gst_ds_http_wav_src_fill (GstPushSrc * psrc, GstBuffer * buf)
+{
+  GstDsHttpWavSrc *self = GST_DS_HTTP_WAV_SRC (psrc);
+  HttpWavResult result;
+  GstMapInfo map;
+  gsize size, filled;
+  GstClockTime end;
+
+again:
+  if (self->fd < 0) {
+    GstCaps *caps = gst_caps_ref (self->caps);
+
+    result = connect_stream (self);
+    if (result == HTTP_WAV_OK && !gst_caps_is_equal (caps, self->caps)) {
+      /* New format: new caps now, buffers of the new size from the next
+       * negotiation on. */
+      GST_INFO_OBJECT (self, "format changed to %" GST_PTR_FORMAT,
+          self->caps);
+      update_blocksize (self);
+      gst_base_src_set_caps (GST_BASE_SRC (self), self->caps);
+      gst_pad_mark_reconfigure (GST_BASE_SRC_PAD (self));
+    }
+    gst_caps_unref (caps);
+    if (result == HTTP_WAV_FLUSHING)
+      return GST_FLOW_FLUSHING;
+    if (result != HTTP_WAV_OK)
+      return GST_FLOW_ERROR;
+  }
+
+  if (!gst_buffer_map (buf, &map, GST_MAP_WRITE)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, WRITE, (NULL),
+        ("Could not map output buffer"));
+    return GST_FLOW_ERROR;
+  }
+  size = map.size - map.size % self->bpf;
+  filled = 0;
+  result = HTTP_WAV_OK;
+  if (self->decoder)
+    result = fill_decoded (self, map.data, size, &filled);
+  while (!self->decoder && filled < size && self->data_left) {
+    gsize n = MIN (size - filled, self->data_left);
+
+    result = read_body (self, map.data + filled, &n);
+    if (result != HTTP_WAV_OK)
+      break;
+    if (!n) {
+      /* A stream of unknown length ended: reconnect. */
+      result = HTTP_WAV_RETRY;
+      break;
+    }
+    filled += n;
+    if (self->data_left != G_MAXUINT64)
+      self->data_left -= n;
+  }
+  gst_buffer_unmap (buf, &map);
+  /* A partial frame of a lost connection is dropped. */
+  filled -= filled % self->bpf;
+
+  if (result == HTTP_WAV_FLUSHING)
+    return GST_FLOW_FLUSHING;
+  if (result == HTTP_WAV_FATAL)
+    return GST_FLOW_ERROR;
+  if (result != HTTP_WAV_OK) {
+    GST_ELEMENT_WARNING (self, RESOURCE, READ,
+        ("Connection to %s lost, reconnecting", self->location), (NULL));
+    self->failing = TRUE;
+    self->failed_since = g_get_monotonic_time ();
+    close_connection (self);
+    /* Hand out what arrived; reconnect with the next buffer. */
+    if (!filled)
+      goto again;
+  } else if (!filled) {
+    GST_INFO_OBJECT (self, "end of %s", self->location);
+    return GST_FLOW_EOS;
+  }
+
+  gst_buffer_resize (buf, 0, filled);
+  GST_BUFFER_PTS (buf) = self->base_pts +
+      gst_util_uint64_scale (self->samples, GST_SECOND, self->rate);
+  self->samples += filled / self->bpf;
+  end = self->base_pts +
+      gst_util_uint64_scale (self->samples, GST_SECOND, self->rate);
+  GST_BUFFER_DURATION (buf) = end - GST_BUFFER_PTS (buf);
+  GST_BUFFER_OFFSET (buf) = self->samples - filled / self->bpf;
+  GST_BUFFER_OFFSET_END (buf) = self->samples;
+  if (self->discont) {
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+    self->discont = FALSE;
+  }
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_ds_http_wav_src_query (GstBaseSrc * bsrc, GstQuery * query)
+{
+  GstDsHttpWavSrc *self = GST_DS_HTTP_WAV_SRC (bsrc);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_LATENCY) {
+    /* A buffer is pushed once it is full. */
+    gst_query_set_latency (query, TRUE, self->block_duration * GST_MSECOND,
+        GST_CLOCK_TIME_NONE);
+    return TRUE;
+  }
+  return GST_BASE_SRC_CLASS (gst_ds_http_wav_src_parent_class)->query
+      (bsrc, query);
+}
+
+static gboolean
+gst_ds_http_wav_src_start (GstBaseSrc * bsrc)
+{
+  GstDsHttpWavSrc *self = GST_DS_HTTP_WAV_SRC (bsrc);
+
+  if (!reset_target (self)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND, (NULL),
+        ("'%s' is not an http:// URI", self->location));
+    return FALSE;
+  }
+  self->poll = gst_poll_new (TRUE);
+  self->rbuf = g_malloc (HTTP_WAV_READ_SIZE);
+  self->rpos = self->rlen = 0;
+  self->cbuf = g_malloc (HTTP_WAV_DECODE_READ_SIZE);
+  self->decoded = g_byte_array_new ();
+  self->decoded_pos = 0;
+  self->failing = FALSE;
+  return TRUE;
+}
+
+static gboolean
+gst_ds_http_wav_src_stop (GstBaseSrc * bsrc)
+{
+  GstDsHttpWavSrc *self = GST_DS_HTTP_WAV_SRC (bsrc);
+
+  close_connection (self);
+  if (self->addrs)
+    freeaddrinfo (self->addrs);
+  self->addrs = NULL;
+  g_clear_pointer (&self->host, g_free);
+  g_clear_pointer (&self->port, g_free);
+  g_clear_pointer (&self->path, g_free);
+  g_clear_pointer (&self->poll, gst_poll_free);
+  g_clear_pointer (&self->rbuf, g_free);
+  g_clear_pointer (&self->cbuf, g_free);
+  g_clear_pointer (&self->decoder, nvds_audio_decoder_free);
+  if (self->decoded)
+    g_byte_array_unref (self->decoded);
+  self->decoded = NULL;
+  if (self->caps)
+    gst_caps_unref (self->caps);
+  self->caps = NULL;
+  GST_INFO_OBJECT (self, "%u connections to %s", self->connects,
+      self->location);
+  return TRUE;
+}
+
+static gboolean
+gst_ds_http_wav_src_unlock (GstBaseSrc * bsrc)
+{
+  GstDsHttpWavSrc *self = GST_DS_HTTP_WAV_SRC (bsrc);
+
+  g_atomic_int_set (&self->flushing, TRUE);
+  if (self->poll)
+    gst_poll_set_flushing (self->poll, TRUE);
+  return TRUE;
+}
+
+static gboolean
+gst_ds_http_wav_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstDsHttpWavSrc *self = GST_DS_HTTP_WAV_SRC (bsrc);
+
+  g_atomic_int_set (&self->flushing, FALSE);
+  if (self->poll)
+    gst_poll_set_flushing (self->poll, FALSE);
+  return TRUE;
+}
+
+static void
+gst_ds_http_wav_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstDsHttpWavSrc *self = GST_DS_HTTP_WAV_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_free (self->location);
+      self->location = g_value_dup_string (value);
+      break;
+    case PROP_TIMEOUT:
+      self->timeout = g_value_get_uint (value);
+      break;
+    case PROP_RETRY_DELAY:
+      self->retry_delay = g_value_get_uint (value);
+      break;
+    case PROP_BLOCK_DURATION:
+      self->block_duration = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ds_http_wav_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstDsHttpWavSrc *self = GST_DS_HTTP_WAV_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_value_set_string (value, self->location);
+      break;
+    case PROP_TIMEOUT:
+      g_value_set_uint (value, self->timeout);
+      break;
+    case PROP_RETRY_DELAY:
+      g_value_set_uint (value, self->retry_delay);
+      break;
+    case PROP_BLOCK_DURATION:
+      g_value_set_uint (value, self->block_duration);
+      break;
+    case PROP_CONNECTS:
+      g_value_set_uint (value, self->connects);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ds_http_wav_src_finalize (GObject * object)
+{
+  GstDsHttpWavSrc *self = GST_DS_HTTP_WAV_SRC (object);
+
+  g_free (self->location);
+
+  G_OBJECT_CLASS (gst_ds_http_wav_src_parent_class)->finalize (object);
+}
+
+static void
+gst_ds_http_wav_src_class_init (GstDsHttpWavSrcClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseSrcClass *base_src_class = GST_BASE_SRC_CLASS (klass);
+  GstPushSrcClass *push_src_class = GST_PUSH_SRC_CLASS (klass);
+
+  gobject_class->set_property = gst_ds_http_wav_src_set_property;
+  gobject_class->get_property = gst_ds_http_wav_src_get_property;
+  gobject_class->finalize = gst_ds_http_wav_src_finalize;
+  base_src_class->start = GST_DEBUG_FUNCPTR (gst_ds_http_wav_src_start);
+  base_src_class->stop = GST_DEBUG_FUNCPTR (gst_ds_http_wav_src_stop);
+  base_src_class->unlock = GST_DEBUG_FUNCPTR (gst_ds_http_wav_src_unlock);
+  base_src_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_ds_http_wav_src_unlock_stop);
+  base_src_class->negotiate =
+      GST_DEBUG_FUNCPTR (gst_ds_http_wav_src_negotiate);
+  base_src_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_ds_http_wav_src_decide_allocation);
+  base_src_class->query = GST_DEBUG_FUNCPTR (gst_ds_http_wav_src_query);
+  push_src_class->fill = GST_DEBUG_FUNCPTR (gst_ds_http_wav_src_fill);
+
+  g_object_class_install_property (gobject_class, PROP_LOCATION,
+      g_param_spec_string ("location", "Location",
+          "http:// URI of the WAV, FLAC or Ogg Opus stream", DEFAULT_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_TIMEOUT,
+      g_param_spec_uint ("timeout", "Timeout",
+          "Reconnect after this many ms without data", 1, G_MAXINT,
+          DEFAULT_TIMEOUT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_RETRY_DELAY,
+      g_param_spec_uint ("retry-delay", "Retry delay",
+          "Wait between failed connection attempts in ms", 0, G_MAXINT,
+          DEFAULT_RETRY_DELAY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_BLOCK_DURATION,
+      g_param_spec_uint ("block-duration", "Block duration",
+          "Audio per buffer in ms", 1, 1000, DEFAULT_BLOCK_DURATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CONNECTS,
+      g_param_spec_uint ("connects", "Connects",
+          "Connections made since the start, including reconnects", 0,
+          G_MAXUINT, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "DeepStream HTTP WAV source", "Source/Network/Audio",
+      "Receives WAV, FLAC or Ogg Opus streamed over HTTP and reconnects "
+      "when it is lost",
+      "NVIDIA Corporation");
+}
+
+static void
+gst_ds_http_wav_src_init (GstDsHttpWavSrc * self)
+{
+  self->location = g_strdup (DEFAULT_LOCATION);
+  self->timeout = DEFAULT_TIMEOUT;
+  self->retry_delay = DEFAULT_RETRY_DELAY;
+  self->block_duration = DEFAULT_BLOCK_DURATION;
+  self->fd = -1;
+
+  gst_base_src_set_live (GST_BASE_SRC (self), TRUE);
+  gst_base_src_set_format (GST_BASE_SRC (self), GST_FORMAT_TIME);
+}
+
+gboolean
+nvds_http_wav_src_register (void)
+{
+  static gsize registered = 0;
+
+  if (g_once_init_enter (&registered)) {
+    GST_DEBUG_CATEGORY_INIT (gst_ds_http_wav_src_debug,
+        NVDS_ELEM_SRC_HTTP_WAV, 0, "DeepStream HTTP WAV source");
+    g_once_init_leave (&registered,
+        gst_element_register (NULL, NVDS_ELEM_SRC_HTTP_WAV, GST_RANK_NONE,
+            GST_TYPE_DS_HTTP_WAV_SRC) ? 1 : 2);
+  }
+  return registered == 1;
+}
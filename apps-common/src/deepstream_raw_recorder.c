@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <linux/limits.h> /* For PATH_MAX */
+#include <stdio.h>
+#include <string.h>
+
+#include "deepstream_common.h"
+#include "deepstream_raw_recorder.h"
+
+#define RAW_RECORDER_ALIGN(size) (((size) + 7) & ~(gsize) 7)
+/** Buffer of the segment file; the writer hands it whole chunks. */
+#define RAW_RECORDER_FILE_BUFFER (1 << 20)
+
+/** Header of a record, see deepstream_raw_recorder.h. */
+typedef struct
+{
+  guint32 magic;
+  guint32 size;
+  guint64 batch;
+  guint64 pts;
+  guint64 time;
+  guint32 layer_index;
+  guint32 data_type;
+  guint32 batch_size;
+  guint32 num_elements;
+  guint32 data_size;
+  guint32 reserved;
+  gchar layer_name[64];
+} RawRecordHeader;
+
+G_STATIC_ASSERT (sizeof (RawRecordHeader) == 120);
+
+struct _NvDsRawRecorder
+{
+  gchar *directory;
+  gchar *name;
+
+  GMutex lock;
+  GCond cond;
+  guint8 *ring;
+  /** Bytes ever queued and written; the ring holds [tail, head). A record
+   *  never wraps: the end of the ring is skipped instead, marked by a
+   *  magic of 0. */
+  guint64 head;
+  guint64 tail;
+  gboolean stop;
+  GThread *thread;
+
+  /** Writer thread only. */
+  FILE *segment;
+  FILE *index;
+  guint segment_num;
+  guint64 segment_size;
+  gboolean failed;
+
+  guint64 batches;
+  guint64 records;
+  guint64 dropped;
+  guint64 bytes;
+  guint num_segments;
+  /** Time spent in nvds_raw_recorder_write () and by the writer, us. */
+  gint64 copy_time;
+  gint64 write_time;
+  gint64 start_time;
+};
+
+static guint
+element_size (NvDsInferDataType type)
+{
+  switch (type) {
+    case FLOAT: return 4;
+    case HALF: return 2;
+    case INT32: return 4;
+    case INT8: return 1;
+  }
+  return 0;
+}
+
+static gchar *
+segment_path (NvDsRawRecorder *rec, guint num)
+{
+  gchar file_name[PATH_MAX];
+
+  g_snprintf (file_name, sizeof (file_name), "%s_%06u.bin", rec->name, num);
+  return g_build_filename (rec->directory, file_name, NULL);
+}
+
+/** Close the current segment and append to the next one. */
+static gboolean
+open_next_segment (NvDsRawRecorder *rec)
+{
+  gchar *path;
+
+  if (rec->segment) {
+    fclose (rec->segment);
+    rec->segment_num++;
+  }
+  path = segment_path (rec, rec->segment_num);
+  rec->segment = fopen (path, "ab");
+  if (!rec->segment) {
+    NVGSTDS_ERR_MSG_V ("Could not open '%s' for writing: %s", path,
+        strerror (errno));
+    g_free (path);
+    return FALSE;
+  }
+  setvbuf (rec->segment, NULL, _IOFBF, RAW_RECORDER_FILE_BUFFER);
+  rec->segment_size = ftell (rec->segment);
+  rec->num_segments++;
+  g_free (path);
+  return TRUE;
+}
+
+/** Append one record to the current segment and the index. */
+static void
+write_record (NvDsRawRecorder *rec, const RawRecordHeader *header)
+{
+  if (rec->failed)
+    return;
+  if (!rec->segment || (rec->segment_size &&
+          rec->segment_size + header->size > NVDS_RAW_RECORDER_SEGMENT_SIZE)) {
+    if (!open_next_segment (rec)) {
+      rec->failed = TRUE;
+      return;
+    }
+  }
+
+  if (fwrite (header, 1, header->size, rec->segment) != header->size) {
+    NVGSTDS_ERR_MSG_V ("Failed to write raw output of '%s': %s; recording"
+        " stopped", rec->name, strerror (errno));
+    rec->failed = TRUE;
+    return;
+  }
+  fprintf (rec->index, "%u %" G_GUINT64_FORMAT " %u %" G_GUINT64_FORMAT
+      " %s\n", rec->segment_num, rec->segment_size, header->size,
+      header->batch, header->layer_name);
+  rec->segment_size += header->size;
+}
+
+static gpointer
+raw_recorder_thread_func (gpointer data)
+{
+  NvDsRawRecorder *rec = (NvDsRawRecorder *) data;
+
+  g_mutex_lock (&rec->lock);
+  while (TRUE) {
+    guint64 pos, end;
+    gint64 start;
+
+    while (rec->head == rec->tail && !rec->stop)
+      g_cond_wait (&rec->cond, &rec->lock);
+    if (rec->head == rec->tail)
+      break;
+    pos = rec->tail;
+    end = rec->head;
+    g_mutex_unlock (&rec->lock);
+
+    /* The producers only write outside of [tail, head). */
+    start = g_get_monotonic_time ();
+    while (pos < end) {
+      gsize offset = pos % NVDS_RAW_RECORDER_RING_SIZE;
+      const RawRecordHeader *header =
+          (const RawRecordHeader *) (rec->ring + offset);
+
+      if (header->magic != NVDS_RAW_RECORDER_MAGIC) {
+        pos += NVDS_RAW_RECORDER_RING_SIZE - offset;
+        continue;
+      }
+      write_record (rec, header);
+      pos += header->size;
+    }
+    if (!rec->failed) {
+      fflush (rec->segment);
+      fflush (rec->index);
+    }
+
+    g_mutex_lock (&rec->lock);
+    rec->write_time += g_get_monotonic_time () - start;
+    rec->tail = end;
+  }
+  g_mutex_unlock (&rec->lock);
+  return NULL;
+}
+
+NvDsRawRecorder *
+nvds_raw_recorder_new (const gchar *directory, const gchar *name)
+{
+  NvDsRawRecorder *rec = g_new0 (NvDsRawRecorder, 1);
+  gchar *file_name;
+  gchar *path = NULL;
+  gboolean ret = FALSE;
+
+  rec->directory = g_strdup (directory);
+  rec->name = g_strdup (name);
+  g_mutex_init (&rec->lock);
+  g_cond_init (&rec->cond);
+
+  if (g_mkdir_with_parents (directory, 0755)) {
+    NVGSTDS_ERR_MSG_V ("Could not create '%s': %s", directory,
+        strerror (errno));
+    goto done;
+  }
+
+  /* Continue after the segments of earlier runs. */
+  while (TRUE) {
+    path = segment_path (rec, rec->segment_num);
+    if (!g_file_test (path, G_FILE_TEST_EXISTS))
+      break;
+    g_free (path);
+    rec->segment_num++;
+  }
+  g_free (path);
+
+  file_name = g_strdup_printf ("%s.index", name);
+  path = g_build_filename (directory, file_name, NULL);
+  g_free (file_name);
+  rec->index = fopen (path, "a");
+  if (!rec->index) {
+    NVGSTDS_ERR_MSG_V ("Could not open '%s' for writing: %s", path,
+        strerror (errno));
+    goto done;
+  }
+
+  rec->ring = g_malloc (NVDS_RAW_RECORDER_RING_SIZE);
+  rec->thread = g_thread_new ("raw-recorder", raw_recorder_thread_func, rec);
+  ret = TRUE;
+done:
+  g_free (path);
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+    nvds_raw_recorder_free (rec);
+    return NULL;
+  }
+  return rec;
+}
+
+/**
+ * Make room for @p size contiguous bytes at head, skipping the end of the
+ * ring if needed. Called with the lock held.
+ */
+static gboolean
+reserve_record (NvDsRawRecorder *rec, gsize size)
+{
+  gsize offset = rec->head % NVDS_RAW_RECORDER_RING_SIZE;
+  gsize contiguous = NVDS_RAW_RECORDER_RING_SIZE - offset;
+  gsize needed = contiguous < size ? contiguous + size : size;
+
+  if (NVDS_RAW_RECORDER_RING_SIZE - (rec->head - rec->tail) < needed)
+    return FALSE;
+  if (contiguous < size) {
+    /* Records are 8 byte aligned, so the magic always fits. */
+    *(guint32 *) (rec->ring + offset) = 0;
+    rec->head += contiguous;
+  }
+  return TRUE;
+}
+
+void
+nvds_raw_recorder_write (NvDsRawRecorder *rec, GstBuffer *buf,
+    NvDsInferLayerInfo *layers_info, guint num_layers, guint batch_size)
+{
+  gint64 start = g_get_monotonic_time ();
+  guint64 batch;
+  guint i;
+
+  g_mutex_lock (&rec->lock);
+  if (!rec->start_time)
+    rec->start_time = start;
+  batch = rec->batches++;
+  for (i = 0; i < num_layers; i++) {
+    NvDsInferLayerInfo *info = &layers_info[i];
+    gsize data_size = (gsize) element_size (info->dataType) *
+        info->inferDims.numElements * batch_size;
+    gsize size = RAW_RECORDER_ALIGN (sizeof (RawRecordHeader) + data_size);
+    RawRecordHeader *header;
+
+    if (size > NVDS_RAW_RECORDER_RING_SIZE || !reserve_record (rec, size)) {
+      rec->dropped++;
+      continue;
+    }
+    header = (RawRecordHeader *) (rec->ring +
+        rec->head % NVDS_RAW_RECORDER_RING_SIZE);
+    memset (header, 0, sizeof (RawRecordHeader));
+    header->magic = NVDS_RAW_RECORDER_MAGIC;
+    header->size = size;
+    header->batch = batch;
+    header->pts = GST_BUFFER_PTS (buf);
+    header->time = start;
+    header->layer_index = i;
+    header->data_type = info->dataType;
+    header->batch_size = batch_size;
+    header->num_elements = info->inferDims.numElements;
+    header->data_size = data_size;
+    g_strlcpy (header->layer_name, info->layerName,
+        sizeof (header->layer_name));
+    memcpy (header + 1, info->buffer, data_size);
+
+    rec->head += size;
+    rec->records++;
+    rec->bytes += size;
+  }
+  g_cond_signal (&rec->cond);
+  rec->copy_time += g_get_monotonic_time () - start;
+  g_mutex_unlock (&rec->lock);
+}
+
+void
+nvds_raw_recorder_free (NvDsRawRecorder *rec)
+{
+  gdouble elapsed;
+
+  if (!rec)
+    return;
+  if (rec->thread) {
+    g_mutex_lock (&rec->lock);
+    rec->stop = TRUE;
+    g_cond_signal (&rec->cond);
+    g_mutex_unlock (&rec->lock);
+    g_thread_join (rec->thread);
+  }
+
+  if (rec->batches) {
+    elapsed = (g_get_monotonic_time () - rec->start_time) / 1e6;
+    g_print ("Raw output of %s: %" G_GUINT64_FORMAT " records, %.1f MB in"
+        " %u segments, %" G_GUINT64_FORMAT " dropped; %.1f us per batch on"
+        " the streaming thread, writer busy %.2f%% of %.1f s\n", rec->name,
+        rec->records, rec->bytes / 1048576.0, rec->num_segments,
+        rec->dropped, (gdouble) rec->copy_time / rec->batches,
+        elapsed > 0 ? rec->write_time / 1e4 / elapsed : 0.0, elapsed);
+  }
+
+  if (rec->segment)
+    fclose (rec->segment);
+  if (rec->index)
+    fclose (rec->index);
+  g_free (rec->ring);
+  g_mutex_clear (&rec->lock);
+  g_cond_clear (&rec->cond);
+  g_free (rec->directory);
+  g_free (rec->name);
+  g_free (rec);
+}
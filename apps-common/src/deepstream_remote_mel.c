@@ -0,0 +1,594 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "deepstream_common.h"
+#include "deepstream_config.h"
+#include "deepstream_remote_mel.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_ds_mel_depay_debug);
+#define GST_CAT_DEFAULT gst_ds_mel_depay_debug
+
+/** Larger jumps of the column index are taken as a restart of the sender;
+ *  smaller ones are filled. About 11 s at hop 482 and 44.1 kHz. */
+#define MEL_DEPAY_MAX_GAP_COLUMNS 1024
+
+#define DEFAULT_SOURCE_ID 0
+#define DEFAULT_RATE 0
+
+#define MEL_DEPAY_SRC_CAPS \
+  "audio/x-raw, format = (string) F32LE, layout = (string) interleaved, " \
+  "rate = (int) [ 1, MAX ], channels = (int) 1"
+
+enum
+{
+  PROP_0,
+  PROP_SOURCE_ID,
+  PROP_RATE,
+};
+
+/** Columns received for one source and not yet taken by the front-end. */
+typedef struct
+{
+  GMutex lock;
+  gboolean registered;
+  GArray *columns;
+  guint num_mels;
+  guint hop_size;
+} RemoteMelQueue;
+
+static RemoteMelQueue remote_mel_queues[MAX_SOURCE_BINS];
+
+void
+nvds_remote_mel_header_write (const NvDsRemoteMelHeader *header, guint8 *out)
+{
+  guint32 magic = GUINT32_TO_LE (header->magic);
+  guint16 num_mels = GUINT16_TO_LE (header->num_mels);
+  guint16 num_columns = GUINT16_TO_LE (header->num_columns);
+  guint16 hop_size = GUINT16_TO_LE (header->hop_size);
+  guint32 sample_rate = GUINT32_TO_LE (header->sample_rate);
+  guint64 first_column = GUINT64_TO_LE (header->first_column);
+  union { gfloat f; guint32 u; } scale = { header->scale };
+  gint32 zero_point = GINT32_TO_LE (header->zero_point);
+
+  scale.u = GUINT32_TO_LE (scale.u);
+  memcpy (out + 0, &magic, 4);
+  out[4] = header->version;
+  out[5] = header->format;
+  memcpy (out + 6, &num_mels, 2);
+  memcpy (out + 8, &num_columns, 2);
+  memcpy (out + 10, &hop_size, 2);
+  memcpy (out + 12, &sample_rate, 4);
+  memcpy (out + 16, &first_column, 8);
+  memcpy (out + 24, &scale.u, 4);
+  memcpy (out + 28, &zero_point, 4);
+}
+
+gboolean
+nvds_remote_mel_header_read (const guint8 *in, NvDsRemoteMelHeader *header)
+{
+  union { gfloat f; guint32 u; } scale;
+
+  memcpy (&header->magic, in + 0, 4);
+  header->version = in[4];
+  header->format = in[5];
+  memcpy (&header->num_mels, in + 6, 2);
+  memcpy (&header->num_columns, in + 8, 2);
+  memcpy (&header->hop_size, in + 10, 2);
+  memcpy (&header->sample_rate, in + 12, 4);
+  memcpy (&header->first_column, in + 16, 8);
+  memcpy (&scale.u, in + 24, 4);
+  memcpy (&header->zero_point, in + 28, 4);
+
+  header->magic = GUINT32_FROM_LE (header->magic);
+  header->num_mels = GUINT16_FROM_LE (header->num_mels);
+  header->num_columns = GUINT16_FROM_LE (header->num_columns);
+  header->hop_size = GUINT16_FROM_LE (header->hop_size);
+  header->sample_rate = GUINT32_FROM_LE (header->sample_rate);
+  header->first_column = GUINT64_FROM_LE (header->first_column);
+  scale.u = GUINT32_FROM_LE (scale.u);
+  header->scale = scale.f;
+  header->zero_point = GINT32_FROM_LE (header->zero_point);
+
+  return header->magic == NVDS_REMOTE_MEL_MAGIC &&
+      header->version == NVDS_REMOTE_MEL_VERSION &&
+      header->format <= NVDS_AUDIO_TENSOR_INT8 &&
+      header->num_mels && header->num_columns && header->hop_size &&
+      header->sample_rate;
+}
+
+gsize
+nvds_remote_mel_payload_size (const NvDsRemoteMelHeader *header)
+{
+  return (gsize) header->num_columns * header->num_mels *
+      nvds_audio_tensor_element_size (header->format);
+}
+
+void
+nvds_remote_mel_source_register (guint source_id)
+{
+  RemoteMelQueue *queue;
+
+  g_return_if_fail (source_id < MAX_SOURCE_BINS);
+  queue = &remote_mel_queues[source_id];
+
+  g_mutex_lock (&queue->lock);
+  queue->registered = TRUE;
+  if (!queue->columns)
+    queue->columns = g_array_new (FALSE, FALSE, sizeof (gfloat));
+  g_array_set_size (queue->columns, 0);
+  g_mutex_unlock (&queue->lock);
+}
+
+gboolean
+nvds_remote_mel_source_is_registered (guint source_id)
+{
+  gboolean registered;
+
+  if (source_id >= MAX_SOURCE_BINS)
+    return FALSE;
+  g_mutex_lock (&remote_mel_queues[source_id].lock);
+  registered = remote_mel_queues[source_id].registered;
+  g_mutex_unlock (&remote_mel_queues[source_id].lock);
+  return registered;
+}
+
+void
+nvds_remote_mel_queue_columns (guint source_id, const gfloat *columns,
+    guint num_columns, guint num_mels, guint hop_size)
+{
+  RemoteMelQueue *queue;
+
+  g_return_if_fail (source_id < MAX_SOURCE_BINS);
+  queue = &remote_mel_queues[source_id];
+
+  g_mutex_lock (&queue->lock);
+  if (queue->registered) {
+    queue->num_mels = num_mels;
+    queue->hop_size = hop_size;
+    g_array_append_vals (queue->columns, columns, num_columns * num_mels);
+  }
+  g_mutex_unlock (&queue->lock);
+}
+
+gfloat *
+nvds_remote_mel_take_columns (guint source_id, guint *num_columns,
+    guint *num_mels, guint *hop_size)
+{
+  RemoteMelQueue *queue;
+  gfloat *columns = NULL;
+
+  *num_columns = 0;
+  if (source_id >= MAX_SOURCE_BINS)
+    return NULL;
+  queue = &remote_mel_queues[source_id];
+
+  g_mutex_lock (&queue->lock);
+  if (queue->registered && queue->columns->len) {
+    *num_columns = queue->columns->len / queue->num_mels;
+    *num_mels = queue->num_mels;
+    *hop_size = queue->hop_size;
+    columns = (gfloat *) g_array_free (queue->columns, FALSE);
+    queue->columns = g_array_new (FALSE, FALSE, sizeof (gfloat));
+  }
+  g_mutex_unlock (&queue->lock);
+  return columns;
+}
+
+typedef struct
+{
+  GstElement element;
+  GstPad *sinkpad;
+  GstPad *srcpad;
+
+  /* Properties. */
+  guint source_id;
+  guint rate;
+
+  /** Received bytes not yet forming a complete frame. */
+  GByteArray *pending;
+  /** Column layout of the stream, fixed by the first frame. */
+  gboolean negotiated;
+  guint out_rate;
+  guint num_mels;
+  guint hop_size;
+  /**
+   * Sender column index of output column 0. Output columns are contiguous;
+   * gaps are filled and restarts of the sender are rebased.
+   */
+  guint64 base_column;
+  guint64 out_columns;
+  gboolean discont;
+  gfloat *columns;
+  gsize columns_len;
+  guint64 columns_filled;
+} GstDsMelDepay;
+
+typedef struct
+{
+  GstElementClass parent_class;
+} GstDsMelDepayClass;
+
+#define GST_DS_MEL_DEPAY(obj) ((GstDsMelDepay *) (obj))
+
+G_DEFINE_TYPE (GstDsMelDepay, gst_ds_mel_depay, GST_TYPE_ELEMENT);
+
+static GstStaticPadTemplate sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (MEL_DEPAY_SRC_CAPS));
+
+static void
+gst_ds_mel_depay_reset (GstDsMelDepay * self)
+{
+  g_byte_array_set_size (self->pending, 0);
+  self->negotiated = FALSE;
+  self->out_columns = 0;
+  self->discont = TRUE;
+}
+
+/** Set the output caps and a TIME segment from the first frame. */
+static gboolean
+gst_ds_mel_depay_negotiate (GstDsMelDepay * self,
+    const NvDsRemoteMelHeader * header)
+{
+  GstCaps *caps;
+  GstSegment segment;
+  gboolean ret;
+
+  if (self->rate && header->sample_rate != self->rate) {
+    GST_ELEMENT_ERROR (self, STREAM, FORMAT, (NULL),
+        ("Sender sample rate %u differs from the pipeline rate %u",
+            header->sample_rate, self->rate));
+    return FALSE;
+  }
+
+  caps = gst_caps_new_simple ("audio/x-raw",
+      "format", G_TYPE_STRING, "F32LE",
+      "layout", G_TYPE_STRING, "interleaved",
+      "rate", G_TYPE_INT, (gint) header->sample_rate,
+      "channels", G_TYPE_INT, 1, NULL);
+  ret = gst_pad_push_event (self->srcpad, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+  if (!ret)
+    return FALSE;
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (self->srcpad, gst_event_new_segment (&segment));
+
+  self->out_rate = header->sample_rate;
+  self->num_mels = header->num_mels;
+  self->hop_size = header->hop_size;
+  self->base_column = header->first_column;
+  self->negotiated = TRUE;
+
+  GST_INFO_OBJECT (self, "source %u: %u mels every %u samples at %u Hz",
+      self->source_id, self->num_mels, self->hop_size, self->out_rate);
+  return TRUE;
+}
+
+static gfloat *
+gst_ds_mel_depay_get_columns (GstDsMelDepay * self, guint num_columns)
+{
+  gsize len = (gsize) num_columns * self->num_mels;
+
+  if (len > self->columns_len) {
+    self->columns = g_renew (gfloat, self->columns, len);
+    self->columns_len = len;
+  }
+  return self->columns;
+}
+
+/** Push one hop of silent samples per column queued for the front-end. */
+static GstFlowReturn
+gst_ds_mel_depay_push (GstDsMelDepay * self, guint num_columns)
+{
+  guint64 first = self->out_columns * self->hop_size;
+  guint64 num_samples = (guint64) num_columns * self->hop_size;
+  gsize size = num_samples * sizeof (gfloat);
+  GstBuffer *outbuf = gst_buffer_new_allocate (NULL, size, NULL);
+  GstClockTime start = gst_util_uint64_scale (first, GST_SECOND,
+      self->out_rate);
+  GstClockTime end = gst_util_uint64_scale (first + num_samples, GST_SECOND,
+      self->out_rate);
+
+  gst_buffer_memset (outbuf, 0, 0, size);
+  GST_BUFFER_PTS (outbuf) = start;
+  GST_BUFFER_DURATION (outbuf) = end - start;
+  GST_BUFFER_OFFSET (outbuf) = first;
+  GST_BUFFER_OFFSET_END (outbuf) = first + num_samples;
+  if (self->discont) {
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+    self->discont = FALSE;
+  }
+  self->out_columns += num_columns;
+
+  return gst_pad_push (self->srcpad, outbuf);
+}
+
+static GstFlowReturn
+gst_ds_mel_depay_process (GstDsMelDepay * self,
+    const NvDsRemoteMelHeader * header, const guint8 * payload)
+{
+  guint num_values = (guint) header->num_columns * header->num_mels;
+  gint64 delta;
+  guint skip = 0, gap = 0;
+  gfloat *columns;
+  gfloat floor_db;
+  guint i;
+
+  if (!self->negotiated) {
+    if (!gst_ds_mel_depay_negotiate (self, header))
+      return GST_FLOW_NOT_NEGOTIATED;
+  } else if (header->sample_rate != self->out_rate ||
+      header->num_mels != self->num_mels ||
+      header->hop_size != self->hop_size) {
+    GST_ELEMENT_ERROR (self, STREAM, FORMAT, (NULL),
+        ("Column layout changed from %u mels / hop %u / %u Hz to"
+            " %u / %u / %u", self->num_mels, self->hop_size, self->out_rate,
+            header->num_mels, header->hop_size, header->sample_rate));
+    return GST_FLOW_ERROR;
+  }
+
+  /* The index arithmetic is modular; a rebase may wrap base_column. */
+  delta = (gint64) (header->first_column -
+      (self->base_column + self->out_columns));
+  if (delta > MEL_DEPAY_MAX_GAP_COLUMNS || delta < -MEL_DEPAY_MAX_GAP_COLUMNS) {
+    GST_INFO_OBJECT (self, "source %u: sender restarted at column %"
+        G_GUINT64_FORMAT, self->source_id, header->first_column);
+    self->base_column = header->first_column - self->out_columns;
+    self->discont = TRUE;
+  } else if (delta < 0) {
+    /* Columns already received, e.g. resent after a reconnect. */
+    skip = -delta;
+    if (skip >= header->num_columns)
+      return GST_FLOW_OK;
+  } else {
+    gap = delta;
+  }
+
+  columns = gst_ds_mel_depay_get_columns (self, gap + header->num_columns);
+  nvds_audio_tensor_unpack (header->format, payload, num_values,
+      header->scale, header->zero_point,
+      columns + (gsize) gap * self->num_mels);
+
+  /* Missing columns are taken as the quietest value of the next frame. */
+  if (gap) {
+    floor_db = G_MAXFLOAT;
+    for (i = 0; i < num_values; i++)
+      floor_db = MIN (floor_db, columns[(gsize) gap * self->num_mels + i]);
+    for (i = 0; i < gap * self->num_mels; i++)
+      columns[i] = floor_db;
+    self->columns_filled += gap;
+    GST_DEBUG_OBJECT (self, "source %u: filled %u missing columns",
+        self->source_id, gap);
+  }
+
+  nvds_remote_mel_queue_columns (self->source_id,
+      columns + (gsize) skip * self->num_mels,
+      gap + header->num_columns - skip, self->num_mels, self->hop_size);
+  return gst_ds_mel_depay_push (self, gap + header->num_columns - skip);
+}
+
+static GstFlowReturn
+gst_ds_mel_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
+{
+  GstDsMelDepay *self = GST_DS_MEL_DEPAY (parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstMapInfo map;
+  gsize consumed = 0;
+
+  if (!gst_buffer_map (inbuf, &map, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+        ("Could not map input buffer"));
+    gst_buffer_unref (inbuf);
+    return GST_FLOW_ERROR;
+  }
+  g_byte_array_append (self->pending, map.data, map.size);
+  gst_buffer_unmap (inbuf, &map);
+  gst_buffer_unref (inbuf);
+
+  while (ret == GST_FLOW_OK &&
+      self->pending->len - consumed >= NVDS_REMOTE_MEL_HEADER_SIZE) {
+    const guint8 *frame = self->pending->data + consumed;
+    NvDsRemoteMelHeader header;
+    gsize frame_size;
+
+    if (!nvds_remote_mel_header_read (frame, &header)) {
+      GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+          ("Invalid mel frame header at byte %" G_GSIZE_FORMAT, consumed));
+      ret = GST_FLOW_ERROR;
+      break;
+    }
+    frame_size = NVDS_REMOTE_MEL_HEADER_SIZE +
+        nvds_remote_mel_payload_size (&header);
+    if (self->pending->len - consumed < frame_size)
+      break;
+
+    ret = gst_ds_mel_depay_process (self, &header,
+        frame + NVDS_REMOTE_MEL_HEADER_SIZE);
+    consumed += frame_size;
+  }
+  g_byte_array_remove_range (self->pending, 0, consumed);
+  return ret;
+}
+
+static gboolean
+gst_ds_mel_depay_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstDsMelDepay *self = GST_DS_MEL_DEPAY (parent);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+    case GST_EVENT_SEGMENT:
+      /* Replaced by the caps and TIME segment of the first frame. */
+      gst_event_unref (event);
+      return TRUE;
+    case GST_EVENT_FLUSH_STOP:
+      gst_ds_mel_depay_reset (self);
+      nvds_remote_mel_source_register (self->source_id);
+      break;
+    default:
+      break;
+  }
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static GstStateChangeReturn
+gst_ds_mel_depay_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstDsMelDepay *self = GST_DS_MEL_DEPAY (element);
+  GstStateChangeReturn ret;
+
+  if (transition == GST_STATE_CHANGE_READY_TO_PAUSED) {
+    gst_ds_mel_depay_reset (self);
+    nvds_remote_mel_source_register (self->source_id);
+  }
+
+  ret = GST_ELEMENT_CLASS (gst_ds_mel_depay_parent_class)->change_state
+      (element, transition);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY && self->columns_filled)
+    GST_INFO_OBJECT (self, "source %u: %" G_GUINT64_FORMAT " columns filled",
+        self->source_id, self->columns_filled);
+  return ret;
+}
+
+static void
+gst_ds_mel_depay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstDsMelDepay *self = GST_DS_MEL_DEPAY (object);
+
+  switch (prop_id) {
+    case PROP_SOURCE_ID:
+      self->source_id = g_value_get_uint (value);
+      break;
+    case PROP_RATE:
+      self->rate = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ds_mel_depay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstDsMelDepay *self = GST_DS_MEL_DEPAY (object);
+
+  switch (prop_id) {
+    case PROP_SOURCE_ID:
+      g_value_set_uint (value, self->source_id);
+      break;
+    case PROP_RATE:
+      g_value_set_uint (value, self->rate);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ds_mel_depay_finalize (GObject * object)
+{
+  GstDsMelDepay *self = GST_DS_MEL_DEPAY (object);
+
+  g_byte_array_unref (self->pending);
+  g_free (self->columns);
+
+  G_OBJECT_CLASS (gst_ds_mel_depay_parent_class)->finalize (object);
+}
+
+static void
+gst_ds_mel_depay_class_init (GstDsMelDepayClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_ds_mel_depay_set_property;
+  gobject_class->get_property = gst_ds_mel_depay_get_property;
+  gobject_class->finalize = gst_ds_mel_depay_finalize;
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_ds_mel_depay_change_state);
+
+  g_object_class_install_property (gobject_class, PROP_SOURCE_ID,
+      g_param_spec_uint ("source-id", "Source ID",
+          "Source ID under which the columns are queued for the front-end",
+          0, MAX_SOURCE_BINS - 1, DEFAULT_SOURCE_ID,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_RATE,
+      g_param_spec_uint ("rate", "Rate",
+          "Expected sample rate of the sender in Hz (0 = any)", 0, G_MAXINT,
+          DEFAULT_RATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "DeepStream mel frame depayloader", "Codec/Depayloader/Audio",
+      "Receives precomputed mel columns and emits placeholder audio",
+      "NVIDIA Corporation");
+}
+
+static void
+gst_ds_mel_depay_init (GstDsMelDepay * self)
+{
+  self->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_ds_mel_depay_chain));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_ds_mel_depay_sink_event));
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_use_fixed_caps (self->srcpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  self->source_id = DEFAULT_SOURCE_ID;
+  self->rate = DEFAULT_RATE;
+  self->pending = g_byte_array_new ();
+  self->discont = TRUE;
+}
+
+gboolean
+nvds_mel_depay_register (void)
+{
+  static gsize registered = 0;
+
+  if (g_once_init_enter (&registered)) {
+    GST_DEBUG_CATEGORY_INIT (gst_ds_mel_depay_debug,
+        NVDS_ELEM_MEL_DEPAY, 0, "DeepStream mel frame depayloader");
+    g_once_init_leave (&registered,
+        gst_element_register (NULL, NVDS_ELEM_MEL_DEPAY, GST_RANK_NONE,
+            GST_TYPE_DS_MEL_DEPAY) ? 1 : 2);
+  }
+  return registered == 1;
+}
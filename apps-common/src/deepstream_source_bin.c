@@ -27,6 +27,10 @@
 #include "deepstream_common.h"
 #include "deepstream_sources.h"
 #include "deepstream_dewarper.h"
+#include "deepstream_audio_ingest.h"
+#include "deepstream_http_wav.h"
+#include "deepstream_remote_mel.h"
+#include "deepstream_audio_resample.h"
 #include <gst/rtp/gstrtcpbuffer.h>
 #include <gst/rtsp/gstrtsptransport.h>
 #include <cuda_runtime_api.h>
@@ -37,6 +41,8 @@
 
 #define SRC_CONFIG_KEY "src_config"
 #define SOURCE_RESET_INTERVAL_SEC 60
+#define SOURCE_WATCHDOG_INTERVAL_MS 500
+#define RECONNECT_BACKOFF_MIN_MS 1000
 
 GST_DEBUG_CATEGORY_EXTERN (NVDS_APP);
 GST_DEBUG_CATEGORY_EXTERN (APP_CFG_PARSER_CAT);
@@ -568,7 +574,8 @@ void destroy_smart_record_bin (gpointer data)
 
   g_return_if_fail (pbin);
 
-  for (i = 0; i < pbin->num_bins; i++) {
+  /* Sources added at runtime may leave free slots in between. */
+  for (i = 0; i < MAX_SOURCE_BINS; i++) {
 
     src_bin = &pbin->sub_bins[i];
     if (src_bin && src_bin->recordCtx)
@@ -632,8 +639,9 @@ static void
 check_rtsp_reconnection_attempts(NvDsSrcBin * src_bin) {
   gboolean remove_probe = TRUE;
   guint i = 0;
-  for (i = 0; i < src_bin->parent_bin->num_bins; i++) {
-    if (src_bin->parent_bin->sub_bins[i].config->type != NV_DS_SOURCE_RTSP)
+  for (i = 0; i < MAX_SOURCE_BINS; i++) {
+    if (!src_bin->parent_bin->sub_bins[i].config ||
+        src_bin->parent_bin->sub_bins[i].config->type != NV_DS_SOURCE_RTSP)
       continue;
     if (src_bin->parent_bin->sub_bins[i].num_rtsp_reconnects <=
             src_bin->parent_bin->sub_bins[i].rtsp_reconnect_attempts) {
@@ -854,6 +862,132 @@ nvstreammux_eosmonitor_probe_func (GstPad * pad, GstPadProbeInfo * info,
   return GST_PAD_PROBE_OK;
 }
 
+/**
+ * Probe on the output of a watched audio source: notes the time of the last
+ * buffer and turns EOS, e.g. of a closed HTTP stream, into an outage so the
+ * muxer does not see the stream end.
+ */
+static GstPadProbeReturn
+audio_source_watchdog_probe_func (GstPad * pad, GstPadProbeInfo * info,
+    gpointer u_data)
+{
+  NvDsSrcBin *bin = (NvDsSrcBin *) u_data;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    g_mutex_lock (&bin->bin_lock);
+    bin->last_data_time = g_get_monotonic_time ();
+    g_mutex_unlock (&bin->bin_lock);
+  }
+  if ((info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) &&
+      GST_EVENT_TYPE (info->data) == GST_EVENT_EOS) {
+    g_mutex_lock (&bin->bin_lock);
+    bin->source_error = TRUE;
+    g_mutex_unlock (&bin->bin_lock);
+    return GST_PAD_PROBE_DROP;
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+/**
+ * Function called at regular interval for each live audio URI and ALSA
+ * source. A source is down after an error, an EOS or reconnect_timeout_sec
+ * without data; it is then reset on its own, first right away and then
+ * with a wait doubling up to reconnect_backoff_max_sec. A reset without
+ * error gets the timeout to deliver data before the next one. Other sources
+ * are not throttled by it.
+ */
+static gboolean
+watch_audio_source_status (gpointer data)
+{
+  NvDsSrcBin *src_bin = (NvDsSrcBin *) data;
+  NvDsSrcReconnectStats *stats = &src_bin->reconnect_stats;
+  gint64 timeout =
+      (gint64) src_bin->config->reconnect_timeout_sec * G_TIME_SPAN_SECOND;
+  gint64 now = g_get_monotonic_time ();
+  gint64 last_data, since_reset;
+  gboolean error;
+
+  g_mutex_lock (&src_bin->bin_lock);
+  last_data = src_bin->last_data_time;
+  error = src_bin->source_error;
+  g_mutex_unlock (&src_bin->bin_lock);
+
+  if (stats->down_since) {
+    if (!error && last_data > stats->down_since) {
+      stats->last_outage = last_data - stats->down_since;
+      stats->total_downtime += stats->last_outage;
+      stats->down_since = 0;
+      NVGSTDS_INFO_MSG_V ("Source %u up again after %.1f s, %u resets so far",
+          src_bin->source_id, stats->last_outage / 1e6, stats->reconnects);
+      return TRUE;
+    }
+  } else {
+    gint64 idle = now - MAX (last_data, src_bin->last_reset_time);
+
+    if (!error && (!timeout || idle < timeout))
+      return TRUE;
+
+    stats->down_since = error ? now : MAX (last_data,
+        src_bin->last_reset_time);
+    stats->outages++;
+    src_bin->backoff_ms = RECONNECT_BACKOFF_MIN_MS;
+    src_bin->next_reset_time = now;
+    if (error)
+      NVGSTDS_WARN_MSG_V ("Source %u failed, reconnecting",
+          src_bin->source_id);
+    else
+      NVGSTDS_WARN_MSG_V ("No data from source %u for %.1f s, reconnecting",
+          src_bin->source_id, idle / 1e6);
+  }
+
+  /* The element keeps retrying a lost connection itself. */
+  if (src_bin->reconnects_itself && !error)
+    return TRUE;
+
+  since_reset = now - src_bin->last_reset_time;
+  if (now < src_bin->next_reset_time ||
+      (!error && (!timeout || since_reset < timeout)))
+    return TRUE;
+
+  g_mutex_lock (&src_bin->bin_lock);
+  src_bin->source_error = FALSE;
+  g_mutex_unlock (&src_bin->bin_lock);
+
+  src_bin->last_reset_time = now;
+  src_bin->next_reset_time = now + src_bin->backoff_ms * G_TIME_SPAN_MILLISECOND;
+  src_bin->backoff_ms = MIN (src_bin->backoff_ms * 2,
+      MAX (src_bin->config->reconnect_backoff_max_sec * 1000,
+          RECONNECT_BACKOFF_MIN_MS));
+  stats->reconnects++;
+  reset_source_pipeline (src_bin);
+  return TRUE;
+}
+
+/**
+ * Watch a live audio URI or ALSA source, see watch_audio_source_status().
+ */
+static gboolean
+start_audio_source_watchdog (NvDsSrcBin * bin)
+{
+  gboolean ret = FALSE;
+  gulong probe_id = 0;
+
+  NVGSTDS_ELEM_ADD_PROBE (probe_id, bin->bin, "src",
+      audio_source_watchdog_probe_func,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, bin);
+
+  bin->last_reset_time = g_get_monotonic_time ();
+  bin->watchdog_id = g_timeout_add (SOURCE_WATCHDOG_INTERVAL_MS,
+      watch_audio_source_status, bin);
+  ret = TRUE;
+
+done:
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
 static gboolean
 create_rtsp_src_bin (NvDsSourceConfig * config, NvDsSrcBin * bin)
 {
@@ -1058,6 +1192,33 @@ done:
   return ret;
 }
 
+/**
+ * Create the fused ingest element as bin->audio_converter, converting to
+ * float at config->input_audio_rate; @p cutoff of 0 disables the high-pass.
+ */
+static gboolean
+create_audio_ingest (NvDsSourceConfig * config, NvDsSrcBin * bin,
+    gdouble cutoff)
+{
+  if (!nvds_audio_ingest_register ()) {
+    NVGSTDS_ERR_MSG_V ("Could not register '%s'", NVDS_ELEM_AUDIO_INGEST);
+    return FALSE;
+  }
+  bin->audio_converter =
+      gst_element_factory_make (NVDS_ELEM_AUDIO_INGEST, "audio_ingest_elem");
+  if (!bin->audio_converter) {
+    NVGSTDS_ERR_MSG_V ("Could not create element audio_ingest");
+    return FALSE;
+  }
+  g_object_set (G_OBJECT (bin->audio_converter), "rate",
+      config->input_audio_rate, "cutoff", cutoff, NULL);
+
+  /* Filter banks of the usual microphone rates are shared by all sources;
+   * build them before the streams start. */
+  nvds_audio_resampler_precompute (config->input_audio_rate);
+  return TRUE;
+}
+
 static gboolean
 create_audiodecode_src_bin (NvDsSourceConfig * config, NvDsSrcBin * bin)
 {
@@ -1099,6 +1260,30 @@ create_audiodecode_src_bin (NvDsSourceConfig * config, NvDsSrcBin * bin)
     goto done;
   }
 
+  if (!config->legacy_ingest) {
+    /* Conversion and resampling without the high-pass of the URI bin. */
+    if (!create_audio_ingest (config, bin, 0.0))
+      goto done;
+
+    if(config->type == NV_DS_SOURCE_AUDIO_WAV) {
+      gst_bin_add_many (GST_BIN (bin->bin), bin->src_elem, bin->decodebin,
+          bin->audio_converter, NULL);
+
+      gst_element_link_many (bin->src_elem, bin->decodebin,
+          bin->audio_converter, NULL);
+    } else if(config->type == NV_DS_SOURCE_ALSA_SRC) {
+      gst_bin_add_many (GST_BIN (bin->bin), bin->src_elem,
+          bin->audio_converter, NULL);
+
+      gst_element_link_many (bin->src_elem, bin->audio_converter, NULL);
+    }
+
+    NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->audio_converter, "src");
+
+    ret = TRUE;
+    goto done;
+  }
+
   bin->audio_converter =
       gst_element_factory_make ("audioconvert", "audio-convert");
   if (!bin->audio_converter) {
@@ -1185,6 +1370,23 @@ create_uridecode_src_bin_audio (NvDsSourceConfig * config, NvDsSrcBin * bin)
   g_signal_connect (G_OBJECT (bin->src_elem), "pad-added",
       G_CALLBACK (cb_newpad_audio), bin);
 
+  if (!config->legacy_ingest) {
+    /* Conversion, high-pass and resampling fused into one element. */
+    if (!create_audio_ingest (config, bin, 120.0))
+      goto done;
+
+    gst_bin_add_many (GST_BIN (bin->bin), bin->src_elem, bin->audio_converter,
+        NULL);
+
+    NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->audio_converter, "src");
+
+    ret = TRUE;
+
+    GST_CAT_DEBUG (NVDS_APP,
+        "Decode bin created. Waiting for a new pad from decodebin to link");
+    goto done;
+  }
+
   bin->audio_converter = gst_element_factory_make (NVDS_ELEM_AUDIO_CONV, "audioconv_elem");
   if (!bin->audio_converter) {
     NVGSTDS_ERR_MSG_V ("Could not create element audio_converter");
@@ -1228,6 +1430,49 @@ done:
 }
 
 
+/**
+ * WAV streamed over HTTP: the native source feeds the fused ingest element
+ * directly, without typefinding, decodebin and dynamic pads.
+ */
+static gboolean
+create_http_wav_src_bin (NvDsSourceConfig * config, NvDsSrcBin * bin)
+{
+  gboolean ret = FALSE;
+  bin->config = config;
+
+  if (!nvds_http_wav_src_register ()) {
+    NVGSTDS_ERR_MSG_V ("Could not register '%s'", NVDS_ELEM_SRC_HTTP_WAV);
+    goto done;
+  }
+  bin->src_elem = gst_element_factory_make (NVDS_ELEM_SRC_HTTP_WAV,
+      "src_elem");
+  if (!bin->src_elem) {
+    NVGSTDS_ERR_MSG_V ("Could not create element 'src_elem'");
+    goto done;
+  }
+  g_object_set (G_OBJECT (bin->src_elem), "location", config->uri, NULL);
+  bin->latency = config->latency;
+  bin->reconnects_itself = TRUE;
+
+  if (!create_audio_ingest (config, bin, 120.0))
+    goto done;
+
+  gst_bin_add_many (GST_BIN (bin->bin), bin->src_elem, bin->audio_converter,
+      NULL);
+
+  NVGSTDS_LINK_ELEMENT (bin->src_elem, bin->audio_converter);
+
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->audio_converter, "src");
+
+  ret = TRUE;
+
+done:
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
 static gboolean
 create_uridecode_src_bin (NvDsSourceConfig * config, NvDsSrcBin * bin)
 {
@@ -1348,6 +1593,79 @@ done:
   return ret;
 }
 
+/**
+ * Source of precomputed mel columns: tcpclientsrc connects to the remote
+ * node given as "mel://host:port" and the depayloader queues the columns for
+ * the audio front-end under bin->bin_id, emitting placeholder audio.
+ */
+static gboolean
+create_remote_mel_src_bin (NvDsSourceConfig * config, NvDsSrcBin * bin)
+{
+  gboolean ret = FALSE;
+  const gchar *host;
+  gchar *port_str;
+  gchar *host_port = NULL;
+  guint64 port;
+
+  bin->config = config;
+  config->live_source = TRUE;
+
+  if (!config->uri || !g_str_has_prefix (config->uri, "mel://")) {
+    NVGSTDS_ERR_MSG_V ("Remote mel source uri must be \"mel://host:port\"");
+    goto done;
+  }
+  host_port = g_strdup (config->uri + strlen ("mel://"));
+  port_str = strrchr (host_port, ':');
+  if (!port_str || port_str == host_port) {
+    NVGSTDS_ERR_MSG_V ("No host or port in '%s'", config->uri);
+    goto done;
+  }
+  *port_str++ = '\0';
+  port = g_ascii_strtoull (port_str, NULL, 10);
+  if (!port || port > G_MAXUINT16) {
+    NVGSTDS_ERR_MSG_V ("Invalid port in '%s'", config->uri);
+    goto done;
+  }
+  host = host_port;
+
+  if (!nvds_mel_depay_register ()) {
+    NVGSTDS_ERR_MSG_V ("Could not register '%s'", NVDS_ELEM_MEL_DEPAY);
+    goto done;
+  }
+
+  bin->src_elem = gst_element_factory_make (NVDS_ELEM_SRC_TCP, "src_elem");
+  if (!bin->src_elem) {
+    NVGSTDS_ERR_MSG_V ("Could not create element 'src_elem'");
+    goto done;
+  }
+  g_object_set (G_OBJECT (bin->src_elem), "host", host, "port", (gint) port,
+      NULL);
+
+  bin->depay = gst_element_factory_make (NVDS_ELEM_MEL_DEPAY, "depay_elem");
+  if (!bin->depay) {
+    NVGSTDS_ERR_MSG_V ("Could not create element 'depay_elem'");
+    goto done;
+  }
+  g_object_set (G_OBJECT (bin->depay), "source-id", bin->bin_id,
+      "rate", config->input_audio_rate, NULL);
+  nvds_remote_mel_source_register (bin->bin_id);
+
+  gst_bin_add_many (GST_BIN (bin->bin), bin->src_elem, bin->depay, NULL);
+
+  NVGSTDS_LINK_ELEMENT (bin->src_elem, bin->depay);
+
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->depay, "src");
+
+  ret = TRUE;
+
+done:
+  g_free (host_port);
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
 gboolean
 create_audio_source_bin (NvDsSourceConfig * config, NvDsSrcBin * bin)
 {
@@ -1410,6 +1728,115 @@ create_source_bin (NvDsSourceConfig * config, NvDsSrcBin * bin)
   return TRUE;
 }
 
+/**
+ * Create the sub bin of source @p index, add it to the parent bin and link
+ * it to the muxer sink pad of the same index.
+ */
+static gboolean
+create_source_sub_bin (NvDsSourceConfig * config, guint index,
+    NvDsSrcParentBin * bin)
+{
+  NvDsSrcBin *sub_bin = &bin->sub_bins[index];
+  gboolean ret = FALSE;
+  gchar elem_name[50];
+
+  g_snprintf (elem_name, sizeof (elem_name), "src_sub_bin%d", index);
+  sub_bin->bin = gst_bin_new (elem_name);
+  if (!sub_bin->bin) {
+    NVGSTDS_ERR_MSG_V ("Failed to create '%s'", elem_name);
+    goto done;
+  }
+
+  sub_bin->bin_id = sub_bin->source_id = index;
+  sub_bin->attach_time = g_get_monotonic_time ();
+  config->live_source = TRUE;
+  bin->live_source = TRUE;
+  sub_bin->eos_done = TRUE;
+  sub_bin->reset_done = TRUE;
+
+  sub_bin->parent_bin = bin;
+
+  switch (config->type) {
+    case NV_DS_SOURCE_CAMERA_CSI:
+    case NV_DS_SOURCE_CAMERA_V4L2:
+      if (!create_camera_source_bin (config, sub_bin)) {
+        goto done;
+      }
+      break;
+    case NV_DS_SOURCE_URI:
+      if (!create_uridecode_src_bin (config, sub_bin)) {
+        goto done;
+      }
+      bin->live_source = config->live_source;
+      break;
+    case NV_DS_SOURCE_RTSP:
+      if (!create_rtsp_src_bin (config, sub_bin)) {
+        goto done;
+      }
+      break;
+    case NV_DS_SOURCE_AUDIO_WAV:
+      if (!create_audio_source_bin (config, sub_bin)) {
+        goto done;
+      }
+      break;
+    case NV_DS_SOURCE_AUDIO_URI:
+      if (!config->legacy_ingest &&
+          g_ascii_strncasecmp (config->uri, "http://", 7) == 0) {
+        if (!create_http_wav_src_bin (config, sub_bin)) {
+          goto done;
+        }
+        break;
+      }
+      if (!create_uridecode_src_bin_audio (config, sub_bin)) {
+        goto done;
+      }
+      bin->live_source = config->live_source;
+      break;
+    case NV_DS_SOURCE_ALSA_SRC:
+      if (!create_audio_source_bin (config, sub_bin)) {
+        goto done;
+      }
+      break;
+    case NV_DS_SOURCE_REMOTE_MEL:
+      if (!create_remote_mel_src_bin (config, sub_bin)) {
+        goto done;
+      }
+      break;
+    default:
+      NVGSTDS_ERR_MSG_V ("Source type not yet implemented!\n");
+      goto done;
+  }
+
+  gst_bin_add (GST_BIN (bin->bin), sub_bin->bin);
+
+  if (!link_element_to_streammux_sink_pad (bin->streammux,
+          sub_bin->bin, index)) {
+    NVGSTDS_ERR_MSG_V ("source %d cannot be linked to mux's sink pad %p\n", index, bin->streammux);
+    goto done;
+  }
+
+  if(config->dewarper_config.enable) {
+      g_object_set(G_OBJECT(sub_bin->dewarper_bin.nvdewarper), "source-id",
+              config->source_id, NULL);
+  }
+
+  if ((config->type == NV_DS_SOURCE_AUDIO_URI && config->live_source) ||
+      config->type == NV_DS_SOURCE_ALSA_SRC) {
+    if (!start_audio_source_watchdog (sub_bin)) {
+      goto done;
+    }
+  }
+
+  bin->num_bins++;
+  ret = TRUE;
+
+done:
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
 gboolean
 create_multi_source_bin (guint num_sub_bins, NvDsSourceConfig * configs,
     NvDsSrcParentBin * bin)
@@ -1440,85 +1867,95 @@ create_multi_source_bin (guint num_sub_bins, NvDsSourceConfig * configs,
       continue;
     }
 
-    gchar elem_name[50];
-    g_snprintf (elem_name, sizeof (elem_name), "src_sub_bin%d", i);
-    bin->sub_bins[i].bin = gst_bin_new (elem_name);
-    if (!bin->sub_bins[i].bin) {
-      NVGSTDS_ERR_MSG_V ("Failed to create '%s'", elem_name);
+    if (!create_source_sub_bin (&configs[i], i, bin)) {
       goto done;
     }
+  }
+  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->streammux, "src");
 
-    bin->sub_bins[i].bin_id = bin->sub_bins[i].source_id = i;
-    configs[i].live_source = TRUE;
-    bin->live_source = TRUE;
-    bin->sub_bins[i].eos_done = TRUE;
-    bin->sub_bins[i].reset_done = TRUE;
+  if (install_mux_eosmonitor_probe) {
+    NVGSTDS_ELEM_ADD_PROBE (bin->nvstreammux_eosmonitor_probe, bin->streammux,
+        "src", nvstreammux_eosmonitor_probe_func,
+        GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        bin);
+  }
 
-    bin->sub_bins[i].parent_bin = bin;
+  ret = TRUE;
 
-    switch (configs[i].type) {
-      case NV_DS_SOURCE_CAMERA_CSI:
-      case NV_DS_SOURCE_CAMERA_V4L2:
-        if (!create_camera_source_bin (&configs[i], &bin->sub_bins[i])) {
-          return FALSE;
-        }
-        break;
-      case NV_DS_SOURCE_URI:
-        if (!create_uridecode_src_bin (&configs[i], &bin->sub_bins[i])) {
-          return FALSE;
-        }
-        bin->live_source = configs[i].live_source;
-        break;
-      case NV_DS_SOURCE_RTSP:
-        if (!create_rtsp_src_bin (&configs[i], &bin->sub_bins[i])) {
-          return FALSE;
-        }
-        break;
-      case NV_DS_SOURCE_AUDIO_WAV:
-        if (!create_audio_source_bin (&configs[i], &bin->sub_bins[i])) {
-          return FALSE;
-        }
-        break;
-      case NV_DS_SOURCE_AUDIO_URI:
-        if (!create_uridecode_src_bin_audio (&configs[i], &bin->sub_bins[i])) {
-          return FALSE;
-        }
-        bin->live_source = configs->live_source;
-        break;
-      case NV_DS_SOURCE_ALSA_SRC:
-        if (!create_audio_source_bin (&configs[i], &bin->sub_bins[i])) {
-          return FALSE;
-        }
-        break;
-      default:
-        NVGSTDS_ERR_MSG_V ("Source type not yet implemented!\n");
-        return FALSE;
-    }
+done:
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
 
-    gst_bin_add (GST_BIN (bin->bin), bin->sub_bins[i].bin);
+gboolean
+add_source_to_multi_source_bin (NvDsSrcParentBin * bin,
+    NvDsSourceConfig * config, guint index)
+{
+  gboolean ret = FALSE;
 
-    if (!link_element_to_streammux_sink_pad (bin->streammux,
-            bin->sub_bins[i].bin, i)) {
-      NVGSTDS_ERR_MSG_V ("source %d cannot be linked to mux's sink pad %p\n", i, bin->streammux);
-      goto done;
-    }
+  if (index >= MAX_SOURCE_BINS || bin->sub_bins[index].bin) {
+    NVGSTDS_ERR_MSG_V ("Source slot %u is not free", index);
+    goto done;
+  }
 
-    if(configs->dewarper_config.enable) {
-        g_object_set(G_OBJECT(bin->sub_bins[i].dewarper_bin.nvdewarper), "source-id",
-                configs[i].source_id, NULL);
-    }
+  if (!create_source_sub_bin (config, index, bin)) {
+    goto done;
+  }
 
-    bin->num_bins++;
+  if (!gst_element_sync_state_with_parent (bin->sub_bins[index].bin)) {
+    NVGSTDS_ERR_MSG_V ("Couldn't sync state of source %u with parent", index);
+    goto done;
   }
-  NVGSTDS_BIN_ADD_GHOST_PAD (bin->bin, bin->streammux, "src");
 
-  if (install_mux_eosmonitor_probe) {
-    NVGSTDS_ELEM_ADD_PROBE (bin->nvstreammux_eosmonitor_probe, bin->streammux,
-        "src", nvstreammux_eosmonitor_probe_func,
-        GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
-        bin);
+  ret = TRUE;
+
+done:
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+gboolean
+remove_source_from_multi_source_bin (NvDsSrcParentBin * bin, guint index)
+{
+  NvDsSrcBin *sub_bin;
+  GstPad *mux_sink_pad = NULL;
+  gboolean ret = FALSE;
+  gchar pad_name[16];
+
+  if (index >= MAX_SOURCE_BINS || !bin->sub_bins[index].bin) {
+    NVGSTDS_ERR_MSG_V ("No source in slot %u", index);
+    goto done;
+  }
+  sub_bin = &bin->sub_bins[index];
+
+  if (sub_bin->watchdog_id) {
+    g_source_remove (sub_bin->watchdog_id);
+    sub_bin->watchdog_id = 0;
+  }
+
+  if (gst_element_set_state (sub_bin->bin,
+          GST_STATE_NULL) == GST_STATE_CHANGE_FAILURE) {
+    NVGSTDS_ERR_MSG_V ("Can't set source %u to NULL", index);
+    goto done;
   }
 
+  /* Let the muxer drop what it holds of the source before the pad goes. */
+  g_snprintf (pad_name, sizeof (pad_name), "sink_%u", index);
+  mux_sink_pad = gst_element_get_static_pad (bin->streammux, pad_name);
+  if (mux_sink_pad) {
+    gst_pad_send_event (mux_sink_pad, gst_event_new_flush_stop (FALSE));
+    gst_element_release_request_pad (bin->streammux, mux_sink_pad);
+    gst_object_unref (mux_sink_pad);
+  }
+
+  gst_bin_remove (GST_BIN (bin->bin), sub_bin->bin);
+  memset (sub_bin, 0, sizeof (*sub_bin));
+  bin->num_bins--;
+
   ret = TRUE;
 
 done:
@@ -1528,6 +1965,27 @@ done:
   return ret;
 }
 
+gboolean
+handle_source_error (NvDsSrcParentBin * bin, GstObject * src)
+{
+  guint i;
+
+  for (i = 0; i < MAX_SOURCE_BINS; i++) {
+    NvDsSrcBin *sub_bin = &bin->sub_bins[i];
+
+    if (!sub_bin->watchdog_id || !src ||
+        (src != GST_OBJECT (sub_bin->bin) &&
+            !gst_object_has_as_ancestor (src, GST_OBJECT (sub_bin->bin))))
+      continue;
+
+    g_mutex_lock (&sub_bin->bin_lock);
+    sub_bin->source_error = TRUE;
+    g_mutex_unlock (&sub_bin->bin_lock);
+    return TRUE;
+  }
+  return FALSE;
+}
+
 gboolean
 reset_source_pipeline (gpointer data)
 {
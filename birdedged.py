@@ -5,7 +5,9 @@ import configparser
 import io
 import json
 import logging
+import re
 import signal
+import socket
 import subprocess
 import time
 import threading
@@ -116,6 +118,9 @@ class BirdEdgeDaemon(ServiceListener):
         self.process: subprocess.Popen = None
         self.last_restart_ts = None
         self.running = False
+        # sources the running process batches together, and its source ids
+        self.process_batch_size = 0
+        self.source_uris = {}
 
         # initialize zeroconf
         self.browser = ServiceBrowser(Zeroconf(), "_birdedge._tcp.local.", self)
@@ -132,6 +137,14 @@ class BirdEdgeDaemon(ServiceListener):
         self.config.add_section(f"source{i}")
         return f"source{i}"
 
+    def active_streams(self):
+        active_streams = 0
+        for name, section in self.config.items():
+            if name.startswith("source"):
+                if "1" in section.get("enable"):
+                    active_streams += 1
+        return active_streams
+
     def restart_classification(self):
         if self.last_restart_ts is None:
             return
@@ -139,6 +152,16 @@ class BirdEdgeDaemon(ServiceListener):
         if self.process is None:
             return
 
+        # a running process swaps its sources without reloading the model
+        if not self.simulate and self.process.poll() is None \
+                and self.active_streams() <= self.process_batch_size:
+            self.write_config()
+            if self.update_sources():
+                return
+            logging.info("Reloading sources of classification process.")
+            self.process.send_signal(signal.SIGHUP)
+            return
+
         restart_wait_s = self.restart_interval - (time.time() - self.last_restart_ts)
         if restart_wait_s <= 0:
             logging.info("Restart classification process.")
@@ -147,6 +170,32 @@ class BirdEdgeDaemon(ServiceListener):
             logging.info("Restarting classification process in %d seconds.", restart_wait_s)
             threading.Timer(restart_wait_s, self.restart_classification).start()
 
+    def control_socket_path(self):
+        return self.export_path + ".sock"
+
+    def update_sources(self):
+        """Attach and detach sources through the control socket of the running process."""
+        uris = [section.get("uri") for name, section in self.config.items()
+                if name.startswith("source") and "1" in section.get("enable")]
+        commands = [f"remove {source_id}" for source_id, uri in list(self.source_uris.items()) if uri not in uris]
+        commands += [f"add 7 {uri}" for uri in uris if uri not in list(self.source_uris.values())]
+
+        try:
+            with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as control:
+                control.settimeout(10)
+                control.connect(self.control_socket_path())
+                replies = control.makefile("r", encoding="utf-8")
+                for command in commands:
+                    control.sendall(f"{command}\n".encode())
+                    reply = replies.readline().strip()
+                    logging.info("%s: %s", command, reply)
+                    if not reply.startswith("OK"):
+                        return False
+        except OSError as e:
+            logging.warning("Control socket unavailable: %s", e)
+            return False
+        return True
+
     def add_service(self, zc: Zeroconf, type_: str, name: str) -> None:
         info = zc.get_service_info(type_, name)
         logging.debug("Discovered %s", info)
@@ -183,28 +232,38 @@ class BirdEdgeDaemon(ServiceListener):
         logging.debug("Writing config to %s", self.export_path)
 
         # get number of active streams
-        active_streams = 0
-        for name, section in self.config.items():
-            if name.startswith("source"):
-                if "1" in section.get("enable"):
-                    active_streams += 1
+        active_streams = self.active_streams()
 
         # adapt batch-sizes
         self.config.set("streammux", "batch-size", str(active_streams))
-        self.config.set("audio-classifier", "batch-size", str(active_streams))
+        # with a batch deadline the classifier batch is independent of the sources
+        if not self.config.has_option("audio-classifier", "batch-deadline-ms"):
+            self.config.set("audio-classifier", "batch-size", str(active_streams))
+        # sources are attached and detached through the control socket
+        if self.config.has_section("application"):
+            self.config.set("application", "control-socket", self.control_socket_path())
 
         # writing config file
         with open(self.export_path, "wt", encoding="utf-8") as export_file:
             self.config.write(export_file)
 
     def publish_classification(self, json_data):
-        if json_data["label"].strip() in ["", "00_background"]:
+        # with top-k every species of the window above top-k-threshold
+        if "top" in json_data:
+            results = [(entry["label"], entry["score"]) for entry in json_data["top"]]
+        else:
+            results = [(json_data["label"], json_data["confidence"])]
+        results = [(label.strip(), score) for label, score in results if label.strip() not in ["", "00_background"]]
+        if not results:
             return
 
-        uri = self.config.get(f"source{json_data['source_id']}", "uri")
+        uri = self.source_uris.get(json_data["source_id"])
+        if uri is None:
+            uri = self.config.get(f"source{json_data['source_id']}", "uri")
         station = uri[7:].split(":")[0]
 
-        self.mqtt_c.add([json_data["timestamp"], station, json_data["label"].strip(), json_data['confidence']])
+        for label, score in results:
+            self.mqtt_c.add([json_data["timestamp"], station, label, score])
 
     def run(self):
         self.running = True
@@ -213,6 +272,8 @@ class BirdEdgeDaemon(ServiceListener):
             logging.debug("Writing config and running classification process.")
             self.last_restart_ts = time.time()
             self.write_config()
+            self.process_batch_size = self.active_streams()
+            self.source_uris = {}
 
             if self.simulate:
                 self.process = subprocess.Popen(
@@ -238,6 +299,14 @@ class BirdEdgeDaemon(ServiceListener):
                     self.publish_classification(json_data)
                     continue
 
+                # source ids stay stable while sources come and go
+                match = re.match(r"Source (\d+) attached: (\S+)", line)
+                if match:
+                    self.source_uris[int(match.group(1))] = match.group(2)
+                match = re.match(r"Source (\d+) detached", line)
+                if match:
+                    self.source_uris.pop(int(match.group(1)), None)
+
                 # add message to respective logging level
                 if line.startswith("WARNING: "):
                     logging.warning(line[9:])
@@ -248,17 +317,8 @@ class BirdEdgeDaemon(ServiceListener):
                 else:
                     logging.info(line)
 
-                # disable connection, if
-                if line.startswith("Could not connect") or line.startswith("Error resolving"):
-                    err = {el.split(":")[0].strip(): ":".join(el.split(":")[1:]).strip()
-                           for el in line.split(",")}
-                    source = self.get_source(err["URL"])
-
-                    logging.error("Disabling source %s", err["URL"])
-                    self.config.set(source, "enable", "0")
-
-                    # restart running classification process
-                    self.restart_classification()
+                # unreachable sources are reconnected with backoff by
+                # birdedge itself; see the "stats" control socket command
 
     def terminate(self, sig, frame):
         self.running = False
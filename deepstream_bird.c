@@ -26,6 +26,8 @@
 #include <stdlib.h>
 
 #include "deepstream_bird.h"
+#include "deepstream_config_file_parser.h"
+#include "deepstream_audio_topk.h"
 
 #define MAX_DISPLAY_LEN 64
 
@@ -103,6 +105,19 @@ bus_callback (GstBus * bus, GstMessage * message, gpointer data)
       GError *error = NULL;
       gchar *debuginfo = NULL;
       gst_message_parse_error (message, &error, &debuginfo);
+      /* Failed live audio sources are reset by their watchdog while the
+       * others keep running. */
+      if (handle_source_error (&appCtx->pipeline.multi_src_bin,
+              message->src)) {
+        g_printerr ("WARNING from %s: %s\n",
+            GST_OBJECT_NAME (message->src), error->message);
+        if (debuginfo) {
+          g_printerr ("Debug info: %s\n", debuginfo);
+        }
+        g_error_free (error);
+        g_free (debuginfo);
+        break;
+      }
       g_printerr ("ERROR from %s: %s\n",
           GST_OBJECT_NAME (message->src), error->message);
       if (debuginfo) {
@@ -276,9 +291,9 @@ done:
 static GstPadProbeReturn
 analytics_done_buf_prob (GstPad * pad, GstPadProbeInfo * info, gpointer u_data)
 {
-  NvDsInstanceBin *bin = (NvDsInstanceBin *) u_data;
-  guint index = bin->index;
-  AppCtx *appCtx = bin->appCtx;
+  NvDsModelBranch *branch = (NvDsModelBranch *) u_data;
+  guint index = branch->model_id;
+  AppCtx *appCtx = branch->instance->appCtx;
   GstBuffer *buf = (GstBuffer *) info->data;
   NvDsBatchMeta *batch_meta = gst_buffer_get_nvds_batch_meta (buf);
   if (!batch_meta) {
@@ -286,6 +301,42 @@ analytics_done_buf_prob (GstPad * pad, GstPadProbeInfo * info, gpointer u_data)
     return GST_PAD_PROBE_OK;
   }
 
+  /* nvinferaudio leaves the scores in its output tensor meta; the CPU
+   * backend attaches the top-k meta itself. */
+  if (branch->config->top_k) {
+    NvDsMetaList *l_frame;
+
+    for (l_frame = batch_meta->frame_meta_list; l_frame;
+        l_frame = l_frame->next) {
+      NvDsAudioFrameMeta *frame_meta = (NvDsAudioFrameMeta *) l_frame->data;
+
+      if (nvds_audio_topk_get_meta (frame_meta))
+        continue;
+      if (!nvds_audio_topk_attach_from_tensor_meta (batch_meta, frame_meta,
+              branch->config->top_k, branch->config->top_k_threshold,
+              branch->classifier_bin.labels) &&
+          !branch->tensor_meta_missing) {
+        NVGSTDS_WARN_MSG_V ("Model %u: no FP32 output tensor meta for top-k;"
+            " set output-tensor-meta=1 in its config-file", index);
+        branch->tensor_meta_missing = TRUE;
+      }
+    }
+  }
+
+  /* The primary model's results pace the front-end's adaptive hop. */
+  if (index == 0 && appCtx->config.audio_frontend_config.adaptive_hop) {
+    NvDsMetaList *l_frame;
+
+    for (l_frame = batch_meta->frame_meta_list; l_frame;
+        l_frame = l_frame->next) {
+      NvDsAudioFrameMeta *frame_meta = (NvDsAudioFrameMeta *) l_frame->data;
+
+      nvds_audio_frontend_report_result (
+          &appCtx->pipeline.common_elements.audio_frontend_bin,
+          frame_meta->source_id, frame_meta->class_label);
+    }
+  }
+
   if (appCtx->bbox_generated_post_analytics_cb)
   {
     appCtx->bbox_generated_post_analytics_cb (appCtx, buf, batch_meta, index);
@@ -294,6 +345,25 @@ analytics_done_buf_prob (GstPad * pad, GstPadProbeInfo * info, gpointer u_data)
    
 }
 
+/**
+ * Buffer probe on the sink pad of each CPU model branch. The tee hands the
+ * same buffer to every branch; the CPU classifier writes its results into
+ * the frame meta from a pad probe, so its branch gets its own copy of the
+ * buffer and its batch meta. The audio memory itself is shared.
+ * nvinferaudio needs no probe: as an in-place transform it makes the
+ * buffer writable itself, copying it only while other branches hold it.
+ */
+static GstPadProbeReturn
+model_branch_copy_buf_prob (GstPad * pad, GstPadProbeInfo * info,
+    gpointer u_data)
+{
+  GstBuffer *buf = (GstBuffer *) info->data;
+
+  info->data = gst_buffer_copy (buf);
+  gst_buffer_unref (buf);
+  return GST_PAD_PROBE_OK;
+}
+
 /**
  * Function to create common elements(Primary infer, tracker, secondary infer)
  * of the pipeline. These components operate on muxed data from all the
@@ -308,30 +378,167 @@ create_common_elements (NvDsConfig * config, NvDsPipeline * pipeline,
   gboolean ret = FALSE;
   *sink_elem = *src_elem = NULL;
 
+  /** One branch per model, all classifying the same batches:
+   *  model_tee -> nvinferaudio (model 0 .. N) -> funnel
+   *  A single model without activity gate or detector needs neither tee nor
+   *  funnel. */
   if (config->audio_classifier_config.enable) {
-    if (!create_audio_classifier_bin (&config->audio_classifier_config,
-            &pipeline->common_elements.audio_classifier_bin)) {
+    NvDsInstanceBin *common = &pipeline->common_elements;
+    guint num_models = 1 + config->num_audio_classifier_sub_bins;
+    GstElement *funnel = NULL;
+    guint i;
+
+    for (i = 0; i < num_models; i++) {
+      NvDsModelBranch *branch = &common->model_branches[i];
+      NvDsGieConfig *gie_config = i ?
+          &config->audio_classifier_sub_bin_config[i - 1] :
+          &config->audio_classifier_config;
+
+      branch->model_id = i ? config->audio_classifier_sub_bin_id[i - 1] : 0;
+      branch->config = gie_config;
+      branch->instance = common;
+      if (!create_audio_classifier_sub_bin (gie_config,
+              &branch->classifier_bin, branch->model_id)) {
+        goto done;
+      }
+      gst_bin_add (GST_BIN (pipeline->pipeline), branch->classifier_bin.bin);
+
+      /** Add the buffer probe on nvinferaudio's src pad */
+      NVGSTDS_ELEM_ADD_PROBE (branch->buffer_probe_id,
+          branch->classifier_bin.bin, "src",
+          analytics_done_buf_prob, GST_PAD_PROBE_TYPE_BUFFER, branch);
+    }
+    common->num_model_branches = num_models;
+
+    if (config->activity_gate_config.enable) {
+      NvDsActivityGateBin *gate = &common->activity_gate_bin;
+
+      if (!create_activity_gate_bin (&config->activity_gate_config, gate)) {
+        goto done;
+      }
+      gst_bin_add_many (GST_BIN (pipeline->pipeline), gate->bin, gate->funnel,
+          NULL);
+      funnel = gate->funnel;
+    } else if (num_models > 1 || config->audio_detector_config.enable) {
+      common->model_funnel =
+          gst_element_factory_make (NVDS_ELEM_FUNNEL, "model_funnel");
+      if (!common->model_funnel) {
+        NVGSTDS_ERR_MSG_V ("Failed to create element 'model_funnel'");
+        goto done;
+      }
+      gst_bin_add (GST_BIN (pipeline->pipeline), common->model_funnel);
+      funnel = common->model_funnel;
+    }
+
+    if (num_models > 1) {
+      common->model_tee = gst_element_factory_make (NVDS_ELEM_TEE, "model_tee");
+      if (!common->model_tee) {
+        NVGSTDS_ERR_MSG_V ("Failed to create element 'model_tee'");
+        goto done;
+      }
+      gst_bin_add (GST_BIN (pipeline->pipeline), common->model_tee);
+      /** The queue at the head of each classifier bin decouples the models.
+       *  CPU models share the windows of the audio front-end; nvinferaudio
+       *  computes its own spectrogram from the shared audio. */
+      for (i = 0; i < num_models; i++) {
+        NvDsModelBranch *branch = &common->model_branches[i];
+
+        NVGSTDS_LINK_ELEMENT (common->model_tee, branch->classifier_bin.bin);
+        if (branch->config->plugin_type != NV_DS_GIE_PLUGIN_CPU)
+          continue;
+        NVGSTDS_ELEM_ADD_PROBE (branch->copy_probe_id,
+            branch->classifier_bin.bin, "sink",
+            model_branch_copy_buf_prob, GST_PAD_PROBE_TYPE_BUFFER, branch);
+      }
+      *sink_elem = common->model_tee;
+    } else {
+      *sink_elem = common->model_branches[0].classifier_bin.bin;
+    }
+
+    if (funnel) {
+      for (i = 0; i < num_models; i++) {
+        NVGSTDS_LINK_ELEMENT (common->model_branches[i].classifier_bin.bin,
+            funnel);
+      }
+      *src_elem = funnel;
+    } else {
+      *src_elem = common->model_branches[0].classifier_bin.bin;
+    }
+
+    /** detector -> models -> funnel
+     *  detector (skip_src) -> funnel, reported as model 0 */
+    if (config->audio_detector_config.enable) {
+      NvDsCascadeBin *cascade = &common->cascade_bin;
+      NvDsGieConfig *gie_config = &config->audio_classifier_config;
+
+      if (gie_config->is_operate_on_gie_id_set &&
+          (!config->audio_detector_config.is_unique_id_set ||
+              gie_config->operate_on_gie_id !=
+              (gint) config->audio_detector_config.unique_id)) {
+        NVGSTDS_WARN_MSG_V ("[audio-classifier] operate-on-gie-id %d is not"
+            " the gie-unique-id of [audio-detector]",
+            gie_config->operate_on_gie_id);
+      }
+      /* Stage two works on the feature windows; it can skip single sources
+       * if only one model is there to report the others. */
+      if (!create_cascade_bin (&config->audio_detector_config,
+              gie_config->list_operate_on_class_ids,
+              gie_config->num_operate_on_class_ids, num_models == 1,
+              cascade)) {
+        goto done;
+      }
+      gst_bin_add (GST_BIN (pipeline->pipeline), cascade->bin);
+      NVGSTDS_LINK_ELEMENT (cascade->bin, *sink_elem);
+      if (!gst_element_link_pads (cascade->bin, "skip_src", funnel, NULL)) {
+        NVGSTDS_ERR_MSG_V ("Failed to link 'cascade_bin' and '%s'",
+            GST_ELEMENT_NAME (funnel));
+        goto done;
+      }
+      NVGSTDS_ELEM_ADD_PROBE (common->cascade_skip_buffer_probe_id,
+          cascade->bin, "skip_src",
+          analytics_done_buf_prob, GST_PAD_PROBE_TYPE_BUFFER,
+          &common->model_branches[0]);
+      *sink_elem = cascade->bin;
+    }
+
+    /** activity gate -> models -> funnel
+     *  activity gate (skip_src) -> funnel, reported as model 0 */
+    if (config->activity_gate_config.enable) {
+      NvDsActivityGateBin *gate = &common->activity_gate_bin;
+
+      NVGSTDS_LINK_ELEMENT (gate->bin, *sink_elem);
+      if (!gst_element_link_pads (gate->bin, "skip_src", gate->funnel, NULL)) {
+        NVGSTDS_ERR_MSG_V ("Failed to link 'activity_gate_bin' and '%s'",
+            GST_ELEMENT_NAME (gate->funnel));
+        goto done;
+      }
+      NVGSTDS_ELEM_ADD_PROBE (common->skip_buffer_probe_id,
+          gate->bin, "skip_src",
+          analytics_done_buf_prob, GST_PAD_PROBE_TYPE_BUFFER,
+          &common->model_branches[0]);
+      *sink_elem = gate->bin;
+    }
+  }
+
+  /** streammux -> audio front-end [-> nvinferaudio] */
+  if (config->audio_frontend_config.enable) {
+    if (!create_audio_frontend_bin (&config->audio_frontend_config,
+            &pipeline->common_elements.audio_frontend_bin)) {
       goto done;
     }
     gst_bin_add (GST_BIN (pipeline->pipeline),
-        pipeline->common_elements.audio_classifier_bin.bin);
+        pipeline->common_elements.audio_frontend_bin.bin);
     if (*sink_elem) {
-      NVGSTDS_LINK_ELEMENT (pipeline->common_elements.audio_classifier_bin.bin,
+      NVGSTDS_LINK_ELEMENT (pipeline->common_elements.audio_frontend_bin.bin,
           *sink_elem);
     }
-    *sink_elem = pipeline->common_elements.audio_classifier_bin.bin;
+    *sink_elem = pipeline->common_elements.audio_frontend_bin.bin;
     if (!*src_elem) {
-      *src_elem = pipeline->common_elements.audio_classifier_bin.bin;
+      *src_elem = pipeline->common_elements.audio_frontend_bin.bin;
     }
+  }
 
-    /** Add the buffer probe on nvinferaudio's src pad */
-    NVGSTDS_ELEM_ADD_PROBE (pipeline->common_elements.
-          primary_bbox_buffer_probe_id,
-          *src_elem, "src",
-          analytics_done_buf_prob, GST_PAD_PROBE_TYPE_BUFFER,
-          &pipeline->common_elements);
-    
-
+  if (*src_elem) {
     /** Now create a tee; Done
      * nvinferaudio -> tee; Done
      * src_elem = tee; Done */
@@ -353,6 +560,55 @@ done:
   return ret;
 }
 
+/**
+ * CPU models classify the windows of the audio front-end, which are cut
+ * with the [audio-classifier] transform.
+ */
+static gboolean
+check_cpu_model (NvDsConfig * config, NvDsGieConfig * gie_config,
+    const gchar * name)
+{
+  if (!gie_config->enable || gie_config->plugin_type != NV_DS_GIE_PLUGIN_CPU)
+    return TRUE;
+  if (!config->audio_frontend_config.enable) {
+    NVGSTDS_ERR_MSG_V ("plugin-type %u needs an enabled [audio-frontend]"
+        " group", NV_DS_GIE_PLUGIN_CPU);
+    return FALSE;
+  }
+  if (gie_config->frame_size != config->audio_classifier_config.frame_size ||
+      g_strcmp0 (gie_config->audio_transform,
+          config->audio_classifier_config.audio_transform)) {
+    NVGSTDS_ERR_MSG_V ("%s must use the audio-framesize and audio-transform"
+        " of [audio-classifier]", name);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * Elements that withhold windows from the classifiers need CPU models,
+ * which classify the front-end windows of the batches they get.
+ * nvinferaudio cuts its windows from the audio of every buffer and would
+ * join the audio around the withheld ones.
+ */
+static gboolean
+check_classifiers_skippable (NvDsConfig * config, const gchar * name)
+{
+  for (guint i = 0; i <= config->num_audio_classifier_sub_bins; i++) {
+    NvDsGieConfig *gie_config = i ?
+        &config->audio_classifier_sub_bin_config[i - 1] :
+        &config->audio_classifier_config;
+
+    if (gie_config->plugin_type != NV_DS_GIE_PLUGIN_CPU) {
+      NVGSTDS_ERR_MSG_V ("%s only works with the CPU backend; set"
+          " plugin-type=%u in all [audio-classifier] groups", name,
+          NV_DS_GIE_PLUGIN_CPU);
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
 /**
  * Main function to create the pipeline.
  */
@@ -400,6 +656,95 @@ create_pipeline (AppCtx * appCtx, perf_callback perf_cb,
            = config->audio_classifier_config.input_audio_rate;
   }
 
+  for (guint i = 0; i < config->num_source_sub_bins; i++) {
+    if (!config->multi_source_config[i].enable ||
+        config->multi_source_config[i].type != NV_DS_SOURCE_REMOTE_MEL)
+      continue;
+    /** Remote sources deliver mel columns and placeholder audio only. */
+    if (!config->audio_frontend_config.enable) {
+      NVGSTDS_ERR_MSG_V ("Remote mel source %u needs an enabled"
+          " [audio-frontend] group", i);
+      goto done;
+    }
+    if (config->audio_classifier_config.enable &&
+        config->audio_classifier_config.plugin_type != NV_DS_GIE_PLUGIN_CPU) {
+      NVGSTDS_WARN_MSG_V ("Source %u: nvinferaudio computes its features from"
+          " audio; remote mel columns reach the [audio-frontend] feature"
+          " meta only\n", i);
+    }
+  }
+
+  if (config->num_audio_classifier_sub_bins &&
+      !config->audio_classifier_config.enable) {
+    NVGSTDS_ERR_MSG_V ("[audio-classifier-<N>] groups need an enabled "
+        "[audio-classifier] group");
+    goto done;
+  }
+
+  /** All models classify the same batches of the same sources. */
+  for (guint i = 0; i < config->num_audio_classifier_sub_bins; i++) {
+    NvDsGieConfig *sub_config = &config->audio_classifier_sub_bin_config[i];
+
+    if (sub_config->input_audio_rate &&
+        sub_config->input_audio_rate !=
+        config->audio_classifier_config.input_audio_rate) {
+      NVGSTDS_WARN_MSG_V ("[audio-classifier-%u] audio-input-rate %u ignored;"
+          " all models use %u Hz\n", config->audio_classifier_sub_bin_id[i],
+          sub_config->input_audio_rate,
+          config->audio_classifier_config.input_audio_rate);
+    }
+    sub_config->input_audio_rate =
+        config->audio_classifier_config.input_audio_rate;
+  }
+
+  if (config->audio_detector_config.enable) {
+    if (!config->audio_classifier_config.enable) {
+      NVGSTDS_ERR_MSG_V ("[audio-detector] needs an enabled "
+          "[audio-classifier] group");
+      goto done;
+    }
+    config->audio_detector_config.input_audio_rate =
+        config->audio_classifier_config.input_audio_rate;
+    if (!check_cpu_model (config, &config->audio_detector_config,
+            "[audio-detector]"))
+      goto done;
+    /** Batches without detection do not reach stage two. */
+    if (!check_classifiers_skippable (config, "[audio-detector]"))
+      goto done;
+  }
+
+  if (config->activity_gate_config.enable &&
+      config->audio_classifier_config.enable) {
+    if (!check_classifiers_skippable (config, "[activity-gate]"))
+      goto done;
+    if (config->audio_detector_config.enable &&
+        config->audio_detector_config.plugin_type != NV_DS_GIE_PLUGIN_CPU) {
+      NVGSTDS_ERR_MSG_V ("[activity-gate] only works with the CPU backend;"
+          " set plugin-type=%u in [audio-detector]", NV_DS_GIE_PLUGIN_CPU);
+      goto done;
+    }
+  }
+
+  for (guint i = 0; i <= config->num_audio_classifier_sub_bins; i++) {
+    gchar name[32];
+
+    g_snprintf (name, sizeof (name), "CPU model %u",
+        i ? config->audio_classifier_sub_bin_id[i - 1] : 0);
+    if (!check_cpu_model (config, i ?
+            &config->audio_classifier_sub_bin_config[i - 1] :
+            &config->audio_classifier_config, name))
+      goto done;
+  }
+
+  config->audio_frontend_config.frame_size =
+      config->audio_classifier_config.frame_size;
+  config->audio_frontend_config.hop_size =
+      config->audio_classifier_config.hop_size;
+  config->audio_frontend_config.audio_transform =
+      config->audio_classifier_config.audio_transform;
+  config->activity_gate_config.frame_size =
+      config->audio_classifier_config.frame_size;
+
 #if 0
   if (!create_audio_source_bin(&config->source_config, &pipeline->src_bin))
     goto done;
@@ -414,6 +759,11 @@ create_pipeline (AppCtx * appCtx, perf_callback perf_cb,
     goto done;
   gst_bin_add (GST_BIN (pipeline->pipeline), pipeline->multi_src_bin.bin);
 
+  for (guint i = 0; i < config->num_source_sub_bins; i++) {
+    if (pipeline->multi_src_bin.sub_bins[i].bin)
+      g_print ("Source %u attached: %s\n", i,
+          config->multi_source_config[i].uri);
+  }
 
   if (config->streammux_config.is_parsed)
     set_streammux_properties (&config->streammux_config,
@@ -514,6 +864,14 @@ destroy_pipeline (AppCtx * appCtx)
   g_mutex_unlock (&appCtx->app_lock);
 
   destroy_sink_bin ();
+  destroy_audio_frontend_bin (&appCtx->pipeline.common_elements.
+      audio_frontend_bin);
+  destroy_cascade_bin (&appCtx->pipeline.common_elements.cascade_bin);
+  for (guint i = 0; i < appCtx->pipeline.common_elements.num_model_branches;
+      i++) {
+    destroy_audio_classifier_bin (&appCtx->pipeline.common_elements.
+        model_branches[i].classifier_bin);
+  }
 
   if (appCtx->pipeline.pipeline) {
     bus = gst_pipeline_get_bus (GST_PIPELINE (appCtx->pipeline.pipeline));
@@ -580,3 +938,245 @@ resume_pipeline (AppCtx * appCtx)
     return FALSE;
   }
 }
+
+/** Sources that can be added and removed while the pipeline runs. */
+static gboolean
+source_is_hot_swappable (NvDsSourceConfig *config)
+{
+  switch (config->type) {
+    case NV_DS_SOURCE_AUDIO_WAV:
+    case NV_DS_SOURCE_AUDIO_URI:
+    case NV_DS_SOURCE_ALSA_SRC:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+static gboolean
+same_source (NvDsSourceConfig *a, NvDsSourceConfig *b)
+{
+  return a->type == b->type && !g_strcmp0 (a->uri, b->uri) &&
+      !g_strcmp0 (a->alsa_device, b->alsa_device);
+}
+
+/** URI of a source, the device of ALSA sources. */
+static const gchar *
+source_name (NvDsSourceConfig *config)
+{
+  return config->uri ? config->uri : config->alsa_device;
+}
+
+gint
+attach_source (AppCtx * appCtx, NvDsSourceConfig * source, gint source_id)
+{
+  NvDsConfig *config = &appCtx->config;
+  NvDsPipeline *pipeline = &appCtx->pipeline;
+  NvDsSrcParentBin *src_bin = &pipeline->multi_src_bin;
+  guint i = source_id;
+
+  if (!source_is_hot_swappable (source)) {
+    NVGSTDS_ERR_MSG_V ("Source %s of type %d can't be added at runtime",
+        source_name (source), source->type);
+    return -1;
+  }
+  if (source_id < 0) {
+    /* The lowest free slot; the IDs of the other sources don't change. */
+    for (i = 0; i < MAX_SOURCE_BINS && src_bin->sub_bins[i].bin; i++);
+    if (i == MAX_SOURCE_BINS) {
+      NVGSTDS_ERR_MSG_V ("App supports max %d sources", MAX_SOURCE_BINS);
+      return -1;
+    }
+  } else if (i >= MAX_SOURCE_BINS || src_bin->sub_bins[i].bin) {
+    NVGSTDS_ERR_MSG_V ("Source ID %d is not free", source_id);
+    return -1;
+  }
+
+  config->multi_source_config[i] = *source;
+  source->uri = NULL;
+  source->alsa_device = NULL;
+  if (config->file_loop)
+    config->multi_source_config[i].loop = TRUE;
+  config->multi_source_config[i].input_audio_rate =
+      config->audio_classifier_config.input_audio_rate;
+  config->num_source_sub_bins = MAX (config->num_source_sub_bins, i + 1);
+
+  /* The new source starts over at sample 0. */
+  if (config->audio_frontend_config.enable)
+    nvds_audio_frontend_reset_source (
+        &pipeline->common_elements.audio_frontend_bin, i);
+  if (config->activity_gate_config.enable)
+    nvds_activity_gate_reset_source (
+        &pipeline->common_elements.activity_gate_bin, i);
+
+  if (!add_source_to_multi_source_bin (src_bin,
+          &config->multi_source_config[i], i)) {
+    g_free (config->multi_source_config[i].uri);
+    g_free (config->multi_source_config[i].alsa_device);
+    memset (&config->multi_source_config[i], 0, sizeof (NvDsSourceConfig));
+    return -1;
+  }
+  g_print ("Source %u attached: %s\n", i,
+      source_name (&config->multi_source_config[i]));
+  return i;
+}
+
+gboolean
+detach_source (AppCtx * appCtx, guint source_id)
+{
+  NvDsSrcParentBin *src_bin = &appCtx->pipeline.multi_src_bin;
+  NvDsSourceConfig *running;
+
+  if (source_id >= MAX_SOURCE_BINS || !src_bin->sub_bins[source_id].bin) {
+    NVGSTDS_ERR_MSG_V ("No source %u", source_id);
+    return FALSE;
+  }
+  running = &appCtx->config.multi_source_config[source_id];
+  if (!source_is_hot_swappable (running)) {
+    NVGSTDS_ERR_MSG_V ("Source %u (%s) can't be removed at runtime",
+        source_id, source_name (running));
+    return FALSE;
+  }
+  if (!remove_source_from_multi_source_bin (src_bin, source_id))
+    return FALSE;
+  g_print ("Source %u detached: %s\n", source_id, source_name (running));
+  g_free (running->uri);
+  g_free (running->alsa_device);
+  memset (running, 0, sizeof (*running));
+  return TRUE;
+}
+
+gboolean
+reload_sources (AppCtx * appCtx, gchar * cfg_file_path)
+{
+  NvDsConfig *config = &appCtx->config;
+  NvDsPipeline *pipeline = &appCtx->pipeline;
+  NvDsSrcParentBin *src_bin = &pipeline->multi_src_bin;
+  NvDsSourceConfig *configs = g_new0 (NvDsSourceConfig, MAX_SOURCE_BINS);
+  gboolean kept[MAX_SOURCE_BINS] = { FALSE };
+  guint num_configs = 0;
+  guint num_added = 0, num_removed = 0;
+  gboolean ret = FALSE;
+  guint i, j;
+
+  if (!parse_config_file_sources (configs, &num_configs, cfg_file_path))
+    goto done;
+
+  /* Keep the running sources that are still configured, so that their
+   * source IDs and front-end state stay as they are. */
+  for (i = 0; i < MAX_SOURCE_BINS; i++) {
+    NvDsSourceConfig *running = &config->multi_source_config[i];
+
+    if (!src_bin->sub_bins[i].bin)
+      continue;
+    for (j = 0; j < num_configs; j++) {
+      if (!kept[j] && same_source (running, &configs[j]))
+        break;
+    }
+    if (j < num_configs) {
+      kept[j] = TRUE;
+      continue;
+    }
+    if (!source_is_hot_swappable (running)) {
+      NVGSTDS_WARN_MSG_V ("Source %u (%s) can't be removed at runtime;"
+          " restart to remove it\n", i, running->uri);
+      continue;
+    }
+    if (!detach_source (appCtx, i))
+      goto done;
+    num_removed++;
+  }
+
+  for (j = 0; j < num_configs; j++) {
+    if (kept[j])
+      continue;
+    if (!source_is_hot_swappable (&configs[j])) {
+      NVGSTDS_WARN_MSG_V ("Source %s can't be added at runtime;"
+          " restart to add it\n", configs[j].uri);
+      continue;
+    }
+    if (attach_source (appCtx, &configs[j], -1) < 0)
+      goto done;
+    num_added++;
+  }
+
+  NVGSTDS_INFO_MSG_V ("Sources reloaded: %u added, %u removed, %u running",
+      num_added, num_removed, src_bin->num_bins);
+  ret = TRUE;
+
+done:
+  for (j = 0; j < num_configs; j++) {
+    g_free (configs[j].uri);
+    g_free (configs[j].alsa_device);
+  }
+  g_free (configs);
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+/** Swap the model of one classifier if its group names other files. */
+static void
+reload_model (NvDsAudioClassifierBin * bin, NvDsGieConfig * gie_config,
+    const gchar * group, gchar * cfg_file_path)
+{
+  gchar *model_file = NULL;
+  gchar *label_file = NULL;
+  gboolean model_changed, labels_changed;
+
+  if (!parse_config_file_model (cfg_file_path, group, &model_file,
+          &label_file))
+    return;
+
+  model_changed = model_file &&
+      g_strcmp0 (model_file, gie_config->model_engine_file_path);
+  labels_changed = label_file &&
+      g_strcmp0 (label_file, gie_config->label_file_path);
+  if ((model_changed || labels_changed) &&
+      nvds_audio_classifier_swap_model (bin,
+          model_changed ? model_file : NULL,
+          labels_changed ? label_file : NULL)) {
+    NVGSTDS_INFO_MSG_V ("[%s]: swapping model", group);
+    if (model_changed) {
+      g_free (gie_config->model_engine_file_path);
+      gie_config->model_engine_file_path = model_file;
+      model_file = NULL;
+    }
+    if (labels_changed) {
+      g_free (gie_config->label_file_path);
+      gie_config->label_file_path = label_file;
+      label_file = NULL;
+    }
+  }
+  g_free (model_file);
+  g_free (label_file);
+}
+
+void
+reload_models (AppCtx * appCtx, gchar * cfg_file_path)
+{
+  NvDsConfig *config = &appCtx->config;
+  NvDsInstanceBin *common = &appCtx->pipeline.common_elements;
+  guint i;
+
+  for (i = 0; i < common->num_model_branches; i++) {
+    NvDsModelBranch *branch = &common->model_branches[i];
+    gchar group[64];
+
+    if (i) {
+      g_snprintf (group, sizeof (group), "%s-%u",
+          CONFIG_GROUP_AUDIO_CLASSIFIER, branch->model_id);
+    } else {
+      g_strlcpy (group, CONFIG_GROUP_AUDIO_CLASSIFIER, sizeof (group));
+    }
+    reload_model (&branch->classifier_bin, i ?
+        &config->audio_classifier_sub_bin_config[i - 1] :
+        &config->audio_classifier_config, group, cfg_file_path);
+  }
+
+  if (config->audio_detector_config.enable)
+    reload_model (&common->cascade_bin.detector,
+        &config->audio_detector_config, CONFIG_GROUP_AUDIO_DETECTOR,
+        cfg_file_path);
+}
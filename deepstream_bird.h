@@ -36,6 +36,9 @@ extern "C"
 #include "deepstream_config.h"
 #include "deepstream_perf.h"
 #include "deepstream_audio_classifier.h"
+#include "deepstream_audio_frontend.h"
+#include "deepstream_activity_gate.h"
+#include "deepstream_cascade.h"
 #include "deepstream_sinks.h"
 #include "deepstream_sources.h"
 #include "deepstream_streammux.h"
@@ -43,20 +46,50 @@ extern "C"
 
 typedef struct _AppCtx AppCtx;
 
+/** @p index is the model ID of the classifier that produced @p batch_meta. */
 typedef void (*bbox_generated_callback)(AppCtx *appCtx, GstBuffer *buf,
                                         NvDsBatchMeta *batch_meta, guint index);
 
+/** Maximum number of [audio-classifier-<N>] groups next to [audio-classifier]. */
+#define MAX_AUDIO_CLASSIFIER_SUB_BINS 8
+
+typedef struct _NvDsInstanceBin NvDsInstanceBin;
+
+/** One classifier model fed by the shared decode / front-end stages. */
 typedef struct
+{
+  /** 0 for [audio-classifier], N for [audio-classifier-N]. */
+  guint model_id;
+  gulong copy_probe_id;
+  gulong buffer_probe_id;
+  NvDsAudioClassifierBin classifier_bin;
+  NvDsGieConfig *config;
+  /** top-k: set once frames without output tensor meta were reported. */
+  gboolean tensor_meta_missing;
+  NvDsInstanceBin *instance;
+} NvDsModelBranch;
+
+struct _NvDsInstanceBin
 {
   guint index;
   gulong all_bbox_buffer_probe_id;
-  gulong primary_bbox_buffer_probe_id;
+  gulong skip_buffer_probe_id;
+  gulong cascade_skip_buffer_probe_id;
   GstElement *bin;
   GstElement *tee;
-  NvDsAudioClassifierBin audio_classifier_bin;
+  /** Fans the batches out to the model branches if there are several. */
+  GstElement *model_tee;
+  /** Merges the model branches and the cascade if there are several and no
+   *  activity gate. */
+  GstElement *model_funnel;
+  NvDsAudioFrontendBin audio_frontend_bin;
+  NvDsActivityGateBin activity_gate_bin;
+  NvDsCascadeBin cascade_bin;
+  NvDsModelBranch model_branches[MAX_AUDIO_CLASSIFIER_SUB_BINS + 1];
+  guint num_model_branches;
   NvDsSinkBin sink_bin;
   AppCtx *appCtx;
-} NvDsInstanceBin;
+};
 
 typedef struct
 {
@@ -73,16 +106,36 @@ typedef struct
 {
   gboolean enable_perf_measurement;
   gint file_loop;
+  gboolean audio_frontend_self_test;
+  gboolean audio_resampler_benchmark;
+  gchar *audio_tensor_format_test;
+  gchar *cpu_streaming_test;
+  gchar *remote_mel_sender;
+  guint remote_mel_sender_port;
+  guint http_wav_benchmark;
+  guint compressed_ingest_benchmark;
+  gboolean audio_clock_self_test;
   gboolean source_list_enabled;
   guint total_num_sources;
   guint num_source_sub_bins;
   guint num_sink_sub_bins;
   guint perf_measurement_interval_sec;
+  /** Path of the local control socket, NULL for none. */
+  gchar *control_socket;
 
   gchar **uri_list;
   NvDsSourceConfig multi_source_config[MAX_SOURCE_BINS];
   NvDsStreammuxConfig streammux_config;
   NvDsGieConfig audio_classifier_config;
+  /** Additional models classifying the same batches, in file order. */
+  NvDsGieConfig audio_classifier_sub_bin_config[MAX_AUDIO_CLASSIFIER_SUB_BINS];
+  /** N of group [audio-classifier-N], used as model ID. */
+  guint audio_classifier_sub_bin_id[MAX_AUDIO_CLASSIFIER_SUB_BINS];
+  guint num_audio_classifier_sub_bins;
+  /** Stage one of a cascade in front of the classifiers. */
+  NvDsGieConfig audio_detector_config;
+  NvDsAudioFrontendConfig audio_frontend_config;
+  NvDsActivityGateConfig activity_gate_config;
   NvDsSinkSubBinConfig sink_bin_sub_bin_config[MAX_SINK_BINS];
 } NvDsConfig;
 
@@ -114,7 +167,14 @@ typedef struct
     GMutex lock_stream_rtcp_sr;
     guint32 id;
     gint frameCount;
+    /** Latest window time; with @ref NvDsAudioClockMeta the recovered time
+     *  of the window's first sample. */
     GstClockTime last_ntp_time;
+    /** Results of windows with a gap, and windows reported twice. */
+    gint gapCount;
+    gint duplicateCount;
+    /** Attach time of the source the counters belong to. */
+    gint64 attach_time;
 } StreamSourceInfo;
 
 typedef struct
@@ -139,6 +199,64 @@ gboolean seek_pipeline (AppCtx * appCtx, glong milliseconds, gboolean seek_is_re
 void destroy_pipeline (AppCtx * appCtx);
 void restart_pipeline (AppCtx * appCtx);
 
+/**
+ * Apply the [source<N>] groups of a configuration file to the running
+ * pipeline. Sources no longer configured are removed, new ones are added in
+ * the lowest free source slots; the others keep running with their source
+ * IDs. The classifiers, their models and engines stay loaded. Only audio
+ * file, URI and ALSA sources are swapped; other changes need a restart.
+ *
+ * @param[in] appCtx application context of a running pipeline.
+ * @param[in] cfg_file_path path of configuration file.
+ *
+ * @return true if the sources were applied.
+ */
+gboolean reload_sources (AppCtx * appCtx, gchar * cfg_file_path);
+
+/**
+ * Swap the models of the running classifiers and detector whose groups name
+ * a different model-engine-file or labelfile-path than they were loaded
+ * with, see nvds_audio_classifier_swap_model(). Audio capture and the
+ * other models keep running.
+ *
+ * @param[in] appCtx application context of a running pipeline.
+ * @param[in] cfg_file_path path of configuration file.
+ */
+void reload_models (AppCtx * appCtx, gchar * cfg_file_path);
+
+/**
+ * Create source @p source_id of the running pipeline and attach it to the
+ * muxer. The other sources keep running and keep their IDs.
+ *
+ * @param[in] appCtx application context of a running pipeline.
+ * @param[in] source configuration of an audio file, URI or ALSA source; its
+ *            uri and alsa_device are taken over.
+ * @param[in] source_id free source ID, -1 for the lowest free one.
+ *
+ * @return source ID, -1 on error.
+ */
+gint attach_source (AppCtx * appCtx, NvDsSourceConfig * source,
+    gint source_id);
+
+/**
+ * Detach source @p source_id from the muxer of the running pipeline and
+ * destroy it. Its ID is free for the next source.
+ */
+gboolean detach_source (AppCtx * appCtx, guint source_id);
+
+/** Local control socket of a running pipeline. */
+typedef struct _NvDsControl NvDsControl;
+
+/**
+ * Listen on the unix socket @p path for line based commands that attach
+ * and detach sources at runtime, see deepstream_bird_control.c. Runs in the
+ * default main context.
+ *
+ * @return NULL if the socket can't be created.
+ */
+NvDsControl *start_control_socket (AppCtx * appCtx, const gchar * path);
+void stop_control_socket (NvDsControl * control);
+
 /**
  * Function to read properties from configuration file.
  *
@@ -150,6 +268,118 @@ void restart_pipeline (AppCtx * appCtx);
 gboolean
 parse_config_file (NvDsConfig * config, gchar * cfg_file_path);
 
+/**
+ * Read the enabled [source<N>] groups of a configuration file only.
+ *
+ * @param[out] configs MAX_SOURCE_BINS source configurations, filled in file
+ *             order.
+ * @param[out] num_configs number of enabled sources.
+ * @param[in] cfg_file_path path of configuration file.
+ *
+ * @return true if parsed successfully.
+ */
+gboolean parse_config_file_sources (NvDsSourceConfig * configs,
+    guint * num_configs, gchar * cfg_file_path);
+
+/**
+ * Read model-engine-file and labelfile-path of one classifier group.
+ *
+ * @param[in] cfg_file_path path of configuration file.
+ * @param[in] group e.g. "audio-classifier-1".
+ * @param[out] model_engine_file absolute path, NULL if not set.
+ * @param[out] label_file absolute path, NULL if not set.
+ *
+ * @return true if parsed successfully.
+ */
+gboolean parse_config_file_model (gchar * cfg_file_path, const gchar * group,
+    gchar ** model_engine_file, gchar ** label_file);
+
+/**
+ * Check the CPU mel front-end kernels against a double precision reference
+ * and benchmark them, using the [audio-classifier] transform.
+ * Enabled with audio-frontend-self-test in group [tests].
+ *
+ * @return true if all kernels are within tolerance.
+ */
+gboolean run_audio_frontend_self_test (NvDsConfig * config);
+
+/**
+ * Check the accuracy of the ingest resampler and compare its throughput with
+ * audioresample for the common microphone rates.
+ * Enabled with audio-resampler-benchmark in group [tests].
+ *
+ * @return true if all rates are converted within tolerance.
+ */
+gboolean run_audio_resampler_benchmark (NvDsConfig * config);
+
+/**
+ * Compare FP16 and INT8 feature tensors with FP32 on the windows of a
+ * recording: conversion error and top-1 agreement of a linear probe.
+ * Enabled by setting audio-tensor-format-test to an audio file in group
+ * [tests].
+ *
+ * @return true if every format agrees with FP32 on enough windows.
+ */
+gboolean run_audio_tensor_format_test (NvDsConfig * config);
+
+/**
+ * Run the plugin-type 2 network of [audio-classifier] on the windows of a
+ * recording with and without streaming-layers: difference of the results,
+ * reuse and time per window of both.
+ * Enabled by setting cpu-streaming-test to an audio file in group [tests].
+ *
+ * @return true if the streamed results are within tolerance.
+ */
+gboolean run_cpu_streaming_test (NvDsConfig * config);
+
+/**
+ * Stand-in for a remote node: serve the mel columns of a recording, looped
+ * in real time, to sources of type NV_DS_SOURCE_REMOTE_MEL. Uses the
+ * [audio-classifier] transform and the [audio-frontend] tensor-format.
+ * Enabled by setting remote-mel-sender to an audio file in group [tests];
+ * runs until interrupted.
+ *
+ * @return false if the recording cannot be served.
+ */
+gboolean run_remote_mel_sender (NvDsConfig * config);
+
+/**
+ * Serve WAV over HTTP from a local stand-in microphone to the given number
+ * of sources and compare uridecodebin with nvdshttpwavsrc: time to the
+ * first buffer, CPU time and resident memory per source, and for
+ * nvdshttpwavsrc the gap of a reconnect.
+ * Enabled by setting http-wav-benchmark to the number of sources in group
+ * [tests].
+ *
+ * @return false if a pipeline fails.
+ */
+gboolean run_http_wav_benchmark (NvDsConfig * config);
+
+/**
+ * Stream a synthetic dawn chorus to the given number of nvdshttpwavsrc
+ * sources as 16 bit PCM, IMA ADPCM, FLAC and Ogg Opus (if libopus is
+ * installed) and report per codec the bandwidth saved, the CPU time per
+ * audio second against PCM and the signal to noise ratio of the decoded
+ * audio. FLAC must decode bit exact.
+ * Enabled by setting compressed-ingest-benchmark to the number of sources
+ * in group [tests].
+ *
+ * @return false if a pipeline fails or FLAC is not lossless.
+ */
+gboolean run_compressed_ingest_benchmark (NvDsConfig * config);
+
+/**
+ * Feed a simulated source that loses, repeats and restarts buffers, with
+ * jittered and falling behind arrival times, through @ref NvDsAudioClock.
+ * The windows of the [audio-classifier] frame and hop size must be timed
+ * by their samples, flagged exactly where samples are missing, and the lag
+ * must follow the backlog.
+ * Enabled with audio-clock-self-test in group [tests].
+ *
+ * @return false if a check fails.
+ */
+gboolean run_audio_clock_self_test (NvDsConfig * config);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,9 +26,23 @@
 #define CONFIG_GROUP_APP "application"
 #define CONFIG_GROUP_APP_ENABLE_PERF_MEASUREMENT "enable-perf-measurement"
 #define CONFIG_GROUP_APP_PERF_MEASUREMENT_INTERVAL "perf-measurement-interval-sec"
+#define CONFIG_GROUP_APP_CONTROL_SOCKET "control-socket"
+
+#define CONFIG_GROUP_MODEL_ENGINE "model-engine-file"
+#define CONFIG_GROUP_MODEL_LABEL "labelfile-path"
 
 #define CONFIG_GROUP_TESTS "tests"
 #define CONFIG_GROUP_TESTS_FILE_LOOP "file-loop"
+#define CONFIG_GROUP_TESTS_AUDIO_FRONTEND_SELF_TEST "audio-frontend-self-test"
+#define CONFIG_GROUP_TESTS_AUDIO_RESAMPLER_BENCHMARK "audio-resampler-benchmark"
+#define CONFIG_GROUP_TESTS_AUDIO_TENSOR_FORMAT_TEST "audio-tensor-format-test"
+#define CONFIG_GROUP_TESTS_CPU_STREAMING_TEST "cpu-streaming-test"
+#define CONFIG_GROUP_TESTS_REMOTE_MEL_SENDER "remote-mel-sender"
+#define CONFIG_GROUP_TESTS_REMOTE_MEL_SENDER_PORT "remote-mel-sender-port"
+#define CONFIG_GROUP_TESTS_HTTP_WAV_BENCHMARK "http-wav-benchmark"
+#define CONFIG_GROUP_TESTS_COMPRESSED_INGEST_BENCHMARK \
+    "compressed-ingest-benchmark"
+#define CONFIG_GROUP_TESTS_AUDIO_CLOCK_SELF_TEST "audio-clock-self-test"
 
 GST_DEBUG_CATEGORY_EXTERN (APP_CFG_PARSER_CAT);
 
@@ -57,6 +71,71 @@ parse_tests (NvDsConfig *config, GKeyFile *key_file)
           g_key_file_get_integer (key_file, CONFIG_GROUP_TESTS,
           CONFIG_GROUP_TESTS_FILE_LOOP, &error);
       CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key,
+            CONFIG_GROUP_TESTS_AUDIO_FRONTEND_SELF_TEST)) {
+      config->audio_frontend_self_test =
+          g_key_file_get_integer (key_file, CONFIG_GROUP_TESTS,
+          CONFIG_GROUP_TESTS_AUDIO_FRONTEND_SELF_TEST, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key,
+            CONFIG_GROUP_TESTS_AUDIO_RESAMPLER_BENCHMARK)) {
+      config->audio_resampler_benchmark =
+          g_key_file_get_integer (key_file, CONFIG_GROUP_TESTS,
+          CONFIG_GROUP_TESTS_AUDIO_RESAMPLER_BENCHMARK, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key,
+            CONFIG_GROUP_TESTS_AUDIO_TENSOR_FORMAT_TEST)) {
+      g_free (config->audio_tensor_format_test);
+      config->audio_tensor_format_test =
+          g_key_file_get_string (key_file, CONFIG_GROUP_TESTS,
+          CONFIG_GROUP_TESTS_AUDIO_TENSOR_FORMAT_TEST, &error);
+      CHECK_ERROR (error);
+      if (!*config->audio_tensor_format_test) {
+        g_free (config->audio_tensor_format_test);
+        config->audio_tensor_format_test = NULL;
+      }
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_TESTS_CPU_STREAMING_TEST)) {
+      g_free (config->cpu_streaming_test);
+      config->cpu_streaming_test =
+          g_key_file_get_string (key_file, CONFIG_GROUP_TESTS,
+          CONFIG_GROUP_TESTS_CPU_STREAMING_TEST, &error);
+      CHECK_ERROR (error);
+      if (!*config->cpu_streaming_test) {
+        g_free (config->cpu_streaming_test);
+        config->cpu_streaming_test = NULL;
+      }
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_TESTS_REMOTE_MEL_SENDER)) {
+      g_free (config->remote_mel_sender);
+      config->remote_mel_sender =
+          g_key_file_get_string (key_file, CONFIG_GROUP_TESTS,
+          CONFIG_GROUP_TESTS_REMOTE_MEL_SENDER, &error);
+      CHECK_ERROR (error);
+      if (!*config->remote_mel_sender) {
+        g_free (config->remote_mel_sender);
+        config->remote_mel_sender = NULL;
+      }
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_TESTS_REMOTE_MEL_SENDER_PORT)) {
+      config->remote_mel_sender_port =
+          g_key_file_get_integer (key_file, CONFIG_GROUP_TESTS,
+          CONFIG_GROUP_TESTS_REMOTE_MEL_SENDER_PORT, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_TESTS_HTTP_WAV_BENCHMARK)) {
+      config->http_wav_benchmark =
+          g_key_file_get_integer (key_file, CONFIG_GROUP_TESTS,
+          CONFIG_GROUP_TESTS_HTTP_WAV_BENCHMARK, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key,
+            CONFIG_GROUP_TESTS_COMPRESSED_INGEST_BENCHMARK)) {
+      config->compressed_ingest_benchmark =
+          g_key_file_get_integer (key_file, CONFIG_GROUP_TESTS,
+          CONFIG_GROUP_TESTS_COMPRESSED_INGEST_BENCHMARK, &error);
+      CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key,
+            CONFIG_GROUP_TESTS_AUDIO_CLOCK_SELF_TEST)) {
+      config->audio_clock_self_test =
+          g_key_file_get_integer (key_file, CONFIG_GROUP_TESTS,
+          CONFIG_GROUP_TESTS_AUDIO_CLOCK_SELF_TEST, &error);
+      CHECK_ERROR (error);
     } else {
       NVGSTDS_WARN_MSG_V ("Unknown key '%s' for group [%s]", *key,
           CONFIG_GROUP_TESTS);
@@ -99,6 +178,11 @@ parse_app (NvDsConfig *config, GKeyFile *key_file, gchar *cfg_file_path)
           g_key_file_get_integer (key_file, CONFIG_GROUP_APP,
           CONFIG_GROUP_APP_PERF_MEASUREMENT_INTERVAL, &error);
       CHECK_ERROR (error);
+    } else if (!g_strcmp0 (*key, CONFIG_GROUP_APP_CONTROL_SOCKET)) {
+      config->control_socket =
+          g_key_file_get_string (key_file, CONFIG_GROUP_APP,
+          CONFIG_GROUP_APP_CONTROL_SOCKET, &error);
+      CHECK_ERROR (error);
     } else {
       NVGSTDS_WARN_MSG_V ("Unknown key '%s' for group [%s]", *key,
                           CONFIG_GROUP_APP);
@@ -209,6 +293,58 @@ parse_config_file (NvDsConfig *config, gchar *cfg_file_path)
           CONFIG_GROUP_AUDIO_CLASSIFIER, cfg_file_path);
     }
 
+    if (!g_strcmp0 (*group, CONFIG_GROUP_AUDIO_DETECTOR)) {
+      parse_err =
+          !parse_gie (&config->audio_detector_config, cfg_file,
+          CONFIG_GROUP_AUDIO_DETECTOR, cfg_file_path);
+    }
+
+    if (!strncmp (*group, CONFIG_GROUP_AUDIO_CLASSIFIER "-",
+            sizeof (CONFIG_GROUP_AUDIO_CLASSIFIER))) {
+      guint n = config->num_audio_classifier_sub_bins;
+      gchar *model_id_start_ptr = *group + sizeof (CONFIG_GROUP_AUDIO_CLASSIFIER);
+      gchar *model_id_end_ptr = NULL;
+      guint model_id =
+          g_ascii_strtoull (model_id_start_ptr, &model_id_end_ptr, 10);
+      if (model_id_start_ptr == model_id_end_ptr
+          || *model_id_end_ptr != '\0' || model_id == 0) {
+        NVGSTDS_ERR_MSG_V
+            ("Classifier group \"[%s]\" is not in the form "
+            "\"[audio-classifier-<%%d>]\" with a model ID > 0", *group);
+        ret = FALSE;
+        goto done;
+      }
+      for (guint i = 0; i < n; i++) {
+        if (config->audio_classifier_sub_bin_id[i] == model_id) {
+          NVGSTDS_ERR_MSG_V ("Duplicate classifier group \"[%s]\"", *group);
+          ret = FALSE;
+          goto done;
+        }
+      }
+      if (n == MAX_AUDIO_CLASSIFIER_SUB_BINS) {
+        NVGSTDS_ERR_MSG_V ("App supports max %d additional classifiers",
+            MAX_AUDIO_CLASSIFIER_SUB_BINS);
+        ret = FALSE;
+        goto done;
+      }
+      parse_err = !parse_gie (&config->audio_classifier_sub_bin_config[n],
+          cfg_file, *group, cfg_file_path);
+      if (config->audio_classifier_sub_bin_config[n].enable) {
+        config->audio_classifier_sub_bin_id[n] = model_id;
+        config->num_audio_classifier_sub_bins++;
+      }
+    }
+
+    if (!g_strcmp0 (*group, CONFIG_GROUP_AUDIO_FRONTEND)) {
+      parse_err =
+          !parse_audio_frontend (&config->audio_frontend_config, cfg_file);
+    }
+
+    if (!g_strcmp0 (*group, CONFIG_GROUP_ACTIVITY_GATE)) {
+      parse_err =
+          !parse_activity_gate (&config->activity_gate_config, cfg_file);
+    }
+
     if (!strncmp (*group, CONFIG_GROUP_SINK, sizeof (CONFIG_GROUP_SINK) - 1)) {
       parse_err = !parse_sink (&config->sink_bin_sub_bin_config[config->num_sink_sub_bins], cfg_file, *group, cfg_file_path);
       if (config->sink_bin_sub_bin_config[config->num_sink_sub_bins].enable)
@@ -244,3 +380,107 @@ done:
   }
   return ret;
 }
+
+gboolean
+parse_config_file_sources (NvDsSourceConfig *configs, guint *num_configs,
+    gchar *cfg_file_path)
+{
+  GKeyFile *cfg_file = g_key_file_new ();
+  GError *error = NULL;
+  gboolean ret = FALSE;
+  gchar **groups = NULL;
+  gchar **group;
+
+  *num_configs = 0;
+  if (!g_key_file_load_from_file (cfg_file, cfg_file_path, G_KEY_FILE_NONE,
+          &error)) {
+    GST_CAT_ERROR (APP_CFG_PARSER_CAT, "Failed to load uri file: %s",
+        error->message);
+    goto done;
+  }
+
+  reset_parsed_source_ids ();
+  groups = g_key_file_get_groups (cfg_file, NULL);
+  for (group = groups; *group; group++) {
+    if (strncmp (*group, CONFIG_GROUP_SOURCE, sizeof (CONFIG_GROUP_SOURCE) - 1))
+      continue;
+    if (*num_configs == MAX_SOURCE_BINS) {
+      NVGSTDS_ERR_MSG_V ("App supports max %d sources", MAX_SOURCE_BINS);
+      goto done;
+    }
+    if (!parse_source (&configs[*num_configs], cfg_file, *group,
+            cfg_file_path)) {
+      GST_CAT_ERROR (APP_CFG_PARSER_CAT, "Failed to parse '%s' group", *group);
+      goto done;
+    }
+    if (configs[*num_configs].enable)
+      (*num_configs)++;
+  }
+
+  ret = TRUE;
+
+done:
+  if (cfg_file) {
+    g_key_file_free (cfg_file);
+  }
+
+  if (groups) {
+    g_strfreev (groups);
+  }
+
+  if (error) {
+    g_error_free (error);
+  }
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+gboolean
+parse_config_file_model (gchar *cfg_file_path, const gchar *group,
+    gchar **model_engine_file, gchar **label_file)
+{
+  GKeyFile *cfg_file = g_key_file_new ();
+  GError *error = NULL;
+  gboolean ret = FALSE;
+
+  *model_engine_file = *label_file = NULL;
+  if (!g_key_file_load_from_file (cfg_file, cfg_file_path, G_KEY_FILE_NONE,
+          &error)) {
+    GST_CAT_ERROR (APP_CFG_PARSER_CAT, "Failed to load uri file: %s",
+        error->message);
+    goto done;
+  }
+
+  if (g_key_file_has_key (cfg_file, group, CONFIG_GROUP_MODEL_ENGINE, NULL)) {
+    *model_engine_file = get_absolute_file_path (cfg_file_path,
+        g_key_file_get_string (cfg_file, group, CONFIG_GROUP_MODEL_ENGINE,
+            &error));
+    CHECK_ERROR (error);
+  }
+  if (g_key_file_has_key (cfg_file, group, CONFIG_GROUP_MODEL_LABEL, NULL)) {
+    *label_file = get_absolute_file_path (cfg_file_path,
+        g_key_file_get_string (cfg_file, group, CONFIG_GROUP_MODEL_LABEL,
+            &error));
+    CHECK_ERROR (error);
+  }
+
+  ret = TRUE;
+
+done:
+  if (cfg_file) {
+    g_key_file_free (cfg_file);
+  }
+
+  if (error) {
+    g_error_free (error);
+  }
+  if (!ret) {
+    g_free (*model_engine_file);
+    g_free (*label_file);
+    *model_engine_file = *label_file = NULL;
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
@@ -0,0 +1,619 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Local control socket: a unix stream socket taking one command per line
+ * and answering each with one line, "OK ..." or "ERR <reason>".
+ *
+ *   add <type> <uri> [<source-id>]  attach a source of type 6 (audio file),
+ *                                   7 (URI) or 8 (ALSA; uri is the device)
+ *                                   at the given or lowest free source ID
+ *   remove <source-id>              detach and destroy a source
+ *   list                            "<source-id>=<uri>" of all sources
+ *   stats                           "<source-id>=<state>,<outages>,
+ *                                   <resets>,<last outage s>,<downtime s>"
+ *                                   of the live audio sources; state is up
+ *                                   or down, downtime includes a running
+ *                                   outage
+ *   bench <count> <type> <uri>      attach and detach a source count times
+ *
+ * Source IDs of the other sources never change. Each reconfiguration is
+ * answered after the muxer has produced batches again, with the time it
+ * took on the main loop and the longest gap between muxed batches since it
+ * started, i.e. how long the other sources were stalled, next to the
+ * typical gap.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <glib-unix.h>
+
+#include "deepstream_bird.h"
+
+#define CONTROL_MAX_LINE 4096
+#define CONTROL_MAX_CLIENTS 8
+
+typedef struct
+{
+  NvDsControl *control;
+  gint fd;
+  guint watch_id;
+  GString *input;
+  /** Closed by the peer while a command was still running. */
+  gboolean closed;
+} ControlClient;
+
+/** Running add, remove or bench command. */
+typedef struct
+{
+  ControlClient *client;
+  /** bench only: source attached and detached, and cycles to go. */
+  NvDsSourceConfig source;
+  guint cycles;
+  guint cycles_done;
+  gboolean attached;
+  gint source_id;
+  const gchar *what;
+  gint64 op_start;
+  gint64 op_time;
+  gdouble attach_sum, attach_max;
+  gdouble detach_sum, detach_max;
+  gdouble gap_sum, gap_max;
+} ControlOp;
+
+struct _NvDsControl
+{
+  AppCtx *appCtx;
+  gchar *path;
+  gint fd;
+  guint watch_id;
+  GList *clients;
+  ControlOp *op;
+  guint settle_id;
+
+  /** Batch gaps at the muxer output, from its streaming thread. */
+  GstPad *mux_pad;
+  gulong mux_probe_id;
+  GMutex lock;
+  gint64 last_batch;
+  /** Running average of the gaps outside of reconfigurations, us. */
+  gint64 typical_gap;
+  gboolean measuring;
+  gint64 max_gap;
+};
+
+static GstPadProbeReturn
+mux_batch_probe (GstPad * pad, GstPadProbeInfo * info, gpointer u_data)
+{
+  NvDsControl *control = (NvDsControl *) u_data;
+  gint64 now = g_get_monotonic_time ();
+
+  g_mutex_lock (&control->lock);
+  if (control->last_batch) {
+    gint64 gap = now - control->last_batch;
+
+    if (control->measuring) {
+      control->max_gap = MAX (control->max_gap, gap);
+    } else if (control->typical_gap) {
+      control->typical_gap += (gap - control->typical_gap) / 16;
+    } else {
+      control->typical_gap = gap;
+    }
+  }
+  control->last_batch = now;
+  g_mutex_unlock (&control->lock);
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+reply (ControlClient * client, const gchar * format, ...)
+    G_GNUC_PRINTF (2, 3);
+
+static void
+reply (ControlClient * client, const gchar * format, ...)
+{
+  gchar *line;
+  va_list args;
+  gsize len, sent = 0;
+
+  if (client->closed)
+    return;
+  va_start (args, format);
+  line = g_strdup_vprintf (format, args);
+  va_end (args);
+  len = strlen (line);
+  while (sent < len) {
+    gssize n = write (client->fd, line + sent, len - sent);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    sent += n;
+  }
+  g_free (line);
+}
+
+static void
+free_client (ControlClient * client)
+{
+  NvDsControl *control = client->control;
+
+  control->clients = g_list_remove (control->clients, client);
+  if (client->watch_id)
+    g_source_remove (client->watch_id);
+  close (client->fd);
+  g_string_free (client->input, TRUE);
+  g_free (client);
+}
+
+/** Longest batch gap since the reconfiguration started, in ms. */
+static gdouble
+stop_measuring (NvDsControl * control)
+{
+  gint64 now = g_get_monotonic_time ();
+  gint64 gap;
+
+  g_mutex_lock (&control->lock);
+  control->measuring = FALSE;
+  gap = control->max_gap;
+  /* No batch since: the muxer is still stalled. */
+  if (control->last_batch < control->op->op_start + control->op->op_time)
+    gap = MAX (gap, now - control->last_batch);
+  g_mutex_unlock (&control->lock);
+  return gap / 1000.0;
+}
+
+static void
+start_measuring (NvDsControl * control)
+{
+  g_mutex_lock (&control->lock);
+  control->measuring = TRUE;
+  control->max_gap = 0;
+  g_mutex_unlock (&control->lock);
+  control->op->op_start = g_get_monotonic_time ();
+}
+
+static gboolean settle_done (gpointer data);
+
+/** Wait a few batch gaps for the muxer to settle, then answer. */
+static void
+settle (NvDsControl * control)
+{
+  gint64 typical;
+
+  control->op->op_time = g_get_monotonic_time () - control->op->op_start;
+  g_mutex_lock (&control->lock);
+  typical = control->typical_gap;
+  g_mutex_unlock (&control->lock);
+  control->settle_id = g_timeout_add (CLAMP (3 * typical / 1000, 50, 2000),
+      settle_done, control);
+}
+
+static void
+finish_op (NvDsControl * control)
+{
+  ControlOp *op = control->op;
+
+  control->op = NULL;
+  g_free (op->source.uri);
+  g_free (op->source.alsa_device);
+  if (op->client->closed)
+    free_client (op->client);
+  g_free (op);
+}
+
+/** Next attach or detach of a bench command; FALSE when done. */
+static gboolean
+bench_step (NvDsControl * control)
+{
+  ControlOp *op = control->op;
+
+  if (op->cycles_done == op->cycles)
+    return FALSE;
+  start_measuring (control);
+  if (op->attached) {
+    if (!detach_source (control->appCtx, op->source_id))
+      return FALSE;
+    op->attached = FALSE;
+  } else {
+    NvDsSourceConfig source = op->source;
+
+    source.uri = g_strdup (op->source.uri);
+    source.alsa_device = g_strdup (op->source.alsa_device);
+    op->source_id = attach_source (control->appCtx, &source, -1);
+    if (op->source_id < 0)
+      return FALSE;
+    op->attached = TRUE;
+  }
+  settle (control);
+  return TRUE;
+}
+
+static gboolean
+settle_done (gpointer data)
+{
+  NvDsControl *control = (NvDsControl *) data;
+  ControlOp *op = control->op;
+  gdouble gap = stop_measuring (control);
+  gdouble op_ms = op->op_time / 1000.0;
+  gdouble typical;
+
+  control->settle_id = 0;
+  g_mutex_lock (&control->lock);
+  typical = control->typical_gap / 1000.0;
+  g_mutex_unlock (&control->lock);
+
+  if (!op->cycles) {
+    reply (op->client, "OK %d %s %.1f ms, longest batch gap %.1f ms"
+        " (typical %.1f ms)\n", op->source_id, op->what, op_ms, gap,
+        typical);
+    finish_op (control);
+    return G_SOURCE_REMOVE;
+  }
+
+  if (op->attached) {
+    op->attach_sum += op_ms;
+    op->attach_max = MAX (op->attach_max, op_ms);
+  } else {
+    op->detach_sum += op_ms;
+    op->detach_max = MAX (op->detach_max, op_ms);
+    op->cycles_done++;
+  }
+  op->gap_sum += gap;
+  op->gap_max = MAX (op->gap_max, gap);
+  if (bench_step (control))
+    return G_SOURCE_REMOVE;
+
+  if (op->cycles_done < op->cycles) {
+    reply (op->client, "ERR bench stopped after %u cycles\n",
+        op->cycles_done);
+  } else {
+    reply (op->client, "OK bench %u cycles: attach %.1f / %.1f ms, detach"
+        " %.1f / %.1f ms, longest batch gap %.1f / %.1f ms (mean / max;"
+        " typical gap %.1f ms)\n", op->cycles,
+        op->attach_sum / op->cycles, op->attach_max,
+        op->detach_sum / op->cycles, op->detach_max,
+        op->gap_sum / (2 * op->cycles), op->gap_max, typical);
+  }
+  NVGSTDS_INFO_MSG_V ("Control socket bench: %u cycles, longest batch gap"
+      " %.1f ms, typical %.1f ms", op->cycles_done, op->gap_max, typical);
+  finish_op (control);
+  return G_SOURCE_REMOVE;
+}
+
+/** Source of "<type> <uri>"; FALSE for types not in @ref NvDsSourceType. */
+static gboolean
+parse_source (gchar ** args, NvDsSourceConfig * source)
+{
+  gchar *end = NULL;
+  gint64 type;
+
+  memset (source, 0, sizeof (*source));
+  type = g_ascii_strtoll (args[0], &end, 10);
+  if (!*args[0] || *end || !args[1] || type < NV_DS_SOURCE_CAMERA_V4L2 ||
+      type > NV_DS_SOURCE_REMOTE_MEL)
+    return FALSE;
+  source->type = (NvDsSourceType) type;
+  source->enable = TRUE;
+  source->num_sources = 1;
+  source->latency = 100;
+  source->rtsp_reconnect_attempts = -1;
+  source->reconnect_timeout_sec = 10;
+  source->reconnect_backoff_max_sec = 60;
+  if (source->type == NV_DS_SOURCE_ALSA_SRC)
+    source->alsa_device = g_strdup (args[1]);
+  else
+    source->uri = g_strdup (args[1]);
+  return TRUE;
+}
+
+static gboolean
+parse_uint (const gchar * str, guint * value)
+{
+  gchar *end = NULL;
+  guint64 v;
+
+  if (!str || !*str)
+    return FALSE;
+  v = g_ascii_strtoull (str, &end, 10);
+  if (*end || v > G_MAXUINT)
+    return FALSE;
+  *value = v;
+  return TRUE;
+}
+
+static void
+handle_command (ControlClient * client, gchar * line)
+{
+  NvDsControl *control = client->control;
+  AppCtx *appCtx = control->appCtx;
+  gchar **args = g_strsplit_set (g_strstrip (line), " \t", -1);
+  guint num_args, i, value;
+  ControlOp *op;
+
+  /* Drop the empty fields of repeated blanks. */
+  for (i = num_args = 0; args[i]; i++) {
+    if (*args[i])
+      args[num_args++] = args[i];
+    else
+      g_free (args[i]);
+  }
+  args[num_args] = NULL;
+
+  if (!num_args)
+    goto done;
+
+  if (!g_strcmp0 (args[0], "list")) {
+    NvDsSrcParentBin *src_bin = &appCtx->pipeline.multi_src_bin;
+    GString *list = g_string_new ("OK");
+
+    for (i = 0; i < MAX_SOURCE_BINS; i++) {
+      NvDsSourceConfig *source = &appCtx->config.multi_source_config[i];
+
+      if (src_bin->sub_bins[i].bin)
+        g_string_append_printf (list, " %u=%s", i,
+            source->uri ? source->uri : source->alsa_device);
+    }
+    reply (client, "%s\n", list->str);
+    g_string_free (list, TRUE);
+    goto done;
+  }
+
+  if (!g_strcmp0 (args[0], "stats")) {
+    NvDsSrcParentBin *src_bin = &appCtx->pipeline.multi_src_bin;
+    GString *list = g_string_new ("OK");
+    gint64 now = g_get_monotonic_time ();
+
+    for (i = 0; i < MAX_SOURCE_BINS; i++) {
+      NvDsSrcReconnectStats *stats = &src_bin->sub_bins[i].reconnect_stats;
+      gint64 downtime = stats->total_downtime;
+
+      if (!src_bin->sub_bins[i].watchdog_id)
+        continue;
+      if (stats->down_since)
+        downtime += now - stats->down_since;
+      g_string_append_printf (list, " %u=%s,%u,%u,%.1f,%.1f", i,
+          stats->down_since ? "down" : "up", stats->outages,
+          stats->reconnects, stats->last_outage / 1e6, downtime / 1e6);
+    }
+    reply (client, "%s\n", list->str);
+    g_string_free (list, TRUE);
+    goto done;
+  }
+
+  if (g_strcmp0 (args[0], "add") && g_strcmp0 (args[0], "remove") &&
+      g_strcmp0 (args[0], "bench")) {
+    reply (client, "ERR unknown command '%s'\n", args[0]);
+    goto done;
+  }
+  if (control->op) {
+    reply (client, "ERR busy\n");
+    goto done;
+  }
+
+  op = g_new0 (ControlOp, 1);
+  op->client = client;
+  control->op = op;
+  if (!g_strcmp0 (args[0], "add")) {
+    NvDsSourceConfig source;
+    gboolean valid = num_args >= 3 && num_args <= 4 &&
+        parse_source (args + 1, &source);
+
+    if (valid && num_args == 4 && !parse_uint (args[3], &value)) {
+      g_free (source.uri);
+      g_free (source.alsa_device);
+      valid = FALSE;
+    }
+    if (!valid) {
+      reply (client, "ERR usage: add <type> <uri> [<source-id>]\n");
+      finish_op (control);
+      goto done;
+    }
+    op->what = "attached in";
+    start_measuring (control);
+    op->source_id = attach_source (appCtx, &source,
+        num_args == 4 ? (gint) value : -1);
+    g_free (source.uri);
+    g_free (source.alsa_device);
+    if (op->source_id < 0) {
+      stop_measuring (control);
+      reply (client, "ERR could not attach the source\n");
+      finish_op (control);
+      goto done;
+    }
+    settle (control);
+  } else if (!g_strcmp0 (args[0], "remove")) {
+    if (num_args != 2 || !parse_uint (args[1], &value)) {
+      reply (client, "ERR usage: remove <source-id>\n");
+      finish_op (control);
+      goto done;
+    }
+    op->what = "detached in";
+    op->source_id = value;
+    start_measuring (control);
+    if (!detach_source (appCtx, value)) {
+      stop_measuring (control);
+      reply (client, "ERR could not detach source %u\n", value);
+      finish_op (control);
+      goto done;
+    }
+    settle (control);
+  } else {
+    if (num_args != 4 || !parse_uint (args[1], &op->cycles) ||
+        !op->cycles || !parse_source (args + 2, &op->source)) {
+      reply (client, "ERR usage: bench <count> <type> <uri>\n");
+      finish_op (control);
+      goto done;
+    }
+    if (!bench_step (control)) {
+      reply (client, "ERR could not attach the source\n");
+      finish_op (control);
+      goto done;
+    }
+  }
+
+done:
+  g_strfreev (args);
+}
+
+static gboolean
+client_func (gint fd, GIOCondition condition, gpointer user_data)
+{
+  ControlClient *client = (ControlClient *) user_data;
+  gchar buf[512];
+  gchar *newline;
+  gssize n;
+
+  n = read (fd, buf, sizeof (buf));
+  if (n < 0 && (errno == EINTR || errno == EAGAIN))
+    return G_SOURCE_CONTINUE;
+  if (n <= 0) {
+    client->watch_id = 0;
+    /* Freed with the command it is waiting for. */
+    if (client->control->op && client->control->op->client == client)
+      client->closed = TRUE;
+    else
+      free_client (client);
+    return G_SOURCE_REMOVE;
+  }
+
+  g_string_append_len (client->input, buf, n);
+  while ((newline = memchr (client->input->str, '\n', client->input->len))) {
+    gchar *line = g_strndup (client->input->str,
+        newline - client->input->str);
+
+    g_string_erase (client->input, 0, newline - client->input->str + 1);
+    handle_command (client, line);
+    g_free (line);
+  }
+  if (client->input->len > CONTROL_MAX_LINE) {
+    reply (client, "ERR line too long\n");
+    g_string_truncate (client->input, 0);
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+accept_func (gint fd, GIOCondition condition, gpointer user_data)
+{
+  NvDsControl *control = (NvDsControl *) user_data;
+  ControlClient *client;
+  gint client_fd = accept (fd, NULL, NULL);
+
+  if (client_fd < 0)
+    return G_SOURCE_CONTINUE;
+  if (g_list_length (control->clients) >= CONTROL_MAX_CLIENTS) {
+    close (client_fd);
+    return G_SOURCE_CONTINUE;
+  }
+  client = g_new0 (ControlClient, 1);
+  client->control = control;
+  client->fd = client_fd;
+  client->input = g_string_new (NULL);
+  client->watch_id = g_unix_fd_add (client_fd, G_IO_IN | G_IO_HUP | G_IO_ERR,
+      client_func, client);
+  control->clients = g_list_prepend (control->clients, client);
+  return G_SOURCE_CONTINUE;
+}
+
+NvDsControl *
+start_control_socket (AppCtx * appCtx, const gchar * path)
+{
+  NvDsControl *control = g_new0 (NvDsControl, 1);
+  struct sockaddr_un addr;
+  gboolean ret = FALSE;
+
+  control->appCtx = appCtx;
+  control->path = g_strdup (path);
+  g_mutex_init (&control->lock);
+
+  if (strlen (path) >= sizeof (addr.sun_path)) {
+    NVGSTDS_ERR_MSG_V ("Control socket path '%s' is too long", path);
+    control->fd = -1;
+    goto done;
+  }
+  control->fd = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (control->fd < 0) {
+    NVGSTDS_ERR_MSG_V ("Could not create socket: %s", strerror (errno));
+    goto done;
+  }
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  g_strlcpy (addr.sun_path, path, sizeof (addr.sun_path));
+  /* A socket left behind by an earlier run. */
+  unlink (path);
+  if (bind (control->fd, (struct sockaddr *) &addr, sizeof (addr)) < 0 ||
+      listen (control->fd, CONTROL_MAX_CLIENTS) < 0) {
+    NVGSTDS_ERR_MSG_V ("Could not listen on '%s': %s", path,
+        strerror (errno));
+    goto done;
+  }
+  control->watch_id = g_unix_fd_add (control->fd, G_IO_IN, accept_func,
+      control);
+
+  control->mux_pad = gst_element_get_static_pad (
+      appCtx->pipeline.multi_src_bin.streammux, "src");
+  if (control->mux_pad)
+    control->mux_probe_id = gst_pad_add_probe (control->mux_pad,
+        GST_PAD_PROBE_TYPE_BUFFER, mux_batch_probe, control, NULL);
+
+  NVGSTDS_INFO_MSG_V ("Control socket listening on %s", path);
+  ret = TRUE;
+done:
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+    stop_control_socket (control);
+    return NULL;
+  }
+  return control;
+}
+
+void
+stop_control_socket (NvDsControl * control)
+{
+  if (!control)
+    return;
+  if (control->settle_id)
+    g_source_remove (control->settle_id);
+  if (control->op)
+    finish_op (control);
+  while (control->clients)
+    free_client (control->clients->data);
+  if (control->mux_pad) {
+    if (control->mux_probe_id)
+      gst_pad_remove_probe (control->mux_pad, control->mux_probe_id);
+    gst_object_unref (control->mux_pad);
+  }
+  if (control->watch_id)
+    g_source_remove (control->watch_id);
+  if (control->fd >= 0) {
+    close (control->fd);
+    unlink (control->path);
+  }
+  g_mutex_clear (&control->lock);
+  g_free (control->path);
+  g_free (control);
+}
@@ -22,6 +22,8 @@
 
 #include "deepstream_bird.h"
 #include "deepstream_config_file_parser.h"
+#include "deepstream_audio_clock.h"
+#include "deepstream_audio_topk.h"
 #include "nvds_version.h"
 #include "nvdsmeta_schema.h"
 #include <stdlib.h>
@@ -34,7 +36,9 @@
 
 AppCtx *appCtx;
 static guint cintr = FALSE;
+static guint creload = FALSE;
 static GMainLoop *main_loop = NULL;
+static NvDsControl *control = NULL;
 static gchar **cfg_files = NULL;
 static gchar **input_files = NULL;
 static gboolean print_version = FALSE;
@@ -46,6 +50,9 @@ static gdouble fps;
 static gdouble fps_avg;
 static gboolean playback_utc = TRUE;
 static TestAppCtx *testAppCtx;
+static gint64 startup_time;
+static gint64 phase_time;
+static gint first_result_seen = FALSE;
 
 GST_DEBUG_CATEGORY(NVDS_APP);
 
@@ -82,6 +89,23 @@ static void _intr_handler(int signum) {
     cintr = TRUE;
 }
 
+/**
+ * Function to handle the reload signal. The sources are reapplied from the
+ * config file by check_for_interrupt().
+ */
+static void _reload_handler(int signum) { creload = TRUE; }
+
+/**
+ * Print the duration of a startup phase and the time since start.
+ */
+static void print_startup_phase(const gchar *phase) {
+    gint64 now = g_get_monotonic_time();
+
+    g_print("Startup: %s %.1f ms (%.1f ms total)\n", phase,
+            (now - phase_time) / 1000.0, (now - startup_time) / 1000.0);
+    phase_time = now;
+}
+
 /**
  * callback function to print the performance numbers of each stream.
  */
@@ -116,6 +140,24 @@ static gboolean check_for_interrupt(gpointer data) {
 
         return FALSE;
     }
+
+    if (creload) {
+        gint64 start = g_get_monotonic_time();
+
+        creload = FALSE;
+        if (!reload_sources(appCtx, cfg_files[0])) {
+            NVGSTDS_ERR_MSG_V("Failed to reload sources from '%s'",
+                              cfg_files[0]);
+            return_value = -1;
+            quit = TRUE;
+            g_main_loop_quit(main_loop);
+
+            return FALSE;
+        }
+        reload_models(appCtx, cfg_files[0]);
+        g_print("Reload: %.1f ms\n",
+                (g_get_monotonic_time() - start) / 1000.0);
+    }
     return TRUE;
 }
 
@@ -131,6 +173,20 @@ static void _intr_setup(void) {
     sigaction(SIGINT, &action, NULL);
 }
 
+/*
+ * Function to install the handler for the reload signal. Installed before
+ * the pipeline is created, so that an early reload is applied once the
+ * pipeline runs instead of terminating the application.
+ */
+static void _reload_setup(void) {
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = _reload_handler;
+
+    sigaction(SIGHUP, &action, NULL);
+}
+
 static gboolean kbhit(void) {
     struct timeval tv;
     fd_set rdfs;
@@ -316,17 +372,47 @@ static void print_predictions(AppCtx *appCtx, GstBuffer *buf,
     for (NvDsMetaList *l_frame = batch_meta->frame_meta_list; l_frame != NULL;
          l_frame = l_frame->next) {
         NvDsAudioFrameMeta *frame_meta = l_frame->data;
+        NvDsAudioTopKMeta *topk = nvds_audio_topk_get_meta(frame_meta);
+        NvDsAudioClockMeta *clock = nvds_audio_clock_get_meta(frame_meta);
+        GString *line = g_string_new(NULL);
 
-        g_print("{"
+        g_string_append_printf(line, "{"
                 "\"frame_num\": %d, "
                 "\"timestamp\": %ld, "
                 "\"label\": \"%s\", "
                 "\"source_id\": %d, "
-                "\"confidence\": %f"
-                "}\n",
+                "\"confidence\": %f, "
+                "\"model_id\": %u",
                 frame_meta->frame_num, frame_meta->ntp_timestamp,
                 frame_meta->class_label, frame_meta->source_id,
-                frame_meta->confidence);
+                frame_meta->confidence, index);
+        /** Windows timed by the clock of their source: whether samples
+         *  are missing, and how far the pipeline is behind the source. */
+        if (clock) {
+            g_string_append_printf(line, ", \"gap\": %s, \"lag_ms\": %.1f",
+                    clock->gap ? "true" : "false",
+                    (gdouble) clock->lag / GST_MSECOND);
+        }
+        /** With top-k, all classes above top-k-threshold, best first. */
+        if (topk) {
+            g_string_append(line, ", \"top\": [");
+            for (guint i = 0; i < topk->num_entries; i++) {
+                const gchar *label =
+                    nvds_audio_topk_label(topk, &topk->entries[i]);
+
+                g_string_append_printf(line,
+                        "%s{\"class_id\": %u, \"label\": \"%s\", "
+                        "\"score\": %.4f}", i ? ", " : "",
+                        topk->entries[i].class_id, label ? label : "",
+                        nvds_audio_topk_score(&topk->entries[i]));
+            }
+            g_string_append_c(line, ']');
+        }
+        g_string_append(line, "}\n");
+        /** One write per result, the branches print from their own
+         *  threads. */
+        g_print("%s", line->str);
+        g_string_free(line, TRUE);
 
         // if (!strcmp(frame_meta->class_label, "00_background")) {
         //     g_print("### frame_num:[%d] ntp_timestamp:[%ld] label:[%s] "
@@ -341,9 +427,52 @@ static void print_predictions(AppCtx *appCtx, GstBuffer *buf,
         //             frame_meta->class_label, frame_meta->source_id,
         //             frame_meta->confidence);
         // }
+        /** Every model sees the same frames; count them once. */
+        if (index != 0)
+            continue;
+
         stream_id = frame_meta->source_id;
+        if (stream_id >= MAX_SOURCE_BINS)
+            continue;
+
+        /** Start the counters over for a source attached to the slot. */
+        gint64 attach_time =
+            appCtx->pipeline.multi_src_bin.sub_bins[stream_id].attach_time;
+        if (attach_time &&
+            attach_time != testAppCtx->streams[stream_id].attach_time) {
+            testAppCtx->streams[stream_id].attach_time = attach_time;
+            testAppCtx->streams[stream_id].frameCount = 0;
+            testAppCtx->streams[stream_id].last_ntp_time = 0;
+            testAppCtx->streams[stream_id].gapCount = 0;
+            testAppCtx->streams[stream_id].duplicateCount = 0;
+            g_print("Source %u: first result %.1f ms after attach\n",
+                    stream_id,
+                    (g_get_monotonic_time() - attach_time) / 1000.0);
+        }
+        if (g_atomic_int_compare_and_exchange(&first_result_seen, FALSE,
+                                              TRUE))
+            print_startup_phase("first result");
+
         GstClockTime buf_ntp_time = 0;
-        if (playback_utc == FALSE) {
+        if (clock) {
+            /** The window timestamps follow the sample count of the
+             *  source, in either playback-utc mode. The skip paths of the
+             *  activity gate and the cascade may overtake the classifier,
+             *  so only a repeated timestamp is an error. */
+            StreamSourceInfo *src_stream = &testAppCtx->streams[stream_id];
+            buf_ntp_time = frame_meta->ntp_timestamp;
+
+            if (clock->gap)
+                src_stream->gapCount++;
+            if (buf_ntp_time == src_stream->last_ntp_time) {
+                src_stream->duplicateCount++;
+                NVGSTDS_WARN_MSG_V(
+                    "Source %d: window at %lu reported twice", stream_id,
+                    buf_ntp_time);
+            }
+            src_stream->last_ntp_time =
+                MAX(buf_ntp_time, src_stream->last_ntp_time);
+        } else if (playback_utc == FALSE) {
             /** Calculate the buffer-NTP-time
              * derived from this stream's RTCP Sender Report here:
              */
@@ -369,6 +498,8 @@ int main(int argc, char *argv[]) {
     GError *error = NULL;
     guint i = 0;
 
+    startup_time = phase_time = g_get_monotonic_time();
+
     /** deepstream-audio app would work only with the new streammux */
     putenv("USE_NEW_NVSTREAMMUX=yes");
 
@@ -410,6 +541,7 @@ int main(int argc, char *argv[]) {
     appCtx = g_malloc0(sizeof(AppCtx));
     appCtx->audio_event_id = -1;
     appCtx->index = i;
+    _reload_setup();
 
 #if 0
   if (input_files) {
@@ -424,12 +556,52 @@ int main(int argc, char *argv[]) {
         appCtx->return_value = -1;
         goto done;
     }
+    print_startup_phase("config");
+
+    if (appCtx->config.audio_frontend_self_test ||
+        appCtx->config.audio_resampler_benchmark ||
+        appCtx->config.audio_tensor_format_test ||
+        appCtx->config.cpu_streaming_test ||
+        appCtx->config.remote_mel_sender ||
+        appCtx->config.http_wav_benchmark ||
+        appCtx->config.compressed_ingest_benchmark ||
+        appCtx->config.audio_clock_self_test) {
+        if (appCtx->config.audio_frontend_self_test &&
+            !run_audio_frontend_self_test(&appCtx->config))
+            return_value = -1;
+        if (appCtx->config.audio_resampler_benchmark &&
+            !run_audio_resampler_benchmark(&appCtx->config))
+            return_value = -1;
+        if (appCtx->config.audio_tensor_format_test &&
+            !run_audio_tensor_format_test(&appCtx->config))
+            return_value = -1;
+        if (appCtx->config.cpu_streaming_test &&
+            !run_cpu_streaming_test(&appCtx->config))
+            return_value = -1;
+        if (appCtx->config.remote_mel_sender &&
+            !run_remote_mel_sender(&appCtx->config))
+            return_value = -1;
+        if (appCtx->config.http_wav_benchmark &&
+            !run_http_wav_benchmark(&appCtx->config))
+            return_value = -1;
+        if (appCtx->config.compressed_ingest_benchmark &&
+            !run_compressed_ingest_benchmark(&appCtx->config))
+            return_value = -1;
+        if (appCtx->config.audio_clock_self_test &&
+            !run_audio_clock_self_test(&appCtx->config))
+            return_value = -1;
+        g_free(appCtx);
+        appCtx = NULL;
+        goto done;
+    }
 
     if (!create_pipeline(appCtx, perf_cb, print_predictions)) {
         NVGSTDS_ERR_MSG_V("Failed to create pipeline");
         return_value = -1;
         goto done;
     }
+    /** Includes loading the CPU models and creating nvinferaudio. */
+    print_startup_phase("pipeline");
 
     main_loop = g_main_loop_new(NULL, FALSE);
 
@@ -442,6 +614,8 @@ int main(int argc, char *argv[]) {
         return_value = -1;
         goto done;
     }
+    /** nvinferaudio deserializes its engine here. */
+    print_startup_phase("paused");
 
     if (gst_element_set_state(appCtx->pipeline.pipeline, GST_STATE_PLAYING) ==
         GST_STATE_CHANGE_FAILURE) {
@@ -450,6 +624,10 @@ int main(int argc, char *argv[]) {
         return_value = -1;
         goto done;
     }
+    print_startup_phase("playing");
+
+    if (appCtx->config.control_socket)
+        control = start_control_socket(appCtx, appCtx->config.control_socket);
 
     // print_runtime_commands ();
 
@@ -463,6 +641,7 @@ int main(int argc, char *argv[]) {
 done:
 
     g_print("Quitting\n");
+    stop_control_socket(control);
     if (appCtx) {
         if (appCtx->return_value == -1)
             return_value = -1;
@@ -0,0 +1,1794 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "deepstream_bird.h"
+#include "deepstream_audio_features.h"
+#include "deepstream_audio_ingest.h"
+#include "deepstream_cpu_infer.h"
+#include "deepstream_audio_resample.h"
+#include "deepstream_remote_mel.h"
+#include "deepstream_http_wav.h"
+#include "deepstream_audio_codec.h"
+#include "deepstream_audio_clock.h"
+
+#define DEFAULT_AUDIO_TRANSFORM "melsdb,fft_length=1024,hop_size=482," \
+    "dsp_window=hann,num_mels=128,sample_rate=44100,p2db_ref=(float)1.0," \
+    "p2db_min_power=(float)0.0,p2db_top_db=(float)80.0"
+#define DEFAULT_FRAME_SIZE 220500
+#define DEFAULT_HOP_SIZE 44100
+
+/** Maximum allowed deviation from the double precision reference. */
+#define MEL_TOLERANCE_DB 0.05
+#define MEL_BENCHMARK_COLUMNS 2000
+#define MEL_BENCHMARK_MAX_SOURCES 16
+#define MEL_BENCHMARK_HOPS 4
+
+/** Minimum SNR of a resampled 1 kHz sine. */
+#define RESAMPLE_MIN_SNR_DB 80.0
+#define RESAMPLE_BENCHMARK_SECONDS 60
+#define RESAMPLE_BLOCK_FRAMES 1024
+#define RESAMPLE_TEST_SRC "audiotestsrc wave=white-noise num-buffers=%u" \
+    " samplesperbuffer=1024 ! audio/x-raw,format=S16LE,channels=1,rate=%u"
+
+/** Random linear probe standing in for the classifier. */
+#define TENSOR_PROBE_CLASSES 64
+#define TENSOR_PROBE_SEGMENTS 8
+/** Minimum top-1 agreement of a reduced precision format with FP32. */
+#define TENSOR_MIN_AGREEMENT 0.98
+#define TENSOR_DECODE_PIPELINE "filesrc location=\"%s\" ! decodebin !" \
+    " audioconvert ! audio/x-raw,channels=1 ! " NVDS_ELEM_AUDIO_INGEST \
+    " rate=%u ! fakesink name=sink signal-handoffs=true sync=false"
+
+/** Maximum difference of streamed and full-window results. The reused
+ *  activations are bit-identical, so the results are expected to match. */
+#define CPU_STREAMING_TOLERANCE 1e-6
+
+#define REMOTE_MEL_DEFAULT_PORT 5000
+/** Columns per frame, about 250 ms at hop 482 and 44.1 kHz. */
+#define REMOTE_MEL_FRAME_COLUMNS 23
+#define REMOTE_MEL_REPORT_INTERVAL_SEC 10
+
+/* Audio served to each source by the HTTP WAV benchmark, 16 bit mono. */
+#define HTTP_WAV_BENCHMARK_SECONDS 60
+#define HTTP_WAV_BENCHMARK_RATE 48000
+#define HTTP_WAV_BENCHMARK_MAX_SOURCES 64
+
+/* Opus bitrate of the compressed ingest benchmark, as of a mobile link. */
+#define COMPRESSED_BENCHMARK_OPUS_BITRATE 32000
+
+/* Audio clock self-test: a simulated source loses, repeats and restarts
+ * buffers while its arrival times jitter and fall behind. */
+#define CLOCK_TEST_BUFFERS 4000
+#define CLOCK_TEST_BUFFER_SIZE 1024
+#define CLOCK_TEST_START_TIME (1600000000 * GST_SECOND)
+#define CLOCK_TEST_JITTER (20 * GST_MSECOND)
+#define CLOCK_TEST_LOST_BUFFERS 300
+#define CLOCK_TEST_BACKLOG_FROM 3000
+#define CLOCK_TEST_BACKLOG_PER_BUFFER (2 * GST_MSECOND)
+
+static const guint resample_benchmark_rates[] = { 48000, 32000, 16000, 44100 };
+
+/* Deterministic test signal: two chirps and white noise. */
+static void
+fill_test_signal (gfloat *x, guint n, guint sample_rate)
+{
+  guint32 seed = 1;
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    gdouble t = (gdouble) i / sample_rate;
+    seed = seed * 1664525u + 1013904223u;
+    x[i] = 0.4 * sin (2.0 * G_PI * (500.0 + 800.0 * t) * t) +
+        0.2 * sin (2.0 * G_PI * (9000.0 - 300.0 * t) * t) +
+        0.05 * ((seed >> 8) / 16777216.0 - 0.5);
+  }
+}
+
+/* Scalar double precision melsdb of one window, using a direct DFT. */
+static void
+compute_reference (const NvDsMelFrontend *fe, const gfloat *x,
+    guint num_frames, gdouble *out)
+{
+  const NvDsAudioTransformParams *p = nvds_mel_frontend_get_params (fe);
+  guint n = p->fft_length;
+  gdouble *cos_table = g_new (gdouble, n);
+  gdouble *sin_table = g_new (gdouble, n);
+  gdouble *frame = g_new (gdouble, n);
+  gdouble *power = g_new (gdouble, n / 2 + 1);
+  gdouble amin = MAX (p->p2db_min_power, 1e-10);
+  gdouble max_db = -G_MAXFLOAT;
+  guint c, k, i, m;
+
+  for (i = 0; i < n; i++) {
+    cos_table[i] = cos (2.0 * G_PI * i / n);
+    sin_table[i] = sin (2.0 * G_PI * i / n);
+  }
+
+  for (c = 0; c < num_frames; c++) {
+    for (i = 0; i < n; i++)
+      frame[i] = x[c * p->hop_size + i] * (0.5 - 0.5 * cos_table[i]);
+    for (k = 0; k <= n / 2; k++) {
+      gdouble re = 0.0, im = 0.0;
+      for (i = 0; i < n; i++) {
+        re += frame[i] * cos_table[(k * i) % n];
+        im -= frame[i] * sin_table[(k * i) % n];
+      }
+      power[k] = re * re + im * im;
+    }
+    for (m = 0; m < p->num_mels; m++) {
+      guint first, len;
+      const gfloat *w = nvds_mel_frontend_get_band (fe, m, &first, &len);
+      gdouble acc = 0.0;
+      for (k = 0; k < len; k++)
+        acc += w[k] * power[first + k];
+      out[c * p->num_mels + m] = 10.0 * log10 (MAX (acc, amin)) -
+          10.0 * log10 (MAX (p->p2db_ref, amin));
+      max_db = MAX (max_db, out[c * p->num_mels + m]);
+    }
+  }
+
+  if (p->p2db_top_db > 0.0)
+    for (i = 0; i < num_frames * p->num_mels; i++)
+      out[i] = MAX (out[i], max_db - p->p2db_top_db);
+
+  g_free (cos_table);
+  g_free (sin_table);
+  g_free (frame);
+  g_free (power);
+}
+
+static gboolean
+check_kernel (const NvDsAudioTransformParams *params, NvDsMelKernel kernel,
+    const gfloat *x, guint frame_size, const gdouble *reference)
+{
+  NvDsMelFrontend *fe = nvds_mel_frontend_new_with_kernel (params, kernel);
+  guint num_frames = nvds_audio_transform_num_frames (params, frame_size);
+  NvDsMelRing *ring = nvds_mel_ring_new (fe, num_frames);
+  gfloat *window = g_new (gfloat, (gsize) num_frames * params->num_mels);
+  gfloat *work = g_new (gfloat, nvds_mel_frontend_work_size (fe));
+  gfloat *column = g_new (gfloat, params->num_mels);
+  gdouble max_err = 0.0;
+  gint64 start, elapsed;
+  gboolean ret;
+  guint i;
+
+  nvds_mel_ring_push_samples (ring, x, frame_size);
+  ret = nvds_mel_ring_assemble (ring, 0, num_frames, window);
+  for (i = 0; ret && i < num_frames * params->num_mels; i++)
+    max_err = MAX (max_err, fabs (window[i] - reference[i]));
+  ret = ret && max_err <= MEL_TOLERANCE_DB;
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < MEL_BENCHMARK_COLUMNS; i++)
+    nvds_mel_frontend_compute_column (fe, work,
+        x + (i % num_frames) * params->hop_size, column);
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  g_print ("mel kernel %-6s: max error %.5f dB (%s), %.0f columns/s,"
+      " %.1fx real time per source\n", nvds_mel_frontend_get_kernel_name (fe),
+      max_err, ret ? "PASS" : "FAIL",
+      MEL_BENCHMARK_COLUMNS * 1e6 / elapsed,
+      MEL_BENCHMARK_COLUMNS * 1e6 / elapsed /
+      ((gdouble) params->sample_rate / params->hop_size));
+
+  g_free (column);
+  g_free (work);
+  g_free (window);
+  nvds_mel_ring_free (ring);
+  nvds_mel_frontend_free (fe);
+  return ret;
+}
+
+/*
+ * Throughput of 1 to MEL_BENCHMARK_MAX_SOURCES sources receiving the same
+ * hop: per-source column kernel versus all sources batched across lanes.
+ */
+static void
+benchmark_source_scaling (const NvDsAudioTransformParams *params,
+    const gfloat *x, guint frame_size, guint hop_size)
+{
+  NvDsMelFrontend *fe = nvds_mel_frontend_new (params);
+  NvDsMelRing *rings[MEL_BENCHMARK_MAX_SOURCES];
+  gfloat *work = g_new (gfloat, nvds_mel_frontend_work_size (fe));
+  gfloat *column = g_new (gfloat, params->num_mels);
+  gdouble audio_sec = (gdouble) MEL_BENCHMARK_HOPS * hop_size /
+      params->sample_rate;
+  guint num_sources, s, h;
+
+  g_print ("mel front-end scaling (%s, %u columns per batch, %u samples"
+      " per hop):\n", nvds_mel_frontend_get_kernel_name (fe),
+      nvds_mel_frontend_get_batch_size (fe), hop_size);
+
+  for (num_sources = 1; num_sources <= MEL_BENCHMARK_MAX_SOURCES;
+      num_sources *= 2) {
+    guint columns = 0;
+    gint64 start, per_source, batched;
+
+    /* Per source: every column through the single column kernel. */
+    start = g_get_monotonic_time ();
+    for (s = 0; s < num_sources; s++) {
+      guint c, num_columns = nvds_audio_transform_num_frames (params,
+          MEL_BENCHMARK_HOPS * hop_size);
+      for (c = 0; c < num_columns; c++)
+        nvds_mel_frontend_compute_column (fe, work,
+            x + c * params->hop_size, column);
+    }
+    per_source = MAX (g_get_monotonic_time () - start, 1);
+
+    /* Batched: the same hop of all sources shares the SIMD lanes. */
+    for (s = 0; s < num_sources; s++)
+      rings[s] = nvds_mel_ring_new (fe,
+          nvds_audio_transform_num_frames (params, frame_size));
+    start = g_get_monotonic_time ();
+    for (h = 0; h < MEL_BENCHMARK_HOPS; h++) {
+      for (s = 0; s < num_sources; s++)
+        nvds_mel_ring_append_samples (rings[s], x + h * hop_size, hop_size);
+      columns += nvds_mel_rings_compute (rings, num_sources, work);
+    }
+    batched = MAX (g_get_monotonic_time () - start, 1);
+    for (s = 0; s < num_sources; s++)
+      nvds_mel_ring_free (rings[s]);
+
+    g_print ("  %2u sources: per-source %7.0f columns/s, batched %7.0f"
+        " columns/s (%.2fx), %.0fx real time\n", num_sources,
+        columns * 1e6 / per_source, columns * 1e6 / batched,
+        (gdouble) per_source / batched, audio_sec * 1e6 / batched);
+  }
+
+  g_free (column);
+  g_free (work);
+  nvds_mel_frontend_free (fe);
+}
+
+/*
+ * Batched kernel specialized for the deployed transform size versus the
+ * runtime-configured kernel on the same columns.
+ */
+static gboolean
+benchmark_specialized_kernel (const NvDsAudioTransformParams *params,
+    const gfloat *x, guint frame_size)
+{
+  NvDsMelFrontend *generic = nvds_mel_frontend_new_full (params,
+      NVDS_MEL_KERNEL_AUTO, FALSE);
+  NvDsMelFrontend *fixed = nvds_mel_frontend_new_full (params,
+      NVDS_MEL_KERNEL_AUTO, TRUE);
+  guint num_frames = nvds_audio_transform_num_frames (params, frame_size);
+  guint batch = nvds_mel_frontend_get_batch_size (fixed);
+  gfloat *work = g_new (gfloat, nvds_mel_frontend_work_size (fixed));
+  gfloat *out_generic = g_new (gfloat, (gsize) batch * params->num_mels);
+  gfloat *out_fixed = g_new (gfloat, (gsize) batch * params->num_mels);
+  const gfloat **frames = g_new (const gfloat *, batch);
+  gfloat **columns = g_new (gfloat *, batch);
+  gint64 elapsed[2] = { 0, 0 };
+  gdouble max_diff = 0.0;
+  gboolean ret = TRUE;
+  guint i, k, v;
+
+  if (!nvds_mel_frontend_is_specialized (fixed)) {
+    g_print ("mel kernel %s: no specialized kernel for fft_length %u,"
+        " %u mels\n", nvds_mel_frontend_get_kernel_name (fixed),
+        params->fft_length, params->num_mels);
+    goto done;
+  }
+
+  for (i = 0; i < MEL_BENCHMARK_COLUMNS; i += batch) {
+    for (k = 0; k < batch; k++)
+      frames[k] = x + ((i + k) % num_frames) * params->hop_size;
+    for (v = 0; v < 2; v++) {
+      NvDsMelFrontend *fe = v ? fixed : generic;
+      gfloat *out = v ? out_fixed : out_generic;
+      gint64 start;
+
+      for (k = 0; k < batch; k++)
+        columns[k] = out + k * params->num_mels;
+      start = g_get_monotonic_time ();
+      nvds_mel_frontend_compute_columns (fe, work, frames, batch, columns);
+      elapsed[v] += g_get_monotonic_time () - start;
+    }
+    for (k = 0; k < batch * params->num_mels; k++)
+      max_diff = MAX (max_diff, fabs (out_fixed[k] - out_generic[k]));
+  }
+  ret = max_diff <= MEL_TOLERANCE_DB;
+
+  g_print ("mel kernel %s specialized for %u/%u: max difference %.5f dB (%s),"
+      " generic %.0f columns/s, specialized %.0f columns/s (%.2fx)\n",
+      nvds_mel_frontend_get_kernel_name (fixed), params->fft_length,
+      params->num_mels,
+      max_diff, ret ? "PASS" : "FAIL",
+      MEL_BENCHMARK_COLUMNS * 1e6 / MAX (elapsed[0], 1),
+      MEL_BENCHMARK_COLUMNS * 1e6 / MAX (elapsed[1], 1),
+      (gdouble) MAX (elapsed[0], 1) / MAX (elapsed[1], 1));
+
+done:
+  g_free (columns);
+  g_free (frames);
+  g_free (out_fixed);
+  g_free (out_generic);
+  g_free (work);
+  nvds_mel_frontend_free (fixed);
+  nvds_mel_frontend_free (generic);
+  return ret;
+}
+
+gboolean
+run_audio_frontend_self_test (NvDsConfig *config)
+{
+  NvDsGieConfig *gie = &config->audio_classifier_config;
+  NvDsAudioTransformParams params;
+  NvDsMelFrontend *fe = NULL;
+  guint frame_size = gie->is_frame_size_set ? gie->frame_size :
+      DEFAULT_FRAME_SIZE;
+  guint num_frames;
+  gfloat *x = NULL;
+  gdouble *reference = NULL;
+  gboolean ret = FALSE;
+
+  if (!nvds_audio_transform_params_parse (gie->audio_transform ?
+          gie->audio_transform : DEFAULT_AUDIO_TRANSFORM, &params))
+    goto done;
+
+  num_frames = nvds_audio_transform_num_frames (&params, frame_size);
+  if (!num_frames) {
+    NVGSTDS_ERR_MSG_V ("audio-framesize %u shorter than fft_length %u",
+        frame_size, params.fft_length);
+    goto done;
+  }
+
+  x = g_new (gfloat, frame_size);
+  fill_test_signal (x, frame_size, params.sample_rate);
+  reference = g_new (gdouble, (gsize) num_frames * params.num_mels);
+  fe = nvds_mel_frontend_new_with_kernel (&params, NVDS_MEL_KERNEL_SCALAR);
+  compute_reference (fe, x, num_frames, reference);
+
+  ret = check_kernel (&params, NVDS_MEL_KERNEL_SCALAR, x, frame_size,
+      reference);
+  ret &= check_kernel (&params, NVDS_MEL_KERNEL_AUTO, x, frame_size,
+      reference);
+  ret &= benchmark_specialized_kernel (&params, x, frame_size);
+
+  benchmark_source_scaling (&params, x, frame_size,
+      gie->is_hop_size_set ? gie->hop_size : DEFAULT_HOP_SIZE);
+
+done:
+  nvds_mel_frontend_free (fe);
+  g_free (x);
+  g_free (reference);
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+/* SNR of a resampled 1 kHz sine against the analytic output. */
+static gdouble
+resampler_snr (guint in_rate, guint out_rate)
+{
+  NvDsAudioResampler *rs = nvds_audio_resampler_new (in_rate, out_rate, 1);
+  guint num_frames = 2 * in_rate;
+  gfloat *out = g_new (gfloat, nvds_audio_resampler_get_max_output (rs,
+          num_frames));
+  gdouble signal = 0.0, noise = 0.0;
+  guint done, n, i, num_out = 0;
+
+  for (done = 0; done < num_frames; done += n) {
+    gfloat *x;
+
+    n = MIN (RESAMPLE_BLOCK_FRAMES, num_frames - done);
+    x = nvds_audio_resampler_get_input (rs, 0, n);
+    for (i = 0; i < n; i++)
+      x[i] = sin (2.0 * G_PI * 1000.0 * (done + i) / in_rate);
+    num_out += nvds_audio_resampler_process (rs, n, out + num_out);
+  }
+
+  /* Skip the first 100 ms, where the filter sees the zero history. */
+  for (i = out_rate / 10; i < num_out; i++) {
+    gdouble ref = sin (2.0 * G_PI * 1000.0 * i / out_rate);
+    signal += ref * ref;
+    noise += (out[i] - ref) * (out[i] - ref);
+  }
+
+  g_free (out);
+  nvds_audio_resampler_free (rs);
+  return noise > 0.0 ? 10.0 * log10 (signal / noise) : G_MAXDOUBLE;
+}
+
+/* Seconds of mono audio resampled per second through the C API. */
+static gdouble
+resampler_speed (guint in_rate, guint out_rate)
+{
+  NvDsAudioResampler *rs = nvds_audio_resampler_new (in_rate, out_rate, 1);
+  guint num_frames = RESAMPLE_BENCHMARK_SECONDS * in_rate;
+  gfloat *noise = g_new (gfloat, RESAMPLE_BLOCK_FRAMES);
+  gfloat *out = g_new (gfloat, nvds_audio_resampler_get_max_output (rs,
+          RESAMPLE_BLOCK_FRAMES));
+  guint32 seed = 1;
+  guint done, n, i;
+  gint64 start, elapsed;
+
+  for (i = 0; i < RESAMPLE_BLOCK_FRAMES; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    noise[i] = (seed >> 8) / 16777216.0 - 0.5;
+  }
+
+  start = g_get_monotonic_time ();
+  for (done = 0; done < num_frames; done += n) {
+    n = MIN (RESAMPLE_BLOCK_FRAMES, num_frames - done);
+    memcpy (nvds_audio_resampler_get_input (rs, 0, n), noise,
+        n * sizeof (gfloat));
+    nvds_audio_resampler_process (rs, n, out);
+  }
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  g_free (out);
+  g_free (noise);
+  nvds_audio_resampler_free (rs);
+  return RESAMPLE_BENCHMARK_SECONDS * 1e6 / elapsed;
+}
+
+/*
+ * Run a pipeline to EOS and release it. Returns the wall time in
+ * microseconds, -1 on error.
+ */
+static gint64
+run_pipeline (GstElement *pipeline)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *msg;
+  gint64 start, elapsed = -1;
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (msg && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS)
+    elapsed = MAX (g_get_monotonic_time () - start, 1);
+  if (msg)
+    gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+  return elapsed;
+}
+
+static GstElement *
+create_test_pipeline (const gchar *description)
+{
+  GError *error = NULL;
+  GstElement *pipeline = gst_parse_launch (description, &error);
+
+  if (error) {
+    NVGSTDS_ERR_MSG_V ("Could not create '%s': %s", description,
+        error->message);
+    g_error_free (error);
+    if (pipeline)
+      gst_object_unref (pipeline);
+    return NULL;
+  }
+  return pipeline;
+}
+
+/* Wall time in microseconds of a pipeline running to EOS, -1 on error. */
+static gint64
+time_pipeline (const gchar *description)
+{
+  GstElement *pipeline = create_test_pipeline (description);
+
+  return pipeline ? run_pipeline (pipeline) : -1;
+}
+
+/*
+ * Seconds of audio per second through audioconvert ! audioresample and
+ * through nvdsaudioingest, both producing F32LE at out_rate. The cost of
+ * generating the test signal is measured separately and subtracted.
+ */
+static void
+benchmark_resampler_elements (guint in_rate, guint out_rate,
+    gdouble *legacy_speed, gdouble *ingest_speed)
+{
+  guint num_buffers = RESAMPLE_BENCHMARK_SECONDS * in_rate /
+      RESAMPLE_BLOCK_FRAMES;
+  gdouble audio_sec = (gdouble) num_buffers * RESAMPLE_BLOCK_FRAMES / in_rate;
+  gchar *src = g_strdup_printf (RESAMPLE_TEST_SRC, num_buffers, in_rate);
+  gchar *description;
+  gint64 base, legacy, ingest;
+
+  description = g_strdup_printf ("%s ! fakesink sync=false", src);
+  base = time_pipeline (description);
+  g_free (description);
+
+  description = g_strdup_printf ("%s ! audioconvert ! audioresample !"
+      " audio/x-raw,format=F32LE,rate=%u ! fakesink sync=false", src,
+      out_rate);
+  legacy = time_pipeline (description);
+  g_free (description);
+
+  description = g_strdup_printf ("%s ! " NVDS_ELEM_AUDIO_INGEST
+      " rate=%u cutoff=0 ! fakesink sync=false", src, out_rate);
+  ingest = time_pipeline (description);
+  g_free (description);
+  g_free (src);
+
+  *legacy_speed = base < 0 || legacy < 0 ? 0.0 :
+      audio_sec * 1e6 / MAX (legacy - base, 1);
+  *ingest_speed = base < 0 || ingest < 0 ? 0.0 :
+      audio_sec * 1e6 / MAX (ingest - base, 1);
+}
+
+gboolean
+run_audio_resampler_benchmark (NvDsConfig *config)
+{
+  guint out_rate = config->audio_classifier_config.input_audio_rate ?
+      config->audio_classifier_config.input_audio_rate : 44100;
+  gboolean ret = TRUE;
+  guint i;
+
+  if (!nvds_audio_ingest_register ()) {
+    NVGSTDS_ERR_MSG_V ("Could not register '%s'", NVDS_ELEM_AUDIO_INGEST);
+    return FALSE;
+  }
+  nvds_audio_resampler_precompute (out_rate);
+
+  g_print ("resampler to %u Hz, %u s of mono audio per run:\n", out_rate,
+      RESAMPLE_BENCHMARK_SECONDS);
+  for (i = 0; i < G_N_ELEMENTS (resample_benchmark_rates); i++) {
+    guint in_rate = resample_benchmark_rates[i];
+    NvDsAudioResampler *rs = nvds_audio_resampler_new (in_rate, out_rate, 1);
+    gdouble snr = resampler_snr (in_rate, out_rate);
+    gdouble legacy, ingest;
+    gboolean pass = snr >= RESAMPLE_MIN_SNR_DB;
+
+    benchmark_resampler_elements (in_rate, out_rate, &legacy, &ingest);
+    g_print ("  %5u Hz: %s, SNR %.1f dB (%s), %.0fx real time;"
+        " audioresample %.0fx, " NVDS_ELEM_AUDIO_INGEST " %.0fx (%.2fx)\n",
+        in_rate, nvds_audio_resampler_is_passthrough (rs) ? "passthrough" :
+        "polyphase", snr, pass ? "PASS" : "FAIL",
+        resampler_speed (in_rate, out_rate), legacy, ingest,
+        legacy > 0.0 ? ingest / legacy : 0.0);
+    nvds_audio_resampler_free (rs);
+    ret &= pass;
+  }
+
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+static void
+append_decoded_samples (GstElement *sink, GstBuffer *buf, GstPad *pad,
+    gpointer user_data)
+{
+  GArray *samples = (GArray *) user_data;
+  GstMapInfo map;
+
+  if (!gst_buffer_map (buf, &map, GST_MAP_READ))
+    return;
+  g_array_append_vals (samples, map.data, map.size / sizeof (gfloat));
+  gst_buffer_unmap (buf, &map);
+}
+
+/* Mono F32 samples of an audio file at @p rate, NULL on error. */
+static GArray *
+decode_audio_file (const gchar *path, guint rate)
+{
+  gchar *description = g_strdup_printf (TENSOR_DECODE_PIPELINE, path, rate);
+  GstElement *pipeline = create_test_pipeline (description);
+  GArray *samples = g_array_new (FALSE, FALSE, sizeof (gfloat));
+  GstElement *sink;
+
+  g_free (description);
+  if (!pipeline)
+    goto error;
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (G_OBJECT (sink), "handoff",
+      G_CALLBACK (append_decoded_samples), samples);
+  gst_object_unref (sink);
+
+  if (run_pipeline (pipeline) < 0) {
+    NVGSTDS_ERR_MSG_V ("Could not decode '%s'", path);
+    goto error;
+  }
+  return samples;
+
+error:
+  g_array_free (samples, TRUE);
+  return NULL;
+}
+
+/*
+ * Top-1 class of a fixed random linear probe on the window, mean pooled
+ * over TENSOR_PROBE_SEGMENTS time segments and centered. The model itself
+ * only runs in TensorRT, so the probe measures how often the precision
+ * loss changes the argmax of a linear read-out of the features.
+ */
+static guint
+probe_top1 (const gfloat *weights, const gfloat *window, guint num_frames,
+    guint num_mels, gfloat *pooled)
+{
+  guint num_features = TENSOR_PROBE_SEGMENTS * num_mels;
+  gdouble mean = 0.0, best = -G_MAXDOUBLE;
+  guint best_class = 0;
+  guint s, f, m, c;
+
+  for (s = 0; s < TENSOR_PROBE_SEGMENTS; s++) {
+    guint first = s * num_frames / TENSOR_PROBE_SEGMENTS;
+    guint last = (s + 1) * num_frames / TENSOR_PROBE_SEGMENTS;
+    for (m = 0; m < num_mels; m++) {
+      gdouble acc = 0.0;
+      for (f = first; f < last; f++)
+        acc += window[f * num_mels + m];
+      pooled[s * num_mels + m] = acc / MAX (last - first, 1);
+      mean += pooled[s * num_mels + m];
+    }
+  }
+  mean /= num_features;
+
+  for (c = 0; c < TENSOR_PROBE_CLASSES; c++) {
+    const gfloat *w = weights + (gsize) c * num_features;
+    gdouble score = 0.0;
+    for (f = 0; f < num_features; f++)
+      score += w[f] * (pooled[f] - mean);
+    if (score > best) {
+      best = score;
+      best_class = c;
+    }
+  }
+  return best_class;
+}
+
+gboolean
+run_audio_tensor_format_test (NvDsConfig *config)
+{
+  static const NvDsAudioTensorFormat formats[] = {
+    NVDS_AUDIO_TENSOR_FP16, NVDS_AUDIO_TENSOR_INT8
+  };
+  NvDsGieConfig *gie = &config->audio_classifier_config;
+  NvDsAudioTransformParams params;
+  NvDsMelFrontend *fe = NULL;
+  NvDsMelRing *ring = NULL;
+  GArray *samples = NULL;
+  guint frame_size = gie->is_frame_size_set ? gie->frame_size :
+      DEFAULT_FRAME_SIZE;
+  guint hop_size = gie->is_hop_size_set ? gie->hop_size : DEFAULT_HOP_SIZE;
+  guint num_frames, num_values, num_windows = 0;
+  guint agree[G_N_ELEMENTS (formats)] = { 0 };
+  gdouble max_err[G_N_ELEMENTS (formats)] = { 0 };
+  gdouble sum_err[G_N_ELEMENTS (formats)] = { 0 };
+  gfloat *weights = NULL, *pooled = NULL;
+  gfloat *window = NULL, *restored = NULL;
+  gpointer packed = NULL;
+  guint32 seed = 1;
+  gboolean ret = FALSE;
+  guint64 w;
+  guint i, f;
+
+  if (!nvds_audio_transform_params_parse (gie->audio_transform ?
+          gie->audio_transform : DEFAULT_AUDIO_TRANSFORM, &params))
+    goto done;
+  num_frames = nvds_audio_transform_num_frames (&params, frame_size);
+  num_values = num_frames * params.num_mels;
+  if (!num_frames) {
+    NVGSTDS_ERR_MSG_V ("audio-framesize %u shorter than fft_length %u",
+        frame_size, params.fft_length);
+    goto done;
+  }
+
+  if (!nvds_audio_ingest_register ()) {
+    NVGSTDS_ERR_MSG_V ("Could not register '%s'", NVDS_ELEM_AUDIO_INGEST);
+    goto done;
+  }
+  samples = decode_audio_file (config->audio_tensor_format_test,
+      params.sample_rate);
+  if (!samples)
+    goto done;
+  if (samples->len < frame_size) {
+    NVGSTDS_ERR_MSG_V ("'%s' is shorter than one window",
+        config->audio_tensor_format_test);
+    goto done;
+  }
+
+  /* Mel columns of the whole recording, windows cut as in the front-end. */
+  fe = nvds_mel_frontend_new (&params);
+  ring = nvds_mel_ring_new (fe, nvds_audio_transform_num_frames (&params,
+          samples->len));
+  nvds_mel_ring_push_samples (ring, (gfloat *) samples->data, samples->len);
+
+  weights = g_new (gfloat, (gsize) TENSOR_PROBE_CLASSES *
+      TENSOR_PROBE_SEGMENTS * params.num_mels);
+  for (i = 0; i < TENSOR_PROBE_CLASSES * TENSOR_PROBE_SEGMENTS *
+      params.num_mels; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    weights[i] = (seed >> 8) / 8388608.0 - 1.0;
+  }
+  pooled = g_new (gfloat, TENSOR_PROBE_SEGMENTS * params.num_mels);
+  window = g_new (gfloat, num_values);
+  restored = g_new (gfloat, num_values);
+  packed = g_malloc ((gsize) num_values * sizeof (gfloat));
+
+  for (w = 0; (guint64) w * hop_size + frame_size <= samples->len; w++) {
+    guint64 first_column = (w * hop_size + params.hop_size / 2) /
+        params.hop_size;
+    guint reference;
+
+    if (!nvds_mel_ring_assemble (ring, first_column, num_frames, window))
+      break;
+    reference = probe_top1 (weights, window, num_frames, params.num_mels,
+        pooled);
+
+    for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+      gfloat scale;
+      gint zero_point;
+
+      nvds_audio_tensor_pack (formats[f], window, num_values, packed, &scale,
+          &zero_point);
+      nvds_audio_tensor_unpack (formats[f], packed, num_values, scale,
+          zero_point, restored);
+      for (i = 0; i < num_values; i++) {
+        gdouble err = fabs (restored[i] - window[i]);
+        max_err[f] = MAX (max_err[f], err);
+        sum_err[f] += err;
+      }
+      if (probe_top1 (weights, restored, num_frames, params.num_mels,
+              pooled) == reference)
+        agree[f]++;
+    }
+    num_windows++;
+  }
+
+  ret = num_windows > 0;
+  g_print ("feature tensors of %u windows of '%s' (%ux%u):\n", num_windows,
+      config->audio_tensor_format_test, num_frames, params.num_mels);
+  for (f = 0; f < G_N_ELEMENTS (formats) && num_windows; f++) {
+    gdouble agreement = (gdouble) agree[f] / num_windows;
+    gboolean pass = agreement >= TENSOR_MIN_AGREEMENT;
+
+    g_print ("  %s: %" G_GSIZE_FORMAT " bytes (%.0f%% of fp32), max error"
+        " %.3f dB, mean error %.4f dB, top-1 agreement %.2f%% (%s)\n",
+        nvds_audio_tensor_format_get_name (formats[f]),
+        (gsize) num_values * nvds_audio_tensor_element_size (formats[f]),
+        100.0 * nvds_audio_tensor_element_size (formats[f]) / sizeof (gfloat),
+        max_err[f], sum_err[f] / ((gdouble) num_windows * num_values),
+        100.0 * agreement, pass ? "PASS" : "FAIL");
+    ret &= pass;
+  }
+
+done:
+  g_free (packed);
+  g_free (restored);
+  g_free (window);
+  g_free (pooled);
+  g_free (weights);
+  nvds_mel_ring_free (ring);
+  nvds_mel_frontend_free (fe);
+  if (samples)
+    g_array_free (samples, TRUE);
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+gboolean
+run_cpu_streaming_test (NvDsConfig *config)
+{
+  NvDsGieConfig *gie = &config->audio_classifier_config;
+  NvDsAudioTransformParams params;
+  NvDsMelFrontend *fe = NULL;
+  NvDsMelRing *ring = NULL;
+  NvDsCpuNet *net = NULL;
+  NvDsCpuNetWorkspace *ws = NULL;
+  NvDsCpuNetStream *stream = NULL;
+  const NvDsCpuNetStreamStats *stats;
+  GArray *samples = NULL;
+  guint frame_size = gie->is_frame_size_set ? gie->frame_size :
+      DEFAULT_FRAME_SIZE;
+  guint hop_size = gie->is_hop_size_set ? gie->hop_size : DEFAULT_HOP_SIZE;
+  guint channels, height, width, num_frames, num_outputs, num_layers;
+  guint num_windows = 0, agree = 0;
+  gfloat *window = NULL, *input = NULL, *full = NULL, *streamed = NULL;
+  gint64 full_time = 0, stream_time = 0, start;
+  gdouble max_diff = 0.0;
+  gboolean time_major, pass, ret = FALSE;
+  guint64 w;
+  guint i, f, m;
+
+  if (gie->plugin_type != NV_DS_GIE_PLUGIN_CPU ||
+      !gie->model_engine_file_path) {
+    NVGSTDS_ERR_MSG_V ("[audio-classifier] needs plugin-type=%u and"
+        " model-engine-file", NV_DS_GIE_PLUGIN_CPU);
+    goto done;
+  }
+  if (!nvds_audio_transform_params_parse (gie->audio_transform ?
+          gie->audio_transform : DEFAULT_AUDIO_TRANSFORM, &params))
+    goto done;
+  num_frames = nvds_audio_transform_num_frames (&params, frame_size);
+
+  net = nvds_cpu_net_load (GET_FILE_PATH (gie->model_engine_file_path));
+  if (!net)
+    goto done;
+  nvds_cpu_net_get_input_dims (net, &channels, &height, &width);
+  time_major = height == num_frames && width == params.num_mels;
+  if (channels != 1 || (!time_major && !(height == params.num_mels &&
+              width == num_frames))) {
+    NVGSTDS_ERR_MSG_V ("Network input %u x %u x %u doesn't match %u mels x %u"
+        " frames", channels, height, width, params.num_mels, num_frames);
+    goto done;
+  }
+  num_layers = nvds_cpu_net_enable_streaming (net, !time_major,
+      gie->streaming_layers ? gie->streaming_layers : G_MAXUINT);
+  if (!num_layers) {
+    NVGSTDS_ERR_MSG_V ("The first layer of the network can't be streamed");
+    goto done;
+  }
+  num_outputs = nvds_cpu_net_get_output_size (net);
+  ws = nvds_cpu_net_workspace_new (net, 1);
+  stream = nvds_cpu_net_stream_new (net);
+
+  if (!nvds_audio_ingest_register ()) {
+    NVGSTDS_ERR_MSG_V ("Could not register '%s'", NVDS_ELEM_AUDIO_INGEST);
+    goto done;
+  }
+  samples = decode_audio_file (config->cpu_streaming_test,
+      params.sample_rate);
+  if (!samples)
+    goto done;
+  if (samples->len < frame_size) {
+    NVGSTDS_ERR_MSG_V ("'%s' is shorter than one window",
+        config->cpu_streaming_test);
+    goto done;
+  }
+
+  fe = nvds_mel_frontend_new (&params);
+  ring = nvds_mel_ring_new (fe, nvds_audio_transform_num_frames (&params,
+          samples->len));
+  nvds_mel_ring_push_samples (ring, (gfloat *) samples->data, samples->len);
+
+  window = g_new (gfloat, (gsize) num_frames * params.num_mels);
+  input = g_new (gfloat, (gsize) num_frames * params.num_mels);
+  full = g_new (gfloat, num_outputs);
+  streamed = g_new (gfloat, num_outputs);
+
+  for (w = 0; (guint64) w * hop_size + frame_size <= samples->len; w++) {
+    guint64 first_column = (w * hop_size + params.hop_size / 2) /
+        params.hop_size;
+    guint best_full = 0, best_streamed = 0;
+
+    if (!nvds_mel_ring_assemble (ring, first_column, num_frames, window))
+      break;
+    if (time_major) {
+      memcpy (input, window, (gsize) num_frames * params.num_mels *
+          sizeof (gfloat));
+    } else {
+      for (f = 0; f < num_frames; f++)
+        for (m = 0; m < params.num_mels; m++)
+          input[m * num_frames + f] = window[f * params.num_mels + m];
+    }
+
+    start = g_get_monotonic_time ();
+    nvds_cpu_net_run (net, ws, input, 1, full);
+    full_time += g_get_monotonic_time () - start;
+    start = g_get_monotonic_time ();
+    nvds_cpu_net_run_streams (net, ws, &stream, &first_column, input, 1,
+        streamed);
+    stream_time += g_get_monotonic_time () - start;
+
+    for (i = 0; i < num_outputs; i++) {
+      max_diff = MAX (max_diff, fabs (full[i] - streamed[i]));
+      if (full[i] > full[best_full])
+        best_full = i;
+      if (streamed[i] > streamed[best_streamed])
+        best_streamed = i;
+    }
+    if (best_full == best_streamed)
+      agree++;
+    num_windows++;
+  }
+
+  stats = nvds_cpu_net_stream_get_stats (stream);
+  pass = num_windows > 0 && max_diff <= CPU_STREAMING_TOLERANCE;
+  g_print ("%u windows of '%s', %u streamed layers, %.1f MB per source:\n"
+      "  %.1f%% of the windows reused activations, %.1f%% of the time steps"
+      " computed\n"
+      "  full window %.2f ms, streaming %.2f ms per window (%.2fx)\n"
+      "  max difference %g (tolerance %g), top-1 agreement %.2f%% (%s)\n",
+      num_windows, config->cpu_streaming_test, num_layers,
+      nvds_cpu_net_get_stream_size (net) / 1048576.0,
+      stats->reused * 100.0 / MAX (stats->windows, 1),
+      stats->steps_computed * 100.0 / MAX (stats->steps, 1),
+      full_time / 1e3 / MAX (num_windows, 1),
+      stream_time / 1e3 / MAX (num_windows, 1),
+      (gdouble) full_time / MAX (stream_time, 1), max_diff,
+      CPU_STREAMING_TOLERANCE, agree * 100.0 / MAX (num_windows, 1),
+      pass ? "PASS" : "FAIL");
+  ret = pass;
+
+done:
+  g_free (streamed);
+  g_free (full);
+  g_free (input);
+  g_free (window);
+  nvds_mel_ring_free (ring);
+  nvds_mel_frontend_free (fe);
+  if (samples)
+    g_array_free (samples, TRUE);
+  nvds_cpu_net_stream_free (stream);
+  nvds_cpu_net_workspace_free (ws);
+  nvds_cpu_net_free (net);
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+static gboolean
+send_all (gint fd, const guint8 *data, gsize size)
+{
+  while (size) {
+    gssize n = send (fd, data, size, MSG_NOSIGNAL);
+
+    if (n <= 0)
+      return FALSE;
+    data += n;
+    size -= n;
+  }
+  return TRUE;
+}
+
+/*
+ * Send the @p num_columns columns of @p ring in frames of
+ * REMOTE_MEL_FRAME_COLUMNS, looping, each frame when its last sample would
+ * have been recorded. Returns when the client disconnects.
+ */
+static void
+serve_remote_mel_client (gint fd, NvDsMelRing *ring, guint num_columns,
+    const NvDsAudioTransformParams *params, NvDsAudioTensorFormat format)
+{
+  guint8 *frame = g_malloc (NVDS_REMOTE_MEL_HEADER_SIZE +
+      (gsize) REMOTE_MEL_FRAME_COLUMNS * params->num_mels * sizeof (gfloat));
+  gint64 start = g_get_monotonic_time ();
+  gint64 last_report = start;
+  guint64 column = 0, bytes = 0;
+
+  while (TRUE) {
+    guint offset = column % num_columns;
+    guint n = MIN (REMOTE_MEL_FRAME_COLUMNS, num_columns - offset);
+    NvDsRemoteMelHeader header = {
+      NVDS_REMOTE_MEL_MAGIC, NVDS_REMOTE_MEL_VERSION, format,
+      params->num_mels, n, params->hop_size, params->sample_rate, column,
+      1.0f, 0
+    };
+    gint64 deadline = start + (gint64) ((column + n) * params->hop_size *
+        G_USEC_PER_SEC / params->sample_rate);
+    gint64 now = g_get_monotonic_time ();
+    gsize size;
+
+    nvds_audio_tensor_pack (format,
+        ring->columns + (gsize) offset * params->num_mels,
+        n * params->num_mels, frame + NVDS_REMOTE_MEL_HEADER_SIZE,
+        &header.scale, &header.zero_point);
+    nvds_remote_mel_header_write (&header, frame);
+    size = NVDS_REMOTE_MEL_HEADER_SIZE + nvds_remote_mel_payload_size (&header);
+
+    if (deadline > now)
+      g_usleep (deadline - now);
+    if (!send_all (fd, frame, size))
+      break;
+    column += n;
+    bytes += size;
+
+    now = g_get_monotonic_time ();
+    if (now - last_report >= REMOTE_MEL_REPORT_INTERVAL_SEC * G_USEC_PER_SEC) {
+      gdouble rate = bytes * (gdouble) G_USEC_PER_SEC / (now - start);
+
+      g_print ("remote mel sender: %" G_GUINT64_FORMAT " columns, %.1f kB/s"
+          " (%.1fx less than 16 bit mono PCM)\n", column, rate / 1000.0,
+          2.0 * params->sample_rate / rate);
+      last_report = now;
+    }
+  }
+  g_free (frame);
+}
+
+gboolean
+run_remote_mel_sender (NvDsConfig *config)
+{
+  NvDsGieConfig *gie = &config->audio_classifier_config;
+  NvDsAudioTensorFormat format = config->audio_frontend_config.tensor_format;
+  guint port = config->remote_mel_sender_port ?
+      config->remote_mel_sender_port : REMOTE_MEL_DEFAULT_PORT;
+  NvDsAudioTransformParams params;
+  NvDsMelFrontend *fe = NULL;
+  NvDsMelRing *ring = NULL;
+  GArray *samples = NULL;
+  struct sockaddr_in addr;
+  guint num_columns;
+  gint fd = -1;
+  gint one = 1;
+  gboolean ret = FALSE;
+
+  if (!nvds_audio_transform_params_parse (gie->audio_transform ?
+          gie->audio_transform : DEFAULT_AUDIO_TRANSFORM, &params))
+    goto done;
+  if (params.num_mels > G_MAXUINT16 || params.hop_size > G_MAXUINT16 ||
+      port > G_MAXUINT16) {
+    NVGSTDS_ERR_MSG_V ("Transform or port out of range of the mel framing");
+    goto done;
+  }
+
+  if (!nvds_audio_ingest_register ()) {
+    NVGSTDS_ERR_MSG_V ("Could not register '%s'", NVDS_ELEM_AUDIO_INGEST);
+    goto done;
+  }
+  samples = decode_audio_file (config->remote_mel_sender, params.sample_rate);
+  if (!samples)
+    goto done;
+
+  /* The columns of the whole recording are computed once. */
+  fe = nvds_mel_frontend_new (&params);
+  num_columns = nvds_audio_transform_num_frames (&params, samples->len);
+  if (!num_columns) {
+    NVGSTDS_ERR_MSG_V ("'%s' is shorter than fft_length %u",
+        config->remote_mel_sender, params.fft_length);
+    goto done;
+  }
+  ring = nvds_mel_ring_new (fe, num_columns);
+  nvds_mel_ring_push_samples (ring, (gfloat *) samples->data, samples->len);
+
+  fd = socket (AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    NVGSTDS_ERR_MSG_V ("Could not create socket: %s", strerror (errno));
+    goto done;
+  }
+  setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one));
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl (INADDR_ANY);
+  addr.sin_port = htons (port);
+  if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0 ||
+      listen (fd, 1) < 0) {
+    NVGSTDS_ERR_MSG_V ("Could not listen on port %u: %s", port,
+        strerror (errno));
+    goto done;
+  }
+
+  g_print ("remote mel sender: %u columns of '%s' as %s frames on port %u\n",
+      num_columns, config->remote_mel_sender,
+      nvds_audio_tensor_format_get_name (format), port);
+  while (TRUE) {
+    gint client = accept (fd, NULL, NULL);
+
+    if (client < 0) {
+      NVGSTDS_ERR_MSG_V ("accept failed: %s", strerror (errno));
+      goto done;
+    }
+    g_print ("remote mel sender: client connected\n");
+    serve_remote_mel_client (client, ring, num_columns, &params, format);
+    close (client);
+    g_print ("remote mel sender: client disconnected\n");
+  }
+
+done:
+  if (fd >= 0)
+    close (fd);
+  nvds_mel_ring_free (ring);
+  nvds_mel_frontend_free (fe);
+  if (samples)
+    g_array_free (samples, TRUE);
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+/* Stand-in microphone of the HTTP WAV benchmark. */
+typedef struct
+{
+  gint fd;
+  guint port;
+  GThread *thread;
+  GMutex lock;
+  GList *clients;
+  /** Close the first connection half way, as a microphone losing power. */
+  gboolean drop_first;
+  gint connections;
+  guint8 *samples;
+  gsize size;
+  /** Stream served as it is instead of WAV of the samples, e.g. FLAC. */
+  const guint8 *body;
+  gsize body_size;
+} HttpWavServer;
+
+typedef struct
+{
+  HttpWavServer *server;
+  gint fd;
+} HttpWavClient;
+
+static void
+write_wav_header (guint8 *header, guint rate, guint32 data_size)
+{
+  memcpy (header, "RIFF", 4);
+  GST_WRITE_UINT32_LE (header + 4, data_size == G_MAXUINT32 ? G_MAXUINT32 :
+      36 + data_size);
+  memcpy (header + 8, "WAVEfmt ", 8);
+  GST_WRITE_UINT32_LE (header + 16, 16);
+  GST_WRITE_UINT16_LE (header + 20, 1);
+  GST_WRITE_UINT16_LE (header + 22, 1);
+  GST_WRITE_UINT32_LE (header + 24, rate);
+  GST_WRITE_UINT32_LE (header + 28, rate * 2);
+  GST_WRITE_UINT16_LE (header + 32, 2);
+  GST_WRITE_UINT16_LE (header + 34, 16);
+  memcpy (header + 36, "data", 4);
+  GST_WRITE_UINT32_LE (header + 40, data_size);
+}
+
+/*
+ * Answer one GET with the samples as fast as the client takes them. With
+ * drop_first, the first connection is an endless stream closed half way
+ * and the next one sends the rest with a bounded header.
+ */
+static gpointer
+serve_http_wav_client (gpointer data)
+{
+  HttpWavClient *client = (HttpWavClient *) data;
+  HttpWavServer *server = client->server;
+  gint connection = g_atomic_int_add (&server->connections, 1);
+  GString *request = g_string_new (NULL);
+  const guint8 *samples = server->samples;
+  gsize size = server->size;
+  guint8 header[44];
+  gchar *response;
+  gchar buf[1024];
+
+  while (!strstr (request->str, "\r\n\r\n")) {
+    gssize n = recv (client->fd, buf, sizeof (buf), 0);
+
+    if (n <= 0)
+      goto done;
+    g_string_append_len (request, buf, n);
+  }
+
+  if (server->body) {
+    response = g_strdup_printf ("HTTP/1.1 200 OK\r\n"
+        "Content-Length: %" G_GSIZE_FORMAT "\r\n\r\n", server->body_size);
+    if (send_all (client->fd, (guint8 *) response, strlen (response)))
+      send_all (client->fd, server->body, server->body_size);
+    g_free (response);
+    goto done;
+  }
+
+  if (server->drop_first && connection == 0) {
+    size /= 2;
+    write_wav_header (header, HTTP_WAV_BENCHMARK_RATE, G_MAXUINT32);
+    response = g_strdup ("HTTP/1.1 200 OK\r\n"
+        "Content-Type: audio/wav\r\n\r\n");
+  } else {
+    if (server->drop_first) {
+      samples += size / 2;
+      size -= size / 2;
+    }
+    write_wav_header (header, HTTP_WAV_BENCHMARK_RATE, size);
+    response = g_strdup_printf ("HTTP/1.1 200 OK\r\n"
+        "Content-Type: audio/wav\r\n"
+        "Content-Length: %" G_GSIZE_FORMAT "\r\n\r\n", sizeof (header) + size);
+  }
+  if (send_all (client->fd, (guint8 *) response, strlen (response)) &&
+      send_all (client->fd, header, sizeof (header)))
+    send_all (client->fd, samples, size);
+  g_free (response);
+
+done:
+  g_string_free (request, TRUE);
+  close (client->fd);
+  g_free (client);
+  return NULL;
+}
+
+static gpointer
+accept_http_wav_clients (gpointer data)
+{
+  HttpWavServer *server = (HttpWavServer *) data;
+  gint fd;
+
+  /* Ends when the listening socket is shut down. */
+  while ((fd = accept (server->fd, NULL, NULL)) >= 0) {
+    HttpWavClient *client = g_new0 (HttpWavClient, 1);
+
+    client->server = server;
+    client->fd = fd;
+    g_mutex_lock (&server->lock);
+    server->clients = g_list_prepend (server->clients,
+        g_thread_new ("http-wav-client", serve_http_wav_client, client));
+    g_mutex_unlock (&server->lock);
+  }
+  return NULL;
+}
+
+static gboolean
+start_http_wav_server (HttpWavServer *server)
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof (addr);
+  gint16 *samples;
+  guint i, n = HTTP_WAV_BENCHMARK_SECONDS * HTTP_WAV_BENCHMARK_RATE;
+
+  samples = g_new (gint16, n);
+  for (i = 0; i < n; i++)
+    samples[i] = (gint16) (8000.0 * sin (2.0 * G_PI * 3000.0 * i /
+            HTTP_WAV_BENCHMARK_RATE));
+  server->samples = (guint8 *) samples;
+  server->size = (gsize) n * sizeof (gint16);
+  g_mutex_init (&server->lock);
+
+  server->fd = socket (AF_INET, SOCK_STREAM, 0);
+  if (server->fd < 0) {
+    NVGSTDS_ERR_MSG_V ("Could not create socket: %s", strerror (errno));
+    return FALSE;
+  }
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  if (bind (server->fd, (struct sockaddr *) &addr, sizeof (addr)) < 0 ||
+      listen (server->fd, HTTP_WAV_BENCHMARK_MAX_SOURCES) < 0 ||
+      getsockname (server->fd, (struct sockaddr *) &addr, &len) < 0) {
+    NVGSTDS_ERR_MSG_V ("Could not listen: %s", strerror (errno));
+    return FALSE;
+  }
+  server->port = ntohs (addr.sin_port);
+  server->thread = g_thread_new ("http-wav-server", accept_http_wav_clients,
+      server);
+  return TRUE;
+}
+
+static void
+stop_http_wav_server (HttpWavServer *server)
+{
+  if (server->fd >= 0) {
+    shutdown (server->fd, SHUT_RDWR);
+    close (server->fd);
+  }
+  if (server->thread)
+    g_thread_join (server->thread);
+  g_list_free_full (server->clients, (GDestroyNotify) g_thread_join);
+  g_mutex_clear (&server->lock);
+  g_free (server->samples);
+}
+
+/* Arrival times of the buffers of one source. */
+typedef struct
+{
+  gint64 first;
+  gint64 last;
+  gint64 max_gap;
+  gint *pending;
+  gsize *rss;
+} HttpWavSink;
+
+static gsize
+get_rss (void)
+{
+  FILE *file = fopen ("/proc/self/statm", "r");
+  unsigned long pages = 0, resident = 0;
+
+  if (file) {
+    if (fscanf (file, "%lu %lu", &pages, &resident) != 2)
+      resident = 0;
+    fclose (file);
+  }
+  return resident * sysconf (_SC_PAGESIZE);
+}
+
+static GstPadProbeReturn
+http_wav_sink_probe (GstPad *pad, GstPadProbeInfo *info, gpointer u_data)
+{
+  HttpWavSink *sink = (HttpWavSink *) u_data;
+  gint64 now = g_get_monotonic_time ();
+
+  if (!sink->first) {
+    sink->first = now;
+    /* Memory of all sources once the last one is streaming. */
+    if (g_atomic_int_dec_and_test (sink->pending))
+      *sink->rss = get_rss ();
+  } else {
+    sink->max_gap = MAX (sink->max_gap, now - sink->last);
+  }
+  sink->last = now;
+  return GST_PAD_PROBE_OK;
+}
+
+static gdouble
+get_cpu_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct
+{
+  /** Mean time from PLAYING to the first buffer, ms. */
+  gdouble connect_ms;
+  /** CPU per second of audio and source, ms. */
+  gdouble cpu_ms;
+  /** Resident memory per source while streaming, bytes. */
+  gdouble rss;
+  /** Longest gap between buffers of a source, ms. */
+  gdouble max_gap_ms;
+} HttpWavStats;
+
+/*
+ * Stream the served audio to num_sources copies of @p source, a pipeline
+ * fragment with one %u for the port, each through nvdsaudioingest.
+ */
+static gboolean
+benchmark_http_source (HttpWavServer *server, const gchar *source,
+    guint num_sources, HttpWavStats *stats)
+{
+  GString *description = g_string_new (NULL);
+  HttpWavSink sinks[HTTP_WAV_BENCHMARK_MAX_SOURCES];
+  GstElement *pipeline;
+  gint pending = num_sources;
+  gsize rss_before, rss = 0;
+  gdouble cpu;
+  gint64 start, elapsed;
+  guint i;
+
+  memset (sinks, 0, sizeof (sinks));
+  memset (stats, 0, sizeof (*stats));
+  for (i = 0; i < num_sources; i++) {
+    g_string_append_printf (description, source, server->port);
+    g_string_append_printf (description, " ! " NVDS_ELEM_AUDIO_INGEST
+        " rate=%u cutoff=120 ! fakesink sync=false name=sink%u ",
+        HTTP_WAV_BENCHMARK_RATE, i);
+  }
+  rss_before = get_rss ();
+  pipeline = create_test_pipeline (description->str);
+  g_string_free (description, TRUE);
+  if (!pipeline)
+    return FALSE;
+
+  for (i = 0; i < num_sources; i++) {
+    gchar name[32];
+    GstElement *sink;
+    GstPad *pad;
+
+    g_snprintf (name, sizeof (name), "sink%u", i);
+    sink = gst_bin_get_by_name (GST_BIN (pipeline), name);
+    pad = gst_element_get_static_pad (sink, "sink");
+    sinks[i].pending = &pending;
+    sinks[i].rss = &rss;
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, http_wav_sink_probe,
+        &sinks[i], NULL);
+    gst_object_unref (pad);
+    gst_object_unref (sink);
+  }
+
+  cpu = get_cpu_time ();
+  start = g_get_monotonic_time ();
+  elapsed = run_pipeline (pipeline);
+  cpu = get_cpu_time () - cpu;
+  if (elapsed < 0)
+    return FALSE;
+
+  for (i = 0; i < num_sources; i++) {
+    stats->connect_ms += (sinks[i].first - start) / 1000.0 / num_sources;
+    stats->max_gap_ms = MAX (stats->max_gap_ms, sinks[i].max_gap / 1000.0);
+  }
+  stats->cpu_ms = cpu * 1000.0 / (HTTP_WAV_BENCHMARK_SECONDS * num_sources);
+  stats->rss = rss > rss_before ? (gdouble) (rss - rss_before) / num_sources :
+      0.0;
+  return TRUE;
+}
+
+gboolean
+run_http_wav_benchmark (NvDsConfig *config)
+{
+  guint num_sources = CLAMP (config->http_wav_benchmark, 1,
+      HTTP_WAV_BENCHMARK_MAX_SOURCES);
+  HttpWavServer server;
+  HttpWavStats legacy, native, reconnect;
+  gboolean ret = FALSE;
+
+  memset (&server, 0, sizeof (server));
+  server.fd = -1;
+  if (!nvds_audio_ingest_register () || !nvds_http_wav_src_register ()) {
+    NVGSTDS_ERR_MSG_V ("Could not register the ingest elements");
+    goto done;
+  }
+  if (!start_http_wav_server (&server))
+    goto done;
+
+  if (!benchmark_http_source (&server, NVDS_ELEM_SRC_URI
+          " uri=http://127.0.0.1:%u/stream.wav", num_sources, &legacy) ||
+      !benchmark_http_source (&server, NVDS_ELEM_SRC_HTTP_WAV
+          " location=http://127.0.0.1:%u/stream.wav", num_sources, &native))
+    goto done;
+
+  /* One source losing its connection half way. */
+  server.drop_first = TRUE;
+  g_atomic_int_set (&server.connections, 0);
+  if (!benchmark_http_source (&server, NVDS_ELEM_SRC_HTTP_WAV
+          " location=http://127.0.0.1:%u/stream.wav retry-delay=0", 1,
+          &reconnect))
+    goto done;
+
+  g_print ("HTTP WAV sources, %u x %u s of %u Hz 16 bit mono:\n", num_sources,
+      HTTP_WAV_BENCHMARK_SECONDS, HTTP_WAV_BENCHMARK_RATE);
+  g_print ("  " NVDS_ELEM_SRC_URI ": first buffer after %.1f ms, %.3f ms CPU"
+      " per audio second, %.0f kB per source\n", legacy.connect_ms,
+      legacy.cpu_ms, legacy.rss / 1024.0);
+  g_print ("  " NVDS_ELEM_SRC_HTTP_WAV ": first buffer after %.1f ms, %.3f ms"
+      " CPU per audio second, %.0f kB per source (%.1fx faster connect,"
+      " %.2fx CPU)\n", native.connect_ms, native.cpu_ms, native.rss / 1024.0,
+      native.connect_ms > 0.0 ? legacy.connect_ms / native.connect_ms : 0.0,
+      legacy.cpu_ms > 0.0 ? native.cpu_ms / legacy.cpu_ms : 0.0);
+  g_print ("  " NVDS_ELEM_SRC_HTTP_WAV ": reconnect after a lost connection"
+      " within %.1f ms, %d connections\n", reconnect.max_gap_ms,
+      g_atomic_int_get (&server.connections));
+  ret = g_atomic_int_get (&server.connections) == 2;
+
+done:
+  stop_http_wav_server (&server);
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+/*
+ * Dawn chorus stand-in: every 400 ms a 150 ms call sweeping 2.25 kHz up
+ * from 2.5, 3.5, 4.5 or 5.5 kHz, over faint noise, so that the codecs see
+ * transients and quiet gaps.
+ */
+static void
+fill_chorus_signal (gint16 *x, guint n, guint sample_rate)
+{
+  guint32 seed = 1;
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    gdouble t = (gdouble) i / sample_rate;
+    gdouble pos = fmod (t, 0.4);
+    gdouble v;
+
+    seed = seed * 1664525u + 1013904223u;
+    v = 300.0 * ((seed >> 8) / 16777216.0 - 0.5);
+    if (pos < 0.15) {
+      gdouble f0 = 2500.0 + 1000.0 * fmod (floor (t / 0.4), 4.0);
+
+      v += 8000.0 * sin (G_PI * pos / 0.15) *
+          sin (2.0 * G_PI * (f0 + 7500.0 * pos) * pos);
+    }
+    x[i] = (gint16) v;
+  }
+}
+
+/* Decode a stream of nvds_audio_encode() in one piece. */
+static GByteArray *
+decode_compressed_stream (NvDsAudioCodec codec, const GByteArray *stream,
+    const gchar **format)
+{
+  NvDsAudioDecoder *dec;
+  GByteArray *out = g_byte_array_new ();
+  gsize offset = 0;
+  guint rate, channels;
+  gboolean ok;
+
+  if (codec == NVDS_AUDIO_CODEC_IMA_ADPCM) {
+    /* The encoder writes a 60 byte header; block_align is at 32. */
+    dec = nvds_audio_decoder_new_ima_adpcm (HTTP_WAV_BENCHMARK_RATE, 1,
+        GST_READ_UINT16_LE (stream->data + 32));
+    offset = 60;
+  } else {
+    dec = nvds_audio_decoder_new (codec);
+  }
+  ok = dec && nvds_audio_decoder_decode (dec, stream->data + offset,
+      stream->len - offset, out) &&
+      nvds_audio_decoder_get_format (dec, format, &rate, &channels);
+  nvds_audio_decoder_free (dec);
+  if (!ok) {
+    g_byte_array_unref (out);
+    return NULL;
+  }
+  return out;
+}
+
+/* SNR of decoded S16LE or F32LE samples; @p exact if they equal @p ref. */
+static gdouble
+decoded_snr (const gint16 *ref, guint n, const GByteArray *decoded,
+    const gchar *format, gboolean *exact)
+{
+  gboolean is_float = !strcmp (format, "F32LE");
+  guint frames = decoded->len / (is_float ? 4 : 2), i;
+  gdouble signal = 0.0, noise = 0.0;
+
+  *exact = frames == n;
+  for (i = 0; i < MIN (n, frames); i++) {
+    gdouble x = ref[i];
+    gdouble y = is_float ? ((const gfloat *) decoded->data)[i] * 32768.0 :
+        ((const gint16 *) decoded->data)[i];
+
+    signal += x * x;
+    noise += (x - y) * (x - y);
+    if (x != y)
+      *exact = FALSE;
+  }
+  return noise > 0.0 ? 10.0 * log10 (signal / noise) : INFINITY;
+}
+
+gboolean
+run_compressed_ingest_benchmark (NvDsConfig *config)
+{
+  static const NvDsAudioCodec codecs[] = {
+    NVDS_AUDIO_CODEC_IMA_ADPCM, NVDS_AUDIO_CODEC_FLAC, NVDS_AUDIO_CODEC_OPUS
+  };
+  guint num_sources = CLAMP (config->compressed_ingest_benchmark, 1,
+      HTTP_WAV_BENCHMARK_MAX_SOURCES);
+  guint n = HTTP_WAV_BENCHMARK_SECONDS * HTTP_WAV_BENCHMARK_RATE;
+  gdouble pcm_rate = HTTP_WAV_BENCHMARK_RATE * 2 / 1000.0;
+  HttpWavServer server;
+  HttpWavStats pcm;
+  gboolean ret = FALSE;
+  guint i;
+
+  memset (&server, 0, sizeof (server));
+  server.fd = -1;
+  if (!nvds_audio_ingest_register () || !nvds_http_wav_src_register ()) {
+    NVGSTDS_ERR_MSG_V ("Could not register the ingest elements");
+    goto done;
+  }
+  if (!start_http_wav_server (&server))
+    goto done;
+  fill_chorus_signal ((gint16 *) server.samples, n, HTTP_WAV_BENCHMARK_RATE);
+
+  if (!benchmark_http_source (&server, NVDS_ELEM_SRC_HTTP_WAV
+          " location=http://127.0.0.1:%u/stream.wav", num_sources, &pcm))
+    goto done;
+  g_print ("Compressed microphone streams, %u x %u s of %u Hz mono, decoded"
+      " by up to %u threads:\n", num_sources, HTTP_WAV_BENCHMARK_SECONDS,
+      HTTP_WAV_BENCHMARK_RATE, g_get_num_processors ());
+  g_print ("  %-10s %6.1f kB/s, %.3f ms CPU per audio second\n", "PCM",
+      pcm_rate, pcm.cpu_ms);
+
+  ret = TRUE;
+  for (i = 0; i < G_N_ELEMENTS (codecs); i++) {
+    const gchar *name = nvds_audio_codec_get_name (codecs[i]);
+    GByteArray *stream, *decoded = NULL;
+    const gchar *format = NULL;
+    HttpWavStats stats;
+    gboolean exact;
+    gdouble snr, rate;
+
+    if (!nvds_audio_codec_is_available (codecs[i])) {
+      g_print ("  %-10s not available\n", name);
+      continue;
+    }
+    stream = nvds_audio_encode (codecs[i], (const gint16 *) server.samples,
+        n, HTTP_WAV_BENCHMARK_RATE, 1, COMPRESSED_BENCHMARK_OPUS_BITRATE);
+    if (stream)
+      decoded = decode_compressed_stream (codecs[i], stream, &format);
+    if (!decoded) {
+      NVGSTDS_ERR_MSG_V ("Could not encode and decode %s", name);
+      if (stream)
+        g_byte_array_unref (stream);
+      ret = FALSE;
+      continue;
+    }
+    snr = decoded_snr ((const gint16 *) server.samples, n, decoded, format,
+        &exact);
+    rate = stream->len / 1000.0 / HTTP_WAV_BENCHMARK_SECONDS;
+
+    server.body = stream->data;
+    server.body_size = stream->len;
+    if (benchmark_http_source (&server, NVDS_ELEM_SRC_HTTP_WAV
+            " location=http://127.0.0.1:%u/stream", num_sources, &stats)) {
+      gchar *quality = exact ? g_strdup ("lossless") :
+          g_strdup_printf ("SNR %.1f dB", snr);
+
+      g_print ("  %-10s %6.1f kB/s, %.1f%% bandwidth saved, %.3f ms CPU per"
+          " audio second (%+.3f ms against PCM), %s\n", name, rate,
+          100.0 * (1.0 - rate / pcm_rate), stats.cpu_ms,
+          stats.cpu_ms - pcm.cpu_ms, quality);
+      g_free (quality);
+    } else {
+      ret = FALSE;
+    }
+    server.body = NULL;
+    if (codecs[i] == NVDS_AUDIO_CODEC_FLAC && !exact) {
+      NVGSTDS_ERR_MSG_V ("FLAC did not decode bit exact");
+      ret = FALSE;
+    }
+    g_byte_array_unref (stream);
+    g_byte_array_unref (decoded);
+  }
+
+done:
+  stop_http_wav_server (&server);
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
+
+/**
+ * Samples the simulated source sends before buffer @p b, relative to the
+ * end of the previous one: lost, repeated and, with a new timeline,
+ * restarted.
+ */
+static gint64
+clock_test_skip (guint b, guint rate, gboolean *restart)
+{
+  *restart = FALSE;
+  switch (b) {
+    case 1000:
+      return CLOCK_TEST_LOST_BUFFERS * CLOCK_TEST_BUFFER_SIZE;
+    case 1500:
+      return -CLOCK_TEST_BUFFER_SIZE;
+    case 2000:
+      return -CLOCK_TEST_BUFFER_SIZE * 3 / 4;
+    case 2500:
+      *restart = TRUE;
+      return rate;
+    default:
+      return 0;
+  }
+}
+
+gboolean
+run_audio_clock_self_test (NvDsConfig *config)
+{
+  NvDsGieConfig *gie = &config->audio_classifier_config;
+  NvDsAudioTransformParams params;
+  guint frame_size = gie->is_frame_size_set ? gie->frame_size :
+      DEFAULT_FRAME_SIZE;
+  guint hop_size = gie->is_hop_size_set ? gie->hop_size : DEFAULT_HOP_SIZE;
+  NvDsAudioClock clock;
+  GRand *rand = g_rand_new_with_seed (1);
+  /* Position of every sample taken by the clock in the source's stream. */
+  guint64 *truth = g_new (guint64,
+      (gsize) CLOCK_TEST_BUFFERS * CLOCK_TEST_BUFFER_SIZE);
+  guint64 num_kept = 0, next = 0, sent = 0, pts_base = 0;
+  guint64 start = 0, windows = 0, flagged = 0, wrong_flags = 0;
+  guint64 last_time = 0, last_arrival = 0, arrival = 0, backlog = 0;
+  gint64 max_error = 0, max_step_error = 0, max_arrival_step_error = 0;
+  guint wrong_drops = 0;
+  guint64 hop_time;
+  guint rate, b;
+  gboolean ret = FALSE;
+
+  memset (&clock, 0, sizeof (clock));
+  if (!nvds_audio_transform_params_parse (gie->audio_transform ?
+          gie->audio_transform : DEFAULT_AUDIO_TRANSFORM, &params))
+    goto done;
+  rate = params.sample_rate;
+  hop_time = gst_util_uint64_scale (hop_size, GST_SECOND, rate);
+
+  for (b = 0; b < CLOCK_TEST_BUFFERS; b++) {
+    gboolean restart;
+    guint64 expected_drop, pts;
+    guint drop, i;
+
+    next += clock_test_skip (b, rate, &restart);
+    if (restart)
+      pts_base = next;
+    expected_drop = sent > next ?
+        MIN (sent - next, CLOCK_TEST_BUFFER_SIZE) : 0;
+    pts = gst_util_uint64_scale (next - pts_base, GST_SECOND, rate);
+    if (b >= CLOCK_TEST_BACKLOG_FROM)
+      backlog += CLOCK_TEST_BACKLOG_PER_BUFFER;
+    arrival = CLOCK_TEST_START_TIME + gst_util_uint64_scale (next +
+        CLOCK_TEST_BUFFER_SIZE, GST_SECOND, rate) + backlog +
+        g_rand_int_range (rand, 0, CLOCK_TEST_JITTER);
+
+    drop = nvds_audio_clock_push (&clock, pts, arrival,
+        CLOCK_TEST_BUFFER_SIZE, rate);
+    if (drop != expected_drop)
+      wrong_drops++;
+    for (i = drop; i < CLOCK_TEST_BUFFER_SIZE; i++)
+      truth[num_kept++] = next + i;
+    next += CLOCK_TEST_BUFFER_SIZE;
+    sent = MAX (sent, next);
+
+    /* Every window completed by the buffer, as the front-end cuts them. */
+    for (; num_kept >= start + frame_size; start += hop_size) {
+      guint64 time = nvds_audio_clock_get_time (&clock, start);
+      guint64 expected = CLOCK_TEST_START_TIME +
+          gst_util_uint64_scale (truth[start], GST_SECOND, rate);
+      gboolean gap = FALSE;
+      guint64 j;
+
+      for (j = MAX (start, 1); j < start + frame_size && !gap; j++)
+        gap = truth[j] != truth[j - 1] + 1;
+      if (gap != nvds_audio_clock_has_gap (&clock, start, frame_size))
+        wrong_flags++;
+      flagged += gap;
+      max_error = MAX (max_error, ABS (GST_CLOCK_DIFF (expected, time)));
+
+      /* Contiguous windows must be exactly one hop apart. */
+      if (windows && truth[start] == truth[start - hop_size] + hop_size) {
+        max_step_error = MAX (max_step_error,
+            ABS (GST_CLOCK_DIFF (last_time + hop_time, time)));
+        max_arrival_step_error = MAX (max_arrival_step_error,
+            ABS (GST_CLOCK_DIFF (last_arrival + hop_time, arrival)));
+      }
+      last_time = time;
+      last_arrival = arrival;
+      windows++;
+    }
+  }
+
+  g_print ("Audio clock: %" G_GUINT64_FORMAT " windows, %" G_GUINT64_FORMAT
+      " with a gap; %" G_GUINT64_FORMAT " gaps (%.3f s lost), %"
+      G_GUINT64_FORMAT " repeated samples, %" G_GUINT64_FORMAT " restarts\n",
+      windows, flagged, clock.stats.gaps,
+      (gdouble) clock.stats.lost / GST_SECOND,
+      clock.stats.duplicate_samples, clock.stats.resyncs);
+  g_print ("Audio clock: window times within %.3f ms of the sample times,"
+      " hops within %.3f us; arrival times would be off by up to %.3f s per"
+      " hop\n", (gdouble) max_error / GST_MSECOND,
+      (gdouble) max_step_error / GST_USECOND,
+      (gdouble) max_arrival_step_error / GST_SECOND);
+  g_print ("Audio clock: lag %.1f ms with a backlog of %.1f ms\n",
+      (gdouble) clock.stats.lag / GST_MSECOND,
+      (gdouble) backlog / GST_MSECOND);
+
+  ret = TRUE;
+  if (wrong_drops || clock.stats.gaps != 1 || clock.stats.duplicates != 2 ||
+      clock.stats.resyncs != 1) {
+    NVGSTDS_ERR_MSG_V ("Lost or repeated samples not detected");
+    ret = FALSE;
+  }
+  if (wrong_flags || !flagged) {
+    NVGSTDS_ERR_MSG_V ("%" G_GUINT64_FORMAT " windows with a wrong gap flag",
+        wrong_flags);
+    ret = FALSE;
+  }
+  /* Only the arrival times the clock was anchored to may shift it. */
+  if (max_error > (gint64) CLOCK_TEST_JITTER ||
+      max_step_error > (gint64) GST_USECOND) {
+    NVGSTDS_ERR_MSG_V ("Window times do not follow the samples");
+    ret = FALSE;
+  }
+  if (ABS (clock.stats.lag - (gint64) backlog) > 2 * CLOCK_TEST_JITTER) {
+    NVGSTDS_ERR_MSG_V ("Lag does not follow the backlog");
+    ret = FALSE;
+  }
+
+done:
+  g_rand_free (rand);
+  g_free (truth);
+  if (!ret) {
+    NVGSTDS_ERR_MSG_V ("%s failed", __func__);
+  }
+  return ret;
+}
@@ -0,0 +1,297 @@
+#!/usr/bin/env python3
+"""Convert an ONNX export of the classifier to the network format run by the
+CPU backend of BirdEdge (plugin-type=2, see apps-common/includes/
+deepstream_cpu_infer.h). Batch normalization is folded into the preceding
+convolution and activations into the preceding layer where possible."""
+
+import argparse
+import struct
+import sys
+
+import numpy as np
+import onnx
+from onnx import numpy_helper
+
+MAGIC = b'BDNN'
+VERSION = 1
+NO_TENSOR = 0xffffffff
+
+CONV, MAX_POOL, AVG_POOL, ADD, MUL, ACTIVATION, SOFTMAX = range(7)
+ACT_NONE, ACT_RELU, ACT_RELU6, ACT_SIGMOID, ACT_SILU = range(5)
+
+# Nodes that only change the view of a tensor; dense layers read the
+# C x H x W input as a kernel of its full size.
+ALIAS_OPS = ('Flatten', 'Reshape', 'Identity', 'Dropout', 'Squeeze', 'Unsqueeze')
+
+
+class Layer:
+    def __init__(self, type, inputs, shape, **params):
+        self.type = type
+        self.activation = ACT_NONE
+        self.inputs = inputs + [NO_TENSOR] * (2 - len(inputs))
+        self.shape = shape
+        self.params = dict(out_channels=0, kernel=(0, 0), stride=(0, 0),
+                           pads=(0, 0, 0, 0), groups=0)
+        self.params.update(params)
+        self.weights = np.zeros(0, np.float32)
+        self.bias = np.zeros(0, np.float32)
+
+    def pack(self, output):
+        p = self.params
+        fields = [self.type, self.activation, self.inputs[0], self.inputs[1],
+                  output, p['out_channels'], p['kernel'][0], p['kernel'][1],
+                  p['stride'][0], p['stride'][1], p['pads'][0], p['pads'][1],
+                  p['pads'][2], p['pads'][3], p['groups'],
+                  self.weights.size, self.bias.size]
+        return (struct.pack('<17I', *fields) +
+                self.weights.astype('<f4').tobytes() +
+                self.bias.astype('<f4').tobytes())
+
+
+def window_size(size, kernel, stride, pad0, pad1):
+    return (size + pad0 + pad1 - kernel) // stride + 1
+
+
+class Converter:
+    def __init__(self, model):
+        self.graph = model.graph
+        self.init = {i.name: numpy_helper.to_array(i) for i in self.graph.initializer}
+        self.layers = []
+        # ONNX value name -> tensor index
+        self.tensors = {}
+        self.uses = {}
+        for node in self.graph.node:
+            for name in node.input:
+                self.uses[name] = self.uses.get(name, 0) + 1
+        for out in self.graph.output:
+            self.uses[out.name] = self.uses.get(out.name, 0) + 1
+
+    def shape(self, tensor):
+        return self.input_shape if tensor == 0 else self.layers[tensor - 1].shape
+
+    def producer(self, tensor):
+        return self.layers[tensor - 1] if tensor else None
+
+    def emit(self, layer, name):
+        self.layers.append(layer)
+        self.tensors[name] = len(self.layers)
+
+    def fusable(self, node):
+        """Producer of the first input if only this node reads it."""
+        tensor = self.tensors[node.input[0]]
+        layer = self.producer(tensor)
+        if layer and self.uses[node.input[0]] == 1 and layer.activation == ACT_NONE:
+            return layer
+        return None
+
+    @staticmethod
+    def attrs(node):
+        return {a.name: onnx.helper.get_attribute_value(a) for a in node.attribute}
+
+    def convert(self):
+        inputs = [i for i in self.graph.input if i.name not in self.init]
+        dims = [d.dim_value for d in inputs[0].type.tensor_type.shape.dim][1:]
+        if len(dims) == 2:
+            dims = [1] + dims
+        if len(dims) != 3 or not all(dims):
+            sys.exit('Expected an input of N x C x H x W, got %s' % dims)
+        self.input_shape = tuple(dims)
+        self.tensors[inputs[0].name] = 0
+
+        for node in self.graph.node:
+            handler = getattr(self, 'op_' + node.op_type, None)
+            if node.op_type in ALIAS_OPS:
+                self.tensors[node.output[0]] = self.tensors[node.input[0]]
+            elif handler:
+                handler(node)
+            else:
+                sys.exit('Unsupported ONNX operator %s (%s)' % (node.op_type, node.name))
+        return self.tensors[self.graph.output[0].name]
+
+    def conv_layer(self, node, tensor, weights, bias, a):
+        c, h, w = self.shape(tensor)
+        kh, kw = weights.shape[2:]
+        stride = tuple(a.get('strides', (1, 1)))
+        if any(d != 1 for d in a.get('dilations', (1, 1))):
+            sys.exit('Dilated convolutions are not supported (%s)' % node.name)
+        if a.get('auto_pad', b'NOTSET') not in (b'NOTSET', 'NOTSET'):
+            sys.exit('auto_pad is not supported (%s)' % node.name)
+        pt, pl, pb, pr = a.get('pads', (0, 0, 0, 0))
+        shape = (weights.shape[0], window_size(h, kh, stride[0], pt, pb),
+                 window_size(w, kw, stride[1], pl, pr))
+        layer = Layer(CONV, [tensor], shape, out_channels=weights.shape[0],
+                      kernel=(kh, kw), stride=stride, pads=(pt, pl, pb, pr),
+                      groups=a.get('group', 1))
+        layer.weights = weights.astype(np.float32).ravel()
+        if bias is not None:
+            layer.bias = bias.astype(np.float32).ravel()
+        return layer
+
+    def op_Conv(self, node):
+        weights = self.init[node.input[1]]
+        bias = self.init[node.input[2]] if len(node.input) > 2 else None
+        self.emit(self.conv_layer(node, self.tensors[node.input[0]], weights,
+                                  bias, self.attrs(node)), node.output[0])
+
+    def op_Gemm(self, node):
+        a = self.attrs(node)
+        if a.get('alpha', 1.0) != 1.0 or a.get('beta', 1.0) != 1.0 or a.get('transA', 0):
+            sys.exit('Unsupported Gemm attributes (%s)' % node.name)
+        weights = self.init[node.input[1]]
+        if not a.get('transB', 0):
+            weights = weights.T
+        self.dense(node, weights, self.init[node.input[2]] if len(node.input) > 2 else None)
+
+    def op_MatMul(self, node):
+        self.dense(node, self.init[node.input[1]].T, None)
+
+    def dense(self, node, weights, bias):
+        tensor = self.tensors[node.input[0]]
+        c, h, w = self.shape(tensor)
+        weights = weights.reshape(weights.shape[0], c, h, w)
+        self.emit(self.conv_layer(node, tensor, weights, bias, {}), node.output[0])
+
+    def op_BatchNormalization(self, node):
+        gamma, beta, mean, var = (self.init[n] for n in node.input[1:5])
+        eps = self.attrs(node).get('epsilon', 1e-5)
+        scale = gamma / np.sqrt(var + eps)
+        shift = beta - mean * scale
+        layer = self.fusable(node)
+        if layer and layer.type == CONV:
+            oc = layer.params['out_channels']
+            layer.weights = (layer.weights.reshape(oc, -1) * scale[:, None]).ravel()
+            bias = layer.bias if layer.bias.size else np.zeros(oc, np.float32)
+            layer.bias = (bias * scale + shift).astype(np.float32)
+            self.tensors[node.output[0]] = self.tensors[node.input[0]]
+            return
+        # Per-channel scale and shift as 1x1 depthwise convolution.
+        tensor = self.tensors[node.input[0]]
+        c = self.shape(tensor)[0]
+        layer = self.conv_layer(node, tensor, scale.reshape(c, 1, 1, 1), shift,
+                                {'group': c})
+        self.emit(layer, node.output[0])
+
+    def activation(self, node, activation):
+        layer = self.fusable(node)
+        if layer and layer.type != SOFTMAX:
+            layer.activation = activation
+            self.tensors[node.output[0]] = self.tensors[node.input[0]]
+            return
+        tensor = self.tensors[node.input[0]]
+        layer = Layer(ACTIVATION, [tensor], self.shape(tensor))
+        layer.activation = activation
+        self.emit(layer, node.output[0])
+
+    def op_Relu(self, node):
+        self.activation(node, ACT_RELU)
+
+    def op_Sigmoid(self, node):
+        self.activation(node, ACT_SIGMOID)
+
+    def op_Clip(self, node):
+        a = self.attrs(node)
+        lo = a.get('min', self.init[node.input[1]] if len(node.input) > 1 and node.input[1] else None)
+        hi = a.get('max', self.init[node.input[2]] if len(node.input) > 2 and node.input[2] else None)
+        if float(lo) != 0.0 or float(hi) != 6.0:
+            sys.exit('Only Clip(0, 6) is supported (%s)' % node.name)
+        self.activation(node, ACT_RELU6)
+
+    def binary(self, node, type):
+        if any(n in self.init for n in node.input):
+            self.add_constant(node, type)
+            return
+        names = list(node.input)
+        a, b = (self.tensors[n] for n in names)
+        if type == MUL and self.is_sigmoid_of(b, a):
+            a, b = b, a
+            names.reverse()
+        if type == MUL and self.is_sigmoid_of(a, b) and self.uses[names[0]] == 1:
+            # x * sigmoid (x) as written by exporters of SiLU / Swish.
+            layer = self.producer(a)
+            layer.activation = ACT_SILU
+            self.tensors[node.output[0]] = a
+            return
+        if self.shape(a)[1:] == (1, 1) and self.shape(b)[1:] != (1, 1):
+            a, b = b, a
+        self.emit(Layer(type, [a, b], self.shape(a)), node.output[0])
+
+    def is_sigmoid_of(self, tensor, other):
+        layer = self.producer(tensor)
+        return (layer is not None and layer.type == ACTIVATION and
+                layer.activation == ACT_SIGMOID and layer.inputs[0] == other)
+
+    def add_constant(self, node, type):
+        """Bias of a dense layer exported as MatMul + Add."""
+        name = node.input[1] if node.input[1] in self.init else node.input[0]
+        other = node.input[0] if name == node.input[1] else node.input[1]
+        node.input[:] = [other]
+        layer = self.fusable(node)
+        if type != ADD or not layer or layer.type != CONV or layer.bias.size:
+            sys.exit('Unsupported constant operand of %s (%s)' % (node.op_type, node.name))
+        layer.bias = self.init[name].astype(np.float32).ravel()
+        self.tensors[node.output[0]] = self.tensors[other]
+
+    def op_Add(self, node):
+        self.binary(node, ADD)
+
+    def op_Mul(self, node):
+        self.binary(node, MUL)
+
+    def pool(self, node, type):
+        a = self.attrs(node)
+        tensor = self.tensors[node.input[0]]
+        c, h, w = self.shape(tensor)
+        if type == AVG_POOL and a.get('count_include_pad', 0):
+            sys.exit('count_include_pad is not supported (%s)' % node.name)
+        kh, kw = a['kernel_shape']
+        stride = tuple(a.get('strides', (1, 1)))
+        pt, pl, pb, pr = a.get('pads', (0, 0, 0, 0))
+        shape = (c, window_size(h, kh, stride[0], pt, pb),
+                 window_size(w, kw, stride[1], pl, pr))
+        self.emit(Layer(type, [tensor], shape, kernel=(kh, kw), stride=stride,
+                        pads=(pt, pl, pb, pr)), node.output[0])
+
+    def op_MaxPool(self, node):
+        self.pool(node, MAX_POOL)
+
+    def op_AveragePool(self, node):
+        self.pool(node, AVG_POOL)
+
+    def op_GlobalAveragePool(self, node):
+        tensor = self.tensors[node.input[0]]
+        self.emit(Layer(AVG_POOL, [tensor], (self.shape(tensor)[0], 1, 1)),
+                  node.output[0])
+
+    def op_ReduceMean(self, node):
+        axes = self.attrs(node).get('axes')
+        if sorted(axes or ()) != [2, 3]:
+            sys.exit('Only ReduceMean over H and W is supported (%s)' % node.name)
+        self.op_GlobalAveragePool(node)
+
+    def op_Softmax(self, node):
+        tensor = self.tensors[node.input[0]]
+        self.emit(Layer(SOFTMAX, [tensor], self.shape(tensor)), node.output[0])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('onnx', help='ONNX model with a N x C x H x W input')
+    parser.add_argument('output', help='network file for model-engine-file')
+    args = parser.parse_args()
+
+    converter = Converter(onnx.load(args.onnx))
+    output = converter.convert()
+    if output == 0:
+        sys.exit('The network has no layers')
+    c, h, w = converter.input_shape
+    with open(args.output, 'wb') as f:
+        f.write(MAGIC + struct.pack('<7I', VERSION, len(converter.layers) + 1,
+                                    len(converter.layers), c, h, w, output))
+        for i, layer in enumerate(converter.layers):
+            f.write(layer.pack(i + 1))
+    print('%d layers, input %dx%dx%d, %d outputs' % (
+        len(converter.layers), c, h, w, int(np.prod(converter.shape(output)))))
+
+
+if __name__ == '__main__':
+    main()